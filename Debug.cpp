@@ -41,7 +41,10 @@ Debugger::Debugger()
 //
 //  Output a diagnostic message if debugging is turned on.
 //
-void Debugger::DebugMessage(String message)
+//  Messages formatted into a character buffer do not need a String so no
+//  memory is allocated unless the real time clock is attached.
+//
+void Debugger::DebugMessage(const char *message)
 {
     if (rtc != NULL)
     {
@@ -53,6 +56,14 @@ void Debugger::DebugMessage(String message)
     yield();
 }
 
+//
+//  Output a diagnostic message held in a String.
+//
+void Debugger::DebugMessage(String message)
+{
+    DebugMessage(message.c_str());
+}
+
 //
 //  Output an array of bytes preceeded by a message.
 //
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+#
+#  Compare the output of WeatherStationBenchmarks against the baseline.
+#
+#  Usage:
+#
+#      CompareBenchmarks.py results.json Baseline.json            Compare
+#      CompareBenchmarks.py results.json Baseline.json --update   Replace the baseline
+#
+#  The allocation, copy, bus, network and compressed size counters are
+#  deterministic and any increase is an error.  Time depends on the machine
+#  the baseline was recorded on so a slow down beyond the tolerance (default
+#  50%) is only reported, add --strict-timing to treat it as a regression
+#  when the baseline was recorded on the same machine.
+#
+#  MIT License
+#
+#  Copyright(c) 2016 Mark Stevens
+#
+import argparse
+import json
+import sys
+
+COUNTERS = ["allocs/op", "alloc_bytes/op", "copied_bytes/op", "bus_bytes/op", "net_bytes/op", "encoded_bytes/sample"]
+
+
+#
+#  Extract the time and counters for each benchmark from the Google Benchmark
+#  JSON output.  When the benchmarks were repeated the median is used.
+#
+def LoadResults(fileName):
+    with open(fileName) as results:
+        data = json.load(results)
+    stages = {}
+    for benchmark in data["benchmarks"]:
+        name = benchmark.get("run_name", benchmark["name"])
+        if benchmark.get("run_type", "iteration") == "aggregate":
+            if benchmark.get("aggregate_name") != "median":
+                continue
+        elif name in stages:
+            continue
+        stage = {"ns/op": round(benchmark["cpu_time"], 1)}
+        for counter in COUNTERS:
+            if counter in benchmark:
+                stage[counter] = round(benchmark[counter], 2)
+        stages[name] = stage
+    return stages
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare weather station benchmarks with the baseline.")
+    parser.add_argument("results")
+    parser.add_argument("baseline")
+    parser.add_argument("--update", action="store_true", help="write the results as the new baseline")
+    parser.add_argument("--tolerance", type=float, default=0.5, help="allowed fractional slow down")
+    parser.add_argument("--strict-timing", action="store_true", help="fail when a stage is slower than the tolerance")
+    arguments = parser.parse_args()
+
+    results = LoadResults(arguments.results)
+    if arguments.update:
+        with open(arguments.baseline, "w") as baseline:
+            json.dump(results, baseline, indent=4, sort_keys=True)
+            baseline.write("\n")
+        print("Baseline updated (%d stages)." % len(results))
+        return 0
+
+    with open(arguments.baseline) as baseline:
+        expected = json.load(baseline)
+    failures = 0
+    print("%-32s %14s %14s %8s" % ("Stage", "Baseline", "Current", "Change"))
+    for name in sorted(expected):
+        if name not in results:
+            print("%-32s missing from the results" % name)
+            failures += 1
+            continue
+        for metric in ["ns/op"] + COUNTERS:
+            if metric not in expected[name]:
+                continue
+            old = expected[name][metric]
+            new = results[name].get(metric, 0)
+            change = ((new - old) / old) if old else (1.0 if new else 0.0)
+            timing = (metric == "ns/op")
+            limit = arguments.tolerance if timing else 0.0
+            status = ""
+            if change > limit + 1e-9:
+                if timing and not arguments.strict_timing:
+                    status = "slower (advisory)"
+                else:
+                    status = "REGRESSION"
+                    failures += 1
+            print("%-32s %14.2f %14.2f %+7.1f%% %s" % (name + " " + metric, old, new, change * 100, status))
+    for name in sorted(set(results) - set(expected)):
+        print("%-32s not in the baseline" % name)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,704 @@
+//
+//  Benchmarks for the sensor to publish path of the weather station.
+//
+//  Each stage of the per-minute cycle is run against the simulated devices
+//  and reports the time per operation along with the heap allocations, bytes
+//  allocated and bytes copied by String operations per operation.  Stages
+//  which talk to the sensors also report the bus traffic.
+//
+//  Usage: WeatherStationBenchmarks [Google Benchmark options]
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <new>
+#include <vector>
+#include <stdlib.h>
+#include <benchmark/benchmark.h>
+#include "Simulator.h"
+#include "WeatherStation.ino"
+#include "TimeSeriesBlock.h"
+
+//
+//  Number of probes on the simulated OneWire bus.
+//
+#define BENCHMARK_GROUND_TEMPERATURE_PROBES     4
+
+//******************************************************************************
+//
+//  Heap instrumentation.
+//
+namespace
+{
+    size_t _allocations = 0;
+    size_t _allocatedBytes = 0;
+}
+
+//
+//  The replacements are not inlined, GCC would otherwise see the malloc in
+//  operator new paired with operator delete and warn (-Wmismatched-new-delete).
+//
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    _allocations++;
+    _allocatedBytes += size;
+    void *memory = malloc((size == 0) ? 1 : size);
+    if (memory == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return(memory);
+}
+
+__attribute__((noinline)) void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+//
+//  Record the resources used by a benchmark and report them per operation.
+//
+class StageCounters
+{
+    public:
+        StageCounters(benchmark::State &state) : _state(state)
+        {
+            _allocations = ::_allocations;
+            _allocatedBytes = ::_allocatedBytes;
+            _bytesCopied = String::BytesCopied();
+            _busBytes = Simulator::I2CBytesTransferred() + Simulator::OneWireBytesTransferred();
+            _networkBytes = NetworkBytes();
+        }
+
+        //
+        //  Everything is measured before the counters are added, adding a
+        //  counter allocates memory.
+        //
+        ~StageCounters()
+        {
+            const benchmark::Counter::Flags average = benchmark::Counter::kAvgIterations;
+            double allocations = (double) (::_allocations - _allocations);
+            double allocatedBytes = (double) (::_allocatedBytes - _allocatedBytes);
+            double bytesCopied = (double) (String::BytesCopied() - _bytesCopied);
+            double busBytes = (double) (Simulator::I2CBytesTransferred() + Simulator::OneWireBytesTransferred() - _busBytes);
+            double networkBytes = (double) (NetworkBytes() - _networkBytes);
+            _state.counters["allocs/op"] = benchmark::Counter(allocations, average);
+            _state.counters["alloc_bytes/op"] = benchmark::Counter(allocatedBytes, average);
+            _state.counters["copied_bytes/op"] = benchmark::Counter(bytesCopied, average);
+            _state.counters["bus_bytes/op"] = benchmark::Counter(busBytes, average);
+            _state.counters["net_bytes/op"] = benchmark::Counter(networkBytes, average);
+        }
+
+    private:
+        benchmark::State &_state;
+        size_t _allocations;
+        size_t _allocatedBytes;
+        size_t _bytesCopied;
+        uint32_t _busBytes;
+        uint32_t _networkBytes;
+
+        static uint32_t NetworkBytes()
+        {
+            return(Simulator::Network().bytesSent + Simulator::Network().bytesReceived);
+        }
+};
+
+//******************************************************************************
+//
+//  Sensor stages.
+//
+
+//
+//  Decode a DS18B20 scratchpad (12 bit) into degrees C.
+//
+static void BM_DecodeGroundTemperature(benchmark::State &state)
+{
+    const byte scratchpad[9] = { 0x91, 0x01, 0x4b, 0x46, 0x7f, 0xff, 0x0f, 0x10, 0x00 };
+    StageCounters counters(state);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(WeatherSensors::DecodeGroundTemperature(scratchpad, 0));
+    }
+}
+BENCHMARK(BM_DecodeGroundTemperature);
+
+//
+//  Full conversion and read of all of the ground temperature probes.
+//
+static void BM_ReadGroundTemperatureSensor(benchmark::State &state)
+{
+    StageCounters counters(state);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(_sensors->ReadGroundTemperatureSensor());
+    }
+}
+BENCHMARK(BM_ReadGroundTemperatureSensor);
+
+//
+//  Read the wind vane and look the reading up in the direction table.
+//
+static void BM_ReadWindDirection(benchmark::State &state)
+{
+    StageCounters counters(state);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(_sensors->ReadWindDirection());
+    }
+}
+BENCHMARK(BM_ReadWindDirection);
+
+//
+//  Table lookup alone across the full ADC range.
+//
+static void BM_DecodeWindDirection(benchmark::State &state)
+{
+    uint16_t reading = 0;
+    StageCounters counters(state);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(WeatherSensors::DecodeWindDirection(reading));
+        reading = (reading + 1) & 0x3ff;
+    }
+}
+BENCHMARK(BM_DecodeWindDirection);
+
+//******************************************************************************
+//
+//  Publishing stages.
+//
+
+//
+//  Run the upload in progress to completion, the clock moves on by a
+//  millisecond for each step as it would between passes round loop().
+//
+static void CompleteUpload()
+{
+    while (_upload != NULL)
+    {
+        ServiceUploads();
+        delay(1);
+    }
+}
+
+//
+//  Float to text conversion used for every field in the URL.
+//
+static void BM_FloatToAscii(benchmark::State &state)
+{
+    char number[20];
+    double value = 1013.25;
+    StageCounters counters(state);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(Debugger::FloatToAscii(number, value, 2));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_FloatToAscii);
+
+//
+//  Build the Phant URL from the latest readings.
+//
+static void BM_BuildPhantURL(benchmark::State &state)
+{
+    TelemetrySerializer::Sample sample;
+    StageCounters counters(state);
+
+    for (auto _ : state)
+    {
+        CaptureSample(sample);
+        benchmark::DoNotOptimize(BuildPhantURL(_telemetry, sample));
+    }
+}
+BENCHMARK(BM_BuildPhantURL);
+
+//
+//  Serialize a set of readings as a JSON object.
+//
+static void BM_SerializeJSON(benchmark::State &state)
+{
+    char buffer[TELEMETRY_BUFFER_SIZE];
+    TelemetrySerializer record(buffer, sizeof(buffer));
+    TelemetrySerializer::Sample sample;
+    StageCounters counters(state);
+
+    CaptureSample(sample);
+    for (auto _ : state)
+    {
+        record.Begin(TelemetrySerializer::JSON);
+        record.Add(sample);
+        benchmark::DoNotOptimize(record.End());
+    }
+}
+BENCHMARK(BM_SerializeJSON);
+
+//
+//  Serialize a full batch of readings as CSV.
+//
+static void BM_SerializeBatch(benchmark::State &state)
+{
+    TelemetrySerializer::Sample sample;
+    StageCounters counters(state);
+
+    CaptureSample(sample);
+    for (auto _ : state)
+    {
+        _batch.BeginBatch(TelemetrySerializer::CSV);
+        for (uint32_t sequence = 1; sequence <= TELEMETRY_BATCH_SIZE; sequence++)
+        {
+            _batch.AddRecord(sequence, sample);
+        }
+        benchmark::DoNotOptimize(_batch.Length());
+    }
+}
+BENCHMARK(BM_SerializeBatch);
+
+//
+//  Encode a set of readings as a binary telemetry frame.
+//
+static void BM_EncodeFrame(benchmark::State &state)
+{
+    TelemetrySerializer::Sample sample;
+    uint8_t frame[TelemetryFrame::MaximumFrameSize];
+    StageCounters counters(state);
+
+    CaptureSample(sample);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(TelemetryFrame::Encode(sample, 1, frame, sizeof(frame)));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_EncodeFrame);
+
+//
+//  Decode a binary telemetry frame (ingest side).
+//
+static void BM_DecodeFrame(benchmark::State &state)
+{
+    TelemetrySerializer::Sample sample;
+    uint8_t frame[TelemetryFrame::MaximumFrameSize];
+    uint32_t sequence;
+    StageCounters counters(state);
+
+    CaptureSample(sample);
+    size_t length = TelemetryFrame::Encode(sample, 1, frame, sizeof(frame));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(TelemetryFrame::Decode(frame, length, sample, sequence));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_DecodeFrame);
+
+//
+//  Append a set of readings to the flash log and acknowledge it.
+//
+static void BM_TelemetryLogAppend(benchmark::State &state)
+{
+    TelemetrySerializer::Sample sample;
+    uint8_t frame[TelemetryFrame::MaximumFrameSize];
+    uint32_t sequence;
+    StageCounters counters(state);
+
+    CaptureSample(sample);
+    size_t length = TelemetryFrame::Encode(sample, 1, frame, sizeof(frame));
+    for (auto _ : state)
+    {
+        _telemetryLog.Append(frame, (uint16_t) length, sequence);
+        _telemetryLog.Acknowledge(sequence);
+    }
+}
+BENCHMARK(BM_TelemetryLogAppend);
+
+//
+//  Send a URL to the simulated Phant server.
+//
+static void BM_PostDataToPhant(benchmark::State &state)
+{
+    TelemetrySerializer::Sample sample;
+    StageCounters counters(state);
+
+    CaptureSample(sample);
+    BuildPhantURL(_telemetry, sample);
+    for (auto _ : state)
+    {
+        //
+        //  Posted as an unlogged reading so nothing from the log follows it.
+        //
+        _uploadSequence = 0;
+        _uploadRequests = TELEMETRY_UPLOAD_BATCH;
+        PostDataToPhant(_telemetry.GetBuffer());
+        CompleteUpload();
+    }
+}
+BENCHMARK(BM_PostDataToPhant);
+
+//
+//  Publish one logged reading to the simulated MQTT broker, one message per
+//  field, and wait for the broker to acknowledge them all.
+//
+static void BM_PublishMQTTReading(benchmark::State &state)
+{
+    TelemetrySerializer::Sample sample;
+    uint8_t frame[TelemetryFrame::MaximumFrameSize];
+    uint32_t sequence;
+    StageCounters counters(state);
+
+    CaptureSample(sample);
+    for (auto _ : state)
+    {
+        size_t length = TelemetryFrame::Encode(sample, _telemetryLog.GetNextSequence(), frame, sizeof(frame));
+        _telemetryLog.Append(frame, (uint16_t) length, sequence);
+        _mqttReadingsWaiting = true;
+        //
+        //  Measure the publishing path, not the time spent waiting for the
+        //  rate limit to allow the next reading.
+        //
+        _mqttPublishCredit = MQTT_PUBLISH_BURST;
+        while (_telemetryLog.GetPendingCount() > 0)
+        {
+            ServiceMQTT();
+            delay(1);
+        }
+    }
+}
+BENCHMARK(BM_PublishMQTTReading);
+
+//******************************************************************************
+//
+//  Time series compression.
+//
+//  A trace is one day of one minute samples for eight channels held as
+//  fixed point values, temperatures to 0.1 C, humidity to 0.1%, pressure to
+//  0.1 hPa, light to 1 lux, wind speed to 0.1 mph, wind direction to 1
+//  degree and rainfall to 0.01 mm.  Two synthetic days are built in (a fair day and a
+//  showery, windy day), a trace recorded by the station can be added with
+//  --trace=file where file is the CSV written by DecodeTelemetry.
+//
+#define TRACE_SAMPLES           1440
+#define TRACE_CHANNELS          8
+#define TRACE_BLOCK_SIZE        512
+
+struct TraceChannel
+{
+    const char *name;               // Column in the DecodeTelemetry CSV.
+    float scale;
+};
+
+const TraceChannel _traceChannels[TRACE_CHANNELS] =
+{
+    { "airtemperature", 10 },
+    { "humidity", 10 },
+    { "airpressure", 10 },
+    { "groundtemperature", 10 },
+    { "luminosity", 1 },
+    { "windspeed", 10 },
+    { "winddirectionmean2m", 1 },
+    { "rainfall", 100 }
+};
+
+struct WeatherTrace
+{
+    size_t numberOfSamples;
+    uint32_t timestamps[TRACE_SAMPLES];
+    int32_t values[TRACE_SAMPLES][TRACE_CHANNELS];
+};
+
+WeatherTrace _fairDay;
+WeatherTrace _showeryDay;
+WeatherTrace _recordedTrace;
+
+//
+//  Repeatable noise in the range -1 to 1.
+//
+static float TraceNoise(uint32_t &seed)
+{
+    seed = (seed * 1664525) + 1013904223;
+    return((((seed >> 8) / 16777216.0f) * 2) - 1);
+}
+
+//
+//  Build a day of readings with a daily temperature and light cycle, sensor
+//  noise at about the resolution of the sensors and, for the showery day,
+//  passing showers with cloud, gusty wind and rain.
+//
+static void GenerateTrace(WeatherTrace &trace, bool showery)
+{
+    uint32_t seed = showery ? 2 : 1;
+    float cloud = showery ? 0.5f : 0.9f;
+    float windSpeed = showery ? 15 : 4;
+    float windDirection = showery ? 250 : 200;
+    float rainfall = 0;
+    float drift = 0;
+
+    trace.numberOfSamples = TRACE_SAMPLES;
+    for (size_t minute = 0; minute < TRACE_SAMPLES; minute++)
+    {
+        float day = sinf(2 * M_PI * (minute - 540.0f) / 1440);
+        bool raining = showery && (((minute / 90) % 4) == 1);
+        drift += 0.02f * TraceNoise(seed);
+        cloud = fminf(1, fmaxf(0.1f, cloud + (0.05f * TraceNoise(seed)) + (raining ? -0.02f : 0.01f)));
+        windSpeed = fmaxf(0, windSpeed + (0.5f * TraceNoise(seed)) + (((showery ? 15 : 4) - windSpeed) * 0.05f));
+        windDirection += (showery ? 5 : 1) * TraceNoise(seed);
+        if (raining && (TraceNoise(seed) > 0))
+        {
+            rainfall += 0.2794f;
+        }
+        float light = ((minute > 300) && (minute < 1260)) ? (80000 * sinf(M_PI * (minute - 300) / 960) * cloud) : 0;
+        float reading[TRACE_CHANNELS] =
+        {
+            13 + (6 * day) + drift - (raining ? 2 : 0) + (0.03f * TraceNoise(seed)),
+            fminf(100, 70 - (20 * day) + (raining ? 15 : 0) + (0.3f * TraceNoise(seed))),
+            (showery ? 1008 - (0.005f * minute) : 1016 - (0.002f * minute)) + (0.1f * TraceNoise(seed)),
+            12 + sinf(2 * M_PI * (minute - 660.0f) / 1440) + (0.02f * TraceNoise(seed)),
+            light * (1 + (0.01f * TraceNoise(seed))),
+            windSpeed,
+            fmodf(windDirection + 360, 360),
+            rainfall
+        };
+        trace.timestamps[minute] = 1464739200 + (minute * 60);
+        for (uint8_t channel = 0; channel < TRACE_CHANNELS; channel++)
+        {
+            trace.values[minute][channel] = (int32_t) lroundf(reading[channel] * _traceChannels[channel].scale);
+        }
+    }
+}
+
+//
+//  Load a trace from a CSV file written by DecodeTelemetry, returns false if
+//  the file cannot be read or has no samples.
+//
+static bool LoadTrace(WeatherTrace &trace, const char *fileName)
+{
+    const int MaximumColumns = 32;
+    char line[512];
+    char *fields[MaximumColumns];
+    int columns[TRACE_CHANNELS + 1];
+
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL)
+    {
+        return(false);
+    }
+    trace.numberOfSamples = 0;
+    for (bool heading = true; (trace.numberOfSamples < TRACE_SAMPLES) && (fgets(line, sizeof(line), file) != NULL); heading = false)
+    {
+        int numberOfFields = 0;
+        for (char *field = line; (field != NULL) && (numberOfFields < MaximumColumns); )
+        {
+            fields[numberOfFields++] = field;
+            field = strpbrk(field, ",\r\n");
+            if ((field != NULL) && (*field == ','))
+            {
+                *field++ = '\0';
+            }
+            else if (field != NULL)
+            {
+                *field = '\0';
+                field = NULL;
+            }
+        }
+        //
+        //  Columns are found by name, sampletime is the last entry.
+        //
+        for (uint8_t channel = 0; channel <= TRACE_CHANNELS; channel++)
+        {
+            if (heading)
+            {
+                const char *name = (channel < TRACE_CHANNELS) ? _traceChannels[channel].name : "sampletime";
+                columns[channel] = -1;
+                for (int column = 0; column < numberOfFields; column++)
+                {
+                    if (strcmp(fields[column], name) == 0)
+                    {
+                        columns[channel] = column;
+                    }
+                }
+                continue;
+            }
+            const char *text = ((columns[channel] >= 0) && (columns[channel] < numberOfFields)) ? fields[columns[channel]] : "";
+            if (channel == TRACE_CHANNELS)
+            {
+                trace.timestamps[trace.numberOfSamples] = (uint32_t) strtoul(text, NULL, 10);
+            }
+            else
+            {
+                trace.values[trace.numberOfSamples][channel] = (*text == '\0') ? TimeSeriesBlock::MissingValue :
+                                                               (int32_t) lround(atof(text) * _traceChannels[channel].scale);
+            }
+        }
+        if (!heading)
+        {
+            trace.numberOfSamples++;
+        }
+    }
+    fclose(file);
+    return(trace.numberOfSamples > 0);
+}
+
+//
+//  Compress the trace into a series of blocks, blocks is called with each
+//  completed block.  Returns the total size of the blocks.
+//
+template<typename BlockHandler> static size_t EncodeTrace(const WeatherTrace &trace, uint8_t *buffer, BlockHandler blocks)
+{
+    TimeSeriesBlock block(buffer, TRACE_BLOCK_SIZE);
+    size_t length = 0;
+
+    block.Begin(TRACE_CHANNELS);
+    for (size_t sample = 0; sample < trace.numberOfSamples; sample++)
+    {
+        if (!block.Append(trace.timestamps[sample], trace.values[sample]))
+        {
+            blocks(block);
+            length += block.Length();
+            block.Begin(TRACE_CHANNELS);
+            block.Append(trace.timestamps[sample], trace.values[sample]);
+        }
+    }
+    blocks(block);
+    return(length + block.Length());
+}
+
+//
+//  Compress a day of readings into 512 byte blocks.  Reports the size of
+//  the compressed data per sample and the compression ratio against the
+//  raw 32 bit timestamp and values.
+//
+static void BM_EncodeTimeSeries(benchmark::State &state, const WeatherTrace *trace)
+{
+    uint8_t buffer[TRACE_BLOCK_SIZE];
+    size_t length = EncodeTrace(*trace, buffer, [](TimeSeriesBlock &) {});
+    size_t raw = trace->numberOfSamples * (sizeof(uint32_t) + (TRACE_CHANNELS * sizeof(int32_t)));
+    state.counters["encoded_bytes/sample"] = (double) length / trace->numberOfSamples;
+    state.counters["compression_ratio"] = (double) raw / length;
+    {
+        StageCounters counters(state);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(EncodeTrace(*trace, buffer, [](TimeSeriesBlock &) {}));
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * trace->numberOfSamples);
+}
+BENCHMARK_CAPTURE(BM_EncodeTimeSeries, FairDay, &_fairDay);
+BENCHMARK_CAPTURE(BM_EncodeTimeSeries, ShoweryDay, &_showeryDay);
+
+//
+//  Decompress a day of readings.
+//
+static void BM_DecodeTimeSeries(benchmark::State &state, const WeatherTrace *trace)
+{
+    uint8_t buffer[TRACE_BLOCK_SIZE];
+    std::vector<uint8_t> blocks;
+    std::vector<size_t> lengths;
+    EncodeTrace(*trace, buffer, [&](TimeSeriesBlock &block)
+    {
+        blocks.insert(blocks.end(), block.GetBuffer(), block.GetBuffer() + block.Length());
+        lengths.push_back(block.Length());
+    });
+    uint32_t timestamp;
+    int32_t values[TRACE_CHANNELS];
+    {
+        StageCounters counters(state);
+        for (auto _ : state)
+        {
+            size_t offset = 0;
+            for (size_t index = 0; index < lengths.size(); index++)
+            {
+                memcpy(buffer, blocks.data() + offset, lengths[index]);
+                TimeSeriesBlock block(buffer, sizeof(buffer));
+                block.Open(lengths[index]);
+                while (block.ReadNext(timestamp, values))
+                {
+                    benchmark::DoNotOptimize(values);
+                }
+                offset += lengths[index];
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * trace->numberOfSamples);
+}
+BENCHMARK_CAPTURE(BM_DecodeTimeSeries, FairDay, &_fairDay);
+BENCHMARK_CAPTURE(BM_DecodeTimeSeries, ShoweryDay, &_showeryDay);
+
+//
+//  The whole per-minute publishing cycle (logging and posting).
+//
+static void BM_ReadAndPublishData(benchmark::State &state)
+{
+    StageCounters counters(state);
+
+    for (auto _ : state)
+    {
+        ReadAndPublishData();
+        CompleteUpload();
+    }
+}
+BENCHMARK(BM_ReadAndPublishData);
+
+//
+//  Start the simulated station and then run the benchmarks with the serial
+//  output turned off.
+//
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if ((argc > 1) && (strncmp(argv[1], "--trace=", 8) == 0))
+    {
+        if (!LoadTrace(_recordedTrace, argv[1] + 8))
+        {
+            fprintf(stderr, "Unable to read the trace %s\n", argv[1] + 8);
+            return(1);
+        }
+        benchmark::RegisterBenchmark("BM_EncodeTimeSeries/Recorded", BM_EncodeTimeSeries, &_recordedTrace);
+        benchmark::RegisterBenchmark("BM_DecodeTimeSeries/Recorded", BM_DecodeTimeSeries, &_recordedTrace);
+        argv[1] = argv[0];
+        argc--;
+        argv++;
+    }
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return(1);
+    }
+    GenerateTrace(_fairDay, false);
+    GenerateTrace(_showeryDay, true);
+    Simulator::Initialise(BENCHMARK_GROUND_TEMPERATURE_PROBES);
+    Serial.SetOutputEnabled(false);
+    setup();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return(0);
+}
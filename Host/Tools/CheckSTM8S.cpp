@@ -0,0 +1,189 @@
+//
+//  Drive the STM8S protocol in WeatherSensors against the simulated STM8S
+//  and check the decoded readings and the rejection of bad data: register
+//  reads using a repeated start, samples and history failing the CRC, stale
+//  samples, history reads (including records lost to the ring buffer wrapping and
+//  the rain gauge counter being reset), sequence number wrap and setting
+//  the debounce windows.
+//
+//  Usage: CheckSTM8S
+//
+//  Prints each check and exits with a non-zero status if any check fails.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <math.h>
+#include <stdio.h>
+#include "Simulator.h"
+#include "WeatherSensors.h"
+
+//
+//  One minute of simulated time (uS), the STM8S takes a reading on each
+//  RTC alarm.
+//
+#define ONE_MINUTE          (60ULL * 1000000ULL)
+
+static int _failures = 0;
+
+//
+//  Report the result of a check.
+//
+static void Check(bool passed, const char *description)
+{
+    printf("%s: %s\n", passed ? "PASS" : "FAIL", description);
+    if (!passed)
+    {
+        _failures++;
+    }
+}
+
+static bool Near(float value, float expected)
+{
+    return(fabs(value - expected) < 0.001);
+}
+
+//
+//  Read the history from the given sequence number until no more records are
+//  returned.  Returns the number of records read, lost is set to the number
+//  of records overwritten before they could be read, next to the sequence
+//  number of the next record to be requested and rainfall to the rain gauge
+//  total of the last record.  consistent is cleared if the records do not
+//  follow on from each other with one rain gauge tip each.
+//
+static int ReadHistory(WeatherSensors &sensors, uint16_t &next, uint16_t &lost, bool &consistent, uint32_t &rainfall)
+{
+    WeatherSensors::STM8SRecord records[WeatherSensors::STM8SRecordsPerRead];
+    WeatherSensors::STM8SRecord previous;
+    int total = 0;
+    uint8_t count;
+
+    lost = 0;
+    consistent = true;
+    while ((count = sensors.ReadSTM8SHistory(next, records, WeatherSensors::STM8SRecordsPerRead)) > 0)
+    {
+        if ((total == 0) && (records[0].sequence != next))
+        {
+            lost = (uint16_t) ((records[0].sequence + 65535 - next) % 65535);
+        }
+        else if (records[0].sequence != next)
+        {
+            consistent = false;
+        }
+        for (uint8_t index = 0; index < count; index++)
+        {
+            const WeatherSensors::STM8SRecord &record = records[index];
+            if (((total + index) > 0) &&
+                ((record.sequence != WeatherSensors::NextSTM8SSequence(previous.sequence)) ||
+                 (record.alarm != (uint16_t) (previous.alarm + 1)) ||
+                 (record.rainfall != (previous.rainfall + 1))))
+            {
+                consistent = false;
+            }
+            if ((record.windSpeed != 4) || (record.windDirection != 780) || (record.ultraviolet != 320) || (record.windPeriodMean != 500000))
+            {
+                consistent = false;
+            }
+            previous = record;
+        }
+        next = WeatherSensors::NextSTM8SSequence(records[count - 1].sequence);
+        rainfall = records[count - 1].rainfall;
+        total += count;
+    }
+    return(total);
+}
+
+int main()
+{
+    Simulator::Initialise(1);
+    Wire.begin();
+    Serial.SetOutputEnabled(false);
+    WeatherSensors sensors;
+    //
+    //  One rain gauge tip and 120 anemometer pulses a minute.
+    //
+    Simulator::Environment().rainTipsPerHour = 60;
+    Simulator::Environment().windSpeedPulsesPerSecond = 2;
+    //
+    //  Sample reads.
+    //
+    Check(!sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 0), "no sample before the first reading");
+    Simulator::Advance(ONE_MINUTE + (3 * 1000000ULL));
+    Simulator::ResetStatistics();
+    Check(sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 1), "first sample is accepted");
+    Check((Simulator::I2CRepeatedStarts() == 1) && (Simulator::I2CBytesTransferred() == 26), "sample register read is one repeated start transaction");
+    Check(Near(sensors.GetRainfall(), 0.2794) && Near(sensors.GetTotalRainfallToday(), 0.2794), "sample rainfall decoded");
+    Check(Near(sensors.GetWindSpeed(), 4 * 1.492) && Near(sensors.GetMeanWindSpeedFromPeriod(), 2 * 1.492) && Near(sensors.GetGustFromPeriod(), 2 * 1.492), "sample wind speed decoded");
+    Check(Near(sensors.GetUltravioletLightReading(), 320), "sample ultraviolet decoded");
+    Check(!sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 1), "stale sample is rejected");
+    Simulator::Advance(ONE_MINUTE);
+    Simulator::STM8S().CorruptNextRead();
+    Check(!sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 1), "sample failing the CRC is rejected");
+    Check(sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 2) && Near(sensors.GetRainfall(), 2 * 0.2794), "sample is accepted after a CRC failure");
+    //
+    //  History reads.
+    //
+    uint16_t next = 1;
+    uint16_t lost;
+    bool consistent;
+    uint32_t rainfall = 0;
+    int records = ReadHistory(sensors, next, lost, consistent, rainfall);
+    Check((records == 2) && (lost == 0) && consistent && (next == 3) && (rainfall == 2), "history read from the first record");
+    Simulator::Advance(10 * ONE_MINUTE);
+    records = ReadHistory(sensors, next, lost, consistent, rainfall);
+    Check((records == 10) && (lost == 0) && consistent && (next == 13) && (rainfall == 12), "history read across several transactions");
+    //
+    //  Resetting the rain gauge counter part way through the history leaves
+    //  one tip in each record, the totals follow the new count.
+    //
+    Simulator::Advance(2 * ONE_MINUTE);
+    WeatherSensors::STM8SRecord history[WeatherSensors::STM8SRecordsPerRead];
+    Simulator::STM8S().CorruptNextRead();
+    Check(sensors.ReadSTM8SHistory(next, history, WeatherSensors::STM8SRecordsPerRead) == 0, "history failing the CRC is rejected");
+    Check(sensors.ResetSTM8SRainfallCounter(), "rain gauge counter reset");
+    Simulator::Advance(2 * ONE_MINUTE);
+    records = ReadHistory(sensors, next, lost, consistent, rainfall);
+    Check((records == 4) && (lost == 0) && consistent && (next == 17) && (rainfall == 2), "history read across a rain gauge counter reset");
+    Check(sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 16) && Near(sensors.GetRainfall(), 2 * 0.2794), "sample after a rain gauge counter reset");
+    Simulator::Advance(30 * ONE_MINUTE);
+    records = ReadHistory(sensors, next, lost, consistent, rainfall);
+    Check((records == SimulatedSTM8S::HistoryLength - 1) && (lost == 30 - records) && consistent && (next == 47), "overwritten history is reported as lost");
+    //
+    //  Sequence numbers skip 0 when they wrap.
+    //
+    Simulator::Advance((65535 - 46) * ONE_MINUTE);
+    Check(sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 65535), "sample before the sequence number wraps");
+    next = 65534;
+    records = ReadHistory(sensors, next, lost, consistent, rainfall);
+    Simulator::Advance(ONE_MINUTE);
+    Check(sensors.ReadSTM8SSensors() && (sensors.GetSTM8SSequence() == 1), "sample after the sequence number wraps");
+    records += ReadHistory(sensors, next, lost, consistent, rainfall);
+    Check((records == 3) && (lost == 0) && consistent && (next == 2), "history read across the sequence number wrap");
+    //
+    //  Debounce windows.
+    //
+    Simulator::ResetStatistics();
+    Check(sensors.SetSTM8SDebounce(20, 3) && (Simulator::I2CRepeatedStarts() == 1), "debounce windows set and read back");
+    Check(sensors.SetSTM8SDebounce(0, 0), "debounce turned off");
+    printf("%d check(s) failed.\n", _failures);
+    return((_failures == 0) ? 0 : 1);
+}
@@ -0,0 +1,119 @@
+//
+//  Drive TelemetryPublisher against the simulated HTTP server and check that
+//  each way a response can be framed completes on the same keep-alive
+//  connection without waiting for the response timeout: a Content-Length,
+//  a chunked body, 204 and 304 responses with no body and interim (100
+//  Continue) responses.
+//
+//  Usage: CheckTelemetryPublisher
+//
+//  Prints each check and exits with a non-zero status if any check fails.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Simulator.h"
+#include "TelemetryPublisher.h"
+
+//
+//  Body returned by the server, long enough to span several chunks.
+//
+#define RESPONSE_BODY       "42 readings stored"
+
+static int _failures = 0;
+
+//
+//  Report the result of a check.
+//
+static void Check(bool passed, const char *description)
+{
+    printf("%s: %s\n", passed ? "PASS" : "FAIL", description);
+    if (!passed)
+    {
+        _failures++;
+    }
+}
+
+//
+//  The status code is the last part of the URI, /status/204 returns 204.
+//
+static std::string StatusHandler(const std::string &request, int &status)
+{
+    size_t position = request.find("/status/");
+    status = (position != std::string::npos) ? atoi(request.c_str() + position + 8) : 200;
+    return(RESPONSE_BODY);
+}
+
+//
+//  Send a GET (or a POST) and service it until it finishes.  Returns true if
+//  it completed on the connection used by the previous request with the
+//  expected status code and body, well within the response timeout.
+//
+static bool Request(TelemetryPublisher &publisher, bool post, const char *uri, int status, const char *body)
+{
+    static const uint8_t data[] = "1,2,3\n";
+    bool started = post ? publisher.BeginPost(uri, "text/plain", data, sizeof(data) - 1) : publisher.BeginGet(uri);
+
+    while (started && publisher.IsBusy())
+    {
+        publisher.Service();
+        delay(1);
+    }
+    return(started && (publisher.GetState() == TelemetryPublisher::Complete) && (publisher.GetStatusCode() == status) &&
+           (strcmp(publisher.GetResponse(), body) == 0) && publisher.WasConnectionReused() &&
+           (publisher.GetTotalTime() < (TelemetryPublisher::ResponseTimeout / 2)));
+}
+
+int main()
+{
+    Simulator::Initialise(1);
+    Serial.SetOutputEnabled(false);
+    Simulator::Network().handler = StatusHandler;
+    TelemetryPublisher publisher("data.example.com", 80);
+    //
+    //  Open the connection, the remaining requests reuse it.
+    //
+    Check(publisher.BeginGet("/status/200"), "first request started");
+    while (publisher.IsBusy())
+    {
+        publisher.Service();
+        delay(1);
+    }
+    Check((publisher.GetState() == TelemetryPublisher::Complete) && (strcmp(publisher.GetResponse(), RESPONSE_BODY) == 0), "response with a Content-Length");
+    Check(Request(publisher, false, "/status/204", 204, ""), "204 response without a body");
+    Check(Request(publisher, false, "/status/304", 304, ""), "304 response without a body");
+    Simulator::Network().chunkedResponses = true;
+    Check(Request(publisher, false, "/status/200", 200, RESPONSE_BODY), "chunked response");
+    Check(Request(publisher, false, "/status/204", 204, ""), "204 response when bodies are chunked");
+    Check(Request(publisher, true, "/status/200", 200, RESPONSE_BODY), "chunked response to a POST");
+    Simulator::Network().interimResponses = true;
+    Check(Request(publisher, true, "/status/200", 200, RESPONSE_BODY), "chunked response after 100 Continue");
+    Simulator::Network().chunkedResponses = false;
+    Check(Request(publisher, false, "/status/200", 200, RESPONSE_BODY), "response with a Content-Length after 100 Continue");
+    Check(Request(publisher, false, "/status/304", 304, ""), "304 response after 100 Continue");
+    Check(publisher.GetNumberOfConnections() == 1, "all requests used one connection");
+    printf("%d check(s) failed.\n", _failures);
+    return((_failures == 0) ? 0 : 1);
+}
@@ -0,0 +1,312 @@
+//
+//  Encode samples with TimeSeriesBlock and check that ReadNext returns
+//  exactly what Append stored: differences at the boundaries of each code,
+//  MissingValue, values and intervals needing the 32 bit escape, timestamps
+//  wrapping, full blocks and blocks opened from a copy of the buffer.
+//
+//  Usage: CheckTimeSeries
+//
+//  Prints each check and exits with a non-zero status if any check fails.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "TimeSeriesBlock.h"
+
+//
+//  Size of the blocks used by the checks, the same as a telemetry log sector.
+//
+#define BLOCK_SIZE          256
+
+//
+//  One sample, unused channels are ignored.
+//
+struct Sample
+{
+    uint32_t timestamp;
+    int32_t values[TimeSeriesBlock::MaximumChannels];
+};
+
+static int _failures = 0;
+
+//
+//  Report the result of a check.
+//
+static void Check(bool passed, const char *description)
+{
+    printf("%s: %s\n", passed ? "PASS" : "FAIL", description);
+    if (!passed)
+    {
+        _failures++;
+    }
+}
+
+//
+//  Read the block from the start and compare each sample with the trace
+//  starting at first.  Returns true if the block holds count samples which
+//  match the trace and nothing can be read after them.
+//
+static bool Matches(TimeSeriesBlock &block, const std::vector<Sample> &trace, size_t first, uint16_t count, uint8_t channels)
+{
+    Sample sample;
+
+    block.Rewind();
+    if ((block.GetNumberOfSamples() != count) || (block.GetNumberOfChannels() != channels))
+    {
+        return(false);
+    }
+    for (uint16_t index = 0; index < count; index++)
+    {
+        const Sample &expected = trace[first + index];
+        if (!block.ReadNext(sample.timestamp, sample.values) || (sample.timestamp != expected.timestamp) ||
+            (memcmp(sample.values, expected.values, channels * sizeof(int32_t)) != 0))
+        {
+            return(false);
+        }
+    }
+    return(!block.ReadNext(sample.timestamp, sample.values));
+}
+
+//
+//  Encode the trace into as many blocks as it needs.  Each block is checked
+//  as it is written and again after opening a copy of the bytes it used, as
+//  the log or the ingest side would.  Returns true if every sample was read
+//  back unchanged, blocks is set to the number of blocks used.
+//
+static bool RoundTrip(const std::vector<Sample> &trace, uint8_t channels, size_t &blocks)
+{
+    uint8_t buffer[BLOCK_SIZE];
+    uint8_t copy[BLOCK_SIZE];
+    size_t first = 0;
+
+    blocks = 0;
+    while (first < trace.size())
+    {
+        TimeSeriesBlock block(buffer, sizeof(buffer));
+        if (!block.Begin(channels))
+        {
+            return(false);
+        }
+        size_t next = first;
+        while ((next < trace.size()) && block.Append(trace[next].timestamp, trace[next].values))
+        {
+            next++;
+        }
+        if ((next == first) || !Matches(block, trace, first, (uint16_t) (next - first), channels))
+        {
+            return(false);
+        }
+        size_t length = block.Length();
+        memset(copy, 0xa5, sizeof(copy));
+        memcpy(copy, buffer, length);
+        TimeSeriesBlock stored(copy, sizeof(copy));
+        if (!stored.Open(length) || !Matches(stored, trace, first, (uint16_t) (next - first), channels))
+        {
+            return(false);
+        }
+        first = next;
+        blocks++;
+    }
+    return(true);
+}
+
+//
+//  Small deterministic generator so the random walks are repeatable.
+//
+static uint32_t Random()
+{
+    static uint32_t state = 2463534242UL;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return(state);
+}
+
+int main()
+{
+    std::vector<Sample> trace;
+    size_t blocks;
+    Sample sample;
+    //
+    //  Regular one minute samples of slowly changing readings.
+    //
+    for (int index = 0; index < 1440; index++)
+    {
+        sample.timestamp = 1475280000UL + (index * 60);
+        for (uint8_t channel = 0; channel < 8; channel++)
+        {
+            sample.values[channel] = (int32_t) (1000 * channel) + ((index / (channel + 1)) % 7) - 3;
+        }
+        trace.push_back(sample);
+    }
+    Check(RoundTrip(trace, 8, blocks) && (blocks > 1), "regular samples over several blocks");
+    //
+    //  Differences either side of each code boundary, for both the values and
+    //  the change in interval.
+    //
+    static const int32_t boundaries[] = { 0, 1, -1, 3, -4, 4, -5, 63, -64, 64, -65, 2047, -2048, 2048, -2049, 0x7fffffff, (int32_t) 0x80000001 };
+    const int numberOfBoundaries = sizeof(boundaries) / sizeof(boundaries[0]);
+    trace.clear();
+    sample.timestamp = 100000;
+    int32_t interval = 60;
+    memset(sample.values, 0, sizeof(sample.values));
+    trace.push_back(sample);
+    for (int index = 0; index < numberOfBoundaries; index++)
+    {
+        interval += (boundaries[index] % 2048);
+        sample.timestamp += (uint32_t) interval;
+        for (uint8_t channel = 0; channel < 4; channel++)
+        {
+            sample.values[channel] = (int32_t) ((uint32_t) sample.values[channel] + (uint32_t) boundaries[(index + channel) % numberOfBoundaries]);
+        }
+        trace.push_back(sample);
+    }
+    Check(RoundTrip(trace, 4, blocks), "differences at the code boundaries");
+    //
+    //  Channels without a reading, the change to and from MissingValue needs
+    //  the 32 bit code.
+    //
+    trace.clear();
+    for (int index = 0; index < 200; index++)
+    {
+        sample.timestamp = 5000 + (index * 60);
+        for (uint8_t channel = 0; channel < 6; channel++)
+        {
+            bool missing = ((index / 10) % (channel + 2)) == 0;
+            sample.values[channel] = missing ? TimeSeriesBlock::MissingValue : (int32_t) (index - (100 * channel));
+        }
+        trace.push_back(sample);
+    }
+    Check(RoundTrip(trace, 6, blocks), "channels switching to and from MissingValue");
+    for (size_t index = 0; index < trace.size(); index++)
+    {
+        for (uint8_t channel = 0; channel < 6; channel++)
+        {
+            trace[index].values[channel] = TimeSeriesBlock::MissingValue;
+        }
+    }
+    Check(RoundTrip(trace, 6, blocks), "every value missing");
+    //
+    //  Extreme values and intervals, each one needs the 32 bit escape.
+    //
+    static const int32_t extremes[] = { 0x7fffffff, (int32_t) 0x80000000, 0, (int32_t) 0x80000001, -1, 0x7ffffffe, 123456789, -123456789 };
+    const int numberOfExtremes = sizeof(extremes) / sizeof(extremes[0]);
+    trace.clear();
+    sample.timestamp = 0;
+    for (int index = 0; index < 64; index++)
+    {
+        sample.timestamp += (index & 1) ? 1 : 0x7fff0000UL;
+        for (uint8_t channel = 0; channel < 3; channel++)
+        {
+            sample.values[channel] = extremes[(index * (channel + 1)) % numberOfExtremes];
+        }
+        trace.push_back(sample);
+    }
+    Check(RoundTrip(trace, 3, blocks) && (blocks > 1), "values and intervals needing the 32 bit escape");
+    //
+    //  Timestamps wrapping past 0xffffffff, a regular interval and then an
+    //  irregular one.
+    //
+    trace.clear();
+    sample.timestamp = 0xffffffffUL - (30 * 60);
+    memset(sample.values, 0, sizeof(sample.values));
+    for (int index = 0; index < 60; index++)
+    {
+        sample.timestamp += 60;
+        sample.values[0] = index;
+        trace.push_back(sample);
+    }
+    Check(RoundTrip(trace, 1, blocks), "timestamps wrapping at a regular interval");
+    trace.clear();
+    sample.timestamp = 0xfffffff0UL;
+    for (int index = 0; index < 60; index++)
+    {
+        sample.timestamp += (uint32_t) (index * 7) % 23;
+        sample.values[0] = -index;
+        trace.push_back(sample);
+    }
+    Check(RoundTrip(trace, 1, blocks), "timestamps wrapping at irregular intervals");
+    //
+    //  The maximum number of channels with random walks of mixed step sizes,
+    //  using every code, over many blocks.
+    //
+    static const uint32_t steps[] = { 1, 8, 128, 4096, 0xffffffffUL };
+    trace.clear();
+    sample.timestamp = 1000;
+    memset(sample.values, 0, sizeof(sample.values));
+    for (int index = 0; index < 5000; index++)
+    {
+        sample.timestamp += 55 + (Random() % 11);
+        for (uint8_t channel = 0; channel < TimeSeriesBlock::MaximumChannels; channel++)
+        {
+            uint32_t step = steps[Random() % (sizeof(steps) / sizeof(steps[0]))];
+            uint32_t change = (step == 0xffffffffUL) ? Random() : (Random() % step) - (step / 2);
+            sample.values[channel] = (int32_t) ((uint32_t) sample.values[channel] + change);
+        }
+        trace.push_back(sample);
+    }
+    Check(RoundTrip(trace, TimeSeriesBlock::MaximumChannels, blocks) && (blocks > 100), "random walks on the maximum number of channels");
+    //
+    //  A full block is left as it was, samples needing fewer bits can still be
+    //  added to it and a block cut short stops at the last complete sample.
+    //
+    uint8_t buffer[BLOCK_SIZE];
+    TimeSeriesBlock block(buffer, sizeof(buffer));
+    block.Begin(TimeSeriesBlock::MaximumChannels);
+    size_t added = 0;
+    while (block.Append(trace[added].timestamp, trace[added].values))
+    {
+        added++;
+    }
+    size_t length = block.Length();
+    Check(!block.Append(trace[0].timestamp, trace[0].values) && (block.Length() == length) &&
+          Matches(block, trace, 0, (uint16_t) added, TimeSeriesBlock::MaximumChannels), "full block is unchanged by a failed append");
+    std::vector<Sample> repeated(trace.begin(), trace.begin() + added);
+    uint32_t period = trace[added - 1].timestamp - trace[added - 2].timestamp;
+    sample = trace[added - 1];
+    sample.timestamp += period;
+    while (block.Append(sample.timestamp, sample.values))
+    {
+        repeated.push_back(sample);
+        sample.timestamp += period;
+    }
+    Check((repeated.size() > added) && Matches(block, repeated, 0, (uint16_t) repeated.size(), TimeSeriesBlock::MaximumChannels),
+          "smaller samples added after a failed append");
+    added = repeated.size();
+    length = block.Length();
+    TimeSeriesBlock truncated(buffer, sizeof(buffer));
+    truncated.Open(length - 1);
+    uint16_t read = 0;
+    while (truncated.ReadNext(sample.timestamp, sample.values))
+    {
+        read++;
+    }
+    Check(read == (added - 1), "truncated block stops at the last complete sample");
+    buffer[0] = TimeSeriesBlock::Version + 1;
+    Check(!truncated.Open(length), "block with an unknown version is rejected");
+    printf("%d check(s) failed.\n", _failures);
+    return((_failures == 0) ? 0 : 1);
+}
@@ -0,0 +1,82 @@
+//
+//  Convert a file of binary telemetry frames (a station archive or a copy
+//  of the flash log) to CSV.
+//
+//  Usage: DecodeTelemetry [frame file]
+//
+//  Reads standard input if no file is given.  Bytes which do not start a
+//  valid frame are skipped until the next valid frame is found.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <stdio.h>
+#include <vector>
+#include "TelemetryFrame.h"
+
+int main(int argc, char **argv)
+{
+    FILE *file = (argc > 1) ? fopen(argv[1], "rb") : stdin;
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return(1);
+    }
+    std::vector<uint8_t> frames;
+    uint8_t block[4096];
+    size_t amountRead;
+    while ((amountRead = fread(block, 1, sizeof(block), file)) > 0)
+    {
+        frames.insert(frames.end(), block, block + amountRead);
+    }
+    if (file != stdin)
+    {
+        fclose(file);
+    }
+
+    char buffer[512];
+    TelemetrySerializer record(buffer, sizeof(buffer));
+    TelemetrySerializer::Sample sample;
+    uint32_t sequence;
+    size_t offset = 0;
+    size_t skipped = 0;
+    unsigned int decoded = 0;
+    record.BeginBatch(TelemetrySerializer::CSV);
+    fputs(record.GetBuffer(), stdout);
+    while (offset < frames.size())
+    {
+        size_t length = TelemetryFrame::Decode(frames.data() + offset, frames.size() - offset, sample, sequence);
+        if (length == 0)
+        {
+            offset++;
+            skipped++;
+            continue;
+        }
+        record.Begin(TelemetrySerializer::CSV);
+        record.AddRecord(sequence, sample);
+        fputs(record.GetBuffer(), stdout);
+        offset += length;
+        decoded++;
+    }
+    fprintf(stderr, "%u readings decoded, %u bytes skipped\n", decoded, (unsigned int) skipped);
+    return(0);
+}
@@ -0,0 +1,152 @@
+//
+//  Host (Linux) driver for the weather station application.
+//
+//  Runs setup() and then loop() against the simulated hardware for the number
+//  of (virtual) minutes given on the command line.  The application source is
+//  compiled unchanged.
+//
+//  Usage: WeatherStationHost [minutes] [number of ground temperature probes]
+//                            [lux] [wind direction noise] [rain tips per hour]
+//                            [minute network goes down] [minute network returns]
+//                            [telemetry archive file]
+//
+//  Binary batches posted to the collection server are decoded and the
+//  frames appended to the archive file (read it with DecodeTelemetry).
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <algorithm>
+#include "Simulator.h"
+#include "WeatherStation.ino"
+
+//
+//  Virtual time taken by one pass through loop().
+//
+#define LOOP_PERIOD     1000
+
+//
+//  Collection server state, the number of readings decoded from binary
+//  batches and the file the frames are archived to (if any).
+//
+uint32_t _framesStored = 0;
+FILE *_archive = NULL;
+
+//
+//  Collection server, binary batches are decoded with the same frame code
+//  the station uses and the frames are appended to the archive.  Everything
+//  else is handled by the default (Phant) server.
+//
+std::string CollectionServer(const std::string &request, int &status)
+{
+    size_t body = request.find("\r\n\r\n");
+    if ((request.compare(0, 5, "POST ") != 0) || (request.find("application/octet-stream") > body))
+    {
+        return(Simulator::DefaultRequestHandler(request, status));
+    }
+    const uint8_t *frames = (const uint8_t *) request.data();
+    size_t offset = body + 4;
+    uint32_t limit = Simulator::Network().batchAcceptLimit;
+    uint32_t count = 0;
+    uint32_t stored = 0;
+    while ((offset < request.size()) && ((limit == 0) || (count < limit)))
+    {
+        TelemetrySerializer::Sample sample;
+        uint32_t sequence;
+        size_t length = TelemetryFrame::Decode(frames + offset, request.size() - offset, sample, sequence);
+        if (length == 0)
+        {
+            printf("Collection server: invalid frame at offset %u\n", (unsigned int) (offset - body - 4));
+            break;
+        }
+        if (_archive != NULL)
+        {
+            fwrite(frames + offset, 1, length, _archive);
+        }
+        stored = sequence;
+        offset += length;
+        count++;
+    }
+    _framesStored += count;
+    status = 200;
+    char response[16];
+    snprintf(response, sizeof(response), "%u\n", (unsigned int) stored);
+    return(response);
+}
+
+int main(int argc, char **argv)
+{
+    int minutes = (argc > 1) ? atoi(argv[1]) : 10;
+    int probes = (argc > 2) ? atoi(argv[2]) : 1;
+
+    Simulator::Initialise(probes);
+    if (argc > 3)
+    {
+        Simulator::Environment().luminosity = atof(argv[3]);
+    }
+    if (argc > 4)
+    {
+        Simulator::Environment().windDirectionNoise = atoi(argv[4]);
+    }
+    if (argc > 5)
+    {
+        Simulator::Environment().rainTipsPerHour = atof(argv[5]);
+    }
+    Simulator::SetPulseSource(PIN_WIND_SPEED, &Simulator::Environment().windSpeedPulsesPerSecond);
+    Simulator::SetPulseSource(PIN_PLUVIOMETER, &Simulator::Environment().rainTipsPerHour, 1.0 / 3600);
+    int offlineStart = (argc > 6) ? atoi(argv[6]) : -1;
+    int offlineEnd = (argc > 7) ? atoi(argv[7]) : -1;
+    if (argc > 8)
+    {
+        _archive = fopen(argv[8], "ab");
+        if (_archive == NULL)
+        {
+            perror(argv[8]);
+            return(1);
+        }
+    }
+    Simulator::Network().handler = CollectionServer;
+    setup();
+    uint64_t start = Simulator::Micros();
+    uint64_t end = start + ((uint64_t) minutes * 60 * 1000000);
+    uint64_t longestLoop = 0;
+    while (Simulator::Micros() < end)
+    {
+        int minute = (int) ((Simulator::Micros() - start) / 60000000);
+        Simulator::Network().online = (minute < offlineStart) || (minute >= offlineEnd);
+        uint64_t loopStart = Simulator::Micros();
+        loop();
+        longestLoop = std::max(longestLoop, Simulator::Micros() - loopStart);
+        Simulator::Advance(LOOP_PERIOD);
+    }
+    SimulatedNetwork &network = Simulator::Network();
+    printf("Network: %u connections, %u requests, %u bytes sent, %u bytes received\n",
+           network.connections, network.requests, network.bytesSent, network.bytesReceived);
+    printf("MQTT: %u publishes, %u duplicates\n", network.brokerPublishes, network.brokerDuplicates);
+    printf("Collection server: %u binary readings stored\n", _framesStored);
+    printf("Longest pass through loop(): %lu us\n", (unsigned long) longestLoop);
+    if (_archive != NULL)
+    {
+        fclose(_archive);
+    }
+    return(0);
+}
@@ -0,0 +1,187 @@
+//
+//  Host (Linux) implementation of the parts of the Arduino / ESP8266 core used
+//  by the weather station.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+//
+//  Basic types and constants.
+//
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH                0x1
+#define LOW                 0x0
+#define INPUT               0x00
+#define OUTPUT              0x01
+#define INPUT_PULLUP        0x02
+#define RISING              0x01
+#define FALLING             0x02
+#define CHANGE              0x03
+#define A0                  17
+
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define pgm_read_byte(address)      (*(const uint8_t *) (address))
+#define pgm_read_word(address)      (*(const uint16_t *) (address))
+#define pgm_read_dword(address)     (*(const uint32_t *) (address))
+#define pgm_read_float(address)     (*(const float *) (address))
+#define pgm_read_ptr(address)       (*(void * const *) (address))
+#define digitalPinToInterrupt(pin)  (pin)
+
+//
+//  Non-standard conversions provided by the ESP8266 C library.
+//
+char *itoa(int, char *, int);
+char *ltoa(long, char *, int);
+char *utoa(unsigned int, char *, int);
+char *ultoa(unsigned long, char *, int);
+
+//
+//  Arduino String class, a thin wrapper around std::string.
+//
+class String
+{
+    public:
+        String();
+        String(const String &);
+        String(const char *);
+        String(const std::string &);
+        String(char);
+        explicit String(int, unsigned char base = 10);
+        explicit String(unsigned int, unsigned char base = 10);
+        explicit String(long, unsigned char base = 10);
+        explicit String(unsigned long, unsigned char base = 10);
+        explicit String(float, unsigned char decimalPlaces = 2);
+        explicit String(double, unsigned char decimalPlaces = 2);
+        String &operator=(const String &);
+        String &operator+=(const String &);
+        String &operator+=(const char *);
+        String &operator+=(char);
+        char operator[](unsigned int) const;
+        char &operator[](unsigned int);
+        bool operator==(const String &) const;
+        bool operator==(const char *) const;
+        bool operator!=(const String &rhs) const { return(!(*this == rhs)); }
+        const char *c_str() const;
+        unsigned int length() const;
+        bool reserve(unsigned int);
+        int indexOf(char, unsigned int from = 0) const;
+        int indexOf(const char *, unsigned int from = 0) const;
+        String substring(unsigned int, unsigned int) const;
+        String substring(unsigned int) const;
+        long toInt() const;
+        bool startsWith(const char *) const;
+        //
+        //  Host only, number of bytes copied by String operations including
+        //  the copies made when the buffer grows (benchmarks).
+        //
+        static size_t BytesCopied();
+        static void ResetBytesCopied();
+
+    private:
+        std::string _buffer;
+        static size_t _bytesCopied;
+        void Append(const char *, size_t);
+};
+
+String operator+(const String &, const String &);
+String operator+(const String &, const char *);
+String operator+(const char *, const String &);
+String operator+(const String &, char);
+
+//
+//  Serial port, output goes to stdout and may be turned off for benchmarks.
+//
+class HardwareSerial
+{
+    public:
+        void begin(unsigned long);
+        void print(const String &);
+        void print(const char *);
+        void print(int, int base = 10);
+        void println();
+        void println(const String &);
+        void println(const char *);
+        void println(int, int base = 10);
+        int printf(const char *, ...) __attribute__ ((format (printf, 2, 3)));
+        void flush();
+        void SetOutputEnabled(bool);
+
+    private:
+        bool _outputEnabled = true;
+};
+
+extern HardwareSerial Serial;
+
+//
+//  Timing, the host uses a virtual clock (see Simulator.h).
+//
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long);
+void delayMicroseconds(unsigned int);
+void yield();
+
+//
+//  GPIO, analog input and interrupts.
+//
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+int analogRead(uint8_t);
+void attachInterrupt(uint8_t, void (*)(), int);
+void detachInterrupt(uint8_t);
+void noInterrupts();
+void interrupts();
+
+//
+//  ESP8266 specific functions.
+//
+#define SPI_FLASH_SEC_SIZE  4096
+
+class EspClass
+{
+    public:
+        uint32_t getFreeHeap();
+        uint32_t getChipId();
+        uint32_t getFlashChipRealSize();
+        bool flashEraseSector(uint32_t);
+        bool flashWrite(uint32_t, uint32_t *, size_t);
+        bool flashRead(uint32_t, uint32_t *, size_t);
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,62 @@
+//
+//  Host (Linux) implementation of the ESP8266HTTPClient library API.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _HOST_ESP8266HTTPCLIENT_H_
+#define _HOST_ESP8266HTTPCLIENT_H_
+
+#include "ESP8266WiFi.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+class HTTPClient
+{
+    public:
+        HTTPClient();
+        ~HTTPClient();
+        void begin(String);
+        void begin(String, uint16_t, String);
+        void setReuse(bool);
+        void addHeader(const String &, const String &);
+        int GET();
+        int POST(String);
+        int POST(uint8_t *, size_t);
+        String getString();
+        void end();
+
+    private:
+        String _host;
+        uint16_t _port;
+        String _uri;
+        String _headers;
+        String _response;
+        bool _reuse;
+        WiFiClient _client;
+        int SendRequest(const char *, const uint8_t *, size_t);
+};
+
+#endif
@@ -0,0 +1,110 @@
+//
+//  Host (Linux) implementation of the parts of the ESP8266WiFi library used by
+//  the weather station.  Connections are made to the simulated network.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _HOST_ESP8266WIFI_H_
+#define _HOST_ESP8266WIFI_H_
+
+#include <string>
+#include "Arduino.h"
+
+#define WL_IDLE_STATUS      0
+#define WL_CONNECTED        3
+#define WL_DISCONNECTED     6
+
+class IPAddress
+{
+    public:
+        IPAddress();
+        IPAddress(uint8_t, uint8_t, uint8_t, uint8_t);
+        String toString() const;
+        operator uint32_t() const { return(_address); }
+
+    private:
+        uint32_t _address;
+};
+
+//
+//  Arduino Client interface.
+//
+class Client
+{
+    public:
+        virtual ~Client() {}
+        virtual int connect(IPAddress, uint16_t) = 0;
+        virtual int connect(const char *, uint16_t) = 0;
+        virtual size_t write(uint8_t) = 0;
+        virtual size_t write(const uint8_t *, size_t) = 0;
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int read(uint8_t *, size_t) = 0;
+        virtual int peek() = 0;
+        virtual void flush() = 0;
+        virtual void stop() = 0;
+        virtual uint8_t connected() = 0;
+};
+
+//
+//  TCP client connected to one of the simulated servers.
+//
+class WiFiClient : public Client
+{
+    public:
+        WiFiClient();
+        ~WiFiClient();
+        int connect(IPAddress, uint16_t);
+        int connect(const char *, uint16_t);
+        size_t write(uint8_t);
+        size_t write(const uint8_t *, size_t);
+        size_t print(const char *);
+        int available();
+        int read();
+        int read(uint8_t *, size_t);
+        int peek();
+        void flush();
+        void stop();
+        uint8_t connected();
+        void setTimeout(unsigned long);
+        void setNoDelay(bool);
+
+    private:
+        int _connection;
+        unsigned long _timeout;
+};
+
+class ESP8266WiFiClass
+{
+    public:
+        int begin();
+        int begin(const char *, const char *);
+        int status();
+        IPAddress localIP();
+        int hostByName(const char *, IPAddress &);
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,61 @@
+//
+//  Host (Linux) implementation of the OneWire library.  The bus is populated
+//  with the simulated DS18x20 probes held by the simulator.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _HOST_ONEWIRE_H_
+#define _HOST_ONEWIRE_H_
+
+#include "Arduino.h"
+
+class OneWire
+{
+    public:
+        OneWire(uint8_t);
+        uint8_t reset();
+        void select(const uint8_t rom[8]);
+        void skip();
+        void write(uint8_t, uint8_t power = 0);
+        void write_bytes(const uint8_t *, uint16_t, bool power = 0);
+        uint8_t read();
+        void read_bytes(uint8_t *, uint16_t);
+        void write_bit(uint8_t);
+        uint8_t read_bit();
+        void depower();
+        void reset_search();
+        uint8_t search(uint8_t *, bool search_mode = true);
+        static uint8_t crc8(const uint8_t *, uint8_t);
+
+    private:
+        enum BusState { Idle, RomCommand, AwaitingFunctionCommand, ReadScratchpad, WriteScratchpad, Converting, ReadPowerSupply };
+        uint8_t _pin;
+        BusState _state = Idle;
+        uint32_t _selected = 0;
+        uint8_t _dataIndex = 0;
+        int _searchIndex = 0;
+        void FunctionCommand(uint8_t);
+};
+
+#endif
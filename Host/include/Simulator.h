@@ -0,0 +1,324 @@
+//
+//  Simulated hardware for the host (Linux) build of the weather station.
+//
+//  The simulator provides a virtual clock and models of the devices attached
+//  to the Oak (BME280, TSL2561, DS18x20 probes, DS3231 and the STM8S).  Each
+//  I2C device is modelled at the register level so the code under test talks
+//  to it through exactly the same Wire transactions it uses on the hardware.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _SIMULATOR_H_
+#define _SIMULATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <string>
+
+//
+//  Conditions seen by the simulated sensors.
+//
+struct SimulatedEnvironment
+{
+    float airTemperature = 15.0;            // Degrees C.
+    float humidity = 65.0;                  // Percent.
+    float airPressure = 101325.0;           // Pa.
+    float luminosity = 500.0;               // Lux.
+    float groundTemperature[8] = { 10.0, 10.5, 11.0, 11.5, 12.0, 12.0, 12.0, 12.0 };
+    uint16_t windDirectionADC = 780;        // Raw ADC reading from the vane.
+    uint16_t windDirectionNoise = 0;        // +/- noise added to each ADC reading.
+    uint16_t ultravioletADC = 320;          // Raw ADC reading from the UV sensor.
+    float windSpeedPulsesPerSecond = 2.0;   // Anemometer pulse rate.
+    float rainTipsPerHour = 0.0;            // Tipping bucket rate.
+};
+
+//
+//  Behaviour of the simulated network and the HTTP server the station posts
+//  its readings to.  The handler (if set) generates the response body and
+//  status code for each request, otherwise Simulator::DefaultRequestHandler
+//  is used.  Responses have a Content-Length unless the status is 204 or
+//  304 (no body) or chunkedResponses is set, interimResponses sends a
+//  100 Continue before each response.  Connections to brokerPort go to a
+//  simple MQTT broker which acknowledges QoS 1 publishes.
+//
+struct SimulatedNetwork
+{
+    typedef std::string (*RequestHandler)(const std::string &, int &);
+    bool online = true;
+    uint32_t connectTime = 150000;          // TCP handshake (microseconds).
+    uint32_t responseTime = 200000;         // Server think time (microseconds).
+    uint32_t keepAliveTimeout = 15000000;   // Idle time before the server closes.
+    uint32_t keepAliveRequests = 100;       // Requests per connection.
+    uint32_t batchAcceptLimit = 0;          // Readings stored per batch (0 = all).
+    bool chunkedResponses = false;
+    bool interimResponses = false;
+    uint32_t connections = 0;
+    uint32_t requests = 0;
+    uint32_t bytesSent = 0;
+    uint32_t bytesReceived = 0;
+    std::string lastRequest;
+    uint16_t brokerPort = 1883;
+    uint32_t brokerPublishes = 0;           // PUBLISH packets received.
+    uint32_t brokerDuplicates = 0;          // PUBLISH packets with the DUP flag.
+    std::string lastTopic;
+    std::string lastPayload;
+    RequestHandler handler = NULL;
+};
+
+//
+//  An I2C device attached to the simulated bus.
+//
+class SimulatedI2CDevice
+{
+    public:
+        virtual ~SimulatedI2CDevice() {}
+        virtual void Write(const uint8_t *, size_t) = 0;
+        virtual size_t Read(uint8_t *, size_t) = 0;
+};
+
+//
+//  Device with a register pointer which auto-increments on each access.
+//  The first byte of a write sets the register pointer.
+//
+class SimulatedRegisterDevice : public SimulatedI2CDevice
+{
+    public:
+        void Write(const uint8_t *, size_t);
+        size_t Read(uint8_t *, size_t);
+
+    protected:
+        uint8_t _pointer = 0;
+        virtual uint8_t ReadRegister(uint8_t) = 0;
+        virtual void WriteRegister(uint8_t, uint8_t) = 0;
+};
+
+//
+//  Bosch BME280 temperature, humidity and pressure sensor.
+//
+class SimulatedBME280 : public SimulatedRegisterDevice
+{
+    public:
+        SimulatedBME280();
+        //
+        //  Bosch reference compensation, shared with the host BME280 library.
+        //
+        static int32_t CompensateTemperature(const uint8_t *, int32_t, int32_t &);
+        static uint32_t CompensatePressure(const uint8_t *, int32_t, int32_t);
+        static uint32_t CompensateHumidity(const uint8_t *, int32_t, int32_t);
+
+    protected:
+        uint8_t ReadRegister(uint8_t);
+        void WriteRegister(uint8_t, uint8_t);
+
+    private:
+        uint8_t _registers[256];
+        uint64_t _measurementComplete = 0;
+        bool _measurementPending = false;
+        void StartMeasurement();
+        void LatchMeasurement();
+};
+
+//
+//  TAOS TSL2561 luminosity sensor.
+//
+class SimulatedTSL2561 : public SimulatedI2CDevice
+{
+    public:
+        void Write(const uint8_t *, size_t);
+        size_t Read(uint8_t *, size_t);
+
+    private:
+        uint8_t _command = 0;
+        uint8_t _control = 0;
+        uint8_t _timing = 0x02;
+        uint64_t _integrationStart = 0;
+        uint16_t _channel0 = 0;
+        uint16_t _channel1 = 0;
+        uint8_t ReadRegister(uint8_t);
+        void UpdateChannels();
+        uint32_t IntegrationTime();
+};
+
+//
+//  Maxim DS3231 real time clock, time is derived from the virtual clock.
+//
+class SimulatedDS3231 : public SimulatedRegisterDevice
+{
+    protected:
+        uint8_t ReadRegister(uint8_t);
+        void WriteRegister(uint8_t, uint8_t);
+
+    private:
+        uint8_t _registers[0x13] = { 0 };
+        int64_t _offset = 0;
+};
+
+//
+//  STM8S sensor co-processor using the command protocol in STM8SCode/main.cpp.
+//
+//  The RTC alarm fires every AlarmPeriod seconds, each alarm starts a two
+//  second reading which is added to the history when it completes.  The
+//  newest reading is published in the register map.  The simulated wind is
+//  steady so the mean and minimum anemometer periods are the same, and the
+//  simulated reed switches do not bounce so the debounce windows are only
+//  stored.  CorruptNextRead flips a bit in the last byte of the next read to
+//  exercise the CRC checks.
+//
+class SimulatedSTM8S : public SimulatedI2CDevice
+{
+    public:
+        static const uint8_t HistoryLength = 24;
+        static const uint8_t HistoryRecordSize = 11;
+        static const uint8_t HistoryHeaderSize = 9;
+        static const uint32_t AlarmPeriod = 60;
+        static const uint8_t SampleLength = 23;
+        void Write(const uint8_t *, size_t);
+        size_t Read(uint8_t *, size_t);
+        void RTCAlarm();
+        void CorruptNextRead();
+        static uint8_t Crc8(const uint8_t *, size_t);
+
+    private:
+        struct HistoryRecord
+        {
+            uint16_t alarm;
+            uint32_t rainfall;
+            uint16_t rainfallDelta;     // Pulses since the previous record.
+            uint16_t windSpeed;
+            uint16_t windDirection;
+            uint16_t ultraviolet;
+            uint32_t windPeriod;        // Mean and minimum period (uS).
+        };
+        uint8_t _txBuffer[HistoryHeaderSize + (HistoryLength * HistoryRecordSize) + 1];
+        size_t _amountToSend = 0;
+        uint8_t _resetCode = 0;
+        uint32_t _rainGaugePulseCount = 0;
+        uint64_t _dataReadyTime = 0;
+        bool _readingStarted = false;
+        HistoryRecord _history[HistoryLength] = {};
+        uint32_t _historyAdded = 0;
+        uint32_t _historyRainfall = 0;  // Total of the newest record, rebased on reset.
+        uint8_t _historyCount = 0;
+        uint16_t _alarmCount = 0;
+        uint64_t _nextAlarm = AlarmPeriod * 1000000ULL;
+        double _rainfall = 0;
+        uint8_t _registerPointer = 0;
+        bool _sendingRegisters = false;
+        bool _corruptNextRead = false;
+        uint8_t _debounceWindow[2] = { 50, 5 };
+        bool DataReady();
+        uint8_t ReadRegister(uint8_t);
+        static uint8_t *PutShort(uint8_t *, uint16_t);
+        static uint8_t *PutLong(uint8_t *, uint32_t);
+        void UpdateHistory();
+        static uint16_t Sequence(uint32_t);
+        void PrepareHistoryResponse(uint16_t, uint8_t);
+};
+
+//
+//  A DS18B20 / DS18S20 temperature probe on the OneWire bus.
+//
+struct SimulatedDS18x20
+{
+    uint8_t rom[8];
+    uint8_t scratchpad[9];
+    uint8_t eeprom[3];
+    bool parasitePower;
+    bool corruptNextRead;
+    uint64_t conversionComplete;
+    int probe;
+};
+
+//
+//  Main simulator interface.
+//
+class Simulator
+{
+    public:
+        typedef void (*EventHandler)();
+        //
+        //  Set up the default set of devices.
+        //
+        static void Initialise(int numberOfProbes = 1);
+        //
+        //  Virtual clock.
+        //
+        static uint64_t Micros();
+        static void Advance(uint64_t);
+        static void SetTimeCost(uint32_t yieldCost);
+        static uint32_t YieldCost();
+        //
+        //  Periodic events (tickers) and pulse sources (interrupt pins).
+        //
+        static int AddPeriodicEvent(uint64_t, EventHandler);
+        static void RemovePeriodicEvent(int);
+        static void AttachInterrupt(uint8_t, EventHandler);
+        static void DetachInterrupt(uint8_t);
+        static void SetPulseSource(uint8_t, float *, float scale = 1.0);
+        //
+        //  Devices.
+        //
+        static SimulatedEnvironment &Environment();
+        static void AttachI2CDevice(uint8_t, SimulatedI2CDevice *);
+        static SimulatedI2CDevice *I2CDevice(uint8_t);
+        static SimulatedSTM8S &STM8S();
+        static int NumberOfProbes();
+        static SimulatedDS18x20 &Probe(int);
+        static void AddProbe(uint8_t family, bool parasitePower);
+        static uint16_t AnalogRead(uint8_t);
+        //
+        //  SPI flash (NOR semantics, erased to 0xff, writes can only clear bits).
+        //
+        static const uint32_t FlashSize = 4 * 1024 * 1024;
+        static const uint32_t FlashSectorSize = 4096;
+        static bool FlashEraseSector(uint32_t);
+        static bool FlashWrite(uint32_t, const uint32_t *, size_t);
+        static bool FlashRead(uint32_t, uint32_t *, size_t);
+        static uint32_t FlashSectorEraseCount(uint32_t);
+        static uint32_t FlashBytesWritten();
+        //
+        //  Network.
+        //
+        static SimulatedNetwork &Network();
+        static int Connect(const char *, uint16_t);
+        static size_t Send(int, const uint8_t *, size_t);
+        static int Available(int);
+        static int Receive(int, uint8_t *, size_t);
+        static int Peek(int);
+        static bool Connected(int);
+        static void Close(int);
+        static std::string DefaultRequestHandler(const std::string &, int &);
+        //
+        //  Bus statistics.
+        //
+        static uint32_t I2CBytesTransferred();
+        static uint32_t OneWireBytesTransferred();
+        static uint32_t I2CRepeatedStarts();
+        static void CountI2CBytes(size_t);
+        static void CountI2CRepeatedStart();
+        static void CountOneWireBytes(size_t);
+        static void ResetStatistics();
+};
+
+#endif
@@ -0,0 +1,63 @@
+//
+//  Host (Linux) implementation of the SparkFun TSL2561 library API.  The
+//  sensor is accessed over the simulated I2C bus.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _HOST_SPARKFUNTSL2561_H_
+#define _HOST_SPARKFUNTSL2561_H_
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define TSL2561_ADDR_0      0x29
+#define TSL2561_ADDR        0x39
+#define TSL2561_ADDR_1      0x49
+
+class SFE_TSL2561
+{
+    public:
+        SFE_TSL2561();
+        boolean begin();
+        boolean begin(char);
+        boolean setPowerUp();
+        boolean setPowerDown();
+        boolean setTiming(boolean, unsigned char);
+        boolean setTiming(boolean, unsigned char, unsigned int &);
+        boolean manualStart();
+        boolean manualStop();
+        boolean getData(unsigned int &, unsigned int &);
+        boolean getLux(unsigned char, unsigned int, unsigned int, unsigned int, double &);
+        boolean getID(unsigned char &);
+        byte getError();
+
+    private:
+        char _i2c_address;
+        byte _error;
+        boolean readByte(unsigned char, unsigned char &);
+        boolean writeByte(unsigned char, unsigned char);
+        boolean readUInt(unsigned char, unsigned int &);
+};
+
+#endif
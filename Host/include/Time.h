@@ -0,0 +1,59 @@
+//
+//  Host (Linux) implementation of the Arduino Time library.  The system time
+//  runs from the virtual clock.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _HOST_TIME_H_
+#define _HOST_TIME_H_
+
+#include <time.h>
+#include "Arduino.h"
+
+#define SECS_PER_MIN            ((time_t) (60UL))
+#define SECS_PER_HOUR           ((time_t) (3600UL))
+#define SECS_PER_DAY            ((time_t) (SECS_PER_HOUR * 24UL))
+#define elapsedDays(_time_)     ((_time_) / SECS_PER_DAY)
+
+typedef enum { timeNotSet, timeNeedsSync, timeSet } timeStatus_t;
+
+time_t now();
+void setTime(time_t);
+timeStatus_t timeStatus();
+int hour();
+int hour(time_t);
+int minute();
+int minute(time_t);
+int second();
+int second(time_t);
+int day();
+int day(time_t);
+int weekday();
+int weekday(time_t);
+int month();
+int month(time_t);
+int year();
+int year(time_t);
+
+#endif
@@ -0,0 +1,4 @@
+//
+//  Newer versions of the Time library use TimeLib.h.
+//
+#include "Time.h"
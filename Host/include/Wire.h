@@ -0,0 +1,68 @@
+//
+//  Host (Linux) implementation of the Arduino Wire (I2C) library.  Transactions
+//  are routed to the simulated devices on the I2C bus.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef _HOST_WIRE_H_
+#define _HOST_WIRE_H_
+
+#include "Arduino.h"
+
+//
+//  The ESP8266 Wire library uses 32 byte transmit and receive buffers.
+//
+#define BUFFER_LENGTH   32
+
+class TwoWire
+{
+    public:
+        void begin();
+        void begin(int, int);
+        void setClock(uint32_t);
+        void beginTransmission(uint8_t);
+        void beginTransmission(int address) { beginTransmission((uint8_t) address); }
+        uint8_t endTransmission();
+        uint8_t endTransmission(uint8_t);
+        uint8_t requestFrom(uint8_t, uint8_t);
+        uint8_t requestFrom(uint8_t, uint8_t, uint8_t);
+        uint8_t requestFrom(int address, int quantity) { return(requestFrom((uint8_t) address, (uint8_t) quantity)); }
+        size_t write(uint8_t);
+        size_t write(const uint8_t *, size_t);
+        int available();
+        int read();
+        int peek();
+
+    private:
+        uint8_t _address = 0;
+        uint8_t _txBuffer[BUFFER_LENGTH];
+        size_t _txLength = 0;
+        uint8_t _rxBuffer[BUFFER_LENGTH];
+        size_t _rxLength = 0;
+        size_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
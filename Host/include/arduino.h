@@ -0,0 +1,5 @@
+//
+//  Lower case alias for Arduino.h, some of the source files use this name
+//  and the host file system is case sensitive.
+//
+#include "Arduino.h"
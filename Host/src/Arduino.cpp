@@ -0,0 +1,519 @@
+//
+//  Host (Linux) implementation of the parts of the Arduino / ESP8266 core used
+//  by the weather station.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <stdarg.h>
+#include <algorithm>
+#include "Arduino.h"
+#include "Simulator.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+//******************************************************************************
+//
+//  Number conversion.
+//
+
+//
+//  Convert an unsigned value to text in the given radix.
+//
+static char *UnsignedToAscii(unsigned long value, char *buffer, int radix, bool negative)
+{
+    char digits[sizeof(unsigned long) * 8 + 1];
+    int length = 0;
+    char *result = buffer;
+
+    do
+    {
+        int digit = value % radix;
+        digits[length++] = (char) ((digit < 10) ? ('0' + digit) : ('a' + digit - 10));
+        value /= radix;
+    }
+    while (value != 0);
+    if (negative)
+    {
+        *buffer++ = '-';
+    }
+    while (length > 0)
+    {
+        *buffer++ = digits[--length];
+    }
+    *buffer = '\0';
+    return(result);
+}
+
+char *itoa(int value, char *buffer, int radix)
+{
+    if ((radix == 10) && (value < 0))
+    {
+        return(UnsignedToAscii(-((unsigned long) (long) value), buffer, radix, true));
+    }
+    return(UnsignedToAscii((unsigned int) value, buffer, radix, false));
+}
+
+char *ltoa(long value, char *buffer, int radix)
+{
+    if ((radix == 10) && (value < 0))
+    {
+        return(UnsignedToAscii(-((unsigned long) value), buffer, radix, true));
+    }
+    return(UnsignedToAscii((unsigned long) value, buffer, radix, false));
+}
+
+char *utoa(unsigned int value, char *buffer, int radix)
+{
+    return(UnsignedToAscii(value, buffer, radix, false));
+}
+
+char *ultoa(unsigned long value, char *buffer, int radix)
+{
+    return(UnsignedToAscii(value, buffer, radix, false));
+}
+
+//******************************************************************************
+//
+//  String.
+//
+size_t String::_bytesCopied = 0;
+
+String::String()
+{
+}
+
+String::String(const String &text) : _buffer(text._buffer)
+{
+    _bytesCopied += _buffer.size();
+}
+
+String::String(const char *text) : _buffer((text == NULL) ? "" : text)
+{
+    _bytesCopied += _buffer.size();
+}
+
+String::String(const std::string &text) : _buffer(text)
+{
+    _bytesCopied += _buffer.size();
+}
+
+String::String(char character) : _buffer(1, character)
+{
+    _bytesCopied++;
+}
+
+String::String(int value, unsigned char base)
+{
+    char buffer[40];
+    _buffer = ltoa(value, buffer, base);
+}
+
+String::String(unsigned int value, unsigned char base)
+{
+    char buffer[40];
+    _buffer = ultoa(value, buffer, base);
+}
+
+String::String(long value, unsigned char base)
+{
+    char buffer[70];
+    _buffer = ltoa(value, buffer, base);
+}
+
+String::String(unsigned long value, unsigned char base)
+{
+    char buffer[70];
+    _buffer = ultoa(value, buffer, base);
+}
+
+String::String(float value, unsigned char decimalPlaces)
+{
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    _buffer = buffer;
+}
+
+String::String(double value, unsigned char decimalPlaces)
+{
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    _buffer = buffer;
+}
+
+String &String::operator=(const String &rhs)
+{
+    if (this != &rhs)
+    {
+        _buffer = rhs._buffer;
+        _bytesCopied += _buffer.size();
+    }
+    return(*this);
+}
+
+//
+//  Append to the buffer counting the bytes moved when the buffer has to grow
+//  as well as the bytes appended.
+//
+void String::Append(const char *text, size_t length)
+{
+    if ((_buffer.size() + length) > _buffer.capacity())
+    {
+        _bytesCopied += _buffer.size();
+    }
+    _buffer.append(text, length);
+    _bytesCopied += length;
+}
+
+String &String::operator+=(const String &rhs)
+{
+    Append(rhs._buffer.data(), rhs._buffer.size());
+    return(*this);
+}
+
+String &String::operator+=(const char *rhs)
+{
+    if (rhs != NULL)
+    {
+        Append(rhs, strlen(rhs));
+    }
+    return(*this);
+}
+
+String &String::operator+=(char rhs)
+{
+    Append(&rhs, 1);
+    return(*this);
+}
+
+char String::operator[](unsigned int index) const
+{
+    return((index < _buffer.size()) ? _buffer[index] : '\0');
+}
+
+char &String::operator[](unsigned int index)
+{
+    static char dummy;
+    if (index < _buffer.size())
+    {
+        return(_buffer[index]);
+    }
+    dummy = '\0';
+    return(dummy);
+}
+
+bool String::operator==(const String &rhs) const
+{
+    return(_buffer == rhs._buffer);
+}
+
+bool String::operator==(const char *rhs) const
+{
+    return(_buffer == ((rhs == NULL) ? "" : rhs));
+}
+
+const char *String::c_str() const
+{
+    return(_buffer.c_str());
+}
+
+unsigned int String::length() const
+{
+    return((unsigned int) _buffer.size());
+}
+
+bool String::reserve(unsigned int size)
+{
+    _buffer.reserve(size);
+    return(true);
+}
+
+int String::indexOf(char character, unsigned int from) const
+{
+    size_t position = _buffer.find(character, from);
+    return((position == std::string::npos) ? -1 : (int) position);
+}
+
+int String::indexOf(const char *text, unsigned int from) const
+{
+    size_t position = _buffer.find(text, from);
+    return((position == std::string::npos) ? -1 : (int) position);
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+    {
+        std::swap(from, to);
+    }
+    if (from >= _buffer.size())
+    {
+        return(String());
+    }
+    return(String(_buffer.substr(from, to - from)));
+}
+
+String String::substring(unsigned int from) const
+{
+    return(substring(from, (unsigned int) _buffer.size()));
+}
+
+long String::toInt() const
+{
+    return(atol(_buffer.c_str()));
+}
+
+bool String::startsWith(const char *prefix) const
+{
+    return(_buffer.compare(0, strlen(prefix), prefix) == 0);
+}
+
+size_t String::BytesCopied()
+{
+    return(_bytesCopied);
+}
+
+void String::ResetBytesCopied()
+{
+    _bytesCopied = 0;
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return(result);
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return(result);
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return(result);
+}
+
+String operator+(const String &lhs, char rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return(result);
+}
+
+//******************************************************************************
+//
+//  Serial port.
+//
+void HardwareSerial::begin(unsigned long)
+{
+}
+
+void HardwareSerial::print(const String &text)
+{
+    print(text.c_str());
+}
+
+void HardwareSerial::print(const char *text)
+{
+    if (_outputEnabled)
+    {
+        fputs(text, stdout);
+    }
+}
+
+void HardwareSerial::print(int value, int base)
+{
+    char buffer[40];
+    print(itoa(value, buffer, base));
+}
+
+void HardwareSerial::println()
+{
+    print("\n");
+}
+
+void HardwareSerial::println(const String &text)
+{
+    print(text.c_str());
+    println();
+}
+
+void HardwareSerial::println(const char *text)
+{
+    print(text);
+    println();
+}
+
+void HardwareSerial::println(int value, int base)
+{
+    print(value, base);
+    println();
+}
+
+int HardwareSerial::printf(const char *format, ...)
+{
+    va_list arguments;
+    int result = 0;
+
+    if (_outputEnabled)
+    {
+        va_start(arguments, format);
+        result = vprintf(format, arguments);
+        va_end(arguments);
+    }
+    return(result);
+}
+
+void HardwareSerial::flush()
+{
+    if (_outputEnabled)
+    {
+        fflush(stdout);
+    }
+}
+
+//
+//  Host only, allow the serial output to be turned off (benchmarks etc.).
+//
+void HardwareSerial::SetOutputEnabled(bool enabled)
+{
+    _outputEnabled = enabled;
+}
+
+//******************************************************************************
+//
+//  Timing.
+//
+unsigned long millis()
+{
+    return((unsigned long) (Simulator::Micros() / 1000));
+}
+
+unsigned long micros()
+{
+    return((unsigned long) Simulator::Micros());
+}
+
+void delay(unsigned long milliseconds)
+{
+    Simulator::Advance((uint64_t) milliseconds * 1000);
+}
+
+void delayMicroseconds(unsigned int microseconds)
+{
+    Simulator::Advance(microseconds);
+}
+
+//
+//  Each pass round the ESP8266 scheduler costs a small amount of time.
+//
+void yield()
+{
+    Simulator::Advance(Simulator::YieldCost());
+}
+
+//******************************************************************************
+//
+//  GPIO.
+//
+namespace
+{
+    uint8_t _pins[32];
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    _pins[pin & 0x1f] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return(_pins[pin & 0x1f]);
+}
+
+int analogRead(uint8_t pin)
+{
+    return(Simulator::AnalogRead(pin));
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int)
+{
+    Simulator::AttachInterrupt(pin, handler);
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    Simulator::DetachInterrupt(pin);
+}
+
+void noInterrupts()
+{
+}
+
+void interrupts()
+{
+}
+
+//******************************************************************************
+//
+//  ESP8266.
+//
+uint32_t EspClass::getFreeHeap()
+{
+    return(40 * 1024);
+}
+
+uint32_t EspClass::getChipId()
+{
+    return(0x00c0ffee);
+}
+
+uint32_t EspClass::getFlashChipRealSize()
+{
+    return(Simulator::FlashSize);
+}
+
+bool EspClass::flashEraseSector(uint32_t sector)
+{
+    return(Simulator::FlashEraseSector(sector));
+}
+
+bool EspClass::flashWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+    return(Simulator::FlashWrite(offset, data, size));
+}
+
+bool EspClass::flashRead(uint32_t offset, uint32_t *data, size_t size)
+{
+    return(Simulator::FlashRead(offset, data, size));
+}
@@ -0,0 +1,160 @@
+//
+//  Host (Linux) implementation of the ESP8266HTTPClient library API.
+//
+//  Each request is sent over a WiFiClient to the simulated server.  As on the
+//  device the connection is torn down by end() unless setReuse(true) has been
+//  called.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "ESP8266HTTPClient.h"
+#include "Simulator.h"
+
+HTTPClient::HTTPClient() : _port(80), _reuse(false)
+{
+}
+
+HTTPClient::~HTTPClient()
+{
+    _client.stop();
+}
+
+void HTTPClient::begin(String url)
+{
+    String location = url;
+    int start = location.indexOf("://");
+    if (start >= 0)
+    {
+        location = location.substring(start + 3);
+    }
+    int path = location.indexOf('/');
+    String host = (path >= 0) ? location.substring(0, path) : location;
+    String uri = (path >= 0) ? location.substring(path) : String("/");
+    int colon = host.indexOf(':');
+    uint16_t port = 80;
+    if (colon >= 0)
+    {
+        port = (uint16_t) host.substring(colon + 1).toInt();
+        host = host.substring(0, colon);
+    }
+    begin(host, port, uri);
+}
+
+void HTTPClient::begin(String host, uint16_t port, String uri)
+{
+    _host = host;
+    _port = port;
+    _uri = uri;
+    _headers = "";
+    _response = "";
+}
+
+void HTTPClient::setReuse(bool reuse)
+{
+    _reuse = reuse;
+}
+
+void HTTPClient::addHeader(const String &name, const String &value)
+{
+    _headers += name + ": " + value + "\r\n";
+}
+
+int HTTPClient::GET()
+{
+    return(SendRequest("GET", NULL, 0));
+}
+
+int HTTPClient::POST(String payload)
+{
+    return(SendRequest("POST", (const uint8_t *) payload.c_str(), payload.length()));
+}
+
+int HTTPClient::POST(uint8_t *payload, size_t length)
+{
+    return(SendRequest("POST", payload, length));
+}
+
+String HTTPClient::getString()
+{
+    return(_response);
+}
+
+void HTTPClient::end()
+{
+    if (!_reuse)
+    {
+        _client.stop();
+    }
+}
+
+//
+//  Send the request and wait for the complete response.
+//
+int HTTPClient::SendRequest(const char *method, const uint8_t *payload, size_t length)
+{
+    char header[64];
+    String request;
+
+    if (!_client.connected() && !_client.connect(_host.c_str(), _port))
+    {
+        return(HTTPC_ERROR_CONNECTION_REFUSED);
+    }
+    request = String(method) + " " + _uri + " HTTP/1.1\r\nHost: " + _host + "\r\n";
+    request += "User-Agent: ESP8266HTTPClient\r\n";
+    request += _reuse ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    request += _headers;
+    if (payload != NULL)
+    {
+        snprintf(header, sizeof(header), "Content-Length: %u\r\n", (unsigned int) length);
+        request += header;
+    }
+    request += "\r\n";
+    _client.write((const uint8_t *) request.c_str(), request.length());
+    if (payload != NULL)
+    {
+        _client.write(payload, length);
+    }
+    //
+    //  Wait for the response to arrive.
+    //
+    while (_client.connected() && (_client.available() == 0))
+    {
+        delay(1);
+    }
+    std::string response;
+    uint8_t buffer[128];
+    int amount;
+    while ((amount = _client.read(buffer, sizeof(buffer))) > 0)
+    {
+        response.append((const char *) buffer, amount);
+    }
+    if (response.compare(0, 9, "HTTP/1.1 ") != 0)
+    {
+        _client.stop();
+        return(HTTPC_ERROR_CONNECTION_LOST);
+    }
+    size_t body = response.find("\r\n\r\n");
+    _response = (body == std::string::npos) ? String() : String(response.substr(body + 4));
+    return(atoi(response.c_str() + 9));
+}
@@ -0,0 +1,173 @@
+//
+//  Host (Linux) implementation of the parts of the ESP8266WiFi library used by
+//  the weather station.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "ESP8266WiFi.h"
+#include "Simulator.h"
+
+ESP8266WiFiClass WiFi;
+
+//******************************************************************************
+//
+//  IPAddress.
+//
+IPAddress::IPAddress() : _address(0)
+{
+}
+
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address(a | (b << 8) | (c << 16) | ((uint32_t) d << 24))
+{
+}
+
+String IPAddress::toString() const
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _address & 0xff, (_address >> 8) & 0xff, (_address >> 16) & 0xff, _address >> 24);
+    return(String(buffer));
+}
+
+//******************************************************************************
+//
+//  WiFiClient.
+//
+WiFiClient::WiFiClient() : _connection(-1), _timeout(5000)
+{
+}
+
+WiFiClient::~WiFiClient()
+{
+    stop();
+}
+
+int WiFiClient::connect(IPAddress address, uint16_t port)
+{
+    return(connect(address.toString().c_str(), port));
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    stop();
+    _connection = Simulator::Connect(host, port);
+    return((_connection >= 0) ? 1 : 0);
+}
+
+size_t WiFiClient::write(uint8_t data)
+{
+    return(write(&data, 1));
+}
+
+size_t WiFiClient::write(const uint8_t *data, size_t length)
+{
+    return(Simulator::Send(_connection, data, length));
+}
+
+size_t WiFiClient::print(const char *text)
+{
+    return(write((const uint8_t *) text, strlen(text)));
+}
+
+int WiFiClient::available()
+{
+    return(Simulator::Available(_connection));
+}
+
+int WiFiClient::read()
+{
+    uint8_t data;
+    return((Simulator::Receive(_connection, &data, 1) == 1) ? data : -1);
+}
+
+int WiFiClient::read(uint8_t *data, size_t length)
+{
+    return(Simulator::Receive(_connection, data, length));
+}
+
+int WiFiClient::peek()
+{
+    return(Simulator::Peek(_connection));
+}
+
+void WiFiClient::flush()
+{
+}
+
+void WiFiClient::stop()
+{
+    if (_connection >= 0)
+    {
+        Simulator::Close(_connection);
+        _connection = -1;
+    }
+}
+
+uint8_t WiFiClient::connected()
+{
+    return(Simulator::Connected(_connection) ? 1 : 0);
+}
+
+void WiFiClient::setTimeout(unsigned long timeout)
+{
+    _timeout = timeout;
+}
+
+void WiFiClient::setNoDelay(bool)
+{
+}
+
+//******************************************************************************
+//
+//  WiFi.
+//
+int ESP8266WiFiClass::begin()
+{
+    return(status());
+}
+
+int ESP8266WiFiClass::begin(const char *, const char *)
+{
+    return(status());
+}
+
+int ESP8266WiFiClass::status()
+{
+    return(Simulator::Network().online ? WL_CONNECTED : WL_DISCONNECTED);
+}
+
+IPAddress ESP8266WiFiClass::localIP()
+{
+    return(IPAddress(192, 168, 1, 50));
+}
+
+int ESP8266WiFiClass::hostByName(const char *, IPAddress &address)
+{
+    if (!Simulator::Network().online)
+    {
+        return(0);
+    }
+    Simulator::Advance(20000);
+    address = IPAddress(10, 0, 0, 1);
+    return(1);
+}
@@ -0,0 +1,57 @@
+//
+//  Host (Linux) implementation of the NtpClientLib API.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "NtpClientLib.h"
+#include "Simulator.h"
+
+//
+//  Network time at the start of the simulation (2016-06-01 00:00:00 UTC).
+//
+#define NTP_SIMULATION_EPOCH    1464739200
+
+ntpClient *ntpClient::getInstance(const char *, int)
+{
+    static ntpClient instance;
+    return(&instance);
+}
+
+bool ntpClient::setInterval(int, int)
+{
+    return(true);
+}
+
+void ntpClient::begin()
+{
+}
+
+time_t ntpClient::getTime()
+{
+    return((time_t) (NTP_SIMULATION_EPOCH + (Simulator::Micros() / 1000000)));
+}
+
+void ntpClient::stop()
+{
+}
@@ -0,0 +1,376 @@
+//
+//  Host (Linux) implementation of the OneWire library.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "OneWire.h"
+#include "Simulator.h"
+
+//
+//  Bus timings (microseconds) for standard speed OneWire.
+//
+#define ONEWIRE_RESET_TIME      960
+#define ONEWIRE_BYTE_TIME       560
+
+//
+//  DS18x20 ROM and function commands.
+//
+#define DS18X20_MATCH_ROM           0x55
+#define DS18X20_SKIP_ROM            0xcc
+#define DS18X20_CONVERT             0x44
+#define DS18X20_READ_SCRATCHPAD     0xbe
+#define DS18X20_WRITE_SCRATCHPAD    0x4e
+#define DS18X20_COPY_SCRATCHPAD     0x48
+#define DS18X20_RECALL_EEPROM       0xb8
+#define DS18X20_READ_POWER_SUPPLY   0xb4
+
+//
+//  Update the scratchpad once a conversion has completed.
+//
+static void CompleteConversion(SimulatedDS18x20 &device)
+{
+    if ((device.conversionComplete == 0) || (Simulator::Micros() < device.conversionComplete))
+    {
+        return;
+    }
+    device.conversionComplete = 0;
+    float temperature = Simulator::Environment().groundTemperature[device.probe & 0x07];
+    int16_t raw;
+    if (device.rom[0] == 0x10)
+    {
+        //
+        //  DS18S20, 9 bit reading plus count remain.
+        //
+        int countRemain = ((int) floor(temperature) * 16) + 12 - (int) floor(temperature * 16);
+        raw = (int16_t) floor(temperature * 2);
+        device.scratchpad[6] = (uint8_t) ((countRemain < 0) ? 0 : countRemain);
+        device.scratchpad[7] = 0x10;
+    }
+    else
+    {
+        static const int16_t masks[4] = { ~7, ~3, ~1, ~0 };
+        raw = (int16_t) floor(temperature * 16);
+        raw &= masks[(device.scratchpad[4] >> 5) & 0x03];
+    }
+    device.scratchpad[0] = raw & 0xff;
+    device.scratchpad[1] = (raw >> 8) & 0xff;
+    device.scratchpad[8] = OneWire::crc8(device.scratchpad, 8);
+}
+
+//
+//  Conversion time in microseconds.
+//
+static uint64_t ConversionTime(const SimulatedDS18x20 &device)
+{
+    if (device.rom[0] == 0x10)
+    {
+        return(750000);
+    }
+    return(93750 << ((device.scratchpad[4] >> 5) & 0x03));
+}
+
+OneWire::OneWire(uint8_t pin) : _pin(pin)
+{
+}
+
+//
+//  Reset the bus, returns 1 if any device responds with a presence pulse.
+//
+uint8_t OneWire::reset()
+{
+    Simulator::Advance(ONEWIRE_RESET_TIME);
+    _state = RomCommand;
+    _selected = 0;
+    return(Simulator::NumberOfProbes() > 0 ? 1 : 0);
+}
+
+//
+//  Match ROM, address a single device.
+//
+void OneWire::select(const uint8_t rom[8])
+{
+    write(DS18X20_MATCH_ROM);
+    _selected = 0;
+    for (int probe = 0; probe < Simulator::NumberOfProbes(); probe++)
+    {
+        if (memcmp(Simulator::Probe(probe).rom, rom, 8) == 0)
+        {
+            _selected |= (1 << probe);
+        }
+    }
+    Simulator::CountOneWireBytes(8);
+    Simulator::Advance(8 * ONEWIRE_BYTE_TIME);
+    _state = AwaitingFunctionCommand;
+}
+
+//
+//  Skip ROM, address all of the devices on the bus.
+//
+void OneWire::skip()
+{
+    write(DS18X20_SKIP_ROM);
+}
+
+//
+//  Write a byte to the bus.
+//
+void OneWire::write(uint8_t value, uint8_t)
+{
+    Simulator::CountOneWireBytes(1);
+    Simulator::Advance(ONEWIRE_BYTE_TIME);
+    switch (_state)
+    {
+        case RomCommand:
+            if (value == DS18X20_SKIP_ROM)
+            {
+                _selected = (1 << Simulator::NumberOfProbes()) - 1;
+                _state = AwaitingFunctionCommand;
+            }
+            else
+            {
+                //
+                //  Match ROM is handled by select().
+                //
+                _state = Idle;
+            }
+            break;
+        case AwaitingFunctionCommand:
+            FunctionCommand(value);
+            break;
+        case WriteScratchpad:
+            for (int probe = 0; probe < Simulator::NumberOfProbes(); probe++)
+            {
+                if ((_selected & (1 << probe)) && (_dataIndex < 3))
+                {
+                    SimulatedDS18x20 &device = Simulator::Probe(probe);
+                    uint8_t data = value;
+                    if (_dataIndex == 2)
+                    {
+                        data = (device.rom[0] == 0x10) ? 0xff : ((value & 0x60) | 0x1f);
+                    }
+                    device.scratchpad[2 + _dataIndex] = data;
+                    device.scratchpad[8] = crc8(device.scratchpad, 8);
+                }
+            }
+            _dataIndex++;
+            break;
+        default:
+            break;
+    }
+}
+
+//
+//  Execute a function command on the selected devices.
+//
+void OneWire::FunctionCommand(uint8_t command)
+{
+    _dataIndex = 0;
+    switch (command)
+    {
+        case DS18X20_CONVERT:
+            for (int probe = 0; probe < Simulator::NumberOfProbes(); probe++)
+            {
+                if (_selected & (1 << probe))
+                {
+                    SimulatedDS18x20 &device = Simulator::Probe(probe);
+                    device.conversionComplete = Simulator::Micros() + ConversionTime(device);
+                }
+            }
+            _state = Converting;
+            break;
+        case DS18X20_READ_SCRATCHPAD:
+            _state = ReadScratchpad;
+            break;
+        case DS18X20_WRITE_SCRATCHPAD:
+            _state = WriteScratchpad;
+            break;
+        case DS18X20_COPY_SCRATCHPAD:
+        case DS18X20_RECALL_EEPROM:
+            for (int probe = 0; probe < Simulator::NumberOfProbes(); probe++)
+            {
+                if (_selected & (1 << probe))
+                {
+                    SimulatedDS18x20 &device = Simulator::Probe(probe);
+                    if (command == DS18X20_COPY_SCRATCHPAD)
+                    {
+                        memcpy(device.eeprom, device.scratchpad + 2, 3);
+                    }
+                    else
+                    {
+                        memcpy(device.scratchpad + 2, device.eeprom, 3);
+                        device.scratchpad[8] = crc8(device.scratchpad, 8);
+                    }
+                }
+            }
+            _state = Idle;
+            break;
+        case DS18X20_READ_POWER_SUPPLY:
+            _state = ReadPowerSupply;
+            break;
+        default:
+            _state = Idle;
+            break;
+    }
+}
+
+void OneWire::write_bytes(const uint8_t *data, uint16_t length, bool power)
+{
+    for (uint16_t index = 0; index < length; index++)
+    {
+        write(data[index], power);
+    }
+}
+
+//
+//  Read a byte from the bus, the selected devices drive the bus (wired AND).
+//
+uint8_t OneWire::read()
+{
+    uint8_t result = 0xff;
+
+    Simulator::CountOneWireBytes(1);
+    Simulator::Advance(ONEWIRE_BYTE_TIME);
+    if ((_state != ReadScratchpad) || (_dataIndex >= 9))
+    {
+        return(result);
+    }
+    for (int probe = 0; probe < Simulator::NumberOfProbes(); probe++)
+    {
+        if (_selected & (1 << probe))
+        {
+            SimulatedDS18x20 &device = Simulator::Probe(probe);
+            CompleteConversion(device);
+            uint8_t data = device.scratchpad[_dataIndex];
+            if (device.corruptNextRead && (_dataIndex == 0))
+            {
+                data ^= 0x01;
+            }
+            if (_dataIndex == 8)
+            {
+                device.corruptNextRead = false;
+            }
+            result &= data;
+        }
+    }
+    _dataIndex++;
+    return(result);
+}
+
+void OneWire::read_bytes(uint8_t *data, uint16_t length)
+{
+    for (uint16_t index = 0; index < length; index++)
+    {
+        data[index] = read();
+    }
+}
+
+void OneWire::write_bit(uint8_t)
+{
+    Simulator::Advance(ONEWIRE_BYTE_TIME / 8);
+}
+
+//
+//  Read a single bit.  During a conversion this reports 1 once all of the
+//  selected devices (which are not parasite powered) have finished, after
+//  Read Power Supply it reports 0 if any selected device is parasite powered.
+//
+uint8_t OneWire::read_bit()
+{
+    uint8_t result = 1;
+
+    Simulator::Advance(ONEWIRE_BYTE_TIME / 8);
+    for (int probe = 0; probe < Simulator::NumberOfProbes(); probe++)
+    {
+        if (_selected & (1 << probe))
+        {
+            SimulatedDS18x20 &device = Simulator::Probe(probe);
+            if (_state == Converting)
+            {
+                CompleteConversion(device);
+                if (device.parasitePower || (device.conversionComplete != 0))
+                {
+                    result = 0;
+                }
+            }
+            else if (_state == ReadPowerSupply)
+            {
+                if (device.parasitePower)
+                {
+                    result = 0;
+                }
+            }
+        }
+    }
+    return(result);
+}
+
+void OneWire::depower()
+{
+}
+
+void OneWire::reset_search()
+{
+    _searchIndex = 0;
+}
+
+//
+//  Return the ROM code of the next device on the bus, the devices are
+//  returned in the order they were added to the simulator.
+//
+uint8_t OneWire::search(uint8_t *rom, bool)
+{
+    if (_searchIndex >= Simulator::NumberOfProbes())
+    {
+        return(0);
+    }
+    Simulator::CountOneWireBytes(24);
+    Simulator::Advance(ONEWIRE_RESET_TIME + (24 * ONEWIRE_BYTE_TIME));
+    memcpy(rom, Simulator::Probe(_searchIndex++).rom, 8);
+    _state = Idle;
+    return(1);
+}
+
+//
+//  Dallas / Maxim CRC8.
+//
+uint8_t OneWire::crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0;
+
+    while (length--)
+    {
+        uint8_t inbyte = *data++;
+        for (uint8_t bit = 8; bit; bit--)
+        {
+            uint8_t mix = (crc ^ inbyte) & 0x01;
+            crc >>= 1;
+            if (mix)
+            {
+                crc ^= 0x8c;
+            }
+            inbyte >>= 1;
+        }
+    }
+    return(crc);
+}
@@ -0,0 +1,405 @@
+//
+//  Simulated network for the host (Linux) build of the weather station.
+//
+//  Each connection is a TCP stream to a simple HTTP/1.1 server which supports
+//  keep-alive connections and closes idle connections after a timeout.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Simulator.h"
+
+namespace
+{
+    struct Connection
+    {
+        bool open;
+        std::string request;
+        std::string response;
+        uint64_t responseReady;
+        uint64_t lastActivity;
+        uint32_t requestsServed;
+        bool closeAfterResponse;
+        bool mqtt;
+        uint32_t keepAlive;
+    };
+
+    SimulatedNetwork _network;
+    //
+    //  Never destroyed, global clients close their connections from their
+    //  destructors after this file's statics would have gone.
+    //
+    std::vector<Connection> &_connections = *new std::vector<Connection>();
+
+    //
+    //  Close the connection if the server has timed it out.
+    //
+    void CheckIdle(Connection &connection)
+    {
+        uint64_t timeout = connection.mqtt ? (connection.keepAlive * 1500000ULL) : _network.keepAliveTimeout;
+        if (connection.open && connection.response.empty() && connection.request.empty() &&
+            (timeout != 0) && ((Simulator::Micros() - connection.lastActivity) > timeout))
+        {
+            connection.open = false;
+        }
+        if (!_network.online)
+        {
+            connection.open = false;
+        }
+    }
+
+    //
+    //  Queue a response, responses already waiting are not delayed by it.
+    //
+    void QueueResponse(Connection &connection, const uint8_t *data, size_t length)
+    {
+        if (connection.response.empty())
+        {
+            connection.responseReady = Simulator::Micros() + _network.responseTime;
+        }
+        connection.response.append((const char *) data, length);
+    }
+
+    //
+    //  Process the complete MQTT packets received by the broker.  CONNECT,
+    //  PUBLISH (QoS 1), PINGREQ and DISCONNECT are understood.
+    //
+    void ProcessPackets(Connection &connection)
+    {
+        while (connection.request.size() >= 2)
+        {
+            const uint8_t *data = (const uint8_t *) connection.request.data();
+            uint32_t remaining = 0;
+            size_t header = 1;
+            do
+            {
+                if (header >= connection.request.size())
+                {
+                    return;
+                }
+                remaining |= (uint32_t) (data[header] & 0x7f) << (7 * (header - 1));
+            }
+            while ((data[header++] & 0x80) != 0);
+            if (connection.request.size() < (header + remaining))
+            {
+                return;
+            }
+            const uint8_t *body = data + header;
+            switch (data[0] & 0xf0)
+            {
+                case 0x10:
+                    {
+                        static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+                        connection.keepAlive = (body[8] << 8) | body[9];
+                        QueueResponse(connection, connack, sizeof(connack));
+                    }
+                    break;
+                case 0x30:
+                    {
+                        uint16_t topicLength = (body[0] << 8) | body[1];
+                        size_t payload = 2 + topicLength + ((data[0] & 0x06) ? 2 : 0);
+                        _network.lastTopic.assign((const char *) body + 2, topicLength);
+                        _network.lastPayload.assign((const char *) body + payload, remaining - payload);
+                        _network.brokerPublishes++;
+                        if (data[0] & 0x08)
+                        {
+                            _network.brokerDuplicates++;
+                        }
+                        if (data[0] & 0x06)
+                        {
+                            uint8_t puback[] = { 0x40, 0x02, body[2 + topicLength], body[3 + topicLength] };
+                            QueueResponse(connection, puback, sizeof(puback));
+                        }
+                    }
+                    break;
+                case 0xc0:
+                    {
+                        static const uint8_t pingresp[] = { 0xd0, 0x00 };
+                        QueueResponse(connection, pingresp, sizeof(pingresp));
+                    }
+                    break;
+                case 0xe0:
+                    connection.open = false;
+                    break;
+            }
+            connection.request.erase(0, header + remaining);
+        }
+    }
+
+    //
+    //  Process any complete requests held by the server.
+    //
+    void ProcessRequests(Connection &connection)
+    {
+        if (connection.mqtt)
+        {
+            ProcessPackets(connection);
+            return;
+        }
+        while (true)
+        {
+            size_t headerEnd = connection.request.find("\r\n\r\n");
+            if (headerEnd == std::string::npos)
+            {
+                return;
+            }
+            size_t contentLength = 0;
+            size_t position = connection.request.find("Content-Length:");
+            if ((position != std::string::npos) && (position < headerEnd))
+            {
+                contentLength = strtoul(connection.request.c_str() + position + 15, NULL, 10);
+            }
+            size_t length = headerEnd + 4 + contentLength;
+            if (connection.request.size() < length)
+            {
+                return;
+            }
+            //
+            //  The copy reuses the last request's storage so serving a request
+            //  does not add allocations to the station's benchmarks.
+            //
+            _network.lastRequest.assign(connection.request, 0, length);
+            connection.request.erase(0, length);
+            const std::string &request = _network.lastRequest;
+            _network.requests++;
+            connection.requestsServed++;
+
+            int status = 200;
+            std::string body = (_network.handler != NULL) ? _network.handler(request, status) : Simulator::DefaultRequestHandler(request, status);
+            bool close = (connection.requestsServed >= _network.keepAliveRequests) ||
+                         (request.find("Connection: close") != std::string::npos);
+            bool noBody = (status == 204) || (status == 304);
+            bool chunked = _network.chunkedResponses && !noBody;
+            char header[160];
+            if (_network.interimResponses)
+            {
+                connection.response += "HTTP/1.1 100 Continue\r\n\r\n";
+            }
+            int size = snprintf(header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: text/plain\r\nConnection: %s\r\n",
+                                status, (status < 300) ? "OK" : "Error", close ? "close" : "keep-alive");
+            if (chunked)
+            {
+                snprintf(header + size, sizeof(header) - size, "Transfer-Encoding: chunked\r\n\r\n");
+            }
+            else
+            {
+                snprintf(header + size, sizeof(header) - size, noBody ? "\r\n" : "Content-Length: %u\r\n\r\n", (unsigned int) body.size());
+            }
+            connection.response += header;
+            if (chunked)
+            {
+                //
+                //  Small chunks so that a response spans several of them.
+                //
+                for (size_t position = 0; position < body.size(); position += 8)
+                {
+                    size_t length = ((body.size() - position) < 8) ? (body.size() - position) : 8;
+                    snprintf(header, sizeof(header), "%x\r\n", (unsigned int) length);
+                    connection.response += header;
+                    connection.response.append(body, position, length);
+                    connection.response += "\r\n";
+                }
+                connection.response += "0\r\n\r\n";
+            }
+            else if (!noBody)
+            {
+                connection.response += body;
+            }
+            connection.responseReady = Simulator::Micros() + _network.responseTime;
+            connection.closeAfterResponse = close;
+        }
+    }
+}
+
+//
+//  Default handler, Phant responds with "1 success" to a GET.  A POST is
+//  a batch of readings (one per line starting with the sequence number)
+//  for the collection server, which replies with the sequence number of
+//  the last reading stored.
+//
+std::string Simulator::DefaultRequestHandler(const std::string &request, int &status)
+{
+    status = 200;
+    if (request.compare(0, 5, "POST ") != 0)
+    {
+        return("1 success\n");
+    }
+    size_t line = request.find("\r\n\r\n") + 4;
+    unsigned long stored = 0;
+    uint32_t count = 0;
+    while (line < request.size())
+    {
+        const char *text = request.c_str() + line;
+        if (*text == '{')
+        {
+            text = strchr(text, ':') + 1;
+        }
+        if ((*text >= '0') && (*text <= '9') && ((_network.batchAcceptLimit == 0) || (count < _network.batchAcceptLimit)))
+        {
+            stored = strtoul(text, NULL, 10);
+            count++;
+        }
+        size_t next = request.find('\n', line);
+        line = (next == std::string::npos) ? request.size() : (next + 1);
+    }
+    char response[16];
+    snprintf(response, sizeof(response), "%lu\n", stored);
+    return(response);
+}
+
+//
+//  Network configuration and statistics.
+//
+SimulatedNetwork &Simulator::Network()
+{
+    return(_network);
+}
+
+//
+//  Open a connection, this takes the TCP handshake time (or a timeout when
+//  the network is down).  Returns the connection ID or -1 on failure.
+//
+int Simulator::Connect(const char *, uint16_t port)
+{
+    if (!_network.online)
+    {
+        Advance(5000000);
+        return(-1);
+    }
+    Advance(_network.connectTime);
+    Connection connection = { true, "", "", 0, Micros(), 0, false, (port == _network.brokerPort), 0 };
+    _network.connections++;
+    for (size_t index = 0; index < _connections.size(); index++)
+    {
+        if (!_connections[index].open)
+        {
+            _connections[index] = connection;
+            return((int) index);
+        }
+    }
+    _connections.push_back(connection);
+    return((int) _connections.size() - 1);
+}
+
+//
+//  Send data to the server.
+//
+size_t Simulator::Send(int id, const uint8_t *data, size_t length)
+{
+    if (!Connected(id))
+    {
+        return(0);
+    }
+    Connection &connection = _connections[id];
+    connection.request.append((const char *) data, length);
+    connection.lastActivity = Micros();
+    _network.bytesSent += length;
+    ProcessRequests(connection);
+    return(length);
+}
+
+//
+//  Number of bytes of response which have arrived.
+//
+int Simulator::Available(int id)
+{
+    if ((id < 0) || (id >= (int) _connections.size()))
+    {
+        return(0);
+    }
+    Connection &connection = _connections[id];
+    if (Micros() < connection.responseReady)
+    {
+        return(0);
+    }
+    return((int) connection.response.size());
+}
+
+//
+//  Read response data.
+//
+int Simulator::Receive(int id, uint8_t *data, size_t length)
+{
+    int available = Available(id);
+    if (available <= 0)
+    {
+        return(-1);
+    }
+    Connection &connection = _connections[id];
+    if (length > (size_t) available)
+    {
+        length = available;
+    }
+    memcpy(data, connection.response.data(), length);
+    connection.response.erase(0, length);
+    connection.lastActivity = Micros();
+    _network.bytesReceived += length;
+    if (connection.response.empty() && connection.closeAfterResponse)
+    {
+        connection.open = false;
+    }
+    return((int) length);
+}
+
+//
+//  Look at the next byte of the response.
+//
+int Simulator::Peek(int id)
+{
+    if (Available(id) <= 0)
+    {
+        return(-1);
+    }
+    return((uint8_t) _connections[id].response[0]);
+}
+
+//
+//  Check if the connection is still open (unread data keeps it alive).
+//
+bool Simulator::Connected(int id)
+{
+    if ((id < 0) || (id >= (int) _connections.size()))
+    {
+        return(false);
+    }
+    Connection &connection = _connections[id];
+    CheckIdle(connection);
+    return(connection.open || (Available(id) > 0));
+}
+
+//
+//  Close the connection from the client side.
+//
+void Simulator::Close(int id)
+{
+    if ((id >= 0) && (id < (int) _connections.size()))
+    {
+        _connections[id].open = false;
+        _connections[id].response.clear();
+        _connections[id].request.clear();
+    }
+}
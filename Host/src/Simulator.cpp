@@ -0,0 +1,1377 @@
+//
+//  Simulated hardware for the host (Linux) build of the weather station.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <map>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include "Simulator.h"
+
+//
+//  Epoch used when the virtual clock is at zero (2016-06-01 00:00:00 UTC).
+//
+#define SIMULATION_EPOCH        1464739200
+
+//******************************************************************************
+//
+//  Simulator state.
+//
+namespace
+{
+    struct PeriodicEvent
+    {
+        uint64_t period;
+        uint64_t next;
+        Simulator::EventHandler handler;
+        bool active;
+    };
+
+    struct PulseSource
+    {
+        float *rate;
+        float scale;
+        uint64_t next;
+        Simulator::EventHandler handler;
+    };
+
+    uint64_t _now = 0;
+    uint32_t _yieldCost = 100;
+    bool _inEvent = false;
+    std::vector<PeriodicEvent> _periodicEvents;
+    std::map<uint8_t, PulseSource> _pulseSources;
+    std::map<uint8_t, SimulatedI2CDevice *> _i2cDevices;
+    std::vector<SimulatedDS18x20> _probes;
+    SimulatedEnvironment _environment;
+    SimulatedBME280 _bme280;
+    SimulatedTSL2561 _tsl2561;
+    SimulatedDS3231 _ds3231;
+    SimulatedSTM8S _stm8s;
+    uint32_t _i2cBytes = 0;
+    uint32_t _i2cRepeatedStarts = 0;
+    uint32_t _oneWireBytes = 0;
+    std::vector<uint8_t> _flash;
+    std::vector<uint32_t> _flashEraseCounts;
+    uint32_t _flashBytesWritten = 0;
+
+    //
+    //  Flash is created on first use, erased.
+    //
+    void CreateFlash()
+    {
+        if (_flash.empty())
+        {
+            _flash.assign(Simulator::FlashSize, 0xff);
+            _flashEraseCounts.assign(Simulator::FlashSize / Simulator::FlashSectorSize, 0);
+        }
+    }
+
+    //
+    //  Dallas / Maxim CRC8 (polynomial x^8 + x^5 + x^4 + 1).
+    //
+    uint8_t DallasCRC8(const uint8_t *data, uint8_t length)
+    {
+        uint8_t crc = 0;
+        while (length--)
+        {
+            uint8_t inbyte = *data++;
+            for (uint8_t bit = 8; bit; bit--)
+            {
+                uint8_t mix = (crc ^ inbyte) & 0x01;
+                crc >>= 1;
+                if (mix)
+                {
+                    crc ^= 0x8c;
+                }
+                inbyte >>= 1;
+            }
+        }
+        return(crc);
+    }
+
+    //
+    //  Time until the next pulse for a pulse source running at the given rate.
+    //
+    uint64_t PulseInterval(const PulseSource &source)
+    {
+        return((uint64_t) (1000000.0 / (*source.rate * source.scale)));
+    }
+}
+
+//******************************************************************************
+//
+//  Register based I2C devices.
+//
+
+//
+//  Write to the device, the first byte sets the register pointer.
+//
+void SimulatedRegisterDevice::Write(const uint8_t *data, size_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    _pointer = data[0];
+    for (size_t index = 1; index < length; index++)
+    {
+        WriteRegister(_pointer++, data[index]);
+    }
+}
+
+//
+//  Read from the current register pointer, auto-incrementing.
+//
+size_t SimulatedRegisterDevice::Read(uint8_t *data, size_t length)
+{
+    for (size_t index = 0; index < length; index++)
+    {
+        data[index] = ReadRegister(_pointer++);
+    }
+    return(length);
+}
+
+//******************************************************************************
+//
+//  BME280.
+//
+#define BME280_REGISTER_CHIP_ID         0xd0
+#define BME280_REGISTER_RESET           0xe0
+#define BME280_REGISTER_CONTROL_HUMIDITY 0xf2
+#define BME280_REGISTER_STATUS          0xf3
+#define BME280_REGISTER_CONTROL         0xf4
+#define BME280_REGISTER_CONFIG          0xf5
+#define BME280_REGISTER_DATA            0xf7
+
+namespace
+{
+    //
+    //  Calibration values, taken from the Bosch data sheet examples and a
+    //  typical production part.
+    //
+    const uint16_t BME280_T1 = 27504;
+    const int16_t BME280_T2 = 26435;
+    const int16_t BME280_T3 = -1000;
+    const uint16_t BME280_P1 = 36477;
+    const int16_t BME280_P2 = -10685;
+    const int16_t BME280_P3 = 3024;
+    const int16_t BME280_P4 = 2855;
+    const int16_t BME280_P5 = 140;
+    const int16_t BME280_P6 = -7;
+    const int16_t BME280_P7 = 15500;
+    const int16_t BME280_P8 = -14600;
+    const int16_t BME280_P9 = 6000;
+    const uint8_t BME280_H1 = 75;
+    const int16_t BME280_H2 = 362;
+    const uint8_t BME280_H3 = 0;
+    const int16_t BME280_H4 = 313;
+    const int16_t BME280_H5 = 50;
+    const int8_t BME280_H6 = 30;
+
+    uint16_t U16(const uint8_t *registers, uint8_t reg)
+    {
+        return((uint16_t) (registers[reg] | (registers[reg + 1] << 8)));
+    }
+
+    int16_t S16(const uint8_t *registers, uint8_t reg)
+    {
+        return((int16_t) U16(registers, reg));
+    }
+
+    void Put16(uint8_t *registers, uint8_t reg, uint16_t value)
+    {
+        registers[reg] = value & 0xff;
+        registers[reg + 1] = value >> 8;
+    }
+
+    //
+    //  Number of samples for an oversampling setting.
+    //
+    uint32_t Oversampling(uint8_t setting)
+    {
+        static const uint32_t samples[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+        return(samples[setting & 0x07]);
+    }
+}
+
+//
+//  Set up the registers as they would be following a power on reset.
+//
+SimulatedBME280::SimulatedBME280()
+{
+    memset(_registers, 0, sizeof(_registers));
+    _registers[BME280_REGISTER_CHIP_ID] = 0x60;
+    Put16(_registers, 0x88, BME280_T1);
+    Put16(_registers, 0x8a, BME280_T2);
+    Put16(_registers, 0x8c, BME280_T3);
+    Put16(_registers, 0x8e, BME280_P1);
+    Put16(_registers, 0x90, BME280_P2);
+    Put16(_registers, 0x92, BME280_P3);
+    Put16(_registers, 0x94, BME280_P4);
+    Put16(_registers, 0x96, BME280_P5);
+    Put16(_registers, 0x98, BME280_P6);
+    Put16(_registers, 0x9a, BME280_P7);
+    Put16(_registers, 0x9c, BME280_P8);
+    Put16(_registers, 0x9e, BME280_P9);
+    _registers[0xa1] = BME280_H1;
+    Put16(_registers, 0xe1, BME280_H2);
+    _registers[0xe3] = BME280_H3;
+    _registers[0xe4] = (BME280_H4 >> 4) & 0xff;
+    _registers[0xe5] = (BME280_H4 & 0x0f) | ((BME280_H5 & 0x0f) << 4);
+    _registers[0xe6] = (BME280_H5 >> 4) & 0xff;
+    _registers[0xe7] = (uint8_t) BME280_H6;
+    _registers[BME280_REGISTER_DATA + 0] = 0x80;
+    _registers[BME280_REGISTER_DATA + 3] = 0x80;
+    _registers[BME280_REGISTER_DATA + 6] = 0x80;
+}
+
+//
+//  Temperature in 0.01 C, also returns t_fine for the other compensations.
+//
+int32_t SimulatedBME280::CompensateTemperature(const uint8_t *registers, int32_t adc, int32_t &tFine)
+{
+    int32_t t1 = U16(registers, 0x88);
+    int32_t t2 = S16(registers, 0x8a);
+    int32_t t3 = S16(registers, 0x8c);
+    int32_t var1 = ((((adc >> 3) - (t1 << 1))) * t2) >> 11;
+    int32_t var2 = (((((adc >> 4) - t1) * ((adc >> 4) - t1)) >> 12) * t3) >> 14;
+    tFine = var1 + var2;
+    return((tFine * 5 + 128) >> 8);
+}
+
+//
+//  Pressure in Pa as Q24.8.
+//
+uint32_t SimulatedBME280::CompensatePressure(const uint8_t *registers, int32_t adc, int32_t tFine)
+{
+    int64_t var1, var2, p;
+
+    var1 = ((int64_t) tFine) - 128000;
+    var2 = var1 * var1 * (int64_t) S16(registers, 0x98);
+    var2 = var2 + ((var1 * (int64_t) S16(registers, 0x96)) << 17);
+    var2 = var2 + (((int64_t) S16(registers, 0x94)) << 35);
+    var1 = ((var1 * var1 * (int64_t) S16(registers, 0x92)) >> 8) + ((var1 * (int64_t) S16(registers, 0x90)) << 12);
+    var1 = (((((int64_t) 1) << 47) + var1)) * ((int64_t) U16(registers, 0x8e)) >> 33;
+    if (var1 == 0)
+    {
+        return(0);
+    }
+    p = 1048576 - adc;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t) S16(registers, 0x9e)) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t) S16(registers, 0x9c)) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t) S16(registers, 0x9a)) << 4);
+    return((uint32_t) p);
+}
+
+//
+//  Relative humidity in % as Q22.10.
+//
+uint32_t SimulatedBME280::CompensateHumidity(const uint8_t *registers, int32_t adc, int32_t tFine)
+{
+    int32_t h1 = registers[0xa1];
+    int32_t h2 = S16(registers, 0xe1);
+    int32_t h3 = registers[0xe3];
+    int32_t h4 = (((int8_t) registers[0xe4]) << 4) | (registers[0xe5] & 0x0f);
+    int32_t h5 = (((int8_t) registers[0xe6]) << 4) | (registers[0xe5] >> 4);
+    int32_t h6 = (int8_t) registers[0xe7];
+    int32_t v = (tFine - ((int32_t) 76800));
+
+    v = (((((adc << 14) - (h4 << 20) - (h5 * v)) + ((int32_t) 16384)) >> 15) *
+         (((((((v * h6) >> 10) * (((v * h3) >> 11) + ((int32_t) 32768))) >> 10) + ((int32_t) 2097152)) * h2 + 8192) >> 14));
+    v = (v - (((((v >> 15) * (v >> 15)) >> 7) * h1) >> 4));
+    v = (v < 0 ? 0 : v);
+    v = (v > 419430400 ? 419430400 : v);
+    return((uint32_t) (v >> 12));
+}
+
+//
+//  Read a register, the data registers are latched when a measurement has
+//  completed.
+//
+uint8_t SimulatedBME280::ReadRegister(uint8_t reg)
+{
+    if (_measurementPending && (_now >= _measurementComplete))
+    {
+        LatchMeasurement();
+    }
+    if (reg == BME280_REGISTER_STATUS)
+    {
+        return(_measurementPending ? 0x08 : 0x00);
+    }
+    if (((_registers[BME280_REGISTER_CONTROL] & 0x03) == 0x03) && (reg >= BME280_REGISTER_DATA))
+    {
+        //
+        //  Normal mode, the data registers always hold a recent measurement.
+        //
+        LatchMeasurement();
+    }
+    return(_registers[reg]);
+}
+
+//
+//  Write a register, writing to ctrl_meas may start a measurement.
+//
+void SimulatedBME280::WriteRegister(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+        case BME280_REGISTER_RESET:
+            if (value == 0xb6)
+            {
+                _registers[BME280_REGISTER_CONTROL_HUMIDITY] = 0;
+                _registers[BME280_REGISTER_CONTROL] = 0;
+                _registers[BME280_REGISTER_CONFIG] = 0;
+                _measurementPending = false;
+            }
+            break;
+        case BME280_REGISTER_CONTROL_HUMIDITY:
+        case BME280_REGISTER_CONFIG:
+            _registers[reg] = value;
+            break;
+        case BME280_REGISTER_CONTROL:
+            _registers[reg] = value;
+            if ((value & 0x03) == 0x01 || (value & 0x03) == 0x02)
+            {
+                StartMeasurement();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+//
+//  Start a forced mode measurement, the duration follows the data sheet
+//  maximum measurement time for the oversampling settings.
+//
+void SimulatedBME280::StartMeasurement()
+{
+    uint32_t t = Oversampling(_registers[BME280_REGISTER_CONTROL] >> 5);
+    uint32_t p = Oversampling(_registers[BME280_REGISTER_CONTROL] >> 2);
+    uint32_t h = Oversampling(_registers[BME280_REGISTER_CONTROL_HUMIDITY]);
+    uint64_t duration = 1250 + (2300 * t);
+
+    if (p)
+    {
+        duration += (2300 * p) + 575;
+    }
+    if (h)
+    {
+        duration += (2300 * h) + 575;
+    }
+    _measurementComplete = _now + duration;
+    _measurementPending = true;
+}
+
+//
+//  Convert the environment into raw ADC values by searching for the reading
+//  which compensates to the required value.
+//
+void SimulatedBME280::LatchMeasurement()
+{
+    int32_t tFine = 0;
+    int32_t low, high;
+    int32_t target;
+    uint32_t adcT = 0x80000, adcP = 0x80000, adcH = 0x8000;
+
+    if (Oversampling(_registers[BME280_REGISTER_CONTROL] >> 5))
+    {
+        target = (int32_t) (_environment.airTemperature * 100);
+        low = 0;
+        high = 0xfffff;
+        while (low < high)
+        {
+            int32_t mid = (low + high) / 2;
+            if (CompensateTemperature(_registers, mid, tFine) < target)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        adcT = low;
+    }
+    CompensateTemperature(_registers, adcT, tFine);
+    if (Oversampling(_registers[BME280_REGISTER_CONTROL] >> 2))
+    {
+        uint32_t pressure = (uint32_t) (_environment.airPressure * 256);
+        low = 0;
+        high = 0xfffff;
+        while (low < high)
+        {
+            int32_t mid = (low + high) / 2;
+            if (CompensatePressure(_registers, mid, tFine) > pressure)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        adcP = low;
+    }
+    if (Oversampling(_registers[BME280_REGISTER_CONTROL_HUMIDITY]))
+    {
+        uint32_t humidity = (uint32_t) (_environment.humidity * 1024);
+        low = 0;
+        high = 0xffff;
+        while (low < high)
+        {
+            int32_t mid = (low + high) / 2;
+            if (CompensateHumidity(_registers, mid, tFine) < humidity)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        adcH = low;
+    }
+    _registers[BME280_REGISTER_DATA + 0] = (adcP >> 12) & 0xff;
+    _registers[BME280_REGISTER_DATA + 1] = (adcP >> 4) & 0xff;
+    _registers[BME280_REGISTER_DATA + 2] = (adcP << 4) & 0xf0;
+    _registers[BME280_REGISTER_DATA + 3] = (adcT >> 12) & 0xff;
+    _registers[BME280_REGISTER_DATA + 4] = (adcT >> 4) & 0xff;
+    _registers[BME280_REGISTER_DATA + 5] = (adcT << 4) & 0xf0;
+    _registers[BME280_REGISTER_DATA + 6] = (adcH >> 8) & 0xff;
+    _registers[BME280_REGISTER_DATA + 7] = adcH & 0xff;
+    if (_measurementPending)
+    {
+        //
+        //  Forced mode measurement complete, return to sleep mode.
+        //
+        _measurementPending = false;
+        _registers[BME280_REGISTER_CONTROL] &= 0xfc;
+    }
+}
+
+//******************************************************************************
+//
+//  TSL2561.
+//
+#define TSL2561_COMMAND         0x80
+#define TSL2561_REGISTER_CONTROL 0x00
+#define TSL2561_REGISTER_TIMING 0x01
+#define TSL2561_REGISTER_ID     0x0a
+#define TSL2561_REGISTER_DATA0  0x0c
+#define TSL2561_POWER_UP        0x03
+
+//
+//  Write a command byte followed by optional register data.
+//
+void SimulatedTSL2561::Write(const uint8_t *data, size_t length)
+{
+    if ((length == 0) || !(data[0] & TSL2561_COMMAND))
+    {
+        return;
+    }
+    _command = data[0] & 0x0f;
+    for (size_t index = 1; index < length; index++)
+    {
+        uint8_t reg = _command + (index - 1);
+        if (reg == TSL2561_REGISTER_CONTROL)
+        {
+            uint8_t power = data[index] & 0x03;
+            if ((power == TSL2561_POWER_UP) && (_control != TSL2561_POWER_UP))
+            {
+                _integrationStart = _now;
+                _channel0 = 0;
+                _channel1 = 0;
+            }
+            _control = power;
+        }
+        else if (reg == TSL2561_REGISTER_TIMING)
+        {
+            _timing = data[index];
+            _integrationStart = _now;
+        }
+    }
+}
+
+//
+//  Read registers starting at the last command address.
+//
+size_t SimulatedTSL2561::Read(uint8_t *data, size_t length)
+{
+    UpdateChannels();
+    for (size_t index = 0; index < length; index++)
+    {
+        data[index] = ReadRegister(_command + index);
+    }
+    return(length);
+}
+
+//
+//  Get the value of a single register.
+//
+uint8_t SimulatedTSL2561::ReadRegister(uint8_t reg)
+{
+    switch (reg)
+    {
+        case TSL2561_REGISTER_CONTROL:
+            return(_control);
+        case TSL2561_REGISTER_TIMING:
+            return(_timing);
+        case TSL2561_REGISTER_ID:
+            return(0x50);
+        case TSL2561_REGISTER_DATA0:
+            return(_channel0 & 0xff);
+        case TSL2561_REGISTER_DATA0 + 1:
+            return(_channel0 >> 8);
+        case TSL2561_REGISTER_DATA0 + 2:
+            return(_channel1 & 0xff);
+        case TSL2561_REGISTER_DATA0 + 3:
+            return(_channel1 >> 8);
+        default:
+            return(0);
+    }
+}
+
+//
+//  Integration time in microseconds.
+//
+uint32_t SimulatedTSL2561::IntegrationTime()
+{
+    static const uint32_t times[4] = { 13700, 101000, 402000, 402000 };
+    return(times[_timing & 0x03]);
+}
+
+//
+//  Update the ADC channels if an integration cycle has completed.  The counts
+//  are the inverse of the data sheet lux calculation for a CH1 / CH0 ratio
+//  of 0.3, clipped to the maximum count for the integration time.
+//
+void SimulatedTSL2561::UpdateChannels()
+{
+    static const uint32_t maximumCounts[4] = { 5047, 37177, 65535, 65535 };
+
+    if ((_control != TSL2561_POWER_UP) || ((_now - _integrationStart) < IntegrationTime()))
+    {
+        return;
+    }
+    double counts = _environment.luminosity / 0.018913;
+    counts *= IntegrationTime() / 402000.0;
+    if (!(_timing & 0x10))
+    {
+        counts /= 16;
+    }
+    uint32_t maximum = maximumCounts[_timing & 0x03];
+    uint32_t channel0 = (counts > maximum) ? maximum : (uint32_t) counts;
+    uint32_t channel1 = (uint32_t) (counts * 0.3);
+    _channel0 = channel0;
+    _channel1 = (channel1 > maximum) ? maximum : channel1;
+}
+
+//******************************************************************************
+//
+//  DS3231.
+//
+namespace
+{
+    uint8_t ToBCD(int value)
+    {
+        return((uint8_t) (((value / 10) << 4) | (value % 10)));
+    }
+
+    int FromBCD(uint8_t value)
+    {
+        return(((value >> 4) * 10) + (value & 0x0f));
+    }
+}
+
+//
+//  Time registers are generated from the virtual clock.
+//
+uint8_t SimulatedDS3231::ReadRegister(uint8_t reg)
+{
+    time_t now = (time_t) (SIMULATION_EPOCH + (_now / 1000000) + _offset);
+    struct tm dateTime;
+
+    gmtime_r(&now, &dateTime);
+    switch (reg)
+    {
+        case 0x00:
+            return(ToBCD(dateTime.tm_sec));
+        case 0x01:
+            return(ToBCD(dateTime.tm_min));
+        case 0x02:
+            return(ToBCD(dateTime.tm_hour));
+        case 0x03:
+            return(dateTime.tm_wday + 1);
+        case 0x04:
+            return(ToBCD(dateTime.tm_mday));
+        case 0x05:
+            return(ToBCD(dateTime.tm_mon + 1) | ((dateTime.tm_year >= 100) ? 0x80 : 0));
+        case 0x06:
+            return(ToBCD(dateTime.tm_year % 100));
+        case 0x11:
+            return(25);
+        default:
+            return((reg < sizeof(_registers)) ? _registers[reg] : 0xff);
+    }
+}
+
+//
+//  Writing a time register moves the clock offset.
+//
+void SimulatedDS3231::WriteRegister(uint8_t reg, uint8_t value)
+{
+    if (reg <= 0x06)
+    {
+        uint8_t current[7];
+        struct tm dateTime;
+
+        for (uint8_t index = 0; index < 7; index++)
+        {
+            current[index] = ReadRegister(index);
+        }
+        current[reg] = value;
+        memset(&dateTime, 0, sizeof(dateTime));
+        dateTime.tm_sec = FromBCD(current[0]);
+        dateTime.tm_min = FromBCD(current[1]);
+        dateTime.tm_hour = FromBCD(current[2] & 0x3f);
+        dateTime.tm_mday = FromBCD(current[4]);
+        dateTime.tm_mon = FromBCD(current[5] & 0x1f) - 1;
+        dateTime.tm_year = FromBCD(current[6]) + ((current[5] & 0x80) ? 100 : 0);
+        _offset = (int64_t) timegm(&dateTime) - (SIMULATION_EPOCH + (int64_t) (_now / 1000000));
+    }
+    else if (reg < sizeof(_registers))
+    {
+        _registers[reg] = value;
+    }
+}
+
+//******************************************************************************
+//
+//  STM8S.
+//
+#define STM8S_RESET_STATE               0x00
+#define STM8S_READ_SENSORS              0x01
+#define STM8S_GET_SENSOR_DATA           0x02
+#define STM8S_DATA_READY                0x03
+#define STM8S_RESET_RAINFALL_COUNTER    0x04
+#define STM8S_GET_HISTORY               0x05
+#define STM8S_SET_DEBOUNCE              0x06
+#define STM8S_READING_LENGTH            2000000
+#define STM8S_REGISTER_BASE             0x10
+#define STM8S_REGISTER_VERSION          0x10
+#define STM8S_REGISTER_CAPABILITIES     0x11
+#define STM8S_REGISTER_SAMPLE_LENGTH    0x12
+#define STM8S_REGISTER_HISTORY_LENGTH   0x13
+#define STM8S_REGISTER_STATUS           0x14
+#define STM8S_REGISTER_SAMPLE           0x15
+#define STM8S_REGISTER_DEBOUNCE         0x30
+
+//
+//  Process a command sent by the ESP8266.
+//
+void SimulatedSTM8S::Write(const uint8_t *data, size_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    UpdateHistory();
+    _sendingRegisters = (data[0] >= STM8S_REGISTER_BASE);
+    _registerPointer = data[0];
+    switch (data[0])
+    {
+        case STM8S_RESET_STATE:
+            _txBuffer[0] = _resetCode;
+            _amountToSend = 1;
+            _resetCode = 1;
+            break;
+        case STM8S_READ_SENSORS:
+            RTCAlarm();
+            break;
+        case STM8S_GET_SENSOR_DATA:
+            if (DataReady())
+            {
+                uint16_t windSpeed = (uint16_t) (_environment.windSpeedPulsesPerSecond * (STM8S_READING_LENGTH / 1000000));
+                uint16_t rainfall = (uint16_t) _rainGaugePulseCount;
+                _txBuffer[0] = rainfall >> 8;
+                _txBuffer[1] = rainfall & 0xff;
+                _txBuffer[2] = windSpeed >> 8;
+                _txBuffer[3] = windSpeed & 0xff;
+                _txBuffer[4] = _environment.windDirectionADC >> 8;
+                _txBuffer[5] = _environment.windDirectionADC & 0xff;
+                _txBuffer[6] = _environment.ultravioletADC >> 8;
+                _txBuffer[7] = _environment.ultravioletADC & 0xff;
+            }
+            else
+            {
+                memset(_txBuffer, 0xaa, 8);
+            }
+            _amountToSend = 8;
+            break;
+        case STM8S_DATA_READY:
+            _txBuffer[0] = DataReady() ? 1 : 0;
+            _amountToSend = 1;
+            break;
+        case STM8S_RESET_RAINFALL_COUNTER:
+            _rainfall -= _rainGaugePulseCount;
+            _historyRainfall -= _rainGaugePulseCount;
+            _rainGaugePulseCount = 0;
+            break;
+        case STM8S_GET_HISTORY:
+            PrepareHistoryResponse((length >= 3) ? ((data[1] << 8) | data[2]) : 0, (length >= 4) ? data[3] : HistoryLength);
+            break;
+        case STM8S_SET_DEBOUNCE:
+            if (length >= 3)
+            {
+                _debounceWindow[0] = data[1];
+                _debounceWindow[1] = data[2];
+            }
+            break;
+    }
+}
+
+//
+//  Add a record to the history for each alarm whose reading has completed.
+//  The rain gauge count follows the environment's rain rate.
+//
+void SimulatedSTM8S::UpdateHistory()
+{
+    while (_now >= (_nextAlarm + STM8S_READING_LENGTH))
+    {
+        _alarmCount++;
+        _rainfall += _environment.rainTipsPerHour * AlarmPeriod / 3600;
+        _rainGaugePulseCount = (uint32_t) _rainfall;
+        HistoryRecord &record = _history[++_historyAdded % HistoryLength];
+        record.alarm = _alarmCount;
+        record.rainfall = _rainGaugePulseCount;
+        record.rainfallDelta = (uint16_t) (record.rainfall - _historyRainfall);
+        _historyRainfall = record.rainfall;
+        record.windSpeed = (uint16_t) (_environment.windSpeedPulsesPerSecond * (STM8S_READING_LENGTH / 1000000));
+        record.windPeriod = (_environment.windSpeedPulsesPerSecond > 0) ? (uint32_t) (1000000 / _environment.windSpeedPulsesPerSecond) : 0;
+        record.windDirection = _environment.windDirectionADC;
+        record.ultraviolet = _environment.ultravioletADC;
+        if (_historyCount < HistoryLength)
+        {
+            _historyCount++;
+        }
+        _nextAlarm += AlarmPeriod * 1000000ULL;
+    }
+}
+
+//
+//  Sequence number of the nth record added, the numbering runs from 1 to
+//  65535 and then starts again at 1 as 0 means no reading has been made.
+//
+uint16_t SimulatedSTM8S::Sequence(uint32_t record)
+{
+    return((uint16_t) (((record - 1) % 65535) + 1));
+}
+
+//
+//  Response to STM8S_GET_HISTORY, the same selection as the firmware.  The
+//  response is ready as soon as the command has been written.
+//
+void SimulatedSTM8S::PrepareHistoryResponse(uint16_t requested, uint8_t maximum)
+{
+    uint8_t available = (_historyCount == HistoryLength) ? (HistoryLength - 1) : _historyCount;
+    uint32_t oldest = _historyAdded - available + 1;
+    uint32_t offset = (requested + 65535 - Sequence(oldest)) % 65535;
+    uint32_t first = oldest;
+    uint16_t firstSequence = requested;
+    uint8_t count = 0;
+
+    if ((requested != 0) && (offset < available))
+    {
+        count = available - offset;
+        first = oldest + offset;
+    }
+    else if ((available != 0) && (requested != Sequence(_historyAdded + 1)))
+    {
+        count = available;
+        firstSequence = Sequence(oldest);
+    }
+    const HistoryRecord &newest = _history[_historyAdded % HistoryLength];
+    uint32_t rainfall = _historyRainfall;
+    for (uint8_t index = 0; index < count; index++)
+    {
+        rainfall -= _history[(first + index) % HistoryLength].rainfallDelta;
+    }
+    uint16_t alarm = (count > 0) ? _history[first % HistoryLength].alarm : (newest.alarm + 1);
+    if (count > maximum)
+    {
+        count = maximum;
+    }
+    uint8_t *data = _txBuffer;
+    *data++ = count;
+    data = PutShort(data, firstSequence);
+    data = PutShort(data, alarm);
+    data = PutLong(data, rainfall);
+    for (uint8_t index = 0; index < count; index++)
+    {
+        const HistoryRecord &record = _history[(first + index) % HistoryLength];
+        data = PutShort(data, record.rainfallDelta);
+        data = PutShort(data, record.windSpeed);
+        uint32_t adc = ((uint32_t) (record.windDirection & 0x3ff) << 10) | (record.ultraviolet & 0x3ff);
+        *data++ = (adc >> 16) & 0xff;
+        data = PutShort(data, adc & 0xffff);
+        uint32_t period = (record.windPeriod + 16) >> 5;
+        data = PutShort(data, (period > 0xffff) ? 0xffff : period);
+        data = PutShort(data, (period > 0xffff) ? 0xffff : period);
+    }
+    *data = Crc8(_txBuffer, data - _txBuffer);
+    data++;
+    _amountToSend = data - _txBuffer;
+}
+
+//
+//  Value of a register in the version 4 register map.
+//
+uint8_t SimulatedSTM8S::ReadRegister(uint8_t reg)
+{
+    switch (reg)
+    {
+        case STM8S_REGISTER_VERSION:
+            return(4);
+        case STM8S_REGISTER_CAPABILITIES:
+            return(0x3f);
+        case STM8S_REGISTER_SAMPLE_LENGTH:
+            return(SampleLength);
+        case STM8S_REGISTER_HISTORY_LENGTH:
+            return((_historyCount == HistoryLength) ? (HistoryLength - 1) : _historyCount);
+        case STM8S_REGISTER_STATUS:
+            return(((_historyCount > 0) && (_now < _nextAlarm)) ? 0x01 : 0x00);
+        case STM8S_REGISTER_DEBOUNCE:
+        case STM8S_REGISTER_DEBOUNCE + 1:
+            return(_debounceWindow[reg - STM8S_REGISTER_DEBOUNCE]);
+    }
+    if ((reg < STM8S_REGISTER_SAMPLE) || (reg >= (STM8S_REGISTER_SAMPLE + SampleLength)))
+    {
+        return(0xff);
+    }
+    uint8_t sample[SampleLength] = { 0 };
+    if (_historyCount > 0)
+    {
+        const HistoryRecord &record = _history[_historyAdded % HistoryLength];
+        uint8_t *data = PutShort(sample, Sequence(_historyAdded));
+        data = PutLong(data, record.rainfall);
+        data = PutLong(data, record.windSpeed);
+        data = PutShort(data, record.windDirection);
+        data = PutShort(data, record.ultraviolet);
+        data = PutLong(data, record.windPeriod);
+        data = PutLong(data, record.windPeriod);
+        *data = Crc8(sample, SampleLength - 1);
+    }
+    return(sample[reg - STM8S_REGISTER_SAMPLE]);
+}
+
+//
+//  Store a value MSB first, returns the position after the value.
+//
+uint8_t *SimulatedSTM8S::PutShort(uint8_t *data, uint16_t value)
+{
+    data[0] = value >> 8;
+    data[1] = value & 0xff;
+    return(data + 2);
+}
+
+uint8_t *SimulatedSTM8S::PutLong(uint8_t *data, uint32_t value)
+{
+    return(PutShort(PutShort(data, value >> 16), value & 0xffff));
+}
+
+//
+//  CRC-8 used by the sample frame, polynomial 0x07, initial value 0.
+//
+uint8_t SimulatedSTM8S::Crc8(const uint8_t *data, size_t length)
+{
+    uint8_t crc = 0;
+
+    while (length--)
+    {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+        }
+    }
+    return(crc);
+}
+
+//
+//  Return the response to the last command, 0xff once the data runs out.
+//  After a register address has been written consecutive registers are
+//  returned instead.
+//
+size_t SimulatedSTM8S::Read(uint8_t *data, size_t length)
+{
+    UpdateHistory();
+    for (size_t index = 0; index < length; index++)
+    {
+        if (_sendingRegisters)
+        {
+            data[index] = ReadRegister(_registerPointer++);
+        }
+        else
+        {
+            data[index] = (index < _amountToSend) ? _txBuffer[index] : 0xff;
+        }
+    }
+    if (_corruptNextRead && (length > 0))
+    {
+        data[length - 1] ^= 0x01;
+        _corruptNextRead = false;
+    }
+    return(length);
+}
+
+//
+//  Corrupt the next read from the device.
+//
+void SimulatedSTM8S::CorruptNextRead()
+{
+    _corruptNextRead = true;
+}
+
+//
+//  The RTC alarm starts a new two second reading window.
+//
+void SimulatedSTM8S::RTCAlarm()
+{
+    _readingStarted = true;
+    _dataReadyTime = _now + STM8S_READING_LENGTH;
+}
+
+//
+//  Data is ready once the reading window has elapsed.
+//
+bool SimulatedSTM8S::DataReady()
+{
+    return(_readingStarted && (_now >= _dataReadyTime));
+}
+
+//******************************************************************************
+//
+//  Simulator.
+//
+
+//
+//  Attach the default devices to the I2C and OneWire buses.
+//
+void Simulator::Initialise(int numberOfProbes)
+{
+    _i2cDevices.clear();
+    AttachI2CDevice(0x77, &_bme280);
+    AttachI2CDevice(0x39, &_tsl2561);
+    AttachI2CDevice(0x68, &_ds3231);
+    AttachI2CDevice(0x48, &_stm8s);
+    _probes.clear();
+    for (int probe = 0; probe < numberOfProbes; probe++)
+    {
+        AddProbe(0x28, false);
+    }
+}
+
+//
+//  Current virtual time in microseconds.
+//
+uint64_t Simulator::Micros()
+{
+    return(_now);
+}
+
+//
+//  Move the virtual clock forward firing any tickers and interrupts which
+//  fall due along the way.  Events do not nest, an event which calls delay()
+//  simply moves the clock on.
+//
+void Simulator::Advance(uint64_t microseconds)
+{
+    uint64_t target = _now + microseconds;
+
+    if (_inEvent)
+    {
+        _now = target;
+        return;
+    }
+    while (true)
+    {
+        uint64_t next = target;
+        PeriodicEvent *event = NULL;
+        PulseSource *pulse = NULL;
+
+        for (auto &candidate : _periodicEvents)
+        {
+            if (candidate.active && (candidate.next <= next))
+            {
+                next = candidate.next;
+                event = &candidate;
+            }
+        }
+        for (auto &candidate : _pulseSources)
+        {
+            PulseSource &source = candidate.second;
+            if ((source.handler != NULL) && (source.rate != NULL) && (*source.rate > 0))
+            {
+                if (source.next == 0)
+                {
+                    source.next = _now + PulseInterval(source);
+                }
+                if (source.next <= next)
+                {
+                    next = source.next;
+                    event = NULL;
+                    pulse = &source;
+                }
+            }
+        }
+        if ((event == NULL) && (pulse == NULL))
+        {
+            break;
+        }
+        _now = (next > _now) ? next : _now;
+        _inEvent = true;
+        if (pulse != NULL)
+        {
+            pulse->next = _now + PulseInterval(*pulse);
+            pulse->handler();
+        }
+        else
+        {
+            event->next += event->period;
+            event->handler();
+        }
+        _inEvent = false;
+    }
+    _now = target;
+}
+
+//
+//  Set the amount of virtual time consumed by each call to yield().
+//
+void Simulator::SetTimeCost(uint32_t yieldCost)
+{
+    _yieldCost = yieldCost;
+}
+
+//
+//  Virtual time consumed by a call to yield().
+//
+uint32_t Simulator::YieldCost()
+{
+    return(_yieldCost);
+}
+
+//
+//  Register a periodic event (used by the Ticker class).
+//
+int Simulator::AddPeriodicEvent(uint64_t period, EventHandler handler)
+{
+    PeriodicEvent event = { period, _now + period, handler, true };
+    for (size_t index = 0; index < _periodicEvents.size(); index++)
+    {
+        if (!_periodicEvents[index].active)
+        {
+            _periodicEvents[index] = event;
+            return((int) index);
+        }
+    }
+    _periodicEvents.push_back(event);
+    return((int) _periodicEvents.size() - 1);
+}
+
+//
+//  Remove a periodic event.
+//
+void Simulator::RemovePeriodicEvent(int id)
+{
+    if ((id >= 0) && (id < (int) _periodicEvents.size()))
+    {
+        _periodicEvents[id].active = false;
+    }
+}
+
+//
+//  Attach an interrupt handler to a pin.
+//
+void Simulator::AttachInterrupt(uint8_t pin, EventHandler handler)
+{
+    _pulseSources[pin].handler = handler;
+    _pulseSources[pin].next = 0;
+}
+
+//
+//  Remove the interrupt handler from a pin.
+//
+void Simulator::DetachInterrupt(uint8_t pin)
+{
+    _pulseSources[pin].handler = NULL;
+}
+
+//
+//  Drive a pin with pulses at the rate held in the variable (normally one of
+//  the environment members), the scale converts the rate to pulses per second.
+//
+void Simulator::SetPulseSource(uint8_t pin, float *rate, float scale)
+{
+    _pulseSources[pin].rate = rate;
+    _pulseSources[pin].scale = scale;
+    _pulseSources[pin].next = 0;
+}
+
+//
+//  Environment seen by the sensors.
+//
+SimulatedEnvironment &Simulator::Environment()
+{
+    return(_environment);
+}
+
+//
+//  Attach a device to the I2C bus.
+//
+void Simulator::AttachI2CDevice(uint8_t address, SimulatedI2CDevice *device)
+{
+    _i2cDevices[address] = device;
+}
+
+//
+//  Find the device at an I2C address, NULL if nothing is attached.
+//
+SimulatedI2CDevice *Simulator::I2CDevice(uint8_t address)
+{
+    auto device = _i2cDevices.find(address);
+    return((device == _i2cDevices.end()) ? NULL : device->second);
+}
+
+//
+//  The STM8S co-processor.
+//
+SimulatedSTM8S &Simulator::STM8S()
+{
+    return(_stm8s);
+}
+
+//
+//  Number of temperature probes on the OneWire bus.
+//
+int Simulator::NumberOfProbes()
+{
+    return((int) _probes.size());
+}
+
+//
+//  Get a temperature probe.
+//
+SimulatedDS18x20 &Simulator::Probe(int probe)
+{
+    return(_probes[probe]);
+}
+
+//
+//  Add a temperature probe to the OneWire bus, the ROM code is generated
+//  from the probe number.
+//
+void Simulator::AddProbe(uint8_t family, bool parasitePower)
+{
+    SimulatedDS18x20 device;
+    int probe = (int) _probes.size();
+
+    memset(&device, 0, sizeof(device));
+    device.rom[0] = family;
+    device.rom[1] = 0x10 + probe;
+    device.rom[2] = 0x5a;
+    device.rom[3] = 0xa5;
+    device.rom[4] = 0x01;
+    device.rom[5] = 0x00;
+    device.rom[6] = 0x00;
+    device.rom[7] = DallasCRC8(device.rom, 7);
+    device.eeprom[0] = 0x4b;
+    device.eeprom[1] = 0x46;
+    device.eeprom[2] = 0x7f;
+    device.scratchpad[0] = 0x50;
+    device.scratchpad[1] = 0x05;
+    device.scratchpad[2] = device.eeprom[0];
+    device.scratchpad[3] = device.eeprom[1];
+    device.scratchpad[4] = (family == 0x10) ? 0xff : device.eeprom[2];
+    device.scratchpad[5] = 0xff;
+    device.scratchpad[6] = 0x0c;
+    device.scratchpad[7] = 0x10;
+    device.scratchpad[8] = DallasCRC8(device.scratchpad, 8);
+    device.parasitePower = parasitePower;
+    device.probe = probe;
+    _probes.push_back(device);
+}
+
+//
+//  Read an analog input.
+//
+uint16_t Simulator::AnalogRead(uint8_t pin)
+{
+    int reading = _environment.windDirectionADC;
+
+    (void) pin;
+    if (_environment.windDirectionNoise > 0)
+    {
+        reading += (rand() % ((2 * _environment.windDirectionNoise) + 1)) - _environment.windDirectionNoise;
+    }
+    if (reading < 0)
+    {
+        reading = 0;
+    }
+    if (reading > 1023)
+    {
+        reading = 1023;
+    }
+    return((uint16_t) reading);
+}
+
+//
+//  Erase a 4 KB sector of flash, erasing takes about 30 ms.
+//
+bool Simulator::FlashEraseSector(uint32_t sector)
+{
+    CreateFlash();
+    if (sector >= (FlashSize / FlashSectorSize))
+    {
+        return(false);
+    }
+    memset(&_flash[sector * FlashSectorSize], 0xff, FlashSectorSize);
+    _flashEraseCounts[sector]++;
+    Advance(30000);
+    return(true);
+}
+
+//
+//  Program flash, the offset and size must be multiples of four bytes and
+//  programming can only change bits from 1 to 0.
+//
+bool Simulator::FlashWrite(uint32_t offset, const uint32_t *data, size_t size)
+{
+    CreateFlash();
+    if ((offset & 3) || (size & 3) || ((offset + size) > FlashSize))
+    {
+        return(false);
+    }
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (size_t index = 0; index < size; index++)
+    {
+        _flash[offset + index] &= bytes[index];
+    }
+    _flashBytesWritten += size;
+    Advance(10 + (size / 4) * 2);
+    return(true);
+}
+
+//
+//  Read flash, the offset and size must be multiples of four bytes.
+//
+bool Simulator::FlashRead(uint32_t offset, uint32_t *data, size_t size)
+{
+    CreateFlash();
+    if ((offset & 3) || (size & 3) || ((offset + size) > FlashSize))
+    {
+        return(false);
+    }
+    memcpy(data, &_flash[offset], size);
+    return(true);
+}
+
+//
+//  Number of times a sector has been erased.
+//
+uint32_t Simulator::FlashSectorEraseCount(uint32_t sector)
+{
+    CreateFlash();
+    return((sector < _flashEraseCounts.size()) ? _flashEraseCounts[sector] : 0);
+}
+
+//
+//  Bytes programmed into flash since the statistics were reset.
+//
+uint32_t Simulator::FlashBytesWritten()
+{
+    return(_flashBytesWritten);
+}
+
+//
+//  Bytes moved over the I2C bus since the statistics were reset.
+//
+uint32_t Simulator::I2CBytesTransferred()
+{
+    return(_i2cBytes);
+}
+
+//
+//  Bytes moved over the OneWire bus since the statistics were reset.
+//
+uint32_t Simulator::OneWireBytesTransferred()
+{
+    return(_oneWireBytes);
+}
+
+//
+//  Writes ended with a repeated start rather than a stop since the
+//  statistics were reset.
+//
+uint32_t Simulator::I2CRepeatedStarts()
+{
+    return(_i2cRepeatedStarts);
+}
+
+//
+//  Record I2C traffic.
+//
+void Simulator::CountI2CBytes(size_t bytes)
+{
+    _i2cBytes += bytes;
+}
+
+//
+//  Record a write which ended with a repeated start.
+//
+void Simulator::CountI2CRepeatedStart()
+{
+    _i2cRepeatedStarts++;
+}
+
+//
+//  Record OneWire traffic.
+//
+void Simulator::CountOneWireBytes(size_t bytes)
+{
+    _oneWireBytes += bytes;
+}
+
+//
+//  Reset the bus statistics.
+//
+void Simulator::ResetStatistics()
+{
+    _i2cBytes = 0;
+    _i2cRepeatedStarts = 0;
+    _oneWireBytes = 0;
+    _flashBytesWritten = 0;
+}
@@ -0,0 +1,218 @@
+//
+//  Host (Linux) implementation of the SparkFun TSL2561 library API.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "SparkFunTSL2561.h"
+
+#define TSL2561_CMD             0x80
+#define TSL2561_REG_CONTROL     0x00
+#define TSL2561_REG_TIMING      0x01
+#define TSL2561_REG_ID          0x0a
+#define TSL2561_REG_DATA_0      0x0c
+#define TSL2561_REG_DATA_1      0x0e
+
+SFE_TSL2561::SFE_TSL2561() : _i2c_address(TSL2561_ADDR), _error(0)
+{
+}
+
+boolean SFE_TSL2561::begin()
+{
+    return(begin(TSL2561_ADDR));
+}
+
+boolean SFE_TSL2561::begin(char address)
+{
+    _i2c_address = address;
+    return(true);
+}
+
+boolean SFE_TSL2561::setPowerUp()
+{
+    return(writeByte(TSL2561_REG_CONTROL, 0x03));
+}
+
+boolean SFE_TSL2561::setPowerDown()
+{
+    return(writeByte(TSL2561_REG_CONTROL, 0x00));
+}
+
+boolean SFE_TSL2561::setTiming(boolean gain, unsigned char time)
+{
+    unsigned char timing;
+
+    if (!readByte(TSL2561_REG_TIMING, timing))
+    {
+        return(false);
+    }
+    timing = (timing & ~0x13) | (gain ? 0x10 : 0x00) | (time & 0x03);
+    return(writeByte(TSL2561_REG_TIMING, timing));
+}
+
+boolean SFE_TSL2561::setTiming(boolean gain, unsigned char time, unsigned int &ms)
+{
+    switch (time)
+    {
+        case 0:
+            ms = 14;
+            break;
+        case 1:
+            ms = 101;
+            break;
+        case 2:
+            ms = 402;
+            break;
+        default:
+            ms = 0;
+            break;
+    }
+    return(setTiming(gain, time));
+}
+
+boolean SFE_TSL2561::manualStart()
+{
+    unsigned char timing;
+
+    if (!readByte(TSL2561_REG_TIMING, timing))
+    {
+        return(false);
+    }
+    return(writeByte(TSL2561_REG_TIMING, timing | 0x0b));
+}
+
+boolean SFE_TSL2561::manualStop()
+{
+    unsigned char timing;
+
+    if (!readByte(TSL2561_REG_TIMING, timing))
+    {
+        return(false);
+    }
+    return(writeByte(TSL2561_REG_TIMING, timing & ~0x08));
+}
+
+boolean SFE_TSL2561::getData(unsigned int &data0, unsigned int &data1)
+{
+    return(readUInt(TSL2561_REG_DATA_0, data0) && readUInt(TSL2561_REG_DATA_1, data1));
+}
+
+//
+//  Data sheet lux calculation (T, FN and CL package).  Only a reading of
+//  0xffff on either channel is treated as saturation.
+//
+boolean SFE_TSL2561::getLux(unsigned char gain, unsigned int ms, unsigned int data0, unsigned int data1, double &lux)
+{
+    double ratio, d0, d1;
+
+    if ((data0 == 0xffff) || (data1 == 0xffff))
+    {
+        lux = 0.0;
+        return(false);
+    }
+    d0 = data0;
+    d1 = data1;
+    ratio = (d0 == 0) ? 0 : (d1 / d0);
+    d0 *= (402.0 / ms);
+    d1 *= (402.0 / ms);
+    if (!gain)
+    {
+        d0 *= 16;
+        d1 *= 16;
+    }
+    if (ratio < 0.5)
+    {
+        lux = 0.0304 * d0 - 0.062 * d0 * pow(ratio, 1.4);
+    }
+    else if (ratio < 0.61)
+    {
+        lux = 0.0224 * d0 - 0.031 * d1;
+    }
+    else if (ratio < 0.80)
+    {
+        lux = 0.0128 * d0 - 0.0153 * d1;
+    }
+    else if (ratio < 1.30)
+    {
+        lux = 0.00146 * d0 - 0.00112 * d1;
+    }
+    else
+    {
+        lux = 0.0;
+    }
+    return(true);
+}
+
+boolean SFE_TSL2561::getID(unsigned char &id)
+{
+    return(readByte(TSL2561_REG_ID, id));
+}
+
+byte SFE_TSL2561::getError()
+{
+    return(_error);
+}
+
+boolean SFE_TSL2561::readByte(unsigned char address, unsigned char &value)
+{
+    Wire.beginTransmission((uint8_t) _i2c_address);
+    Wire.write((address & 0x0f) | TSL2561_CMD);
+    _error = Wire.endTransmission();
+    if (_error == 0)
+    {
+        Wire.requestFrom((uint8_t) _i2c_address, (uint8_t) 1);
+        if (Wire.available() == 1)
+        {
+            value = Wire.read();
+            return(true);
+        }
+    }
+    return(false);
+}
+
+boolean SFE_TSL2561::writeByte(unsigned char address, unsigned char value)
+{
+    Wire.beginTransmission((uint8_t) _i2c_address);
+    Wire.write((address & 0x0f) | TSL2561_CMD);
+    Wire.write(value);
+    _error = Wire.endTransmission();
+    return(_error == 0);
+}
+
+boolean SFE_TSL2561::readUInt(unsigned char address, unsigned int &value)
+{
+    Wire.beginTransmission((uint8_t) _i2c_address);
+    Wire.write((address & 0x0f) | TSL2561_CMD);
+    _error = Wire.endTransmission();
+    if (_error == 0)
+    {
+        Wire.requestFrom((uint8_t) _i2c_address, (uint8_t) 2);
+        if (Wire.available() == 2)
+        {
+            value = Wire.read();
+            value |= (Wire.read() << 8);
+            return(true);
+        }
+    }
+    return(false);
+}
@@ -0,0 +1,54 @@
+//
+//  Host (Linux) implementation of the ESP8266 Ticker library.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "Ticker.h"
+#include "Simulator.h"
+
+Ticker::~Ticker()
+{
+    detach();
+}
+
+void Ticker::attach(float seconds, callback_t callback)
+{
+    detach();
+    _event = Simulator::AddPeriodicEvent((uint64_t) (seconds * 1000000), callback);
+}
+
+void Ticker::attach_ms(uint32_t milliseconds, callback_t callback)
+{
+    detach();
+    _event = Simulator::AddPeriodicEvent((uint64_t) milliseconds * 1000, callback);
+}
+
+void Ticker::detach()
+{
+    if (_event >= 0)
+    {
+        Simulator::RemovePeriodicEvent(_event);
+        _event = -1;
+    }
+}
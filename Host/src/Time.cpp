@@ -0,0 +1,73 @@
+//
+//  Host (Linux) implementation of the Arduino Time library.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "Time.h"
+#include "Simulator.h"
+
+//
+//  Offset between the virtual clock and the system time, the time starts at
+//  zero (1970) until setTime() is called, as it does on the device.
+//
+static int64_t _offset = 0;
+static timeStatus_t _status = timeNotSet;
+
+static struct tm Breakdown(time_t t)
+{
+    struct tm result;
+    gmtime_r(&t, &result);
+    return(result);
+}
+
+time_t now()
+{
+    return((time_t) ((Simulator::Micros() / 1000000) + _offset));
+}
+
+void setTime(time_t t)
+{
+    _offset = (int64_t) t - (int64_t) (Simulator::Micros() / 1000000);
+    _status = timeSet;
+}
+
+timeStatus_t timeStatus()
+{
+    return(_status);
+}
+
+int hour() { return(hour(now())); }
+int hour(time_t t) { return(Breakdown(t).tm_hour); }
+int minute() { return(minute(now())); }
+int minute(time_t t) { return(Breakdown(t).tm_min); }
+int second() { return(second(now())); }
+int second(time_t t) { return(Breakdown(t).tm_sec); }
+int day() { return(day(now())); }
+int day(time_t t) { return(Breakdown(t).tm_mday); }
+int weekday() { return(weekday(now())); }
+int weekday(time_t t) { return(Breakdown(t).tm_wday + 1); }
+int month() { return(month(now())); }
+int month(time_t t) { return(Breakdown(t).tm_mon + 1); }
+int year() { return(year(now())); }
+int year(time_t t) { return(Breakdown(t).tm_year + 1900); }
@@ -0,0 +1,148 @@
+//
+//  Host (Linux) implementation of the Arduino Wire (I2C) library.
+//
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "Wire.h"
+#include "Simulator.h"
+
+TwoWire Wire;
+
+//
+//  Time taken to move one byte (plus ACK) over the bus at 100 kHz.
+//
+#define I2C_BYTE_TIME       90
+
+void TwoWire::begin()
+{
+}
+
+void TwoWire::begin(int, int)
+{
+}
+
+void TwoWire::setClock(uint32_t)
+{
+}
+
+//
+//  Start buffering a write transaction to the device.
+//
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _address = address;
+    _txLength = 0;
+}
+
+//
+//  Send the buffered data to the device.  Returns 2 (address NACK) if there
+//  is no device at the address.  A write which does not send a stop is
+//  counted as a repeated start.
+//
+uint8_t TwoWire::endTransmission()
+{
+    return(endTransmission(1));
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+    SimulatedI2CDevice *device = Simulator::I2CDevice(_address);
+
+    Simulator::CountI2CBytes(_txLength + 1);
+    if (!sendStop)
+    {
+        Simulator::CountI2CRepeatedStart();
+    }
+    Simulator::Advance((_txLength + 1) * I2C_BYTE_TIME);
+    if (device == NULL)
+    {
+        return(2);
+    }
+    device->Write(_txBuffer, _txLength);
+    _txLength = 0;
+    return(0);
+}
+
+//
+//  Read data from the device into the receive buffer.
+//
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity)
+{
+    return(requestFrom(address, quantity, 1));
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t)
+{
+    SimulatedI2CDevice *device = Simulator::I2CDevice(address);
+
+    if (quantity > BUFFER_LENGTH)
+    {
+        quantity = BUFFER_LENGTH;
+    }
+    Simulator::CountI2CBytes(quantity + 1);
+    Simulator::Advance((quantity + 1) * I2C_BYTE_TIME);
+    _rxIndex = 0;
+    _rxLength = 0;
+    if (device == NULL)
+    {
+        return(0);
+    }
+    _rxLength = device->Read(_rxBuffer, quantity);
+    return((uint8_t) _rxLength);
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (_txLength >= BUFFER_LENGTH)
+    {
+        return(0);
+    }
+    _txBuffer[_txLength++] = data;
+    return(1);
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t length)
+{
+    size_t written = 0;
+    while ((written < length) && write(data[written]))
+    {
+        written++;
+    }
+    return(written);
+}
+
+int TwoWire::available()
+{
+    return((int) (_rxLength - _rxIndex));
+}
+
+int TwoWire::read()
+{
+    return((_rxIndex < _rxLength) ? _rxBuffer[_rxIndex++] : -1);
+}
+
+int TwoWire::peek()
+{
+    return((_rxIndex < _rxLength) ? _rxBuffer[_rxIndex] : -1);
+}
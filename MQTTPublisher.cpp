@@ -0,0 +1,493 @@
+//
+//  MQTT publisher, QoS 1 messages pipelined over a persistent session.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "MQTTPublisher.h"
+
+//
+//  MQTT control packet types (upper four bits of the first byte).
+//
+#define MQTT_CONNECT        0x10
+#define MQTT_CONNACK        0x20
+#define MQTT_PUBLISH        0x30
+#define MQTT_PUBACK         0x40
+#define MQTT_PINGREQ        0xc0
+#define MQTT_PINGRESP       0xd0
+#define MQTT_QOS1           0x02
+#define MQTT_DUP            0x08
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Publish to the broker on the given port.  The strings must remain valid
+//  for the life of the publisher.
+//
+MQTTPublisher::MQTTPublisher(const char *host, uint16_t port, const char *clientID, const char *userName, const char *password)
+{
+    _host = host;
+    _port = port;
+    _clientID = clientID;
+    _userName = userName;
+    _password = password;
+    _state = Disconnected;
+    _head = 0;
+    _count = 0;
+    _nextPacketID = 1;
+    //
+    //  Allow the first call to Service to connect straight away.
+    //
+    _connectStarted = millis() - ReconnectInterval;
+    _lastSent = 0;
+    _pingSent = 0;
+    _pingOutstanding = false;
+    _parserState = PacketType;
+    _messagesPublished = 0;
+    _messagesAcknowledged = 0;
+    _messagesResent = 0;
+    _numberOfConnections = 0;
+    _bytesSent = 0;
+}
+
+//******************************************************************************
+//
+//  Session management.
+//
+
+//
+//  Connect to the broker, read the acknowledgements and keep the session
+//  alive.  A session which stops responding is dropped and re-established
+//  after ReconnectInterval.
+//
+void MQTTPublisher::Service()
+{
+    switch (_state)
+    {
+        case Disconnected:
+            if ((millis() - _connectStarted) >= ReconnectInterval)
+            {
+                Connect();
+            }
+            break;
+        case Connecting:
+            Receive();
+            if ((_state == Connecting) && (!_client.connected() || ((millis() - _connectStarted) >= AcknowledgeTimeout)))
+            {
+                Drop();
+            }
+            break;
+        case Connected:
+            Receive();
+            if (_state != Connected)
+            {
+                break;
+            }
+            if (!_client.connected() ||
+                ((_count > 0) && ((millis() - _window[_head].sent) >= AcknowledgeTimeout)) ||
+                (_pingOutstanding && ((millis() - _pingSent) >= AcknowledgeTimeout)))
+            {
+                Drop();
+                break;
+            }
+            if (!_pingOutstanding && ((millis() - _lastSent) >= ((KeepAlive * 1000UL) / 2)))
+            {
+                static const uint8_t ping[] = { MQTT_PINGREQ, 0 };
+                if (Send(ping, sizeof(ping)))
+                {
+                    _pingOutstanding = true;
+                    _pingSent = millis();
+                }
+            }
+            break;
+    }
+}
+
+//
+//  Open the connection and send the CONNECT packet.  The session is not
+//  cleared so that the broker keeps it while the station is disconnected.
+//
+bool MQTTPublisher::Connect()
+{
+    uint8_t packet[128];
+    size_t clientIDLength = strlen(_clientID);
+    size_t userNameLength = strlen(_userName);
+    size_t passwordLength = strlen(_password);
+    uint32_t remaining = 10 + (2 + clientIDLength) + (2 + userNameLength) + (2 + passwordLength);
+    size_t length = 0;
+
+    _connectStarted = millis();
+    if ((remaining + 5) > sizeof(packet))
+    {
+        return(false);
+    }
+    if (!_client.connect(_host, _port))
+    {
+        return(false);
+    }
+    _numberOfConnections++;
+    packet[length++] = MQTT_CONNECT;
+    length += EncodeLength(packet + length, remaining);
+    length += EncodeString(packet + length, "MQTT", 4);
+    packet[length++] = 4;                       // Protocol level (3.1.1).
+    packet[length++] = 0xc0;                    // User name and password.
+    packet[length++] = KeepAlive >> 8;
+    packet[length++] = KeepAlive & 0xff;
+    length += EncodeString(packet + length, _clientID, clientIDLength);
+    length += EncodeString(packet + length, _userName, userNameLength);
+    length += EncodeString(packet + length, _password, passwordLength);
+    _parserState = PacketType;
+    _pingOutstanding = false;
+    _state = Connecting;
+    if (!Send(packet, length))
+    {
+        Drop();
+        return(false);
+    }
+    return(true);
+}
+
+//
+//  Close the connection, the messages in the window are kept and sent again
+//  on the next connection.
+//
+void MQTTPublisher::Drop()
+{
+    _client.stop();
+    _state = Disconnected;
+    _pingOutstanding = false;
+}
+
+//
+//  Current state of the session.
+//
+MQTTPublisher::SessionState MQTTPublisher::GetState()
+{
+    return(_state);
+}
+
+//******************************************************************************
+//
+//  Publishing.
+//
+
+//
+//  Indicate if a message can be published now, the session must be
+//  established and there must be space in the window.
+//
+bool MQTTPublisher::CanPublish()
+{
+    return((_state == Connected) && (_count < WindowSize));
+}
+
+//
+//  Publish the payload to the topic with QoS 1.  Returns false if the
+//  message cannot be accepted (CanPublish is false or the message is larger
+//  than MaximumPacketSize).
+//
+bool MQTTPublisher::Publish(const char *topic, const char *payload, uint32_t tag)
+{
+    size_t topicLength = strlen(topic);
+    size_t payloadLength = strlen(payload);
+    uint32_t remaining = (2 + topicLength) + 2 + payloadLength;
+
+    if (!CanPublish() || ((remaining + 5) > MaximumPacketSize))
+    {
+        return(false);
+    }
+    Message &message = _window[(_head + _count) % WindowSize];
+    uint16_t length = 0;
+    message.packet[length++] = MQTT_PUBLISH | MQTT_QOS1;
+    length += EncodeLength(message.packet + length, remaining);
+    length += EncodeString(message.packet + length, topic, topicLength);
+    message.packet[length++] = _nextPacketID >> 8;
+    message.packet[length++] = _nextPacketID & 0xff;
+    memcpy(message.packet + length, payload, payloadLength);
+    length += payloadLength;
+    message.length = length;
+    message.acknowledged = false;
+    message.packetID = _nextPacketID;
+    message.tag = tag;
+    message.sent = millis();
+    _nextPacketID = (_nextPacketID == 0xffff) ? 1 : (_nextPacketID + 1);
+    _count++;
+    _messagesPublished++;
+    //
+    //  A message which cannot be sent stays in the window and is sent again
+    //  when the session is re-established.
+    //
+    if (!Send(message.packet, message.length))
+    {
+        Drop();
+    }
+    return(true);
+}
+
+//
+//  Get the tag of the oldest message waiting for an acknowledgement, returns
+//  false if the broker has acknowledged every message.
+//
+bool MQTTPublisher::GetOldestUnacknowledged(uint32_t &tag)
+{
+    if (_count == 0)
+    {
+        return(false);
+    }
+    tag = _window[_head].tag;
+    return(true);
+}
+
+//
+//  Send the messages in the window again after a reconnection.
+//
+void MQTTPublisher::ResendWindow()
+{
+    for (uint8_t index = 0; index < _count; index++)
+    {
+        Message &message = _window[(_head + index) % WindowSize];
+        if (!message.acknowledged)
+        {
+            message.packet[0] |= MQTT_DUP;
+            message.sent = millis();
+            _messagesResent++;
+            if (!Send(message.packet, message.length))
+            {
+                Drop();
+                return;
+            }
+        }
+    }
+}
+
+//
+//  Mark the message as acknowledged and remove the acknowledged messages from
+//  the front of the window.
+//
+void MQTTPublisher::Acknowledge(uint16_t packetID)
+{
+    for (uint8_t index = 0; index < _count; index++)
+    {
+        Message &message = _window[(_head + index) % WindowSize];
+        if ((message.packetID == packetID) && !message.acknowledged)
+        {
+            message.acknowledged = true;
+            _messagesAcknowledged++;
+            break;
+        }
+    }
+    while ((_count > 0) && _window[_head].acknowledged)
+    {
+        _head = (_head + 1) % WindowSize;
+        _count--;
+    }
+}
+
+//******************************************************************************
+//
+//  Packet handling.
+//
+
+//
+//  Read the packets sent by the broker, at most ReceiveChunkSize bytes are
+//  read each time.
+//
+void MQTTPublisher::Receive()
+{
+    for (uint8_t count = 0; (count < ReceiveChunkSize) && (_state != Disconnected) && (_client.available() > 0); count++)
+    {
+        uint8_t data = (uint8_t) _client.read();
+        switch (_parserState)
+        {
+            case PacketType:
+                _packet[0] = data;
+                _remainingLength = 0;
+                _lengthShift = 0;
+                _bodyReceived = 0;
+                _parserState = RemainingLength;
+                break;
+            case RemainingLength:
+                _remainingLength |= ((uint32_t) (data & 0x7f)) << _lengthShift;
+                _lengthShift += 7;
+                if ((data & 0x80) != 0)
+                {
+                    if (_lengthShift > 21)
+                    {
+                        Drop();
+                    }
+                }
+                else if (_remainingLength == 0)
+                {
+                    ProcessPacket();
+                    _parserState = PacketType;
+                }
+                else
+                {
+                    _parserState = PacketBody;
+                }
+                break;
+            case PacketBody:
+                if (_bodyReceived < (sizeof(_packet) - 1))
+                {
+                    _packet[1 + _bodyReceived] = data;
+                }
+                _bodyReceived++;
+                if (_bodyReceived == _remainingLength)
+                {
+                    ProcessPacket();
+                    _parserState = PacketType;
+                }
+                break;
+        }
+    }
+}
+
+//
+//  Act on a packet from the broker, anything other than CONNACK, PUBACK
+//  and PINGRESP is ignored.
+//
+void MQTTPublisher::ProcessPacket()
+{
+    switch (_packet[0] & 0xf0)
+    {
+        case MQTT_CONNACK:
+            if ((_state != Connecting) || (_bodyReceived < 2) || (_packet[2] != 0))
+            {
+                Drop();
+                break;
+            }
+            _state = Connected;
+            ResendWindow();
+            break;
+        case MQTT_PUBACK:
+            if (_bodyReceived >= 2)
+            {
+                Acknowledge((_packet[1] << 8) | _packet[2]);
+            }
+            break;
+        case MQTT_PINGRESP:
+            _pingOutstanding = false;
+            break;
+    }
+}
+
+//
+//  Send a packet to the broker.
+//
+bool MQTTPublisher::Send(const uint8_t *data, size_t length)
+{
+    if (_client.write(data, length) != length)
+    {
+        return(false);
+    }
+    _bytesSent += length;
+    _lastSent = millis();
+    return(true);
+}
+
+//
+//  Write the MQTT variable length encoding of the remaining length, returns
+//  the number of bytes written.
+//
+uint8_t MQTTPublisher::EncodeLength(uint8_t *buffer, uint32_t length)
+{
+    uint8_t size = 0;
+
+    do
+    {
+        uint8_t data = length & 0x7f;
+        length >>= 7;
+        if (length > 0)
+        {
+            data |= 0x80;
+        }
+        buffer[size++] = data;
+    }
+    while (length > 0);
+    return(size);
+}
+
+//
+//  Write a length prefixed string, returns the number of bytes written.
+//
+uint16_t MQTTPublisher::EncodeString(uint8_t *buffer, const char *text, uint16_t length)
+{
+    buffer[0] = length >> 8;
+    buffer[1] = length & 0xff;
+    memcpy(buffer + 2, text, length);
+    return(2 + length);
+}
+
+//******************************************************************************
+//
+//  Statistics.
+//
+
+//
+//  Number of messages waiting for an acknowledgement.
+//
+uint8_t MQTTPublisher::GetUnacknowledgedCount()
+{
+    return(_count);
+}
+
+//
+//  Number of messages published (not counting messages sent again).
+//
+uint32_t MQTTPublisher::GetMessagesPublished()
+{
+    return(_messagesPublished);
+}
+
+//
+//  Number of messages acknowledged by the broker.
+//
+uint32_t MQTTPublisher::GetMessagesAcknowledged()
+{
+    return(_messagesAcknowledged);
+}
+
+//
+//  Number of messages sent again after a reconnection.
+//
+uint32_t MQTTPublisher::GetMessagesResent()
+{
+    return(_messagesResent);
+}
+
+//
+//  Number of connections opened.
+//
+uint32_t MQTTPublisher::GetNumberOfConnections()
+{
+    return(_numberOfConnections);
+}
+
+//
+//  Number of bytes sent to the broker.
+//
+uint32_t MQTTPublisher::GetBytesSent()
+{
+    return(_bytesSent);
+}
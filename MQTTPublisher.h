@@ -0,0 +1,136 @@
+//
+//  Header for the MQTT publisher class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __MQTTPUBLISHER_H__
+#define __MQTTPUBLISHER_H__
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+//
+//  MQTT 3.1.1 client which publishes QoS 1 messages over one persistent
+//  session.
+//
+//  Publishes are pipelined, messages are sent without waiting for the
+//  PUBACK of the previous message.  Each message is held in a fixed size
+//  window until the broker acknowledges it.  When the window is full no more
+//  messages are accepted.  A message can be large enough to hold a whole
+//  reading (an Adafruit IO group message) so the window is kept short to
+//  limit the RAM it takes.  If the connection is lost the messages in the
+//  window are sent again (with the DUP flag set) once the session has been
+//  re-established.
+//
+//  Each message carries a tag supplied by the caller (e.g. the sequence
+//  number of the reading it belongs to).  The tag of the oldest message
+//  still waiting for an acknowledgement tells the caller which readings the
+//  broker has received.
+//
+//  Service must be called regularly (from loop()) to connect, read the
+//  acknowledgements and keep the session alive.  Each call reads at most
+//  ReceiveChunkSize bytes.
+//
+class MQTTPublisher
+{
+    public:
+        enum SessionState { Disconnected, Connecting, Connected };
+        static const uint8_t WindowSize = 3;
+        static const uint16_t MaximumPacketSize = 640;
+        static const uint8_t ReceiveChunkSize = 64;
+        static const uint16_t KeepAlive = 120;
+        static const unsigned long AcknowledgeTimeout = 10000;
+        static const unsigned long ReconnectInterval = 30000;
+
+        MQTTPublisher(const char *, uint16_t, const char *, const char *, const char *);
+        void Service();
+        bool Publish(const char *, const char *, uint32_t);
+        bool CanPublish();
+        bool GetOldestUnacknowledged(uint32_t &);
+        SessionState GetState();
+        //
+        //  Statistics.
+        //
+        uint8_t GetUnacknowledgedCount();
+        uint32_t GetMessagesPublished();
+        uint32_t GetMessagesAcknowledged();
+        uint32_t GetMessagesResent();
+        uint32_t GetNumberOfConnections();
+        uint32_t GetBytesSent();
+
+    private:
+        //
+        //  Message waiting for a PUBACK, the whole PUBLISH packet is kept so
+        //  that it can be sent again.
+        //
+        struct Message
+        {
+            uint8_t packet[MaximumPacketSize];
+            uint16_t length;
+            bool acknowledged;
+            uint16_t packetID;
+            uint32_t tag;
+            unsigned long sent;
+        };
+        //
+        //  Incoming packet parser, only the first few bytes of each packet
+        //  are kept (CONNACK, PUBACK and PINGRESP are all short).
+        //
+        enum ParserState { PacketType, RemainingLength, PacketBody };
+        const char *_host;
+        uint16_t _port;
+        const char *_clientID;
+        const char *_userName;
+        const char *_password;
+        WiFiClient _client;
+        SessionState _state;
+        Message _window[WindowSize];
+        uint8_t _head;
+        uint8_t _count;
+        uint16_t _nextPacketID;
+        unsigned long _connectStarted;
+        unsigned long _lastSent;
+        unsigned long _pingSent;
+        bool _pingOutstanding;
+        ParserState _parserState;
+        uint8_t _packet[4];
+        uint32_t _remainingLength;
+        uint8_t _lengthShift;
+        uint32_t _bodyReceived;
+        uint32_t _messagesPublished;
+        uint32_t _messagesAcknowledged;
+        uint32_t _messagesResent;
+        uint32_t _numberOfConnections;
+        uint32_t _bytesSent;
+        bool Connect();
+        void Receive();
+        void ProcessPacket();
+        void Acknowledge(uint16_t);
+        void ResendWindow();
+        bool Send(const uint8_t *, size_t);
+        void Drop();
+        static uint8_t EncodeLength(uint8_t *, uint32_t);
+        static uint16_t EncodeString(uint8_t *, const char *, uint16_t);
+};
+
+#endif
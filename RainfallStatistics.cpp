@@ -0,0 +1,257 @@
+//
+//  Rainfall statistics class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "RainfallStatistics.h"
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Default constructor.
+//
+RainfallStatistics::RainfallStatistics()
+{
+    Reset();
+}
+
+//
+//  Discard all of the rainfall data.
+//
+void RainfallStatistics::Reset()
+{
+    _tipHead = 0;
+    _tipTail = 0;
+    _tipsLost = 0;
+    memset(_buckets, 0, sizeof(_buckets));
+    _currentBucket = 0;
+    _currentBucketStart = 0;
+    _started = false;
+    _tenMinuteTips = 0;
+    _oneHourTips = 0;
+    _twentyFourHourTips = 0;
+    _date = 0;
+    _tipsToday = 0;
+    _lastTipTime = 0;
+    _lastTipInterval = 0;
+    _lastTipValid = false;
+}
+
+//******************************************************************************
+//
+//  Data collection.
+//
+
+//
+//  Record a tip of the bucket, called from the pluviometer interrupt handler
+//  with the current time in milliseconds.
+//
+//  If the buffer is full (Update has not been called for some time) then the
+//  tip is counted as lost.
+//
+void RainfallStatistics::RecordTip(unsigned long now)
+{
+    uint8_t head = _tipHead;
+    uint8_t next = (head + 1) % TipBufferSize;
+
+    if (next == _tipTail)
+    {
+        _tipsLost++;
+        return;
+    }
+    _tipTimes[head] = now;
+    _tipHead = next;
+}
+
+//
+//  Process any tips recorded by the interrupt handler and age the buckets.
+//
+//  now is the current time in milliseconds and date is the current date from
+//  the clock (any value which changes at midnight, 0 if the date is not yet
+//  known).  A change of date resets the rainfall today.
+//
+void RainfallStatistics::Update(unsigned long now, uint32_t date)
+{
+    if (!_started)
+    {
+        _currentBucketStart = now;
+        _started = true;
+    }
+    while (_tipTail != _tipHead)
+    {
+        uint8_t tail = _tipTail;
+        unsigned long tipTime = _tipTimes[tail];
+        _tipTail = (tail + 1) % TipBufferSize;
+        AdvanceBuckets(tipTime);
+        AddTip(tipTime);
+    }
+    AdvanceBuckets(now);
+    if (date != _date)
+    {
+        if ((_date != 0) && (date != 0))
+        {
+            _tipsToday = 0;
+        }
+        _date = date;
+    }
+}
+
+//
+//  Add a single tip to the current bucket and the totals.
+//
+void RainfallStatistics::AddTip(unsigned long tipTime)
+{
+    if (_buckets[_currentBucket] < 0xff)
+    {
+        _buckets[_currentBucket]++;
+        _tenMinuteTips++;
+        _oneHourTips++;
+        _twentyFourHourTips++;
+    }
+    _tipsToday++;
+    if (_lastTipValid && ((tipTime - _lastTipTime) < _maximumTipInterval))
+    {
+        _lastTipInterval = tipTime - _lastTipTime;
+    }
+    else
+    {
+        _lastTipInterval = 0;
+    }
+    _lastTipTime = tipTime;
+    _lastTipValid = true;
+}
+
+//
+//  Get the bucket a number of minutes before the current bucket.
+//
+uint8_t &RainfallStatistics::BucketsAgo(uint16_t minutes)
+{
+    return(_buckets[(_currentBucket + NumberOfBuckets - minutes) % NumberOfBuckets]);
+}
+
+//
+//  Move on to the bucket for the time given, the buckets falling out of
+//  each window are removed from the running totals.
+//
+void RainfallStatistics::AdvanceBuckets(unsigned long now)
+{
+    //
+    //  Tips are processed a little after they happen so a tip may belong
+    //  to the bucket which has just started.
+    //
+    if ((long) (now - _currentBucketStart) < 0)
+    {
+        return;
+    }
+    if ((now - _currentBucketStart) >= (BucketPeriod * NumberOfBuckets))
+    {
+        memset(_buckets, 0, sizeof(_buckets));
+        _tenMinuteTips = 0;
+        _oneHourTips = 0;
+        _twentyFourHourTips = 0;
+        _currentBucketStart = now;
+        return;
+    }
+    while ((now - _currentBucketStart) >= BucketPeriod)
+    {
+        _tenMinuteTips -= BucketsAgo(10 - 1);
+        _oneHourTips -= BucketsAgo(60 - 1);
+        _twentyFourHourTips -= BucketsAgo(NumberOfBuckets - 1);
+        _currentBucket = (_currentBucket + 1) % NumberOfBuckets;
+        _buckets[_currentBucket] = 0;
+        _currentBucketStart += BucketPeriod;
+    }
+}
+
+//******************************************************************************
+//
+//  Statistics.
+//
+
+//
+//  Number of tips in the window.
+//
+uint32_t RainfallStatistics::GetTipCount(Window window)
+{
+    switch (window)
+    {
+        case TenMinutes:
+            return(_tenMinuteTips);
+        case OneHour:
+            return(_oneHourTips);
+        default:
+            return(_twentyFourHourTips);
+    }
+}
+
+//
+//  Rainfall (mm) in the window.
+//
+float RainfallStatistics::GetRainfall(Window window)
+{
+    return(GetTipCount(window) * _millimetresPerTip);
+}
+
+//
+//  Rainfall (mm) since midnight.
+//
+float RainfallStatistics::GetRainfallToday()
+{
+    return(_tipsToday * _millimetresPerTip);
+}
+
+//
+//  Instantaneous rain rate (mm per hour) at the time given.
+//
+//  This is one tip over the interval between the last two tips.  Once the
+//  time since the last tip is longer than that interval the rate decays as
+//  one tip over the time since the last tip.
+//
+float RainfallStatistics::GetRainRate(unsigned long now)
+{
+    if (!_lastTipValid || (_lastTipInterval == 0))
+    {
+        return(0);
+    }
+    unsigned long interval = now - _lastTipTime;
+    if (interval >= _maximumTipInterval)
+    {
+        return(0);
+    }
+    if (interval < _lastTipInterval)
+    {
+        interval = _lastTipInterval;
+    }
+    return((_millimetresPerTip * 3600000.0) / interval);
+}
+
+//
+//  Number of tips lost because the tip buffer was full.
+//
+uint32_t RainfallStatistics::GetTipsLost()
+{
+    return(_tipsLost);
+}
@@ -0,0 +1,100 @@
+//
+//  Header for the rainfall statistics class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __RAINFALLSTATISTICS_H__
+#define __RAINFALLSTATISTICS_H__
+
+#include <Arduino.h>
+
+//
+//  Work out the rain rate and the rainfall totals from the tipping bucket.
+//
+//  Each tip is timestamped by the interrupt handler (RecordTip) and placed in
+//  a lock free ring buffer, the interrupt handler is the only writer of the
+//  head and Update (called from loop) is the only writer of the tail.
+//
+//  Update moves the tips into one minute buckets covering the last 24 hours,
+//  running totals are kept for the 10 minute, 1 hour and 24 hour windows so
+//  the totals can be read without walking the buckets.  The total since
+//  midnight is reset when the date passed to Update changes.
+//
+class RainfallStatistics
+{
+    public:
+        enum Window
+        {
+            TenMinutes, OneHour, TwentyFourHours
+        };
+        static const uint8_t TipBufferSize = 64;
+        static const uint16_t NumberOfBuckets = 24 * 60;
+        static const unsigned long BucketPeriod = 60000;
+
+        RainfallStatistics();
+        void Reset();
+        void RecordTip(unsigned long);
+        void Update(unsigned long, uint32_t);
+        uint32_t GetTipCount(Window);
+        float GetRainfall(Window);
+        float GetRainfallToday();
+        float GetRainRate(unsigned long);
+        uint32_t GetTipsLost();
+
+    private:
+        //
+        //  Ring buffer of tip times (milliseconds) written by the interrupt handler.
+        //
+        volatile unsigned long _tipTimes[TipBufferSize];
+        volatile uint8_t _tipHead;
+        volatile uint8_t _tipTail;
+        volatile uint32_t _tipsLost;
+        //
+        //  Tips in each minute for the last 24 hours.
+        //
+        uint8_t _buckets[NumberOfBuckets];
+        uint16_t _currentBucket;
+        unsigned long _currentBucketStart;
+        bool _started;
+        uint32_t _tenMinuteTips;
+        uint32_t _oneHourTips;
+        uint32_t _twentyFourHourTips;
+        //
+        //  Rain today.
+        //
+        uint32_t _date;
+        uint32_t _tipsToday;
+        //
+        //  Rain rate.
+        //
+        unsigned long _lastTipTime;
+        unsigned long _lastTipInterval;
+        bool _lastTipValid;
+        const unsigned long _maximumTipInterval = 60UL * 60UL * 1000UL;
+        const float _millimetresPerTip = 0.2794;
+        void AddTip(unsigned long);
+        void AdvanceBuckets(unsigned long);
+        uint8_t &BucketsAgo(uint16_t);
+};
+
+#endif
@@ -1,622 +1,1358 @@
-//
-//  STM8S code to read the following sensors:
-//      - Rain guage (pluviometer)
-//      - Wind direction
-//      - Wind speed
-//      - UV Light intensity
-//
-//  The data from the sensors is made available over I2C.  The sensor readings
-//  are triggered by an external interrupt.
-//
-//  MIT License
-//
-//  Copyright(c) 2016 Mark Stevens
-//
-//  Permission is hereby granted, free of charge, to any person obtaining a copy
-//  of this software and associated documentation files(the "Software"), to deal
-//  in the Software without restriction, including without limitation the rights
-//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
-//  copies of the Software, and to permit persons to whom the Software is
-//  furnished to do so, subject to the following conditions :
-//
-//  The above copyright notice and this permission notice shall be included in all
-//  copies or substantial portions of the Software.
-//
-//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
-//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-//  SOFTWARE.
-//
-#include <iostm8s103f3.h>
-#include <intrinsics.h>
-
-//
-//  Define some pins to output diagnostic data.
-//
-#define PIN_BIT_BANG_DATA       PC_ODR_ODR3
-#define PIN_BIT_BANG_CLOCK      PC_ODR_ODR4
-//
-//  Wind Direction sensor.
-//
-#define PIN_WIND_DIRECTION      PD_ODR_ODR6
-
-//
-//  Work out the timer values for the reset pulse (300 uS).
-//
-#define CLOCK_SPEED             16
-#define RESET_LENGTH            1000
-#define RESET_PULSE_COUNT       (CLOCK_SPEED * RESET_LENGTH)
-#define TIMER2_RESET_LOW_BYTE   ((unsigned char) ((RESET_PULSE_COUNT & 0xff)))
-#define TIMER2_RESET_HIGH_BYTE  ((unsigned char) ((RESET_PULSE_COUNT >> 8) & 0xff))
-//
-//  Now the timer values for the sensor reading (2 S = 2,000,000 uS).
-//
-#define SENSOR_READING_LENGTH       		2000000
-#define TIMER2_SENSOR_READING_PRESCALAR     0x0f
-#define SENSOR_READING_PULSE_COUNT  		(CLOCK_SPEED * SENSOR_READING_LENGTH / 32768)
-#define TIMER2_SENSOR_LOW_BYTE   			((unsigned char) ((SENSOR_READING_PULSE_COUNT & 0xff)))
-#define TIMER2_SENSOR_HIGH_BYTE  			((unsigned char) ((SENSOR_READING_PULSE_COUNT >> 8) & 0xff))
-
-//
-//  Define which ADC is for which sensor.
-//
-#define ADC_UV_SENSOR               0x05
-#define ADC_WIND_DIRECTION_SENSOR   0x06
-
-//
-//  Interrupt masks and pins for sensors and the RTC.
-//
-volatile unsigned char _lastPortDInput = 0;
-#define MASK_WIND_SPEED         0x10
-#define MASK_RTC                0x04
-#define MASK_RAIN_GAUGE         0x08
-
-//
-//  Indicate if the sensor data is ready to be retrieved.
-//
-volatile bool _dataReady = false;
-
-//
-//  Determine if we have just powered on.
-//
-volatile unsigned char _resetCode;
-
-//
-//  Set aside some storage for the sensor readings.
-//
-volatile unsigned short _uvReading = 0;
-volatile unsigned short _windDirectionReading = 0;
-volatile unsigned short _rainGaugePulseCount = 0;
-volatile unsigned short _windSpeedPulseCount = 0;
-
-//
-//  I2C config information
-//
-#define DEVICE_ADDRESS          			0x48
-//
-//  Somewhere to hold the data for the I2C interface.
-//
-#define I2C_INPUT_BUFFER_LENGTH             2
-unsigned char _rxBuffer[I2C_INPUT_BUFFER_LENGTH];
-volatile int _rxBufferPointer = 0;
-//
-#define I2C_OUTPUT_RAINFALL_COUNTER_MSB     0
-#define I2C_OUTPUT_RAINFALL_COUNTER_LSB     1
-#define I2C_OUTPUT_WINDSPEED_MSB            2
-#define I2C_OUTPUT_WINDSPEED_LSB            3
-#define I2C_OUTPUT_WIND_DIRECTION_MSB       4
-#define I2C_OUTPUT_WIND_DIRECTION_LSB       5
-#define I2C_OUTPUT_UV_READING_MSB           6
-#define I2C_OUTPUT_UV_READING_LSB           7
-#define I2C_OUTPUT_BUFFER_LENGTH            8
-unsigned char _txBuffer[I2C_OUTPUT_BUFFER_LENGTH];
-volatile int _txBufferPointer = 0;
-volatile int _amountToSend = 0;
-volatile bool _processCommand = false;
-//
-//  Commands that this application understands.
-//
-#define I2C_RESET_STATE                     0x00
-#define I2C_READ_SENSORS                    0x01
-#define I2C_GET_SENSOR_DATA                 0x02
-#define I2C_DATA_READY                      0x03
-#define I2C_RESET_RAINFALL_COUNTER          0x04
-
-//--------------------------------------------------------------------------------
-//
-//  Bit bang data on the diagnostic pins.
-//
-void BitBang(unsigned char byte)
-{
-    for (short bit = 7; bit >= 0; bit--)
-    {
-        if (byte & (1 << bit))
-        {
-            PIN_BIT_BANG_DATA = 1;
-        }
-        else
-        {
-            PIN_BIT_BANG_DATA = 0;
-        }
-        PIN_BIT_BANG_CLOCK = 1;
-        __no_operation();
-        PIN_BIT_BANG_CLOCK = 0;
-    }
-    PIN_BIT_BANG_DATA = 0;
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Write the default values into EEPROM.
-//
-void SetDefaultValues()
-{
-    //
-    //  Check if the EEPROM is write-protected.  If it is then unlock the EEPROM.
-    //
-//    if (FLASH_IAPSR_DUL == 0)
-//    {
-//        FLASH_DUKR = 0xae;
-//        FLASH_DUKR = 0x56;
-//    }
-//    //
-//    //  Write the data to the EEPROM.
-//    //
-//    char *address = (char *) EEPROM_DATA_START;     //  Data location in EEPROM.
-//    *address = (char *) DEVICE_ADDRESS9;            //  Default I2C address of this device.
-//    //
-//    //  Now write protect the EEPROM.
-//    //
-//    FLASH_IAPSR_DUL = 0;
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Setup the ADC to perform a single conversion and then generate an interrupt.
-//
-void InitialiseADC()
-{
-    ADC_CR1_ADON = 1;                   //  Turn ADC on, note a second set is
-                                        //  required to start the conversion.
-    ADC_CSR_CH = ADC_UV_SENSOR;         //  ADC for the UV sensor first.
-    ADC_CR3_DBUF = 0;
-    ADC_CR2_ALIGN = 1;                  //  Data is right aligned.
-    ADC_CSR_EOCIE = 1;                  //  Enable the interrupt after conversion completed.
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Set up the system clock to run at 16MHz using the internal oscillator.
-//
-void InitialiseSystemClock()
-{
-    CLK_ICKR = 0;                       //  Reset the Internal Clock Register.
-    CLK_ICKR_HSIEN = 1;                 //  Enable the HSI.
-    CLK_ECKR = 0;                       //  Disable the external clock.
-    while (CLK_ICKR_HSIRDY == 0);       //  Wait for the HSI to be ready for use.
-    CLK_CKDIVR = 0;                     //  Ensure the clocks are running at full speed.
-    CLK_PCKENR1 = 0xff;                 //  Enable all peripheral clocks.
-    CLK_PCKENR2 = 0xff;                 //  Ditto.
-    CLK_CCOR = 0;                       //  Turn off CCO.
-    CLK_HSITRIMR = 0;                   //  Turn off any HSIU trimming.
-    CLK_SWIMCCR = 0;                    //  Set SWIM to run at clock / 2.
-    CLK_SWR = 0xe1;                     //  Use HSI as the clock source.
-    CLK_SWCR = 0;                       //  Reset the clock switch control register.
-    CLK_SWCR_SWEN = 1;                  //  Enable switching.
-    while (CLK_SWCR_SWBSY != 0);        //  Pause while the clock switch is busy.
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Configure the GPIO pins on ports C & D.
-//
-void InitialiseGPIO()
-{
-    PD_ODR = 0;             //  All pins are turned off.
-    //
-    //  RTC is on port D2.
-    //
-    PD_DDR_DDR2 = 0;        //  D2 is an input pin.
-    PD_CR1_C12 = 0;         //  Floating input.
-    PD_CR2_C22 = 1;         //  Now enable the interrupt on this pin.
-    //
-    //  Rain gauge is on port D3.
-    //
-    PD_DDR_DDR3 = 0;        //  D2 is an input pin.
-    PD_CR1_C13 = 0;         //  Floating input.
-    PD_CR2_C23 = 1;         //  Now enable the interrupt on this pin.
-    //
-    //  Wind speed switch is on port D4.
-    //
-    PD_DDR_DDR4 = 0;        //  D4 is an input pin.
-    PD_CR1_C14 = 0;         //  Floating input.
-    PD_CR2_C24 = 1;         //  Now enable the interrupt on this pin.
-    //
-    //  Set port D to detect falling edge interrupts only.
-    //
-    EXTI_CR1_PDIS = 3;      //  Falling edge only 0b10.
-    EXTI_CR2_TLIS = 0;      //  Interrupt on falling edge.
-    //
-    //  Port C7 is output and is used to reset the ESP8266.  Configure
-    //  as an output, push-pull operating at upto 10 MHz, turn the pin
-    //  off inititially.
-    //
-    PC_DDR_DDR7 = 1;    	//  Output pin.
-    PC_CR1_C17 = 1;         //  Push-pull output.
-    PC_CR2_C27 = 1;         //  10 MHz output.
-    PC_ODR_ODR7 = 1;        //  Turn pin on.
-    //
-    //  Diagnostic output pins, one data, one clock.
-    //
-    PC_DDR_DDR3 = 1;    	//  Output pin.
-    PC_CR1_C13 = 1;         //  Push-pull output.
-    PC_CR2_C23 = 1;         //  10 MHz output.
-    PC_ODR_ODR3 = 0;        //  Turn pin off.
-    //
-    PC_DDR_DDR4 = 1;    	//  Output pin.
-    PC_CR1_C14 = 1;         //  Push-pull output.
-    PC_CR2_C24 = 1;         //  10 MHz output.
-    PC_ODR_ODR4 = 0;        //  Turn pin off.
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Initialise the I2C bus.
-//
-void InitialiseI2C()
-{
-    I2C_CR1_PE = 0;                     //  Disable I2C before configuration starts.
-    //
-    //  Set up the clock information.
-    //
-    I2C_FREQR = 16;                     //  Set the internal clock frequency (MHz).
-    //
-    //  Set the address of this device.
-    //
-    I2C_OARH_ADDMODE = 0;               //  7 bit address mode.
-    I2C_OARH_ADD = 0;                   //  Set this device address.
-    I2C_OARL_ADD = DEVICE_ADDRESS;      //
-    I2C_OARH_ADDCONF = 1;               //  Docs say this must always be 1.
-    //
-    //  Setup the bus characteristics.
-    //
-    I2C_TRISER = 17;                    //  Set the maximum SCL rise time.
-    //
-    //  Turn on the interrupts.
-    //
-    I2C_ITR_ITBUFEN = 1;                //  Buffer interrupt enabled.
-    I2C_ITR_ITEVTEN = 1;                //  Event interrupt enabled.
-    I2C_ITR_ITERREN = 1;                //  Error interrupt enabled.
-    //
-    //  Configuration complete so turn the peripheral on.
-    //
-    I2C_CR1_PE = 1;
-    //
-    //  Send acknowledge after every byte received.
-    //
-    I2C_CR2_ACK = 1;
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Set up Timer 1, channel 3 to output a single pulse lasting 240 uS.
-//
-void InitialiseTimer1()
-{
-    TIM1_ARRH = 0x02;       //  Reload counter = 512
-    TIM1_ARRL = 0x00;
-    TIM1_PSCRH = 0xf4;      //  Prescalar = 62,500
-    TIM1_PSCRL = 0x24;
-    TIM1_IER_UIE = 1;       //  Turn interrupts on.
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Process the command in the I2C receive buffer.
-//
-void ExecuteI2CCommand()
-{
-    BitBang(0x06);
-    BitBang(_rxBuffer[0]);
-    switch (_rxBuffer[0])
-    {
-        case I2C_RESET_STATE:
-            _txBuffer[0] = _resetCode;
-            _amountToSend = 1;
-            _resetCode = 1;
-            break;
-        case I2C_READ_SENSORS:
-            //
-            //  Start sensor reading, do not need to respond with any data yet.
-            //
-            _dataReady = false;
-            ADC_CSR_CH = ADC_UV_SENSOR;     //  ADC for the UV sensor first.
-            ADC_CR1_ADON = 1;
-            __no_operation();
-            ADC_CR1_ADON = 1;
-            break;
-        case I2C_GET_SENSOR_DATA:
-            if (_dataReady)
-            {
-                //
-                //  Copy the sensor data into the buffer ready for transmission.
-                //
-                _txBuffer[I2C_OUTPUT_RAINFALL_COUNTER_LSB] = (unsigned char) (_rainGaugePulseCount & 0xff);
-                _txBuffer[I2C_OUTPUT_RAINFALL_COUNTER_MSB] = (unsigned char) ((_rainGaugePulseCount >> 8) & 0xff);
-                _txBuffer[I2C_OUTPUT_WINDSPEED_LSB] = (unsigned char) (_windSpeedPulseCount & 0xff);
-                _txBuffer[I2C_OUTPUT_WINDSPEED_MSB] = (unsigned char) ((_windSpeedPulseCount >> 8) & 0xff);
-                _txBuffer[I2C_OUTPUT_UV_READING_LSB] = (unsigned char) (_uvReading & 0xff);
-                _txBuffer[I2C_OUTPUT_UV_READING_MSB] = (unsigned char) ((_uvReading >> 8) & 0xff);
-                _txBuffer[I2C_OUTPUT_WIND_DIRECTION_LSB] = (unsigned char) (_windDirectionReading & 0xff);
-                _txBuffer[I2C_OUTPUT_WIND_DIRECTION_MSB] = (unsigned char) ((_windDirectionReading >> 8) & 0xff);
-            }
-            else
-            {
-                //
-                //  Fill the buffer with 0xaa to indicate that the data is not
-                //  ready yet.
-                //
-                for (int index = 0; index < sizeof(_txBuffer); index++)
-                {
-                    _txBuffer[index] = 0xaa;
-                }
-            }
-            _amountToSend = sizeof(_txBuffer);
-            break;
-        case I2C_DATA_READY:
-            _txBuffer[0] = _dataReady ? 1 : 0;
-            _amountToSend = 1;
-            break;
-        case I2C_RESET_RAINFALL_COUNTER:
-            _rainGaugePulseCount = 0;
-            break;
-    }
-    _txBufferPointer = 0;
-    _processCommand = false;
-}
-
-//--------------------------------------------------------------------------------
-//
-//  ADC End Of Conversion (EOC) interrupt handler.
-//
-#pragma vector = ADC1_EOC_vector
-__interrupt void ADC1_EOC_IRQHandler()
-{
-    unsigned char low, high;
-    unsigned short reading;
-
-    ADC_CR1_ADON = 0;       //  Disable the ADC.
-    ADC_CSR_EOC = 0;    	// 	Indicate that ADC conversion is complete.
-
-    low = ADC_DRL;			//	Extract the ADC reading.
-    high = ADC_DRH;
-    reading = ((high * 256) + low);
-    if (ADC_CSR_CH == ADC_UV_SENSOR)
-    {
-        _uvReading = reading;
-        //
-        //  Now let the conversion start for the wind direction sensor.
-        //
-        ADC_CSR_CH = ADC_WIND_DIRECTION_SENSOR;
-        ADC_CR1_ADON = 1;
-        __no_operation();
-        ADC_CR1_ADON = 1;
-    }
-    else
-    {
-        _windDirectionReading = reading;
-    }
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Timer 1 Overflow handler.
-//
-//  This handler deals with the 2 second timer pulse for the ESP8266 and also
-//  indicates if we should be taking wind speed readings.
-//
-#pragma vector = TIM1_OVR_UIF_vector
-__interrupt void TIM1_UPD_OVF_IRQHandler(void)
-{
-    _dataReady = true;
-    PC_ODR_ODR7 = 1;        //  Tell the ESP8266 that data is ready.
-    TIM1_CR1_CEN = 0;       //  Stop Timer 1.
-    TIM1_SR1_UIF = 0;       //  Reset the interrupt otherwise it will fire again straight away.
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Process the interrupt on Port D.
-//
-//  The following devices can generate an interrupt on Port D:
-//      - RTC
-//      - Wind speed sensor
-//      - Rain gauge
-//
-//  All interrupts will be generateed on the falling edge of a pulse.
-//
-#pragma vector = EXTI3_vector
-__interrupt void EXTI_PORTD_IRQHandler(void)
-{
-    unsigned char portDInput = PD_IDR;
-    //
-    //  XORing the current reading with the last reading will leave us with the
-    //  changed bits.
-    //
-    unsigned char changedBits = (portDInput ^ _lastPortDInput);
-    _lastPortDInput = portDInput;
-    //
-    //  Now work out what has changed and act accordingly.
-    //
-    if (changedBits & MASK_RTC)
-    {
-        //
-        //  RTC has generated an interrupt, generate a short interrupt pulse to
-        //  tell the ESP8266 that it is time to read the sensors on the falling
-        //	edge of the RTC pulse.
-        //
-        if (!(portDInput & MASK_RTC))
-        {
-	        //
-    	    //  Start the ADC for the UV and wind direction sensor.
-        	//
- 	       	ADC_CSR_CH = ADC_UV_SENSOR; //  ADC for the UV sensor first.
-    	    ADC_CR1_ADON = 1;			// Reference manual says do this twice.
-        	__no_operation();
-        	ADC_CR1_ADON = 1;
-        	//
-        	//	Now kick off the timer for the wind speed reading.
-        	//
-	        _windSpeedPulseCount = 0;
-	        _dataReady = false;
-            BitBang(0x01);
-		    //
-    		//  Force Timer 1 to update without generating an interrupt.
-    		//  This is necessary to makes sure we start off with the correct
-    		//  count and prescalar values in the Timer 1 registers.
-    		//
-    		TIM1_CR1_URS = 1;
-    		TIM1_EGR_UG = 1;
-    		//
-    		//  Enable Timer 1
-    		//
-    		TIM1_CR1_CEN = 1;           //  Start Timer 1.
-            PC_ODR_ODR7 = 0;
-        }
-    }
-    if (changedBits & MASK_RAIN_GAUGE)
-    {
-        //
-        //  Increment on the rising edge only.
-        //
-        BitBang(0x02);
-        if (portDInput & MASK_RAIN_GAUGE)
-        {
-        	BitBang(0x04);
-            _rainGaugePulseCount++;
-        }
-    }
-    //
-    //  We only increment the wind speed counter when Timer 2 is running,
-    //  i.e. during a reset or shortly afterwards when sesnor readings are
-    //  being collected.
-    //
-    if (changedBits & MASK_WIND_SPEED)
-    {
-        //
-        //  Increment on the rising edge only.
-        //
-        BitBang(0x03);
-        if ((portDInput & MASK_WIND_SPEED) && TIM1_CR1_CEN)
-        {
-        	BitBang(0x05);
-            _windSpeedPulseCount++;
-        }
-    }
-}
-
-//--------------------------------------------------------------------------------
-//
-//  I2C interrupt handler.
-//
-#pragma vector = I2C_RXNE_vector
-__interrupt void I2C_IRQHandler()
-{
-    unsigned char reg;
-
-    BitBang(0x07);
-    if (I2C_SR1_ADDR)
-    {
-        _txBufferPointer = 0;
-        _rxBufferPointer = 0;
-        _processCommand = false;
-        reg = I2C_SR1;
-        reg = I2C_SR3;
-        return;
-    }
-    if (I2C_SR1_RXNE)
-    {
-        if (_rxBufferPointer < I2C_INPUT_BUFFER_LENGTH)
-        {
-            reg = I2C_DR;
-            _rxBuffer[_rxBufferPointer++] = reg;
-        }
-        else
-        {
-            //
-            //  If we get here then the calling application has sent too much
-            //  data.  We have no where to store this so we will discard it.
-            //
-            reg = I2C_DR;
-        }
-        return;
-    }
-    if (I2C_SR1_TXE)
-    {
-        unsigned int amount = _amountToSend;
-        if (_txBufferPointer < amount)
-        {
-            reg =  _txBuffer[_txBufferPointer++];
-            I2C_DR = reg;
-        }
-        else
-        {
-            //
-            //  Calling application is requesting too much data, return 0xff
-            //  for this and all subsequent requests.
-            //
-            I2C_SR2_AF = 0;         // End of slave transmission.
-            _processCommand = 0;
-        }
-        return;
-    }
-    if (I2C_SR2_AF)
-    {
-        I2C_SR2_AF = 0;             //  End of slave transmission.
-        _txBufferPointer = 0;
-        return;
-    }
-    if (I2C_SR1_STOPF)
-    {
-        _processCommand = true;
-        _rxBufferPointer = 0;
-        I2C_CR2_STOP = 0;
-        reg = I2C_SR1;
-        return;
-    }
-    //
-    //  If we get here then we have an error so clear the error by reading the
-    //  status registers.
-    //
-    reg = I2C_SR1;
-    reg = I2C_SR2;
-    reg = I2C_SR3;
-}
-
-//--------------------------------------------------------------------------------
-//
-//  Main program loop.
-//
-int main()
-{
-    __disable_interrupt();
-    InitialiseSystemClock();
-    InitialiseGPIO();
-    _lastPortDInput = PD_IDR;
-    InitialiseI2C();
-    InitialiseADC();
-    InitialiseTimer1();
-    _resetCode = 0;
-    __enable_interrupt();
-    while (1)
-    {
-        __wait_for_interrupt();
-        if (_processCommand)
-        {
-            ExecuteI2CCommand();
-        }
-    }
-}
+//
+//  STM8S code to read the following sensors:
+//      - Rain guage (pluviometer)
+//      - Wind direction
+//      - Wind speed
+//      - UV Light intensity
+//
+//  The data from the sensors is made available over I2C.  The sensor readings
+//  are triggered by an external interrupt.
+//
+//  The anemometer is connected to Timer 2 channel 1 (PD4) and the time of
+//  each pulse is captured to the microsecond, giving the mean and minimum
+//  (gust) pulse period as well as the number of pulses in each reading.
+//
+//  The rain gauge and anemometer reed switches are debounced, once an edge
+//  has been seen the input is ignored for a configurable period.
+//
+//  Each completed reading is also added to a history held in RAM so that the
+//  ESP8266 can be offline for a while and then collect the readings it has
+//  missed in a few I2C transactions (I2C_GET_HISTORY).
+//
+//  The latest reading is also published in a register map (see below).
+//  Writing a register address (0x10 or above) sets the register pointer,
+//  a read (normally following a repeated start) then returns consecutive
+//  registers.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <iostm8s103f3.h>
+#include <intrinsics.h>
+
+//
+//  Define some pins to output diagnostic data.
+//
+#define PIN_BIT_BANG_DATA       PC_ODR_ODR3
+#define PIN_BIT_BANG_CLOCK      PC_ODR_ODR4
+//
+//  Wind Direction sensor.
+//
+#define PIN_WIND_DIRECTION      PD_ODR_ODR6
+
+//
+//  Work out the timer values for the reset pulse (300 uS).
+//
+#define CLOCK_SPEED             16
+#define RESET_LENGTH            1000
+#define RESET_PULSE_COUNT       (CLOCK_SPEED * RESET_LENGTH)
+#define TIMER2_RESET_LOW_BYTE   ((unsigned char) ((RESET_PULSE_COUNT & 0xff)))
+#define TIMER2_RESET_HIGH_BYTE  ((unsigned char) ((RESET_PULSE_COUNT >> 8) & 0xff))
+//
+//  Now the timer values for the sensor reading (2 S = 2,000,000 uS).
+//
+#define SENSOR_READING_LENGTH       		2000000
+#define TIMER2_SENSOR_READING_PRESCALAR     0x0f
+#define SENSOR_READING_PULSE_COUNT  		(CLOCK_SPEED * SENSOR_READING_LENGTH / 32768)
+#define TIMER2_SENSOR_LOW_BYTE   			((unsigned char) ((SENSOR_READING_PULSE_COUNT & 0xff)))
+#define TIMER2_SENSOR_HIGH_BYTE  			((unsigned char) ((SENSOR_READING_PULSE_COUNT >> 8) & 0xff))
+
+//
+//  Define which ADC is for which sensor.
+//
+#define ADC_UV_SENSOR               0x05
+#define ADC_WIND_DIRECTION_SENSOR   0x06
+
+//
+//  Interrupt masks and pins for sensors and the RTC.
+//
+volatile unsigned char _lastPortDInput = 0;
+#define MASK_RTC                0x04
+#define MASK_RAIN_GAUGE         0x08
+#define MASK_ANEMOMETER         0x10
+
+//
+//  Indicate if the sensor data is ready to be retrieved.
+//
+volatile bool _dataReady = false;
+
+//
+//  Determine if we have just powered on.
+//
+volatile unsigned char _resetCode;
+
+//
+//  Set aside some storage for the sensor readings.
+//
+//  The interrupt handlers only ever update this working set.  When a reading
+//  completes Timer 1 copies it into the sample frame which is not being
+//  published and then publishes that frame (see PublishSample).  The I2C
+//  handler only reads published frames so it never sees a partly updated
+//  counter.
+//
+struct SensorReadings
+{
+    unsigned long rainGaugePulseCount;
+    unsigned long windSpeedPulseCount;
+    unsigned long windPeriodTotal;          //  Sum of the pulse periods (uS).
+    unsigned long windPeriodMinimum;        //  Shortest pulse period (uS).
+    unsigned short windPeriodCount;         //  Number of periods in the total.
+    unsigned short windDirection;
+    unsigned short ultraviolet;
+};
+volatile SensorReadings _working;
+
+//
+//  Timer 2 runs continuously at 1 MHz, the update interrupt extends the 16
+//  bit counter to 32 bits.  _lastWindPulse is the time of the last pulse
+//  from the anemometer.  Periods longer than WIND_MAXIMUM_PERIOD are
+//  treated as calm and are not included in the wind statistics.
+//
+#define TIMER2_PRESCALAR                    0x04
+#define WIND_MAXIMUM_PERIOD                 10000000
+volatile unsigned short _timer2Overflows = 0;
+volatile unsigned long _lastWindPulse = 0;
+volatile bool _windPulseSeen = false;
+
+//
+//  Debouncing.  Once an edge has been accepted from the rain gauge or the
+//  anemometer the interrupt for that input is masked until the debounce
+//  window (mS) has passed.  Timer 2 channel 2 is used as a compare only
+//  channel (PD3 is not driven) to interrupt when the earliest lockout ends.
+//  _lockedOut has one bit for each input which is locked out.
+//
+//  A closure shorter than the window hides the following edge, so when a
+//  lockout ends the input is read again and a rising edge which was hidden
+//  is counted then.  Timer 2 channel 1 captures both edges of the
+//  anemometer pulse (the polarity is flipped after each capture) so that
+//  the bounce on the closing edge is locked out as well as the bounce on
+//  the opening edge, only the rising edges are counted and timed.
+//
+#define DEBOUNCE_RAIN_GAUGE                 0
+#define DEBOUNCE_ANEMOMETER                 1
+#define DEBOUNCE_INPUTS                     2
+#define DEFAULT_RAIN_GAUGE_DEBOUNCE         50
+#define DEFAULT_ANEMOMETER_DEBOUNCE         5
+volatile unsigned char _debounceWindow[DEBOUNCE_INPUTS] = { DEFAULT_RAIN_GAUGE_DEBOUNCE, DEFAULT_ANEMOMETER_DEBOUNCE };
+volatile unsigned long _lockoutEnd[DEBOUNCE_INPUTS];
+volatile unsigned char _lockedOut = 0;
+
+//
+//  History of completed readings, a ring of HISTORY_LENGTH records.  Each
+//  record is held in the order it is transmitted (MSB first):
+//
+//      Offset  Contents
+//      0       Rain gauge pulses since the previous record.
+//      2       Wind speed pulse count for the reading.
+//      4       Wind direction and UV ADC readings, 10 bits each packed
+//              into 20 bits (direction first) and right aligned.
+//      7       Mean wind pulse period (units of 32 uS, 0xffff if longer).
+//      9       Minimum wind pulse period (units of 32 uS).
+//
+//  Every RTC alarm starts one reading so the alarm count of a record follows
+//  from its sequence number, and the rain gauge total from the total before
+//  the first record sent, both are in the I2C_GET_HISTORY header.  Keeping
+//  the records small lets more of them fit into each I2C read.
+//
+//  Records are numbered from 1, after 65535 the numbering starts again at 1
+//  as the ESP8266 takes a sequence number of 0 to mean that no reading has
+//  been made.  _historyNewest is the sequence number of the last record
+//  added, _historyHead the entry holding it and _historyCount the number of
+//  records held.  _historyAlarm and _historyRainfall are the alarm count and
+//  rain gauge total of the newest record.  _alarmCount counts the RTC alarms.
+//
+#define HISTORY_LENGTH                      24
+#define HISTORY_RECORD_SIZE                 11
+#define HISTORY_PERIOD_SHIFT                5
+unsigned char _history[HISTORY_LENGTH][HISTORY_RECORD_SIZE];
+volatile unsigned short _historyNewest = 0;
+volatile unsigned char _historyHead = HISTORY_LENGTH - 1;
+volatile unsigned char _historyCount = 0;
+volatile unsigned short _historyAlarm = 0;
+volatile unsigned long _historyRainfall = 0;
+volatile unsigned short _alarmCount = 0;
+
+//
+//  I2C config information
+//
+#define DEVICE_ADDRESS          			0x48
+//
+//  Somewhere to hold the data for the I2C interface.
+//
+#define I2C_INPUT_BUFFER_LENGTH             4
+unsigned char _rxBuffer[I2C_INPUT_BUFFER_LENGTH];
+volatile int _rxBufferPointer = 0;
+//
+#define I2C_OUTPUT_RAINFALL_COUNTER_MSB     0
+#define I2C_OUTPUT_RAINFALL_COUNTER_LSB     1
+#define I2C_OUTPUT_WINDSPEED_MSB            2
+#define I2C_OUTPUT_WINDSPEED_LSB            3
+#define I2C_OUTPUT_WIND_DIRECTION_MSB       4
+#define I2C_OUTPUT_WIND_DIRECTION_LSB       5
+#define I2C_OUTPUT_UV_READING_MSB           6
+#define I2C_OUTPUT_UV_READING_LSB           7
+#define I2C_OUTPUT_BUFFER_LENGTH            8
+unsigned char _txBuffer[I2C_OUTPUT_BUFFER_LENGTH];
+//
+//  I2C_GET_HISTORY is followed by the sequence number of the first record
+//  wanted (MSB first) and optionally the most records to send.  The
+//  response is built by the I2C interrupt handler as soon as the command
+//  has been received so a read straight after the command never sees a
+//  stale or partly built response.
+//
+//  The header holds the number of records sent, the sequence number and RTC
+//  alarm count of the first record and the rain gauge total before the
+//  first record (MSB first).  The records follow the header and are read
+//  directly from the history, the response ends with a CRC-8 of the header
+//  and records.
+//
+#define I2C_HISTORY_COUNT                   0
+#define I2C_HISTORY_SEQUENCE                1
+#define I2C_HISTORY_ALARM_COUNT             3
+#define I2C_HISTORY_RAINFALL                5
+#define I2C_HISTORY_HEADER_LENGTH           9
+unsigned char _historyHeader[I2C_HISTORY_HEADER_LENGTH];
+volatile unsigned char _historyCrc = 0;
+volatile bool _sendingHistory = false;
+volatile unsigned short _historyFirst = 0;
+volatile unsigned char _historyFirstEntry = 0;
+volatile int _txBufferPointer = 0;
+volatile int _amountToSend = 0;
+volatile bool _processCommand = false;
+//
+//  Register map, version 4.  The sample frame holds the latest completed
+//  reading, the sequence number is the history sequence number of the
+//  reading (0 until the first reading completes) and the frame ends with
+//  a CRC-8 (polynomial 0x07, initial value 0) of the preceding bytes.  The
+//  capabilities register has one bit for each field present in the frame,
+//  the fields appear in bit order, MSB first.  The rain gauge and wind speed
+//  counts and the wind periods (uS, 0 if no period was measured) are four
+//  bytes, the ADC readings two bytes.
+//
+//      Register    Contents
+//      0x10        Protocol version.
+//      0x11        Capabilities.
+//      0x12        Sample frame length.
+//      0x13        Number of history records available to I2C_GET_HISTORY.
+//      0x14        Status, bit 0 is set when a reading is not in progress.
+//      0x15        Sample frame: sequence number, fields, CRC.
+//      0x30        Rain gauge debounce window (mS).
+//      0x31        Anemometer debounce window (mS).
+//
+//  The debounce windows are set by I2C_SET_DEBOUNCE followed by the rain
+//  gauge and anemometer windows, 0 turns debouncing off.
+//
+#define I2C_REGISTER_BASE                   0x10
+#define I2C_REGISTER_VERSION                0x10
+#define I2C_REGISTER_CAPABILITIES           0x11
+#define I2C_REGISTER_SAMPLE_LENGTH          0x12
+#define I2C_REGISTER_HISTORY_LENGTH         0x13
+#define I2C_REGISTER_STATUS                 0x14
+#define I2C_REGISTER_SAMPLE                 0x15
+#define I2C_REGISTER_RAIN_GAUGE_DEBOUNCE    0x30
+#define I2C_REGISTER_ANEMOMETER_DEBOUNCE    0x31
+#define I2C_PROTOCOL_VERSION                4
+#define I2C_CAPABILITY_RAINFALL             0x01
+#define I2C_CAPABILITY_WIND_SPEED           0x02
+#define I2C_CAPABILITY_WIND_DIRECTION       0x04
+#define I2C_CAPABILITY_ULTRAVIOLET          0x08
+#define I2C_CAPABILITY_WIND_PERIOD_MEAN     0x10
+#define I2C_CAPABILITY_WIND_PERIOD_MINIMUM  0x20
+#define I2C_CAPABILITIES                    (I2C_CAPABILITY_RAINFALL | I2C_CAPABILITY_WIND_SPEED | I2C_CAPABILITY_WIND_DIRECTION | I2C_CAPABILITY_ULTRAVIOLET | I2C_CAPABILITY_WIND_PERIOD_MEAN | I2C_CAPABILITY_WIND_PERIOD_MINIMUM)
+#define I2C_SAMPLE_LENGTH                   23
+#define I2C_SAMPLE_SEQUENCE                 0
+#define I2C_SAMPLE_RAINFALL                 2
+#define I2C_SAMPLE_WIND_SPEED               6
+#define I2C_SAMPLE_WIND_DIRECTION           10
+#define I2C_SAMPLE_ULTRAVIOLET              12
+#define I2C_SAMPLE_WIND_PERIOD_MEAN         14
+#define I2C_SAMPLE_WIND_PERIOD_MINIMUM      18
+#define I2C_SAMPLE_CRC                      22
+#define I2C_STATUS_DATA_READY               0x01
+//
+//  Double buffered sample frames, _publishedFrame is the frame the I2C
+//  handler may read.  The frame being read is latched when the ESP8266
+//  addresses the device so a transaction never straddles a swap.
+//
+unsigned char _frames[2][I2C_SAMPLE_LENGTH];
+volatile unsigned char _publishedFrame = 0;
+volatile unsigned char _readFrame = 0;
+volatile unsigned char _registerPointer = 0;
+volatile bool _sendingRegisters = false;
+//
+//  Commands that this application understands.
+//
+#define I2C_RESET_STATE                     0x00
+#define I2C_READ_SENSORS                    0x01
+#define I2C_GET_SENSOR_DATA                 0x02
+#define I2C_DATA_READY                      0x03
+#define I2C_RESET_RAINFALL_COUNTER          0x04
+#define I2C_GET_HISTORY                     0x05
+#define I2C_SET_DEBOUNCE                    0x06
+
+//--------------------------------------------------------------------------------
+//
+//  Bit bang data on the diagnostic pins.
+//
+void BitBang(unsigned char byte)
+{
+    for (short bit = 7; bit >= 0; bit--)
+    {
+        if (byte & (1 << bit))
+        {
+            PIN_BIT_BANG_DATA = 1;
+        }
+        else
+        {
+            PIN_BIT_BANG_DATA = 0;
+        }
+        PIN_BIT_BANG_CLOCK = 1;
+        __no_operation();
+        PIN_BIT_BANG_CLOCK = 0;
+    }
+    PIN_BIT_BANG_DATA = 0;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Write the default values into EEPROM.
+//
+void SetDefaultValues()
+{
+    //
+    //  Check if the EEPROM is write-protected.  If it is then unlock the EEPROM.
+    //
+//    if (FLASH_IAPSR_DUL == 0)
+//    {
+//        FLASH_DUKR = 0xae;
+//        FLASH_DUKR = 0x56;
+//    }
+//    //
+//    //  Write the data to the EEPROM.
+//    //
+//    char *address = (char *) EEPROM_DATA_START;     //  Data location in EEPROM.
+//    *address = (char *) DEVICE_ADDRESS9;            //  Default I2C address of this device.
+//    //
+//    //  Now write protect the EEPROM.
+//    //
+//    FLASH_IAPSR_DUL = 0;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Setup the ADC to perform a single conversion and then generate an interrupt.
+//
+void InitialiseADC()
+{
+    ADC_CR1_ADON = 1;                   //  Turn ADC on, note a second set is
+                                        //  required to start the conversion.
+    ADC_CSR_CH = ADC_UV_SENSOR;         //  ADC for the UV sensor first.
+    ADC_CR3_DBUF = 0;
+    ADC_CR2_ALIGN = 1;                  //  Data is right aligned.
+    ADC_CSR_EOCIE = 1;                  //  Enable the interrupt after conversion completed.
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Set up the system clock to run at 16MHz using the internal oscillator.
+//
+void InitialiseSystemClock()
+{
+    CLK_ICKR = 0;                       //  Reset the Internal Clock Register.
+    CLK_ICKR_HSIEN = 1;                 //  Enable the HSI.
+    CLK_ECKR = 0;                       //  Disable the external clock.
+    while (CLK_ICKR_HSIRDY == 0);       //  Wait for the HSI to be ready for use.
+    CLK_CKDIVR = 0;                     //  Ensure the clocks are running at full speed.
+    CLK_PCKENR1 = 0xff;                 //  Enable all peripheral clocks.
+    CLK_PCKENR2 = 0xff;                 //  Ditto.
+    CLK_CCOR = 0;                       //  Turn off CCO.
+    CLK_HSITRIMR = 0;                   //  Turn off any HSIU trimming.
+    CLK_SWIMCCR = 0;                    //  Set SWIM to run at clock / 2.
+    CLK_SWR = 0xe1;                     //  Use HSI as the clock source.
+    CLK_SWCR = 0;                       //  Reset the clock switch control register.
+    CLK_SWCR_SWEN = 1;                  //  Enable switching.
+    while (CLK_SWCR_SWBSY != 0);        //  Pause while the clock switch is busy.
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Configure the GPIO pins on ports C & D.
+//
+void InitialiseGPIO()
+{
+    PD_ODR = 0;             //  All pins are turned off.
+    //
+    //  RTC is on port D2.
+    //
+    PD_DDR_DDR2 = 0;        //  D2 is an input pin.
+    PD_CR1_C12 = 0;         //  Floating input.
+    PD_CR2_C22 = 1;         //  Now enable the interrupt on this pin.
+    //
+    //  Rain gauge is on port D3.
+    //
+    PD_DDR_DDR3 = 0;        //  D2 is an input pin.
+    PD_CR1_C13 = 0;         //  Floating input.
+    PD_CR2_C23 = 1;         //  Now enable the interrupt on this pin.
+    //
+    //  Wind speed switch is on port D4 (Timer 2 channel 1), the pulses are
+    //  captured by Timer 2 rather than the port D interrupt.
+    //
+    PD_DDR_DDR4 = 0;        //  D4 is an input pin.
+    PD_CR1_C14 = 0;         //  Floating input.
+    PD_CR2_C24 = 0;         //  No external interrupt on this pin.
+    //
+    //  Set port D to detect falling edge interrupts only.
+    //
+    EXTI_CR1_PDIS = 3;      //  Falling edge only 0b10.
+    EXTI_CR2_TLIS = 0;      //  Interrupt on falling edge.
+    //
+    //  Port C7 is output and is used to reset the ESP8266.  Configure
+    //  as an output, push-pull operating at upto 10 MHz, turn the pin
+    //  off inititially.
+    //
+    PC_DDR_DDR7 = 1;    	//  Output pin.
+    PC_CR1_C17 = 1;         //  Push-pull output.
+    PC_CR2_C27 = 1;         //  10 MHz output.
+    PC_ODR_ODR7 = 1;        //  Turn pin on.
+    //
+    //  Diagnostic output pins, one data, one clock.
+    //
+    PC_DDR_DDR3 = 1;    	//  Output pin.
+    PC_CR1_C13 = 1;         //  Push-pull output.
+    PC_CR2_C23 = 1;         //  10 MHz output.
+    PC_ODR_ODR3 = 0;        //  Turn pin off.
+    //
+    PC_DDR_DDR4 = 1;    	//  Output pin.
+    PC_CR1_C14 = 1;         //  Push-pull output.
+    PC_CR2_C24 = 1;         //  10 MHz output.
+    PC_ODR_ODR4 = 0;        //  Turn pin off.
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Initialise the I2C bus.
+//
+void InitialiseI2C()
+{
+    I2C_CR1_PE = 0;                     //  Disable I2C before configuration starts.
+    //
+    //  Set up the clock information.
+    //
+    I2C_FREQR = 16;                     //  Set the internal clock frequency (MHz).
+    //
+    //  Set the address of this device.
+    //
+    I2C_OARH_ADDMODE = 0;               //  7 bit address mode.
+    I2C_OARH_ADD = 0;                   //  Set this device address.
+    I2C_OARL_ADD = DEVICE_ADDRESS;      //
+    I2C_OARH_ADDCONF = 1;               //  Docs say this must always be 1.
+    //
+    //  Setup the bus characteristics.
+    //
+    I2C_TRISER = 17;                    //  Set the maximum SCL rise time.
+    //
+    //  Turn on the interrupts.
+    //
+    I2C_ITR_ITBUFEN = 1;                //  Buffer interrupt enabled.
+    I2C_ITR_ITEVTEN = 1;                //  Event interrupt enabled.
+    I2C_ITR_ITERREN = 1;                //  Error interrupt enabled.
+    //
+    //  Configuration complete so turn the peripheral on.
+    //
+    I2C_CR1_PE = 1;
+    //
+    //  Send acknowledge after every byte received.
+    //
+    I2C_CR2_ACK = 1;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Set up Timer 1, channel 3 to output a single pulse lasting 240 uS.
+//
+void InitialiseTimer1()
+{
+    TIM1_ARRH = 0x02;       //  Reload counter = 512
+    TIM1_ARRL = 0x00;
+    TIM1_PSCRH = 0xf4;      //  Prescalar = 62,500
+    TIM1_PSCRL = 0x24;
+    TIM1_IER_UIE = 1;       //  Turn interrupts on.
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Set up Timer 2 as a free running 1 MHz timer capturing the edges from the
+//  anemometer on channel 1, starting with a rising edge.
+//
+void InitialiseTimer2()
+{
+    TIM2_PSCR = TIMER2_PRESCALAR;   //  16 MHz / 2^4 = 1 MHz.
+    TIM2_ARRH = 0xff;               //  Count through the full 16 bits.
+    TIM2_ARRL = 0xff;
+    TIM2_CCMR1_CC1S = 1;            //  Channel 1 is an input mapped to TI1.
+    TIM2_CCMR1_IC1F = 3;            //  Filter, 8 samples at 16 MHz.
+    TIM2_CCER1_CC1P = 0;            //  Capture the rising edge.
+    TIM2_CCER1_CC1E = 1;            //  Enable the capture.
+    TIM2_CCMR2 = 0;                 //  Channel 2 is a frozen output compare
+                                    //  used for debouncing, PD3 is not driven.
+    TIM2_IER_CC1IE = 1;             //  Capture interrupt.
+    TIM2_IER_UIE = 1;               //  Overflow interrupt.
+    TIM2_CR1_CEN = 1;               //  Start Timer 2.
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Store a value MSB first.
+//
+void PutShort(unsigned char *buffer, unsigned short value)
+{
+    buffer[0] = (unsigned char) (value >> 8);
+    buffer[1] = (unsigned char) (value & 0xff);
+}
+
+void PutLong(unsigned char *buffer, unsigned long value)
+{
+    PutShort(buffer, (unsigned short) (value >> 16));
+    PutShort(buffer + 2, (unsigned short) (value & 0xffff));
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Convert a wind period in a sample frame (uS) to the units used in the
+//  history (32 uS), periods which do not fit are stored as 0xffff.
+//
+unsigned short HistoryPeriod(unsigned char *buffer)
+{
+    unsigned long period = ((unsigned long) buffer[0] << 24) | ((unsigned long) buffer[1] << 16) | ((unsigned long) buffer[2] << 8) | buffer[3];
+    period = (period + (1 << (HISTORY_PERIOD_SHIFT - 1))) >> HISTORY_PERIOD_SHIFT;
+    return((period > 0xffff) ? 0xffff : (unsigned short) period);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Sequence number arithmetic, sequence numbers run from 1 to 65535 and
+//  then start again at 1.
+//
+unsigned short NextSequence(unsigned short sequence)
+{
+    return((sequence == 0xffff) ? 1 : (sequence + 1));
+}
+
+//
+//  Sequence number count records before the given sequence number.
+//
+unsigned short PreviousSequence(unsigned short sequence, unsigned char count)
+{
+    unsigned short previous = sequence - count;
+    if ((count > 0) && ((previous == 0) || (previous > sequence)))
+    {
+        previous--;
+    }
+    return(previous);
+}
+
+//
+//  Number of records from first to last.
+//
+unsigned short SequenceDistance(unsigned short first, unsigned short last)
+{
+    unsigned short distance = last - first;
+    if (last < first)
+    {
+        distance--;
+    }
+    return(distance);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Add the reading in the published frame to the history, the oldest
+//  record is overwritten when the history is full.
+//
+void AddReadingToHistory()
+{
+    unsigned char *frame = _frames[_publishedFrame];
+    unsigned short sequence = NextSequence(_historyNewest);
+    unsigned char head = (_historyHead + 1) % HISTORY_LENGTH;
+    unsigned char *record = _history[head];
+    unsigned long rainfall = ((unsigned long) frame[I2C_SAMPLE_RAINFALL] << 24) | ((unsigned long) frame[I2C_SAMPLE_RAINFALL + 1] << 16) |
+                             ((unsigned long) frame[I2C_SAMPLE_RAINFALL + 2] << 8) | frame[I2C_SAMPLE_RAINFALL + 3];
+    //
+    //  The rain gauge pulses between readings and the anemometer pulses in
+    //  one reading always fit in 16 bits.
+    //
+    PutShort(record, (unsigned short) (rainfall - _historyRainfall));
+    record[2] = frame[I2C_SAMPLE_WIND_SPEED + 2];
+    record[3] = frame[I2C_SAMPLE_WIND_SPEED + 3];
+    unsigned short direction = ((unsigned short) frame[I2C_SAMPLE_WIND_DIRECTION] << 8) | frame[I2C_SAMPLE_WIND_DIRECTION + 1];
+    unsigned short ultraviolet = ((unsigned short) frame[I2C_SAMPLE_ULTRAVIOLET] << 8) | frame[I2C_SAMPLE_ULTRAVIOLET + 1];
+    record[4] = (unsigned char) ((direction >> 6) & 0x0f);
+    record[5] = (unsigned char) (((direction & 0x3f) << 2) | ((ultraviolet >> 8) & 0x03));
+    record[6] = (unsigned char) (ultraviolet & 0xff);
+    PutShort(record + 7, HistoryPeriod(frame + I2C_SAMPLE_WIND_PERIOD_MEAN));
+    PutShort(record + 9, HistoryPeriod(frame + I2C_SAMPLE_WIND_PERIOD_MINIMUM));
+    _historyRainfall = rainfall;
+    _historyAlarm = _alarmCount;
+    _historyNewest = sequence;
+    _historyHead = head;
+    if (_historyCount < HISTORY_LENGTH)
+    {
+        _historyCount++;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  CRC-8, polynomial x^8 + x^2 + x + 1 (0x07), initial value 0.  The CRC
+//  of data held in several blocks is found by passing the CRC of the
+//  previous blocks as crc.
+//
+unsigned char Crc8(unsigned char crc, unsigned char *data, unsigned char length)
+{
+    while (length--)
+    {
+        crc ^= *data++;
+        for (unsigned char bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+        }
+    }
+    return(crc);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Copy the working set into the frame which is not published and then
+//  publish it.  The sequence number is that of the history record which
+//  will be added for this reading.
+//
+//  This is called from the Timer 1 interrupt so the port D, Timer 2 and ADC
+//  interrupts cannot change the working set while it is being copied.
+//
+void PublishSample()
+{
+    unsigned char next = _publishedFrame ^ 1;
+    unsigned char *frame = _frames[next];
+    PutShort(frame + I2C_SAMPLE_SEQUENCE, NextSequence(_historyNewest));
+    PutLong(frame + I2C_SAMPLE_RAINFALL, _working.rainGaugePulseCount);
+    PutLong(frame + I2C_SAMPLE_WIND_SPEED, _working.windSpeedPulseCount);
+    PutShort(frame + I2C_SAMPLE_WIND_DIRECTION, _working.windDirection);
+    PutShort(frame + I2C_SAMPLE_ULTRAVIOLET, _working.ultraviolet);
+    unsigned short periods = _working.windPeriodCount;
+    PutLong(frame + I2C_SAMPLE_WIND_PERIOD_MEAN, periods ? (_working.windPeriodTotal / periods) : 0);
+    PutLong(frame + I2C_SAMPLE_WIND_PERIOD_MINIMUM, _working.windPeriodMinimum);
+    frame[I2C_SAMPLE_CRC] = Crc8(0, frame, I2C_SAMPLE_CRC);
+    _publishedFrame = next;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Get the value of a register, unused registers read as 0xff.
+//
+unsigned char ReadRegister(unsigned char reg)
+{
+    switch (reg)
+    {
+        case I2C_REGISTER_VERSION:
+            return(I2C_PROTOCOL_VERSION);
+        case I2C_REGISTER_CAPABILITIES:
+            return(I2C_CAPABILITIES);
+        case I2C_REGISTER_SAMPLE_LENGTH:
+            return(I2C_SAMPLE_LENGTH);
+        case I2C_REGISTER_HISTORY_LENGTH:
+            return((_historyCount == HISTORY_LENGTH) ? (HISTORY_LENGTH - 1) : _historyCount);
+        case I2C_REGISTER_STATUS:
+            return(_dataReady ? I2C_STATUS_DATA_READY : 0);
+        case I2C_REGISTER_RAIN_GAUGE_DEBOUNCE:
+            return(_debounceWindow[DEBOUNCE_RAIN_GAUGE]);
+        case I2C_REGISTER_ANEMOMETER_DEBOUNCE:
+            return(_debounceWindow[DEBOUNCE_ANEMOMETER]);
+    }
+    if ((reg >= I2C_REGISTER_SAMPLE) && (reg < (I2C_REGISTER_SAMPLE + I2C_SAMPLE_LENGTH)))
+    {
+        return(_frames[_readFrame][reg - I2C_REGISTER_SAMPLE]);
+    }
+    return(0xff);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Set up the response to I2C_GET_HISTORY, the records from the requested
+//  sequence number towards the newest record, no more than maximum records.
+//  If the requested record is no longer held the response starts with the
+//  oldest record, the header holds the sequence number of the first record
+//  sent so the ESP8266 can tell that readings have been lost.
+//
+//  Once the history is full the oldest record is not sent, it is the next
+//  to be overwritten and could change while it is being transmitted.  A
+//  record which is overwritten while it is being sent fails the CRC.
+//
+//  This is called from the I2C interrupt handler, Timer 1 cannot add a
+//  record while the history state is being read.
+//
+void PrepareHistoryResponse(unsigned short requested, unsigned char maximum)
+{
+    unsigned char count;
+    unsigned short newest = _historyNewest;
+    unsigned char head = _historyHead;
+    unsigned char available = _historyCount;
+    unsigned short alarm = _historyAlarm;
+    unsigned long rainfall = _historyRainfall;
+
+    if (available == HISTORY_LENGTH)
+    {
+        available--;
+    }
+    unsigned short oldest = PreviousSequence(newest, (available > 0) ? (available - 1) : 0);
+    unsigned short offset = SequenceDistance(oldest, requested);
+    if ((requested != 0) && (offset < available))
+    {
+        count = available - (unsigned char) offset;
+        _historyFirst = requested;
+    }
+    else if ((available == 0) || (requested == NextSequence(newest)))
+    {
+        count = 0;
+        _historyFirst = requested;
+    }
+    else
+    {
+        count = available;
+        _historyFirst = oldest;
+    }
+    //
+    //  Work back from the newest record to the rain gauge total and alarm
+    //  count before the first record, then send no more than maximum.
+    //
+    _historyFirstEntry = (head + HISTORY_LENGTH - ((count > 0) ? (count - 1) : 0)) % HISTORY_LENGTH;
+    for (unsigned char index = 0; index < count; index++)
+    {
+        unsigned char *record = _history[(_historyFirstEntry + index) % HISTORY_LENGTH];
+        rainfall -= ((unsigned short) record[0] << 8) | record[1];
+    }
+    alarm = (count > 0) ? (alarm - (count - 1)) : (alarm + 1);
+    if (count > maximum)
+    {
+        count = maximum;
+    }
+    _historyHeader[I2C_HISTORY_COUNT] = count;
+    PutShort(_historyHeader + I2C_HISTORY_SEQUENCE, _historyFirst);
+    PutShort(_historyHeader + I2C_HISTORY_ALARM_COUNT, alarm);
+    PutLong(_historyHeader + I2C_HISTORY_RAINFALL, rainfall);
+    unsigned char crc = Crc8(0, _historyHeader, I2C_HISTORY_HEADER_LENGTH);
+    for (unsigned char index = 0; index < count; index++)
+    {
+        crc = Crc8(crc, _history[(_historyFirstEntry + index) % HISTORY_LENGTH], HISTORY_RECORD_SIZE);
+    }
+    _historyCrc = crc;
+    _amountToSend = I2C_HISTORY_HEADER_LENGTH + (count * HISTORY_RECORD_SIZE) + 1;
+    _txBufferPointer = 0;
+    _sendingHistory = true;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Get the byte at the given position in the I2C_GET_HISTORY response.
+//
+unsigned char GetHistoryByte(int position)
+{
+    if (position < I2C_HISTORY_HEADER_LENGTH)
+    {
+        return(_historyHeader[position]);
+    }
+    position -= I2C_HISTORY_HEADER_LENGTH;
+    if (position == (_historyHeader[I2C_HISTORY_COUNT] * HISTORY_RECORD_SIZE))
+    {
+        return(_historyCrc);
+    }
+    unsigned char entry = (_historyFirstEntry + (position / HISTORY_RECORD_SIZE)) % HISTORY_LENGTH;
+    return(_history[entry][position % HISTORY_RECORD_SIZE]);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Process the command in the I2C receive buffer.
+//
+void ExecuteI2CCommand()
+{
+    BitBang(0x06);
+    BitBang(_rxBuffer[0]);
+    _sendingHistory = false;
+    switch (_rxBuffer[0])
+    {
+        case I2C_RESET_STATE:
+            _txBuffer[0] = _resetCode;
+            _amountToSend = 1;
+            _resetCode = 1;
+            break;
+        case I2C_READ_SENSORS:
+            //
+            //  Start sensor reading, do not need to respond with any data yet.
+            //
+            _dataReady = false;
+            ADC_CSR_CH = ADC_UV_SENSOR;     //  ADC for the UV sensor first.
+            ADC_CR1_ADON = 1;
+            __no_operation();
+            ADC_CR1_ADON = 1;
+            break;
+        case I2C_GET_SENSOR_DATA:
+            if (_dataReady)
+            {
+                //
+                //  Copy the sensor data from the published frame into the
+                //  buffer ready for transmission.  The counts are truncated
+                //  to 16 bits for compatibility.
+                //
+                unsigned char *frame = _frames[_publishedFrame];
+                _txBuffer[I2C_OUTPUT_RAINFALL_COUNTER_MSB] = frame[I2C_SAMPLE_RAINFALL + 2];
+                _txBuffer[I2C_OUTPUT_RAINFALL_COUNTER_LSB] = frame[I2C_SAMPLE_RAINFALL + 3];
+                _txBuffer[I2C_OUTPUT_WINDSPEED_MSB] = frame[I2C_SAMPLE_WIND_SPEED + 2];
+                _txBuffer[I2C_OUTPUT_WINDSPEED_LSB] = frame[I2C_SAMPLE_WIND_SPEED + 3];
+                _txBuffer[I2C_OUTPUT_WIND_DIRECTION_MSB] = frame[I2C_SAMPLE_WIND_DIRECTION];
+                _txBuffer[I2C_OUTPUT_WIND_DIRECTION_LSB] = frame[I2C_SAMPLE_WIND_DIRECTION + 1];
+                _txBuffer[I2C_OUTPUT_UV_READING_MSB] = frame[I2C_SAMPLE_ULTRAVIOLET];
+                _txBuffer[I2C_OUTPUT_UV_READING_LSB] = frame[I2C_SAMPLE_ULTRAVIOLET + 1];
+            }
+            else
+            {
+                //
+                //  Fill the buffer with 0xaa to indicate that the data is not
+                //  ready yet.
+                //
+                for (int index = 0; index < sizeof(_txBuffer); index++)
+                {
+                    _txBuffer[index] = 0xaa;
+                }
+            }
+            _amountToSend = sizeof(_txBuffer);
+            break;
+        case I2C_DATA_READY:
+            _txBuffer[0] = _dataReady ? 1 : 0;
+            _amountToSend = 1;
+            break;
+        case I2C_RESET_RAINFALL_COUNTER:
+            //
+            //  Rebase the total of the newest history record by the pulses
+            //  cleared so the next record still holds the pulses since it.
+            //
+            __disable_interrupt();
+            _historyRainfall -= _working.rainGaugePulseCount;
+            _working.rainGaugePulseCount = 0;
+            __enable_interrupt();
+            break;
+        case I2C_SET_DEBOUNCE:
+            _debounceWindow[DEBOUNCE_RAIN_GAUGE] = _rxBuffer[1];
+            _debounceWindow[DEBOUNCE_ANEMOMETER] = _rxBuffer[2];
+            break;
+    }
+    _txBufferPointer = 0;
+    _processCommand = false;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  ADC End Of Conversion (EOC) interrupt handler.
+//
+#pragma vector = ADC1_EOC_vector
+__interrupt void ADC1_EOC_IRQHandler()
+{
+    unsigned char low, high;
+    unsigned short reading;
+
+    ADC_CR1_ADON = 0;       //  Disable the ADC.
+    ADC_CSR_EOC = 0;    	// 	Indicate that ADC conversion is complete.
+
+    low = ADC_DRL;			//	Extract the ADC reading.
+    high = ADC_DRH;
+    reading = ((high * 256) + low);
+    if (ADC_CSR_CH == ADC_UV_SENSOR)
+    {
+        _working.ultraviolet = reading;
+        //
+        //  Now let the conversion start for the wind direction sensor.
+        //
+        ADC_CSR_CH = ADC_WIND_DIRECTION_SENSOR;
+        ADC_CR1_ADON = 1;
+        __no_operation();
+        ADC_CR1_ADON = 1;
+    }
+    else
+    {
+        _working.windDirection = reading;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Timer 1 Overflow handler.
+//
+//  This handler deals with the 2 second timer pulse for the ESP8266 and also
+//  indicates if we should be taking wind speed readings.
+//
+#pragma vector = TIM1_OVR_UIF_vector
+__interrupt void TIM1_UPD_OVF_IRQHandler(void)
+{
+    PublishSample();
+    AddReadingToHistory();
+    _dataReady = true;
+    PC_ODR_ODR7 = 1;        //  Tell the ESP8266 that data is ready.
+    TIM1_CR1_CEN = 0;       //  Stop Timer 1.
+    TIM1_SR1_UIF = 0;       //  Reset the interrupt otherwise it will fire again straight away.
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Extend a Timer 2 count to 32 bits.  The counter may have overflowed
+//  after the count was taken but before the overflow interrupt has run, the
+//  overflow is still pending in this case and the count is small.
+//
+//  Only call this from an interrupt handler.
+//
+unsigned long Timer2Time(unsigned char high, unsigned char low)
+{
+    unsigned short overflows = _timer2Overflows;
+    if (TIM2_SR1_UIF && !(high & 0x80))
+    {
+        overflows++;
+    }
+    return(((unsigned long) overflows << 16) | ((unsigned short) high << 8) | low);
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Current Timer 2 time (uS), reading the high byte latches the low byte.
+//
+unsigned long Timer2Now()
+{
+    unsigned char high = TIM2_CNTRH;
+    unsigned char low = TIM2_CNTRL;
+    return(Timer2Time(high, low));
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Set Timer 2 channel 2 to interrupt when the earliest lockout ends.  The
+//  compare only uses the low 16 bits so long windows may interrupt early,
+//  EndLockouts simply schedules the interrupt again.
+//
+void ScheduleLockoutEnd()
+{
+    unsigned long end = 0;
+    bool found = false;
+    for (unsigned char input = 0; input < DEBOUNCE_INPUTS; input++)
+    {
+        if ((_lockedOut & (1 << input)) && (!found || ((long) (_lockoutEnd[input] - end) < 0)))
+        {
+            end = _lockoutEnd[input];
+            found = true;
+        }
+    }
+    if (found)
+    {
+        TIM2_CCR2H = (unsigned char) ((end >> 8) & 0xff);   //  High byte first.
+        TIM2_CCR2L = (unsigned char) (end & 0xff);
+        TIM2_SR1_CC2IF = 0;
+        TIM2_IER_CC2IE = 1;
+    }
+    else
+    {
+        TIM2_IER_CC2IE = 0;
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Select the edge captured by Timer 2 channel 1, the polarity can only be
+//  changed while the capture is disabled.
+//
+void SetAnemometerEdge(bool rising)
+{
+    TIM2_CCER1_CC1E = 0;
+    TIM2_CCER1_CC1P = rising ? 0 : 1;
+    TIM2_CCER1_CC1E = 1;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Mask the interrupt for an input until its debounce window has passed.
+//
+void StartLockout(unsigned char input, unsigned long now)
+{
+    unsigned char window = _debounceWindow[input];
+    if (window == 0)
+    {
+        return;
+    }
+    _lockoutEnd[input] = now + (window * 1000UL);
+    _lockedOut |= (1 << input);
+    if (input == DEBOUNCE_RAIN_GAUGE)
+    {
+        PD_CR2_C23 = 0;
+    }
+    else
+    {
+        TIM2_IER_CC1IE = 0;
+    }
+    ScheduleLockoutEnd();
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Unmask the inputs whose debounce window has passed.  Any edges during
+//  the lockout are discarded, the last known state of the rain gauge is
+//  refreshed and any capture made by Timer 2 is thrown away.
+//
+void EndLockouts()
+{
+    unsigned long now = Timer2Now();
+    for (unsigned char input = 0; input < DEBOUNCE_INPUTS; input++)
+    {
+        unsigned char mask = 1 << input;
+        if ((_lockedOut & mask) && ((long) (now - _lockoutEnd[input]) >= 0))
+        {
+            _lockedOut &= ~mask;
+            if (input == DEBOUNCE_RAIN_GAUGE)
+            {
+                unsigned char rainGauge = PD_IDR & MASK_RAIN_GAUGE;
+                if (rainGauge && !(_lastPortDInput & MASK_RAIN_GAUGE))
+                {
+                    _working.rainGaugePulseCount++;
+                }
+                _lastPortDInput = (_lastPortDInput & ~MASK_RAIN_GAUGE) | rainGauge;
+                PD_CR2_C23 = 1;
+            }
+            else
+            {
+                unsigned char reg = TIM2_CCR1H;
+                reg = TIM2_CCR1L;                   //  Clears CC1IF.
+                TIM2_SR2_CC1OF = 0;
+                bool high = ((PD_IDR & MASK_ANEMOMETER) != 0);
+                if (high && !TIM2_CCER1_CC1P)
+                {
+                    //
+                    //  The rising edge was hidden by the lockout, count the
+                    //  pulse but there is no time for it so the next period
+                    //  is not measured.
+                    //
+                    if (TIM1_CR1_CEN)
+                    {
+                        _working.windSpeedPulseCount++;
+                    }
+                    _windPulseSeen = false;
+                }
+                SetAnemometerEdge(!high);
+                TIM2_IER_CC1IE = 1;
+            }
+        }
+    }
+    ScheduleLockoutEnd();
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Process the interrupt on Port D.
+//
+//  The following devices can generate an interrupt on Port D:
+//      - RTC
+//      - Rain gauge
+//
+//  All interrupts will be generateed on the falling edge of a pulse.
+//
+#pragma vector = EXTI3_vector
+__interrupt void EXTI_PORTD_IRQHandler(void)
+{
+    unsigned char portDInput = PD_IDR;
+    //
+    //  XORing the current reading with the last reading will leave us with the
+    //  changed bits.
+    //
+    unsigned char changedBits = (portDInput ^ _lastPortDInput);
+    _lastPortDInput = portDInput;
+    //
+    //  Now work out what has changed and act accordingly.
+    //
+    if (changedBits & MASK_RTC)
+    {
+        //
+        //  RTC has generated an interrupt, generate a short interrupt pulse to
+        //  tell the ESP8266 that it is time to read the sensors on the falling
+        //	edge of the RTC pulse.
+        //
+        if (!(portDInput & MASK_RTC))
+        {
+            _alarmCount++;
+	        //
+    	    //  Start the ADC for the UV and wind direction sensor.
+        	//
+ 	       	ADC_CSR_CH = ADC_UV_SENSOR; //  ADC for the UV sensor first.
+    	    ADC_CR1_ADON = 1;			// Reference manual says do this twice.
+        	__no_operation();
+        	ADC_CR1_ADON = 1;
+        	//
+        	//	Now kick off the timer for the wind speed reading.
+        	//
+	        _working.windSpeedPulseCount = 0;
+	        _working.windPeriodTotal = 0;
+	        _working.windPeriodMinimum = 0;
+	        _working.windPeriodCount = 0;
+	        _dataReady = false;
+            BitBang(0x01);
+		    //
+    		//  Force Timer 1 to update without generating an interrupt.
+    		//  This is necessary to makes sure we start off with the correct
+    		//  count and prescalar values in the Timer 1 registers.
+    		//
+    		TIM1_CR1_URS = 1;
+    		TIM1_EGR_UG = 1;
+    		//
+    		//  Enable Timer 1
+    		//
+    		TIM1_CR1_CEN = 1;           //  Start Timer 1.
+            PC_ODR_ODR7 = 0;
+        }
+    }
+    if ((changedBits & MASK_RAIN_GAUGE) && !(_lockedOut & (1 << DEBOUNCE_RAIN_GAUGE)))
+    {
+        //
+        //  Ignore the switch bouncing on either edge, increment on the
+        //  rising edge only.
+        //
+        StartLockout(DEBOUNCE_RAIN_GAUGE, Timer2Now());
+        BitBang(0x02);
+        if (portDInput & MASK_RAIN_GAUGE)
+        {
+        	BitBang(0x04);
+            _working.rainGaugePulseCount++;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Timer 2 overflow handler, extend the counter to 32 bits.
+//
+#pragma vector = TIM2_OVR_UIF_vector
+__interrupt void TIM2_UPD_OVF_IRQHandler(void)
+{
+    _timer2Overflows++;
+    TIM2_SR1_UIF = 0;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  A pulse from the anemometer has been captured by Timer 2 channel 1.
+//
+//  Both edges are captured so that either one starts the debounce lockout,
+//  only the rising edge is a pulse.  Pulses are only counted while Timer 1
+//  is running, i.e. while the sensor readings are being collected.  The
+//  period ending with each pulse is added to the statistics, this includes
+//  a period which started before the reading so that a single pulse still
+//  gives a wind speed.
+//
+void AnemometerPulse()
+{
+    unsigned char high = TIM2_CCR1H;
+    unsigned char low = TIM2_CCR1L;         //  Reading CCR1L clears CC1IF.
+    unsigned long now = Timer2Time(high, low);
+    bool rising = !TIM2_CCER1_CC1P;
+    SetAnemometerEdge(!rising);
+    StartLockout(DEBOUNCE_ANEMOMETER, now);
+    if (!rising)
+    {
+        return;
+    }
+    unsigned long period = now - _lastWindPulse;
+    bool periodValid = _windPulseSeen && (period <= WIND_MAXIMUM_PERIOD);
+    _lastWindPulse = now;
+    _windPulseSeen = true;
+    BitBang(0x03);
+    if (TIM1_CR1_CEN)
+    {
+        BitBang(0x05);
+        _working.windSpeedPulseCount++;
+        if (periodValid)
+        {
+            _working.windPeriodTotal += period;
+            _working.windPeriodCount++;
+            if ((_working.windPeriodMinimum == 0) || (period < _working.windPeriodMinimum))
+            {
+                _working.windPeriodMinimum = period;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Timer 2 capture / compare handler, channel 1 captures the anemometer
+//  pulses and channel 2 ends the debounce lockouts.
+//
+#pragma vector = TIM2_CAPCOM_CC1IF_vector
+__interrupt void TIM2_CAPCOM_IRQHandler(void)
+{
+    if (TIM2_IER_CC1IE && TIM2_SR1_CC1IF)
+    {
+        AnemometerPulse();
+    }
+    if (TIM2_IER_CC2IE && TIM2_SR1_CC2IF)
+    {
+        TIM2_SR1_CC2IF = 0;
+        EndLockouts();
+    }
+}
+
+//--------------------------------------------------------------------------------
+//
+//  I2C interrupt handler.
+//
+#pragma vector = I2C_RXNE_vector
+__interrupt void I2C_IRQHandler()
+{
+    unsigned char reg;
+
+    BitBang(0x07);
+    if (I2C_SR1_ADDR)
+    {
+        _readFrame = _publishedFrame;
+        _txBufferPointer = 0;
+        _rxBufferPointer = 0;
+        _processCommand = false;
+        reg = I2C_SR1;
+        reg = I2C_SR3;
+        return;
+    }
+    if (I2C_SR1_RXNE)
+    {
+        if (_rxBufferPointer < I2C_INPUT_BUFFER_LENGTH)
+        {
+            reg = I2C_DR;
+            //
+            //  A register address must take effect straight away as the
+            //  read normally follows a repeated start rather than a stop.
+            //
+            if (_rxBufferPointer == 0)
+            {
+                _sendingRegisters = (reg >= I2C_REGISTER_BASE);
+                _registerPointer = reg;
+            }
+            _rxBuffer[_rxBufferPointer++] = reg;
+        }
+        else
+        {
+            //
+            //  If we get here then the calling application has sent too much
+            //  data.  We have no where to store this so we will discard it.
+            //
+            reg = I2C_DR;
+        }
+        return;
+    }
+    if (I2C_SR1_TXE)
+    {
+        if (_sendingRegisters)
+        {
+            I2C_DR = ReadRegister(_registerPointer++);
+            return;
+        }
+        unsigned int amount = _amountToSend;
+        if (_txBufferPointer < amount)
+        {
+            if (_sendingHistory)
+            {
+                reg = GetHistoryByte(_txBufferPointer++);
+            }
+            else
+            {
+                reg =  _txBuffer[_txBufferPointer++];
+            }
+            I2C_DR = reg;
+        }
+        else
+        {
+            //
+            //  Calling application is requesting too much data, return 0xff
+            //  for this and all subsequent requests.
+            //
+            I2C_SR2_AF = 0;         // End of slave transmission.
+            _processCommand = 0;
+        }
+        return;
+    }
+    if (I2C_SR2_AF)
+    {
+        I2C_SR2_AF = 0;             //  End of slave transmission.
+        _txBufferPointer = 0;
+        return;
+    }
+    if (I2C_SR1_STOPF)
+    {
+        //
+        //  The history response is built here rather than in the main loop
+        //  as the read may follow straight away.
+        //
+        if ((_rxBufferPointer >= 3) && (_rxBuffer[0] == I2C_GET_HISTORY))
+        {
+            PrepareHistoryResponse((_rxBuffer[1] << 8) | _rxBuffer[2], (_rxBufferPointer > 3) ? _rxBuffer[3] : HISTORY_LENGTH);
+        }
+        else
+        {
+            _processCommand = true;
+        }
+        _rxBufferPointer = 0;
+        I2C_CR2_STOP = 0;
+        reg = I2C_SR1;
+        return;
+    }
+    //
+    //  If we get here then we have an error so clear the error by reading the
+    //  status registers.
+    //
+    reg = I2C_SR1;
+    reg = I2C_SR2;
+    reg = I2C_SR3;
+}
+
+//--------------------------------------------------------------------------------
+//
+//  Main program loop.
+//
+int main()
+{
+    __disable_interrupt();
+    InitialiseSystemClock();
+    InitialiseGPIO();
+    _lastPortDInput = PD_IDR;
+    InitialiseI2C();
+    InitialiseADC();
+    InitialiseTimer1();
+    InitialiseTimer2();
+    _resetCode = 0;
+    __enable_interrupt();
+    while (1)
+    {
+        __wait_for_interrupt();
+        if (_processCommand)
+        {
+            ExecuteI2CCommand();
+        }
+    }
+}
@@ -0,0 +1,316 @@
+//
+//  Sensor scheduler class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "SensorScheduler.h"
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Default constructor.
+//
+SensorScheduler::SensorScheduler()
+{
+    memset(_tasks, 0, sizeof(_tasks));
+    _started = false;
+}
+
+//******************************************************************************
+//
+//  Schedule.
+//
+
+//
+//  Register a task.
+//
+//  period and phase are in milliseconds, the estimated cost is in
+//  microseconds.  Use AutomaticPhase to let the scheduler pick the phase.
+//  Registering a task a second time replaces the original settings.
+//
+bool SensorScheduler::AddTask(uint8_t task, unsigned long period, unsigned long phase, unsigned long estimatedCost)
+{
+    if ((task >= MaximumTasks) || (period == 0))
+    {
+        return(false);
+    }
+    _tasks[task].active = false;
+    if (phase == AutomaticPhase)
+    {
+        phase = ChoosePhase(period);
+    }
+    memset(&_tasks[task], 0, sizeof(Task));
+    _tasks[task].period = period;
+    _tasks[task].phase = phase % period;
+    _tasks[task].estimatedCost = estimatedCost;
+    _tasks[task].active = true;
+    return(true);
+}
+
+//
+//  Start the schedule, now is the time (milliseconds) that phase 0 refers to.
+//
+void SensorScheduler::Start(unsigned long now)
+{
+    for (uint8_t task = 0; task < MaximumTasks; task++)
+    {
+        _tasks[task].nextDue = now + _tasks[task].phase;
+    }
+    _started = true;
+}
+
+//
+//  Get the next task which is due to run, -1 if nothing is due.
+//
+//  The task is assumed to have been run, if more than one period has been
+//  missed (loop() was busy) then the missed runs are skipped rather than
+//  running the task several times in succession.
+//
+int SensorScheduler::GetNextDueTask(unsigned long now)
+{
+    int result = -1;
+    long latest = 0;
+
+    if (!_started)
+    {
+        return(-1);
+    }
+    //
+    //  Pick the most overdue task.
+    //
+    for (uint8_t task = 0; task < MaximumTasks; task++)
+    {
+        if (_tasks[task].active)
+        {
+            long late = (long) (now - _tasks[task].nextDue);
+            if ((late >= 0) && ((result < 0) || (late > latest)))
+            {
+                result = task;
+                latest = late;
+            }
+        }
+    }
+    if (result >= 0)
+    {
+        Task *task = &_tasks[result];
+        task->lastLateness = latest;
+        if ((unsigned long) latest > task->maximumLateness)
+        {
+            task->maximumLateness = latest;
+        }
+        task->nextDue += task->period;
+        if ((long) (now - task->nextDue) >= 0)
+        {
+            unsigned long missed = ((now - task->nextDue) / task->period) + 1;
+            task->missedCount += missed;
+            task->nextDue += missed * task->period;
+        }
+        task->runCount++;
+    }
+    return(result);
+}
+
+//
+//  Record the time (microseconds) a task actually took.
+//
+void SensorScheduler::RecordExecution(uint8_t task, unsigned long cost)
+{
+    if (task >= MaximumTasks)
+    {
+        return;
+    }
+    _tasks[task].lastCost = cost;
+    _tasks[task].totalCost += cost;
+    if (cost > _tasks[task].maximumCost)
+    {
+        _tasks[task].maximumCost = cost;
+    }
+}
+
+//******************************************************************************
+//
+//  Phase selection.
+//
+
+//
+//  Greatest common divisor of two periods.
+//
+unsigned long SensorScheduler::GreatestCommonDivisor(unsigned long a, unsigned long b)
+{
+    while (b != 0)
+    {
+        unsigned long remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return(a);
+}
+
+//
+//  Work out the cost of the tasks which would run in the same slot as a task
+//  with the given period and phase.
+//
+//  Two periodic tasks with periods p1 and p2 run together whenever the
+//  difference in their phases is a multiple of gcd(p1, p2).
+//
+unsigned long SensorScheduler::PhaseLoad(unsigned long period, unsigned long phase)
+{
+    unsigned long load = 0;
+
+    for (uint8_t task = 0; task < MaximumTasks; task++)
+    {
+        if (_tasks[task].active)
+        {
+            unsigned long gcd = GreatestCommonDivisor(period, _tasks[task].period);
+            unsigned long distance = ((phase % gcd) + gcd - (_tasks[task].phase % gcd)) % gcd;
+            if ((distance < SlotPeriod) || ((gcd - distance) < SlotPeriod))
+            {
+                load += _tasks[task].estimatedCost;
+            }
+        }
+    }
+    return(load);
+}
+
+//
+//  Choose the phase for a new task which clashes with the least work.
+//
+//  At most 240 candidate phases are tried, a whole number of slots apart.
+//
+unsigned long SensorScheduler::ChoosePhase(unsigned long period)
+{
+    unsigned long step = SlotPeriod;
+    unsigned long bestPhase = 0;
+    unsigned long bestLoad = 0xffffffff;
+
+    if (period <= SlotPeriod)
+    {
+        return(0);
+    }
+    if ((period / step) > 240)
+    {
+        step = ((period / 240) / SlotPeriod + 1) * SlotPeriod;
+    }
+    for (unsigned long phase = 0; phase < period; phase += step)
+    {
+        unsigned long load = PhaseLoad(period, phase);
+        if (load < bestLoad)
+        {
+            bestLoad = load;
+            bestPhase = phase;
+        }
+    }
+    return(bestPhase);
+}
+
+//******************************************************************************
+//
+//  Schedule information and statistics.
+//
+
+//
+//  Period of the task (milliseconds).
+//
+unsigned long SensorScheduler::GetPeriod(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].period : 0);
+}
+
+//
+//  Phase of the task within its period (milliseconds).
+//
+unsigned long SensorScheduler::GetPhase(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].phase : 0);
+}
+
+//
+//  Planned cost of the task (microseconds).
+//
+unsigned long SensorScheduler::GetEstimatedCost(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].estimatedCost : 0);
+}
+
+//
+//  Actual cost of the last run of the task (microseconds).
+//
+unsigned long SensorScheduler::GetLastCost(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].lastCost : 0);
+}
+
+//
+//  Highest actual cost of the task (microseconds).
+//
+unsigned long SensorScheduler::GetMaximumCost(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].maximumCost : 0);
+}
+
+//
+//  Average actual cost of the task (microseconds).
+//
+unsigned long SensorScheduler::GetAverageCost(uint8_t task)
+{
+    if ((task >= MaximumTasks) || (_tasks[task].runCount == 0))
+    {
+        return(0);
+    }
+    return((unsigned long) (_tasks[task].totalCost / _tasks[task].runCount));
+}
+
+//
+//  Time between the planned and actual start of the last run (milliseconds).
+//
+unsigned long SensorScheduler::GetLastLateness(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].lastLateness : 0);
+}
+
+//
+//  Worst time between the planned and actual start of the task (milliseconds).
+//
+unsigned long SensorScheduler::GetMaximumLateness(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].maximumLateness : 0);
+}
+
+//
+//  Number of times the task has been run.
+//
+uint32_t SensorScheduler::GetRunCount(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].runCount : 0);
+}
+
+//
+//  Number of runs skipped because the task was more than a period late.
+//
+uint32_t SensorScheduler::GetMissedCount(uint8_t task)
+{
+    return((task < MaximumTasks) ? _tasks[task].missedCount : 0);
+}
@@ -0,0 +1,102 @@
+//
+//  Header for the sensor scheduler class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __SENSORSCHEDULER_H__
+#define __SENSORSCHEDULER_H__
+
+#include <Arduino.h>
+
+//
+//  Decide when each sensor should be read.
+//
+//  Each task (sensor) has a period, a phase offset within the period and an
+//  estimated cost (the time the processor is busy talking to the sensor).
+//  The scheduler only reports the tasks which are due, the caller runs the
+//  task and reports the time it actually took.  The planned and actual start
+//  times and costs are kept so that the schedule can be tuned.
+//
+//  If the phase is not given then the scheduler picks the phase which keeps
+//  the task away from the tasks already registered so that the I2C and
+//  OneWire work is spread out rather than happening in the same pass through
+//  loop().
+//
+class SensorScheduler
+{
+    public:
+        static const uint8_t MaximumTasks = 8;
+        static const unsigned long AutomaticPhase = 0xffffffff;
+        //
+        //  Phases are chosen with this resolution (milliseconds), two tasks due
+        //  within a slot of each other are considered to clash.
+        //
+        static const unsigned long SlotPeriod = 250;
+
+        SensorScheduler();
+        bool AddTask(uint8_t, unsigned long, unsigned long, unsigned long);
+        void Start(unsigned long);
+        int GetNextDueTask(unsigned long);
+        void RecordExecution(uint8_t, unsigned long);
+        //
+        //  Schedule information and statistics.
+        //
+        unsigned long GetPeriod(uint8_t);
+        unsigned long GetPhase(uint8_t);
+        unsigned long GetEstimatedCost(uint8_t);
+        unsigned long GetLastCost(uint8_t);
+        unsigned long GetMaximumCost(uint8_t);
+        unsigned long GetAverageCost(uint8_t);
+        unsigned long GetLastLateness(uint8_t);
+        unsigned long GetMaximumLateness(uint8_t);
+        uint32_t GetRunCount(uint8_t);
+        uint32_t GetMissedCount(uint8_t);
+
+    private:
+        //
+        //  Task details, the times are in milliseconds and the costs in
+        //  microseconds.
+        //
+        struct Task
+        {
+            bool active;
+            unsigned long period;
+            unsigned long phase;
+            unsigned long estimatedCost;
+            unsigned long nextDue;
+            unsigned long lastCost;
+            unsigned long maximumCost;
+            uint64_t totalCost;
+            unsigned long lastLateness;
+            unsigned long maximumLateness;
+            uint32_t runCount;
+            uint32_t missedCount;
+        };
+        Task _tasks[MaximumTasks];
+        bool _started;
+        unsigned long ChoosePhase(unsigned long);
+        unsigned long PhaseLoad(unsigned long, unsigned long);
+        static unsigned long GreatestCommonDivisor(unsigned long, unsigned long);
+};
+
+#endif
@@ -0,0 +1,243 @@
+//
+//  Telemetry frame, compact binary encoding of a set of readings.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "TelemetryFrame.h"
+
+//
+//  Size (bytes) and scale of each field in a version 1 frame.  The wind
+//  direction is the compass point and the time of the sample is held in
+//  the frame header.
+//
+const TelemetryFrame::FieldEncoding TelemetryFrame::_encoding[TelemetrySerializer::NumberOfFields] =
+{
+    { 2, 10 },          // Air pressure (hPa).
+    { 2, 100 },         // Ground temperature (C).
+    { 2, 100 },         // Air temperature (C).
+    { 2, 100 },         // Humidity (%).
+    { 4, 100 },         // Luminosity (lux).
+    { 4, 100 },         // Rainfall today (mm).
+    { 4, 100 },         // Rain rate (mm/h), a cloudburst can exceed 327 mm/h.
+    { 2, 100 },         // Rainfall, 10 minutes (mm).
+    { 2, 100 },         // Rainfall, 1 hour (mm).
+    { 4, 100 },         // Rainfall, 24 hours (mm).
+    { 1, 1 },           // Wind direction (compass point).
+    { 2, 10 },          // Mean wind direction, 2 minutes (degrees).
+    { 2, 10 },          // Wind direction standard deviation, 2 minutes (degrees).
+    { 2, 10 },          // Mean wind direction, 10 minutes (degrees).
+    { 2, 10 },          // Wind direction standard deviation, 10 minutes (degrees).
+    { 2, 100 },         // Wind speed, 2 minutes (mph).
+    { 2, 100 },         // Wind speed, 10 minutes (mph).
+    { 2, 100 },         // Wind gust (mph).
+    { 0, 1 }            // Sample time (in the header).
+};
+
+//******************************************************************************
+//
+//  Encoding and decoding.
+//
+
+//
+//  Encode the sample into the buffer, returns the length of the frame or 0
+//  if the buffer is too small.
+//
+size_t TelemetryFrame::Encode(const TelemetrySerializer::Sample &sample, uint32_t sequence, uint8_t *buffer, size_t size)
+{
+    uint32_t present = 0;
+    size_t length = HeaderSize;
+
+    if (size < (HeaderSize + 2))
+    {
+        return(0);
+    }
+    for (uint8_t field = 0; field < TelemetrySerializer::NumberOfFields; field++)
+    {
+        uint8_t fieldSize = _encoding[field].size;
+        int32_t value;
+
+        if (fieldSize == 0)
+        {
+            continue;
+        }
+        if (field == TelemetrySerializer::WindDirection)
+        {
+            if (sample.windDirection >= 16)
+            {
+                continue;
+            }
+            value = sample.windDirection;
+        }
+        else
+        {
+            double scaled = (double) sample.values[field] * _encoding[field].scale;
+            double limit = (fieldSize == 4) ? 2147483647.0 : 32767.0;
+            if (isnan(scaled) || (scaled > limit) || (scaled < -limit))
+            {
+                continue;
+            }
+            value = (int32_t) lround(scaled);
+        }
+        if ((length + fieldSize + 2) > size)
+        {
+            return(0);
+        }
+        WriteInteger(buffer + length, value, fieldSize);
+        length += fieldSize;
+        present |= 1UL << field;
+    }
+    length += 2;
+    buffer[0] = Version;
+    buffer[1] = (uint8_t) length;
+    WriteInteger(buffer + 2, (int32_t) sequence, 4);
+    WriteInteger(buffer + 6, (int32_t) sample.timestamp, 4);
+    WriteInteger(buffer + 10, (int32_t) present, 3);
+    WriteInteger(buffer + length - 2, CRC16(buffer, length - 2), 2);
+    return(length);
+}
+
+//
+//  Decode the frame at the start of the buffer.  Fields which are not
+//  present are set to NAN.  Returns the length of the frame or 0 if the
+//  buffer does not start with a valid frame.
+//
+size_t TelemetryFrame::Decode(const uint8_t *buffer, size_t size, TelemetrySerializer::Sample &sample, uint32_t &sequence)
+{
+    size_t length = GetFrameLength(buffer, size);
+
+    if (length == 0)
+    {
+        return(0);
+    }
+    uint32_t present = (uint32_t) ReadInteger(buffer + 10, 3) & 0xffffff;
+    size_t offset = HeaderSize;
+    sample.timestamp = (uint32_t) ReadInteger(buffer + 6, 4);
+    sample.windDirection = TelemetrySerializer::UnknownWindDirection;
+    for (uint8_t field = 0; field < TelemetrySerializer::NumberOfFields; field++)
+    {
+        uint8_t fieldSize = _encoding[field].size;
+
+        sample.values[field] = NAN;
+        if ((present & (1UL << field)) == 0)
+        {
+            continue;
+        }
+        if ((fieldSize == 0) || ((offset + fieldSize + 2) > length))
+        {
+            return(0);
+        }
+        int32_t value = ReadInteger(buffer + offset, fieldSize);
+        offset += fieldSize;
+        if (field == TelemetrySerializer::WindDirection)
+        {
+            sample.windDirection = (uint8_t) value;
+        }
+        else
+        {
+            sample.values[field] = (float) ((double) value / _encoding[field].scale);
+        }
+    }
+    if ((offset + 2) != length)
+    {
+        return(0);
+    }
+    sequence = (uint32_t) ReadInteger(buffer + 2, 4);
+    return(length);
+}
+
+//
+//  Check the version, length and CRC of the frame at the start of the
+//  buffer, returns the length of the frame or 0 if it is not valid.
+//
+size_t TelemetryFrame::GetFrameLength(const uint8_t *buffer, size_t size)
+{
+    if ((size < (HeaderSize + 2)) || (buffer[0] != Version))
+    {
+        return(0);
+    }
+    size_t length = buffer[1];
+    if ((length < (HeaderSize + 2)) || (length > size) || (length > MaximumFrameSize))
+    {
+        return(0);
+    }
+    if ((uint16_t) ReadInteger(buffer + length - 2, 2) != CRC16(buffer, length - 2))
+    {
+        return(0);
+    }
+    return(length);
+}
+
+//******************************************************************************
+//
+//  Helpers.
+//
+
+//
+//  Write the least significant size bytes of the value, little endian.
+//
+void TelemetryFrame::WriteInteger(uint8_t *buffer, int32_t value, uint8_t size)
+{
+    uint32_t bits = (uint32_t) value;
+
+    for (uint8_t index = 0; index < size; index++)
+    {
+        buffer[index] = bits & 0xff;
+        bits >>= 8;
+    }
+}
+
+//
+//  Read a little endian signed integer of size bytes.
+//
+int32_t TelemetryFrame::ReadInteger(const uint8_t *buffer, uint8_t size)
+{
+    uint32_t bits = 0;
+
+    for (uint8_t index = size; index > 0; index--)
+    {
+        bits = (bits << 8) | buffer[index - 1];
+    }
+    if ((size < 4) && (bits & (1UL << ((size * 8) - 1))))
+    {
+        bits |= 0xffffffffUL << (size * 8);
+    }
+    return((int32_t) bits);
+}
+
+//
+//  CRC-16-CCITT (polynomial 0x1021, initial value 0xffff).  Passing the
+//  result of a previous call as the initial value continues the CRC over
+//  more data, the telemetry log uses this for its record headers.
+//
+uint16_t TelemetryFrame::CRC16(const uint8_t *data, size_t length, uint16_t crc)
+{
+    while (length--)
+    {
+        crc ^= (uint16_t) (*data++) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return(crc);
+}
@@ -0,0 +1,81 @@
+//
+//  Header for the telemetry frame class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __TELEMETRYFRAME_H__
+#define __TELEMETRYFRAME_H__
+
+#include "TelemetrySerializer.h"
+
+//
+//  Compact binary encoding of one set of readings, used for the telemetry
+//  log, batch uploads and archives.
+//
+//  Frame layout (version 1, all values little endian):
+//
+//      Offset  Size    Contents
+//      0       1       Version.
+//      1       1       Length of the frame in bytes (including the CRC).
+//      2       4       Sequence number.
+//      6       4       Time of the sample (Unix time, 0 if not known).
+//      10      3       Presence bitmap, bit n set if field n is present.
+//      13      n       Values of the fields which are present, in field
+//                      order, as fixed point signed integers.
+//      13 + n  2       CRC-16-CCITT of the bytes before the CRC.
+//
+//  The size and scale of each field are fixed by the layout table for the
+//  version.  Values which are not a number or out of range for the field
+//  are left out.  A frame with every field present is 58 bytes.
+//
+//  The encoder and decoder do not depend on the sensors so the same code can
+//  be built into the station and the systems which receive the readings.
+//
+class TelemetryFrame
+{
+    public:
+        static const uint8_t Version = 1;
+        static const uint8_t HeaderSize = 13;
+        static const uint8_t MaximumFrameSize = 64;
+
+        static size_t Encode(const TelemetrySerializer::Sample &, uint32_t, uint8_t *, size_t);
+        static size_t Decode(const uint8_t *, size_t, TelemetrySerializer::Sample &, uint32_t &);
+        static size_t GetFrameLength(const uint8_t *, size_t);
+        static uint16_t CRC16(const uint8_t *, size_t, uint16_t crc = 0xffff);
+
+    private:
+        //
+        //  Encoding of a field, the value is multiplied by scale and stored
+        //  in size bytes (0 for fields which are not part of the frame).
+        //
+        struct FieldEncoding
+        {
+            uint8_t size;
+            uint16_t scale;
+        };
+        static const FieldEncoding _encoding[TelemetrySerializer::NumberOfFields];
+        static void WriteInteger(uint8_t *, int32_t, uint8_t);
+        static int32_t ReadInteger(const uint8_t *, uint8_t);
+};
+
+#endif
@@ -0,0 +1,580 @@
+//
+//  Telemetry log, an append only log of records held in raw flash sectors.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "TelemetryLog.h"
+#include "TelemetryFrame.h"
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Create a log using numberOfSectors (at least two) flash sectors starting
+//  at firstSector.  Mount() must be called before the log is used.
+//
+TelemetryLog::TelemetryLog(uint32_t firstSector, uint16_t numberOfSectors)
+{
+    _firstSector = firstSector;
+    _numberOfSectors = (numberOfSectors < 2) ? 2 : numberOfSectors;
+    _mounted = false;
+    _sectorSequence = 0;
+    _nextSequence = 1;
+    _head.sector = 0;
+    _head.offset = sizeof(SectorHeader);
+    _tail = _head;
+    _reader = _head;
+    _pendingCount = 0;
+    _recordsLost = 0;
+    _crcFailures = 0;
+    _flashBytesWritten = 0;
+    _payloadBytesWritten = 0;
+}
+
+//******************************************************************************
+//
+//  Log management.
+//
+
+//
+//  Rebuild the state of the log from the contents of the flash.
+//
+//  The sector with the highest sequence number holds the newest records and
+//  the next record is written after the last record in that sector.  The
+//  oldest sector is the first formatted sector after the newest one.  A log
+//  which has never been written is formatted.
+//
+bool TelemetryLog::Mount()
+{
+    SectorHeader sectorHeader;
+    RecordHeader header;
+    bool found = false;
+    uint16_t newest = 0;
+
+    _mounted = false;
+    for (uint16_t sector = 0; sector < _numberOfSectors; sector++)
+    {
+        if (ReadSectorHeader(sector, sectorHeader) && (!found || (sectorHeader.sequence > _sectorSequence)))
+        {
+            _sectorSequence = sectorHeader.sequence;
+            newest = sector;
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        return(Format());
+    }
+    //
+    //  Find the end of the records in the newest sector.  A damaged header
+    //  closes the sector, the next record starts a new one.
+    //
+    _head.sector = newest;
+    _head.offset = sizeof(SectorHeader);
+    while ((_head.offset + sizeof(RecordHeader)) <= SPI_FLASH_SEC_SIZE)
+    {
+        if (!ESP.flashRead(SectorAddress(_head.sector) + _head.offset, (uint32_t *) &header, sizeof(header)))
+        {
+            return(false);
+        }
+        if (header.sequence == _unwritten)
+        {
+            break;
+        }
+        if ((header.length > MaximumRecordSize) || ((_head.offset + sizeof(RecordHeader) + PaddedLength(header.length)) > SPI_FLASH_SEC_SIZE))
+        {
+            _head.offset = SPI_FLASH_SEC_SIZE;
+            break;
+        }
+        _nextSequence = header.sequence + 1;
+        Skip(_head, header);
+    }
+    //
+    //  Walk the log from the oldest sector to find the records which have
+    //  not been acknowledged.
+    //
+    Position oldest;
+    oldest.sector = NextSector(newest);
+    oldest.offset = sizeof(SectorHeader);
+    while ((oldest.sector != newest) && !ReadSectorHeader(oldest.sector, sectorHeader))
+    {
+        oldest.sector = NextSector(oldest.sector);
+    }
+    _mounted = true;
+    FindTail(oldest);
+    Rewind();
+    return(true);
+}
+
+//
+//  Discard the contents of the log.
+//
+//  Only the sectors which hold part of a log are erased, the remaining
+//  sectors are erased as the log reaches them.
+//
+bool TelemetryLog::Format()
+{
+    SectorHeader header;
+
+    _mounted = false;
+    for (uint16_t sector = 0; sector < _numberOfSectors; sector++)
+    {
+        if (ReadSectorHeader(sector, header) && !ESP.flashEraseSector(_firstSector + sector))
+        {
+            return(false);
+        }
+    }
+    _sectorSequence = 0;
+    _nextSequence = 1;
+    _pendingCount = 0;
+    if (!StartSector(0))
+    {
+        return(false);
+    }
+    _head.sector = 0;
+    _head.offset = sizeof(SectorHeader);
+    _tail = _head;
+    _reader = _head;
+    _mounted = true;
+    return(true);
+}
+
+//
+//  Indicate if the log is ready for use.
+//
+bool TelemetryLog::IsMounted()
+{
+    return(_mounted);
+}
+
+//
+//  Append a record to the log, sequence is set to the sequence number of the
+//  new record.
+//
+//  When the current sector is full the next sector is erased and any records
+//  in it which have not been acknowledged are lost.
+//
+bool TelemetryLog::Append(const uint8_t *data, uint16_t length, uint32_t &sequence)
+{
+    uint16_t size = sizeof(RecordHeader) + PaddedLength(length);
+
+    if (!_mounted || (length > MaximumRecordSize))
+    {
+        return(false);
+    }
+    if ((_head.offset + size) > SPI_FLASH_SEC_SIZE)
+    {
+        uint16_t next = NextSector(_head.sector);
+        if (!StartSector(next))
+        {
+            return(false);
+        }
+        _head.sector = next;
+        _head.offset = sizeof(SectorHeader);
+    }
+    RecordHeader *header = (RecordHeader *) _record;
+    uint8_t *payload = (uint8_t *) (header + 1);
+    header->sequence = _nextSequence;
+    header->length = length;
+    header->state = _recordPending;
+    memcpy(payload, data, length);
+    memset(payload + length, 0xff, PaddedLength(length) - length);
+    header->crc = TelemetryFrame::CRC16(payload, length, TelemetryFrame::CRC16((const uint8_t *) header, 6));
+    if (!ESP.flashWrite(SectorAddress(_head.sector) + _head.offset, _record, size))
+    {
+        return(false);
+    }
+    if (_pendingCount == 0)
+    {
+        _tail = _head;
+    }
+    _pendingCount++;
+    _flashBytesWritten += size;
+    _payloadBytesWritten += length;
+    sequence = _nextSequence++;
+    _head.offset += size;
+    return(true);
+}
+
+//******************************************************************************
+//
+//  Reading the log.
+//
+
+//
+//  Move the reader back to the oldest record which has not been acknowledged.
+//
+void TelemetryLog::Rewind()
+{
+    _reader = _tail;
+}
+
+//
+//  Read the next record which has not been acknowledged.
+//
+//  Records with a bad CRC are acknowledged and skipped.  Returns false when
+//  there are no more records or the record will not fit in the buffer.
+//
+bool TelemetryLog::ReadNext(uint8_t *buffer, uint16_t size, uint16_t &length, uint32_t &sequence)
+{
+    RecordHeader header;
+
+    if (!_mounted)
+    {
+        return(false);
+    }
+    while (Seek(_reader, header))
+    {
+        Position record = _reader;
+        if (header.state == _recordPending)
+        {
+            if (!IsRecordValid(record, header))
+            {
+                MarkAcknowledged(record);
+                _crcFailures++;
+                _pendingCount--;
+            }
+            else
+            {
+                if (header.length > size)
+                {
+                    return(false);
+                }
+                Skip(_reader, header);
+                memcpy(buffer, ((uint8_t *) _record) + sizeof(RecordHeader), header.length);
+                length = header.length;
+                sequence = header.sequence;
+                return(true);
+            }
+        }
+        Skip(_reader, header);
+    }
+    return(false);
+}
+
+//
+//  Mark all of the records up to and including sequence as uploaded, returns
+//  the number of records acknowledged.
+//
+uint32_t TelemetryLog::Acknowledge(uint32_t sequence)
+{
+    RecordHeader header;
+    uint32_t count = 0;
+
+    if (!_mounted)
+    {
+        return(0);
+    }
+    while ((_pendingCount > 0) && Seek(_tail, header) && ((header.state != _recordPending) || (header.sequence <= sequence)))
+    {
+        if (header.state == _recordPending)
+        {
+            MarkAcknowledged(_tail);
+            _pendingCount--;
+            count++;
+        }
+        Skip(_tail, header);
+    }
+    if (_pendingCount == 0)
+    {
+        _tail = _head;
+    }
+    return(count);
+}
+
+//
+//  Sequence number which will be given to the next record appended.
+//
+uint32_t TelemetryLog::GetNextSequence()
+{
+    return(_nextSequence);
+}
+
+//
+//  Number of records waiting to be uploaded.
+//
+uint32_t TelemetryLog::GetPendingCount()
+{
+    return(_pendingCount);
+}
+
+//******************************************************************************
+//
+//  Statistics.
+//
+
+//
+//  Records overwritten before they were acknowledged.
+//
+uint32_t TelemetryLog::GetRecordsLost()
+{
+    return(_recordsLost);
+}
+
+//
+//  Records discarded because the CRC did not match.
+//
+uint32_t TelemetryLog::GetCRCFailures()
+{
+    return(_crcFailures);
+}
+
+//
+//  Bytes programmed into the flash (headers, padding and acknowledgements).
+//
+uint32_t TelemetryLog::GetFlashBytesWritten()
+{
+    return(_flashBytesWritten);
+}
+
+//
+//  Bytes of record data written, the ratio of flash bytes to payload bytes
+//  is the write amplification.
+//
+uint32_t TelemetryLog::GetPayloadBytesWritten()
+{
+    return(_payloadBytesWritten);
+}
+
+//
+//  Lowest and highest erase counts of the formatted sectors, with even wear
+//  these differ by at most one.
+//
+void TelemetryLog::GetEraseCounts(uint32_t &minimum, uint32_t &maximum)
+{
+    SectorHeader header;
+
+    minimum = 0xffffffff;
+    maximum = 0;
+    for (uint16_t sector = 0; sector < _numberOfSectors; sector++)
+    {
+        if (ReadSectorHeader(sector, header))
+        {
+            minimum = (header.eraseCount < minimum) ? header.eraseCount : minimum;
+            maximum = (header.eraseCount > maximum) ? header.eraseCount : maximum;
+        }
+    }
+    if (maximum == 0)
+    {
+        minimum = 0;
+    }
+}
+
+//
+//  Space available for records (bytes).
+//
+uint32_t TelemetryLog::GetCapacity()
+{
+    return((uint32_t) (_numberOfSectors - 1) * (SPI_FLASH_SEC_SIZE - sizeof(SectorHeader)));
+}
+
+//******************************************************************************
+//
+//  Sectors and records.
+//
+
+//
+//  Flash address of a sector in the log.
+//
+uint32_t TelemetryLog::SectorAddress(uint16_t sector)
+{
+    return((_firstSector + sector) * SPI_FLASH_SEC_SIZE);
+}
+
+//
+//  Sectors are used in rotation.
+//
+uint16_t TelemetryLog::NextSector(uint16_t sector)
+{
+    return((sector + 1) % _numberOfSectors);
+}
+
+//
+//  Read the header of a sector, returns false if the sector is not part of
+//  a log.
+//
+bool TelemetryLog::ReadSectorHeader(uint16_t sector, SectorHeader &header)
+{
+    if (!ESP.flashRead(SectorAddress(sector), (uint32_t *) &header, sizeof(header)))
+    {
+        return(false);
+    }
+    return(header.magic == _sectorMagic);
+}
+
+//
+//  Erase a sector and write a new header carrying the erase count forward.
+//
+//  Any records in the sector which have not been acknowledged are lost and
+//  the tail moves on to the next record.
+//
+bool TelemetryLog::StartSector(uint16_t sector)
+{
+    SectorHeader header;
+    uint32_t eraseCount = 1;
+
+    if ((_pendingCount > 0) && (_tail.sector == sector))
+    {
+        RecordHeader record;
+        while (Seek(_tail, record) && (_tail.sector == sector))
+        {
+            if (record.state == _recordPending)
+            {
+                _recordsLost++;
+                _pendingCount--;
+            }
+            Skip(_tail, record);
+        }
+        if (_reader.sector == sector)
+        {
+            _reader = _tail;
+        }
+    }
+    if (ReadSectorHeader(sector, header))
+    {
+        eraseCount = header.eraseCount + 1;
+    }
+    if (!ESP.flashEraseSector(_firstSector + sector))
+    {
+        return(false);
+    }
+    header.magic = _sectorMagic;
+    header.sequence = ++_sectorSequence;
+    header.eraseCount = eraseCount;
+    header.reserved = _unwritten;
+    _flashBytesWritten += sizeof(header);
+    return(ESP.flashWrite(SectorAddress(sector), (uint32_t *) &header, sizeof(header)));
+}
+
+//
+//  Move position forward to the next record, returns false when the head of
+//  the log is reached.
+//
+bool TelemetryLog::Seek(Position &position, RecordHeader &header)
+{
+    while ((position.sector != _head.sector) || (position.offset != _head.offset))
+    {
+        if ((position.offset + sizeof(RecordHeader)) <= SPI_FLASH_SEC_SIZE)
+        {
+            if (!ESP.flashRead(SectorAddress(position.sector) + position.offset, (uint32_t *) &header, sizeof(header)))
+            {
+                return(false);
+            }
+            if ((header.sequence != _unwritten) && (header.length <= MaximumRecordSize) &&
+                ((position.offset + sizeof(RecordHeader) + PaddedLength(header.length)) <= SPI_FLASH_SEC_SIZE))
+            {
+                return(true);
+            }
+        }
+        if (position.sector == _head.sector)
+        {
+            position = _head;
+            return(false);
+        }
+        position.sector = NextSector(position.sector);
+        position.offset = sizeof(SectorHeader);
+    }
+    return(false);
+}
+
+//
+//  Step over the record at position.
+//
+void TelemetryLog::Skip(Position &position, const RecordHeader &header)
+{
+    position.offset += sizeof(RecordHeader) + PaddedLength(header.length);
+}
+
+//
+//  Read the payload of a record into the record buffer and check the CRC.
+//
+bool TelemetryLog::IsRecordValid(const Position &position, const RecordHeader &header)
+{
+    uint8_t *payload = ((uint8_t *) _record) + sizeof(RecordHeader);
+
+    if (!ESP.flashRead(SectorAddress(position.sector) + position.offset, _record, sizeof(RecordHeader) + PaddedLength(header.length)))
+    {
+        return(false);
+    }
+    return(TelemetryFrame::CRC16(payload, header.length, TelemetryFrame::CRC16((const uint8_t *) &header, 6)) == header.crc);
+}
+
+//
+//  Clear the state word of a record, flash bits can be cleared without
+//  erasing the sector.
+//
+void TelemetryLog::MarkAcknowledged(const Position &position)
+{
+    uint32_t state = _recordAcknowledged;
+
+    ESP.flashWrite(SectorAddress(position.sector) + position.offset + offsetof(RecordHeader, state), &state, sizeof(state));
+    _flashBytesWritten += sizeof(state);
+}
+
+//
+//  Find the oldest record which has not been acknowledged and count the
+//  records waiting to be uploaded.
+//
+void TelemetryLog::FindTail(Position position)
+{
+    RecordHeader header;
+    bool found = false;
+
+    _pendingCount = 0;
+    _tail = _head;
+    while (Seek(position, header))
+    {
+        if (header.state == _recordPending)
+        {
+            if (IsRecordValid(position, header))
+            {
+                if (!found)
+                {
+                    _tail = position;
+                    found = true;
+                }
+                _pendingCount++;
+            }
+            else
+            {
+                MarkAcknowledged(position);
+                _crcFailures++;
+            }
+        }
+        if ((header.sequence + 1) > _nextSequence)
+        {
+            _nextSequence = header.sequence + 1;
+        }
+        Skip(position, header);
+    }
+}
+
+//
+//  Records are padded to a multiple of four bytes (flash word size).
+//
+uint16_t TelemetryLog::PaddedLength(uint16_t length)
+{
+    return((length + 3) & ~3);
+}
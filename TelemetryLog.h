@@ -0,0 +1,134 @@
+//
+//  Header for the telemetry log class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __TELEMETRYLOG_H__
+#define __TELEMETRYLOG_H__
+
+#include <Arduino.h>
+
+//
+//  Append only log of telemetry records held in a range of raw flash sectors.
+//
+//  Records are written once, four byte aligned, and carry a sequence number
+//  and a CRC.  When a record has been uploaded its state word is cleared in
+//  place (flash bits can be cleared without an erase) so acknowledging a
+//  record costs a single four byte write.  The sectors are used in rotation
+//  so every sector is erased the same number of times, when the log is full
+//  the oldest sector is erased and any records in it which had not been
+//  uploaded are counted as lost.
+//
+//  Mount() rebuilds the log state by scanning the sector and record headers
+//  so the log survives a reset.  Records with a bad CRC (torn writes) are
+//  skipped.
+//
+class TelemetryLog
+{
+    public:
+        static const uint16_t MaximumRecordSize = 244;
+
+        TelemetryLog(uint32_t, uint16_t);
+        bool Mount();
+        bool Format();
+        bool IsMounted();
+        bool Append(const uint8_t *, uint16_t, uint32_t &);
+        uint32_t GetNextSequence();
+        //
+        //  Reading and acknowledging records which have not been uploaded.
+        //
+        void Rewind();
+        bool ReadNext(uint8_t *, uint16_t, uint16_t &, uint32_t &);
+        uint32_t Acknowledge(uint32_t);
+        uint32_t GetPendingCount();
+        //
+        //  Statistics.
+        //
+        uint32_t GetRecordsLost();
+        uint32_t GetCRCFailures();
+        uint32_t GetFlashBytesWritten();
+        uint32_t GetPayloadBytesWritten();
+        void GetEraseCounts(uint32_t &, uint32_t &);
+        uint32_t GetCapacity();
+
+    private:
+        //
+        //  Written at the start of each sector when it is erased.
+        //
+        struct SectorHeader
+        {
+            uint32_t magic;
+            uint32_t sequence;          // Increases each time a sector is started.
+            uint32_t eraseCount;
+            uint32_t reserved;
+        };
+        //
+        //  Written in front of each record, the payload follows padded to a
+        //  multiple of four bytes.
+        //
+        struct RecordHeader
+        {
+            uint32_t sequence;
+            uint16_t length;
+            uint16_t crc;               // CRC-16 of the sequence, length and payload.
+            uint32_t state;             // RecordPending until acknowledged.
+        };
+        //
+        //  Position of a record in the log.
+        //
+        struct Position
+        {
+            uint16_t sector;
+            uint16_t offset;
+        };
+        const uint32_t _sectorMagic = 0x474c5357;   // "WSLG"
+        const uint32_t _recordPending = 0xffffffff;
+        const uint32_t _recordAcknowledged = 0;
+        const uint32_t _unwritten = 0xffffffff;
+        uint32_t _firstSector;
+        uint16_t _numberOfSectors;
+        bool _mounted;
+        uint32_t _sectorSequence;
+        uint32_t _nextSequence;
+        Position _head;                 // Where the next record will be written.
+        Position _tail;                 // Oldest record not yet acknowledged.
+        Position _reader;
+        uint32_t _pendingCount;
+        uint32_t _recordsLost;
+        uint32_t _crcFailures;
+        uint32_t _flashBytesWritten;
+        uint32_t _payloadBytesWritten;
+        uint32_t _record[(sizeof(RecordHeader) + MaximumRecordSize) / 4];
+        uint32_t SectorAddress(uint16_t);
+        uint16_t NextSector(uint16_t);
+        bool ReadSectorHeader(uint16_t, SectorHeader &);
+        bool StartSector(uint16_t);
+        bool Seek(Position &, RecordHeader &);
+        void Skip(Position &, const RecordHeader &);
+        bool IsRecordValid(const Position &, const RecordHeader &);
+        void MarkAcknowledged(const Position &);
+        void FindTail(Position);
+        static uint16_t PaddedLength(uint16_t);
+};
+
+#endif
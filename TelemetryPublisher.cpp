@@ -0,0 +1,514 @@
+//
+//  Telemetry publisher, HTTP client using a persistent (keep-alive)
+//  connection.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "TelemetryPublisher.h"
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Publish to the server on the given port.  The host name must remain valid
+//  for the life of the publisher.
+//
+TelemetryPublisher::TelemetryPublisher(const char *host, uint16_t port)
+{
+    _host = host;
+    _port = port;
+    _addressResolved = false;
+    _state = Idle;
+    _statusCode = -1;
+    _response[0] = '\0';
+    _connectTime = 0;
+    _firstByteTime = 0;
+    _totalTime = 0;
+    _connectionReused = false;
+    _numberOfConnections = 0;
+    _numberOfRequests = 0;
+}
+
+//******************************************************************************
+//
+//  Requests.
+//
+
+//
+//  Start a GET request, returns false if a request is already in progress.
+//
+bool TelemetryPublisher::BeginGet(const char *uri)
+{
+    return(Begin("GET", uri, NULL, NULL, 0));
+}
+
+//
+//  Start a POST request, returns false if a request is already in progress.
+//
+bool TelemetryPublisher::BeginPost(const char *uri, const char *contentType, const uint8_t *body, size_t length)
+{
+    return(Begin("POST", uri, contentType, body, length));
+}
+
+//
+//  Record the request, nothing is sent until Service is called.
+//
+bool TelemetryPublisher::Begin(const char *method, const char *uri, const char *contentType, const uint8_t *body, size_t length)
+{
+    if (IsBusy())
+    {
+        return(false);
+    }
+    _method = method;
+    _uri = uri;
+    _contentType = contentType;
+    _body = body;
+    _length = length;
+    _attempt = 0;
+    _statusCode = -1;
+    _response[0] = '\0';
+    _start = millis();
+    _connectTime = 0;
+    _firstByteTime = 0;
+    _totalTime = 0;
+    _state = Connecting;
+    return(true);
+}
+
+//
+//  Advance the request in progress by one step, returns the new state.
+//
+TelemetryPublisher::RequestState TelemetryPublisher::Service()
+{
+    switch (_state)
+    {
+        case Connecting:
+            _connectionReused = _client.connected();
+            if (!_connectionReused)
+            {
+                unsigned long connectStart = millis();
+                if (!Connect())
+                {
+                    Finish(Failed);
+                    break;
+                }
+                _connectTime = millis() - connectStart;
+            }
+            _bodySent = 0;
+            _lineLength = 0;
+            _responseStarted = false;
+            _closeConnection = false;
+            _chunked = false;
+            _contentLength = -1;
+            _responseLength = 0;
+            if (!WriteHeader())
+            {
+                Retry();
+                break;
+            }
+            _state = (_body == NULL) ? ReadingStatus : Sending;
+            break;
+        case Sending:
+            SendBody();
+            break;
+        case ReadingStatus:
+        case ReadingHeaders:
+        case ReadingBody:
+        case ReadingChunkSize:
+        case ReadingTrailers:
+            Receive();
+            break;
+        default:
+            break;
+    }
+    return(_state);
+}
+
+//
+//  Current state of the request.
+//
+TelemetryPublisher::RequestState TelemetryPublisher::GetState()
+{
+    return(_state);
+}
+
+//
+//  Indicate if a request is in progress.
+//
+bool TelemetryPublisher::IsBusy()
+{
+    return((_state != Idle) && (_state != Complete) && (_state != Failed));
+}
+
+//
+//  HTTP status code of the last request or -1 if it failed.
+//
+int TelemetryPublisher::GetStatusCode()
+{
+    return(_statusCode);
+}
+
+//
+//  Body of the last response (truncated to MaximumResponseSize).
+//
+const char *TelemetryPublisher::GetResponse()
+{
+    return(_response);
+}
+
+//
+//  Close the connection to the server, any request in progress fails.
+//
+void TelemetryPublisher::Close()
+{
+    if (IsBusy())
+    {
+        Finish(Failed);
+    }
+    _client.stop();
+}
+
+//
+//  Open a new connection, the address of the server is looked up the first
+//  time and again if a connection fails.
+//
+bool TelemetryPublisher::Connect()
+{
+    if (!_addressResolved)
+    {
+        _addressResolved = (WiFi.hostByName(_host, _address) == 1);
+        if (!_addressResolved)
+        {
+            return(false);
+        }
+    }
+    if (!_client.connect(_address, _port))
+    {
+        _addressResolved = false;
+        return(false);
+    }
+    _numberOfConnections++;
+    return(true);
+}
+
+//
+//  Write the request line and headers.
+//
+bool TelemetryPublisher::WriteHeader()
+{
+    char header[160];
+    size_t size;
+
+    size = snprintf(header, sizeof(header), "%s ", _method);
+    if (_client.write((const uint8_t *) header, size) != size)
+    {
+        return(false);
+    }
+    size = strlen(_uri);
+    if (_client.write((const uint8_t *) _uri, size) != size)
+    {
+        return(false);
+    }
+    size = snprintf(header, sizeof(header), " HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n", _host);
+    if (_body != NULL)
+    {
+        size += snprintf(header + size, sizeof(header) - size, "Content-Type: %s\r\nContent-Length: %u\r\n", _contentType, (unsigned int) _length);
+    }
+    size += snprintf(header + size, sizeof(header) - size, "\r\n");
+    return((size < sizeof(header)) && (_client.write((const uint8_t *) header, size) == size));
+}
+
+//
+//  Send the next chunk of the body.
+//
+void TelemetryPublisher::SendBody()
+{
+    size_t size = _length - _bodySent;
+
+    if (size > SendChunkSize)
+    {
+        size = SendChunkSize;
+    }
+    if (_client.write(_body + _bodySent, size) != size)
+    {
+        Retry();
+        return;
+    }
+    _bodySent += size;
+    if (_bodySent == _length)
+    {
+        _state = ReadingStatus;
+    }
+}
+
+//
+//  Process the response data which has arrived, at most ReceiveChunkSize
+//  bytes are read each time.
+//
+void TelemetryPublisher::Receive()
+{
+    if (_client.available() == 0)
+    {
+        if (!_client.connected())
+        {
+            //
+            //  Without a content length the body runs until the server
+            //  closes the connection.
+            //
+            if ((_state == ReadingBody) && !_chunked && (_contentLength < 0))
+            {
+                _closeConnection = true;
+                Finish(Complete);
+            }
+            else if (!_responseStarted)
+            {
+                Retry();
+            }
+            else
+            {
+                Finish(Failed);
+            }
+        }
+        else if ((millis() - _start) >= ResponseTimeout)
+        {
+            Finish(Failed);
+        }
+        return;
+    }
+    if (!_responseStarted)
+    {
+        _responseStarted = true;
+        _firstByteTime = millis() - _start;
+    }
+    for (uint8_t count = 0; (count < ReceiveChunkSize) && IsBusy() && (_client.available() > 0); count++)
+    {
+        char character = (char) _client.read();
+        if (_state == ReadingBody)
+        {
+            if (_responseLength < MaximumResponseSize)
+            {
+                _response[_responseLength] = character;
+            }
+            _responseLength++;
+            if (_chunked)
+            {
+                if (--_chunkRemaining == 0)
+                {
+                    _state = ReadingChunkSize;
+                }
+            }
+            else if ((_contentLength >= 0) && ((long) _responseLength >= _contentLength))
+            {
+                Finish(Complete);
+            }
+        }
+        else if (character == '\n')
+        {
+            _line[_lineLength] = '\0';
+            ProcessLine();
+            _lineLength = 0;
+        }
+        else if ((character != '\r') && (_lineLength < (sizeof(_line) - 1)))
+        {
+            _line[_lineLength++] = character;
+        }
+    }
+}
+
+//
+//  Process a line of the status, headers, chunk sizes or trailers.
+//
+void TelemetryPublisher::ProcessLine()
+{
+    if (_state == ReadingStatus)
+    {
+        if ((_lineLength < 12) || (strncmp(_line, "HTTP/1.", 7) != 0))
+        {
+            Finish(Failed);
+            return;
+        }
+        _statusCode = atoi(_line + 9);
+        _state = ReadingHeaders;
+        return;
+    }
+    if (_state == ReadingChunkSize)
+    {
+        //
+        //  The empty line is the end of the previous chunk's data, the size
+        //  may be followed by chunk extensions which are ignored.
+        //
+        if (_lineLength > 0)
+        {
+            char *end;
+            _chunkRemaining = strtol(_line, &end, 16);
+            if ((end == _line) || (_chunkRemaining < 0))
+            {
+                Finish(Failed);
+            }
+            else
+            {
+                _state = (_chunkRemaining == 0) ? ReadingTrailers : ReadingBody;
+            }
+        }
+        return;
+    }
+    if (_state == ReadingTrailers)
+    {
+        if (_lineLength == 0)
+        {
+            Finish(Complete);
+        }
+        return;
+    }
+    if (_lineLength == 0)
+    {
+        //
+        //  An interim response is followed by the real response, 204 and
+        //  304 responses never have a body.
+        //
+        if ((_statusCode >= 100) && (_statusCode < 200))
+        {
+            _chunked = false;
+            _contentLength = -1;
+            _state = ReadingStatus;
+        }
+        else if ((_statusCode == 204) || (_statusCode == 304) || (!_chunked && (_contentLength == 0)))
+        {
+            Finish(Complete);
+        }
+        else
+        {
+            _state = _chunked ? ReadingChunkSize : ReadingBody;
+        }
+        return;
+    }
+    if (strncasecmp(_line, "Content-Length:", 15) == 0)
+    {
+        _contentLength = atol(_line + 15);
+    }
+    if ((strncasecmp(_line, "Transfer-Encoding:", 18) == 0) && (strstr(_line + 18, "chunked") != NULL))
+    {
+        _chunked = true;
+    }
+    if ((strncasecmp(_line, "Connection:", 11) == 0) && (strstr(_line + 11, "close") != NULL))
+    {
+        _closeConnection = true;
+    }
+}
+
+//
+//  The connection failed, if it had been reused then the server may have
+//  closed it while it was idle so try once more on a new connection.
+//
+void TelemetryPublisher::Retry()
+{
+    _client.stop();
+    if (_connectionReused && (_attempt == 0))
+    {
+        _attempt++;
+        _state = Connecting;
+    }
+    else
+    {
+        Finish(Failed);
+    }
+}
+
+//
+//  Complete the request, the connection is closed if the request failed or
+//  the server asked for it to be closed.
+//
+void TelemetryPublisher::Finish(RequestState state)
+{
+    if (state == Failed)
+    {
+        _statusCode = -1;
+        _client.stop();
+    }
+    else
+    {
+        _response[(_responseLength < MaximumResponseSize) ? _responseLength : MaximumResponseSize] = '\0';
+        if (_closeConnection)
+        {
+            _client.stop();
+        }
+    }
+    _state = state;
+    _totalTime = millis() - _start;
+    _numberOfRequests++;
+}
+
+//******************************************************************************
+//
+//  Statistics.
+//
+
+//
+//  Time taken to open the connection (0 if the connection was reused).
+//
+unsigned long TelemetryPublisher::GetConnectTime()
+{
+    return(_connectTime);
+}
+
+//
+//  Time from the start of the request to the first byte of the response.
+//
+unsigned long TelemetryPublisher::GetFirstByteTime()
+{
+    return(_firstByteTime);
+}
+
+//
+//  Time taken by the whole request.
+//
+unsigned long TelemetryPublisher::GetTotalTime()
+{
+    return(_totalTime);
+}
+
+//
+//  Indicate if the last request used a connection which was already open.
+//
+bool TelemetryPublisher::WasConnectionReused()
+{
+    return(_connectionReused);
+}
+
+//
+//  Number of connections opened.
+//
+uint32_t TelemetryPublisher::GetNumberOfConnections()
+{
+    return(_numberOfConnections);
+}
+
+//
+//  Number of requests sent.
+//
+uint32_t TelemetryPublisher::GetNumberOfRequests()
+{
+    return(_numberOfRequests);
+}
@@ -0,0 +1,131 @@
+//
+//  Header for the telemetry publisher class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __TELEMETRYPUBLISHER_H__
+#define __TELEMETRYPUBLISHER_H__
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+//
+//  HTTP/1.1 client which keeps one connection to a server open between
+//  requests.
+//
+//  Requests are asynchronous, BeginGet / BeginPost start a request and
+//  Service is then called from loop() to advance it a step at a time.  Each
+//  step writes or reads at most a small chunk of data so that the sensors can
+//  be serviced while the request is in flight.  The URI and body must remain
+//  valid until the request has completed.
+//
+//  The server address is looked up once and the connection is only opened
+//  when a request is made and the previous connection has been closed by the
+//  server.  A request sent on a reused connection which the server closed
+//  while it was idle is retried once on a new connection.
+//
+//  The response body may be sent with a Content-Length, chunked or, without
+//  either, run until the server closes the connection.  Interim (1xx)
+//  responses are skipped and 204 / 304 responses have no body.
+//
+//  The connect, first byte and total time of the last request are recorded.
+//
+class TelemetryPublisher
+{
+    public:
+        enum RequestState { Idle, Connecting, Sending, ReadingStatus, ReadingHeaders, ReadingBody, ReadingChunkSize, ReadingTrailers, Complete, Failed };
+        static const uint16_t MaximumResponseSize = 128;
+        static const size_t SendChunkSize = 256;
+        static const uint8_t ReceiveChunkSize = 64;
+        static const unsigned long ResponseTimeout = 5000;
+
+        TelemetryPublisher(const char *, uint16_t);
+        bool BeginGet(const char *);
+        bool BeginPost(const char *, const char *, const uint8_t *, size_t);
+        RequestState Service();
+        RequestState GetState();
+        bool IsBusy();
+        int GetStatusCode();
+        const char *GetResponse();
+        void Close();
+        //
+        //  Statistics for the last request (milliseconds).
+        //
+        unsigned long GetConnectTime();
+        unsigned long GetFirstByteTime();
+        unsigned long GetTotalTime();
+        bool WasConnectionReused();
+        uint32_t GetNumberOfConnections();
+        uint32_t GetNumberOfRequests();
+
+    private:
+        const char *_host;
+        uint16_t _port;
+        IPAddress _address;
+        bool _addressResolved;
+        WiFiClient _client;
+        RequestState _state;
+        //
+        //  Request being sent.
+        //
+        const char *_method;
+        const char *_uri;
+        const char *_contentType;
+        const uint8_t *_body;
+        size_t _length;
+        size_t _bodySent;
+        uint8_t _attempt;
+        //
+        //  Response being received.
+        //
+        char _line[MaximumResponseSize];
+        uint16_t _lineLength;
+        bool _responseStarted;
+        bool _closeConnection;
+        bool _chunked;
+        long _contentLength;
+        long _chunkRemaining;
+        size_t _responseLength;
+        int _statusCode;
+        char _response[MaximumResponseSize + 1];
+        //
+        //  Statistics.
+        //
+        unsigned long _start;
+        unsigned long _connectTime;
+        unsigned long _firstByteTime;
+        unsigned long _totalTime;
+        bool _connectionReused;
+        uint32_t _numberOfConnections;
+        uint32_t _numberOfRequests;
+        bool Begin(const char *, const char *, const char *, const uint8_t *, size_t);
+        bool Connect();
+        bool WriteHeader();
+        void SendBody();
+        void Receive();
+        void ProcessLine();
+        void Retry();
+        void Finish(RequestState);
+};
+
+#endif
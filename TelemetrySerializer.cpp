@@ -0,0 +1,539 @@
+//
+//  Telemetry serializer, writes the sensor readings into a fixed buffer
+//  without using the heap.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "TelemetrySerializer.h"
+
+//
+//  Field names and the number of decimal places sent for each field.
+//
+const TelemetrySerializer::FieldLayout TelemetrySerializer::_layout[TelemetrySerializer::NumberOfFields] =
+{
+    { "airpressure", 0 },
+    { "groundtemperature", 2 },
+    { "airtemperature", 2 },
+    { "humidity", 2 },
+    { "luminosity", 2 },
+    { "rainfall", 2 },
+    { "rainrate", 2 },
+    { "rainfall10m", 2 },
+    { "rainfall1h", 2 },
+    { "rainfall24h", 2 },
+    { "winddirection", 0 },
+    { "winddirectionmean2m", 0 },
+    { "winddirectionsd2m", 0 },
+    { "winddirectionmean10m", 0 },
+    { "winddirectionsd10m", 0 },
+    { "windspeed", 2 },
+    { "windspeed10m", 2 },
+    { "windgust", 2 },
+    { "sampletime", 0 }
+};
+
+//
+//  Compass point names in the same order as WeatherSensors::WindDirection.
+//
+const char *TelemetrySerializer::_windDirectionNames[16] =
+{
+    "North", "North-North-East", "North-East", "East-North-East",
+    "East", "East-South-East", "South-East", "South-South-East",
+    "South", "South-South-West", "South-West", "West-South-West",
+    "West", "West-North-West", "North-West", "North-North-West"
+};
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Serialize into the buffer of the given size (including the terminator).
+//
+TelemetrySerializer::TelemetrySerializer(char *buffer, size_t size)
+{
+    _buffer = buffer;
+    _size = size;
+    Begin(QueryString);
+}
+
+//******************************************************************************
+//
+//  Record construction.
+//
+
+//
+//  Start a new record, the prefix (if any) is copied to the buffer unchanged.
+//
+void TelemetrySerializer::Begin(Format format, const char *prefix)
+{
+    _format = format;
+    _length = 0;
+    _nextField = 0;
+    _overflow = (_size == 0);
+    _leadingSeparator = false;
+    if (prefix != NULL)
+    {
+        Append(prefix);
+    }
+    if (_format == JSON)
+    {
+        Append('{');
+    }
+    Terminate();
+}
+
+//
+//  Add a numeric field, values which are not a number are written as an
+//  empty field (null in JSON).
+//
+bool TelemetrySerializer::Add(Field field, float value)
+{
+    size_t start = _length;
+
+    if (!StartField(field))
+    {
+        _length = start;
+        Terminate();
+        return(false);
+    }
+    if (isnan(value) || isinf(value))
+    {
+        if (_format == JSON)
+        {
+            Append("null");
+        }
+    }
+    else
+    {
+        AppendNumber(value, _layout[field].decimalPlaces);
+    }
+    if (_overflow)
+    {
+        _length = start;
+    }
+    Terminate();
+    return(!_overflow);
+}
+
+//
+//  Add a text field.
+//
+bool TelemetrySerializer::Add(Field field, const char *value)
+{
+    size_t start = _length;
+
+    if (!StartField(field))
+    {
+        _length = start;
+        Terminate();
+        return(false);
+    }
+    if (_format == JSON)
+    {
+        Append('"');
+    }
+    AppendEscaped((value == NULL) ? "" : value);
+    if (_format == JSON)
+    {
+        Append('"');
+    }
+    if (_overflow)
+    {
+        _length = start;
+    }
+    Terminate();
+    return(!_overflow);
+}
+
+//
+//  Add an integer field, 0 is treated as unknown and written as an empty
+//  field (null in JSON).
+//
+bool TelemetrySerializer::Add(Field field, uint32_t value)
+{
+    size_t start = _length;
+
+    if (!StartField(field))
+    {
+        _length = start;
+        Terminate();
+        return(false);
+    }
+    if (value != 0)
+    {
+        AppendUnsigned(value);
+    }
+    else if (_format == JSON)
+    {
+        Append("null");
+    }
+    if (_overflow)
+    {
+        _length = start;
+    }
+    Terminate();
+    return(!_overflow);
+}
+
+//
+//  Add all of the fields in a sample.
+//
+bool TelemetrySerializer::Add(const Sample &sample)
+{
+    for (uint8_t field = 0; field < NumberOfFields; field++)
+    {
+        if (!AddField(sample, (Field) field))
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+//
+//  Add one field from a set of readings.
+//
+bool TelemetrySerializer::AddField(const Sample &sample, Field field)
+{
+    switch (field)
+    {
+        case WindDirection:
+            return(Add(field, (sample.windDirection < 16) ? _windDirectionNames[sample.windDirection] : ""));
+        case SampleTime:
+            return(Add(field, sample.timestamp));
+        default:
+            return(Add(field, sample.values[field]));
+    }
+}
+
+//
+//  Finish the record, returns false if any of the fields did not fit.
+//
+//  CSV records are padded so that every row has a column for every field.
+//
+bool TelemetrySerializer::End()
+{
+    if (_format == CSV)
+    {
+        while (!_overflow && (_nextField < NumberOfFields))
+        {
+            if ((_nextField > 0) || _leadingSeparator)
+            {
+                Append(',');
+            }
+            _nextField++;
+        }
+    }
+    if (_format == JSON)
+    {
+        Append('}');
+    }
+    Terminate();
+    return(!_overflow);
+}
+
+//
+//  Start a batch of samples.  CSV batches start with a header line naming
+//  the columns, JSON batches have one object per line.  Query strings cannot
+//  hold more than one sample.
+//
+void TelemetrySerializer::BeginBatch(Format format)
+{
+    Begin(format);
+    _length = 0;
+    if (_format == CSV)
+    {
+        Append("sequence");
+        for (uint8_t field = 0; field < NumberOfFields; field++)
+        {
+            Append(',');
+            Append(_layout[field].name);
+        }
+        Append('\n');
+    }
+    Terminate();
+}
+
+//
+//  Add a sample to a batch as a single line.  A sample which does not fit is
+//  removed completely so the buffer always holds whole lines.
+//
+bool TelemetrySerializer::AddRecord(uint32_t sequence, const Sample &sample)
+{
+    size_t start = _length;
+    bool added;
+
+    if (_format == QueryString)
+    {
+        return(false);
+    }
+    _nextField = 0;
+    if (_format == JSON)
+    {
+        Append("{\"sequence\":");
+    }
+    AppendUnsigned(sequence);
+    _leadingSeparator = true;
+    added = Add(sample) && End() && Append('\n');
+    _leadingSeparator = false;
+    if (!added)
+    {
+        _length = start;
+        Terminate();
+        return(false);
+    }
+    Terminate();
+    return(true);
+}
+
+//
+//  Write the separator and name for the next field.
+//
+//  Fields must be added in layout order, skipped fields are left empty in
+//  CSV records and omitted from the other formats.
+//
+bool TelemetrySerializer::StartField(Field field)
+{
+    if ((field >= NumberOfFields) || (field < _nextField))
+    {
+        return(false);
+    }
+    switch (_format)
+    {
+        case QueryString:
+            Append('&');
+            Append(_layout[field].name);
+            Append('=');
+            break;
+        case JSON:
+            if ((_nextField > 0) || _leadingSeparator)
+            {
+                Append(',');
+            }
+            Append('"');
+            Append(_layout[field].name);
+            Append("\":");
+            break;
+        case CSV:
+            while (_nextField < field)
+            {
+                if ((_nextField > 0) || _leadingSeparator)
+                {
+                    Append(',');
+                }
+                _nextField++;
+            }
+            if ((field > 0) || _leadingSeparator)
+            {
+                Append(',');
+            }
+            break;
+        case Value:
+            break;
+    }
+    _nextField = field + 1;
+    return(!_overflow);
+}
+
+//******************************************************************************
+//
+//  Buffer management.
+//
+
+//
+//  Append a single character, keeping space for the terminator.
+//
+bool TelemetrySerializer::Append(char character)
+{
+    if (_overflow || ((_length + 1) >= _size))
+    {
+        _overflow = true;
+        return(false);
+    }
+    _buffer[_length++] = character;
+    return(true);
+}
+
+//
+//  Append a string.
+//
+bool TelemetrySerializer::Append(const char *text)
+{
+    while (*text != '\0')
+    {
+        if (!Append(*text++))
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+//
+//  Append a string escaping the characters which are not allowed in the
+//  current format.
+//
+bool TelemetrySerializer::AppendEscaped(const char *text)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    for (; *text != '\0'; text++)
+    {
+        char character = *text;
+        if (_format == QueryString)
+        {
+            if (((character >= 'a') && (character <= 'z')) || ((character >= 'A') && (character <= 'Z')) ||
+                ((character >= '0') && (character <= '9')) || (character == '-') || (character == '_') || (character == '.'))
+            {
+                Append(character);
+            }
+            else
+            {
+                Append('%');
+                Append(hex[(character >> 4) & 0x0f]);
+                Append(hex[character & 0x0f]);
+            }
+        }
+        else if (_format == JSON)
+        {
+            if ((character == '"') || (character == '\\'))
+            {
+                Append('\\');
+            }
+            Append(character);
+        }
+        else
+        {
+            Append((character == ',') ? ' ' : character);
+        }
+    }
+    return(!_overflow);
+}
+
+//
+//  Append an unsigned integer.
+//
+bool TelemetrySerializer::AppendUnsigned(uint32_t value)
+{
+    char digits[10];
+    uint8_t count = 0;
+
+    do
+    {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    }
+    while (value != 0);
+    while (count > 0)
+    {
+        Append(digits[--count]);
+    }
+    return(!_overflow);
+}
+
+//
+//  Append a number rounded to the given number of decimal places (up to 6).
+//
+//  The conversion uses integer arithmetic on the scaled value so the
+//  fractional part keeps any leading zeros (1.05 is written as 1.05).
+//
+bool TelemetrySerializer::AppendNumber(float value, uint8_t decimalPlaces)
+{
+    static const uint32_t scale[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+    if (decimalPlaces > 6)
+    {
+        decimalPlaces = 6;
+    }
+    double scaled = fabs((double) value) * scale[decimalPlaces] + 0.5;
+    if (scaled >= 4294967295.0)
+    {
+        return(Append("null"));
+    }
+    uint32_t fixedPoint = (uint32_t) scaled;
+    if ((value < 0) && (fixedPoint != 0))
+    {
+        Append('-');
+    }
+    uint32_t fraction = fixedPoint % scale[decimalPlaces];
+    AppendUnsigned(fixedPoint / scale[decimalPlaces]);
+    if (decimalPlaces > 0)
+    {
+        Append('.');
+        for (uint8_t place = decimalPlaces; place > 0; place--)
+        {
+            Append('0' + ((fraction / scale[place - 1]) % 10));
+        }
+    }
+    return(!_overflow);
+}
+
+//
+//  Keep the buffer null terminated.
+//
+void TelemetrySerializer::Terminate()
+{
+    if (_size > 0)
+    {
+        _buffer[(_length < _size) ? _length : (_size - 1)] = '\0';
+    }
+}
+
+//******************************************************************************
+//
+//  Properties.
+//
+
+//
+//  Indicate if any of the data did not fit in the buffer.
+//
+bool TelemetrySerializer::Overflowed()
+{
+    return(_overflow);
+}
+
+//
+//  Number of characters in the buffer (excluding the terminator).
+//
+size_t TelemetrySerializer::Length()
+{
+    return(_length);
+}
+
+//
+//  The serialized record.
+//
+const char *TelemetrySerializer::GetBuffer()
+{
+    return(_buffer);
+}
+
+//
+//  Name of a field in the record layout.
+//
+const char *TelemetrySerializer::GetFieldName(Field field)
+{
+    return((field < NumberOfFields) ? _layout[field].name : "");
+}
@@ -0,0 +1,116 @@
+//
+//  Header for the telemetry serializer class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __TELEMETRYSERIALIZER_H__
+#define __TELEMETRYSERIALIZER_H__
+
+#include <Arduino.h>
+
+//
+//  Write a set of sensor readings into a caller supplied buffer as a URL
+//  query string, a JSON object or a CSV row.  The Value format writes the
+//  value of a single field on its own (an MQTT payload).
+//
+//  The fields and the number of decimal places for each are fixed by the
+//  layout table and must be added in layout order.  Nothing is allocated on
+//  the heap, when a field will not fit in the buffer the record is cut short
+//  after the last complete field and the overflow is reported by End() and
+//  Overflowed().
+//
+//  A batch holds several samples, one per line, each starting with the
+//  sequence number of the sample (CSV with a header line or JSON lines).
+//
+class TelemetrySerializer
+{
+    public:
+        enum Format
+        {
+            QueryString, JSON, CSV, Value
+        };
+        enum Field
+        {
+            AirPressure, GroundTemperature, AirTemperature, Humidity, Luminosity,
+            Rainfall, RainRate, Rainfall10Minutes, Rainfall1Hour, Rainfall24Hours,
+            WindDirection, WindDirectionMean2Minutes, WindDirectionStandardDeviation2Minutes,
+            WindDirectionMean10Minutes, WindDirectionStandardDeviation10Minutes,
+            WindSpeed, WindSpeed10Minutes, WindGust, SampleTime,
+            NumberOfFields
+        };
+        //
+        //  One set of readings.  The wind direction (compass point) and the
+        //  time of the sample are held separately, their entries in values
+        //  are not used.
+        //
+        static const uint8_t UnknownWindDirection = 0xff;
+        struct Sample
+        {
+            uint32_t timestamp;                 // Unix time, 0 if not known.
+            float values[NumberOfFields];
+            uint8_t windDirection;              // WeatherSensors::WindDirection or UnknownWindDirection.
+        };
+
+        TelemetrySerializer(char *, size_t);
+        void Begin(Format, const char *prefix = NULL);
+        bool Add(Field, float);
+        bool Add(Field, const char *);
+        bool Add(Field, uint32_t);
+        bool Add(const Sample &);
+        bool AddField(const Sample &, Field);
+        bool End();
+        void BeginBatch(Format);
+        bool AddRecord(uint32_t, const Sample &);
+        bool Overflowed();
+        size_t Length();
+        const char *GetBuffer();
+        static const char *GetFieldName(Field);
+
+    private:
+        //
+        //  Layout of a telemetry record.
+        //
+        struct FieldLayout
+        {
+            const char *name;
+            uint8_t decimalPlaces;
+        };
+        static const FieldLayout _layout[NumberOfFields];
+        static const char *_windDirectionNames[16];
+        char *_buffer;
+        size_t _size;
+        size_t _length;
+        Format _format;
+        uint8_t _nextField;
+        bool _overflow;
+        bool _leadingSeparator;
+        bool StartField(Field);
+        bool Append(char);
+        bool Append(const char *);
+        bool AppendEscaped(const char *);
+        bool AppendUnsigned(uint32_t);
+        bool AppendNumber(float, uint8_t);
+        void Terminate();
+};
+
+#endif
@@ -0,0 +1,385 @@
+//
+//  Time series block, compressed storage for regular samples.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "TimeSeriesBlock.h"
+
+//
+//  Variable length codes for the differences, the prefix and the number of
+//  bits which follow it.  The last entry holds any 32 bit value.
+//
+namespace
+{
+    struct DifferenceCode
+    {
+        uint8_t prefix;
+        uint8_t prefixBits;
+        uint8_t valueBits;
+    };
+
+    const uint8_t NumberOfCodes = 4;
+    const DifferenceCode _codes[NumberOfCodes] =
+    {
+        { 0x02, 2, 3 },
+        { 0x06, 3, 7 },
+        { 0x0e, 4, 12 },
+        { 0x0f, 4, 32 }
+    };
+}
+
+//
+//  Attach the block to a buffer, the buffer must stay in scope for as long
+//  as the block is used.
+//
+TimeSeriesBlock::TimeSeriesBlock(uint8_t *buffer, size_t size)
+{
+    _buffer = buffer;
+    _size = size;
+    _numberOfChannels = 0;
+    _numberOfSamples = 0;
+    _writable = false;
+    _writer.bit = 0;
+    Rewind();
+}
+
+//******************************************************************************
+//
+//  Writing.
+//
+
+//
+//  Start a new, empty block with the given number of channels.
+//
+bool TimeSeriesBlock::Begin(uint8_t numberOfChannels)
+{
+    if ((numberOfChannels == 0) || (numberOfChannels > MaximumChannels) || (_size < HeaderSize))
+    {
+        _writable = false;
+        return(false);
+    }
+    _numberOfChannels = numberOfChannels;
+    _numberOfSamples = 0;
+    _buffer[0] = Version;
+    _buffer[1] = numberOfChannels;
+    _buffer[2] = 0;
+    _buffer[3] = 0;
+    _writer.bit = HeaderSize * 8;
+    _writer.timestamp = 0;
+    _writer.interval = 0;
+    _writable = true;
+    Rewind();
+    return(true);
+}
+
+//
+//  Add a sample to the block, values holds one fixed point value for each
+//  channel (MissingValue if there is no reading).  Returns false if the
+//  block is full, the block is unchanged.
+//
+bool TimeSeriesBlock::Append(uint32_t timestamp, const int32_t *values)
+{
+    State previous = _writer;
+    bool added = true;
+
+    if (!_writable || (_numberOfSamples == 0xffff))
+    {
+        return(false);
+    }
+    if (_numberOfSamples == 0)
+    {
+        added = WriteBits(timestamp, 32);
+        for (uint8_t channel = 0; added && (channel < _numberOfChannels); channel++)
+        {
+            added = WriteBits((uint32_t) values[channel], 32);
+        }
+    }
+    else
+    {
+        int32_t interval = (int32_t) (timestamp - _writer.timestamp);
+        added = WriteDifference((int32_t) ((uint32_t) interval - (uint32_t) _writer.interval));
+        _writer.interval = interval;
+        for (uint8_t channel = 0; added && (channel < _numberOfChannels); channel++)
+        {
+            added = WriteDifference((int32_t) ((uint32_t) values[channel] - (uint32_t) _writer.values[channel]));
+        }
+    }
+    if (!added)
+    {
+        //
+        //  Clear any bits written into the last byte of the block.
+        //
+        _writer = previous;
+        if (_writer.bit & 7)
+        {
+            _buffer[_writer.bit >> 3] &= 0xff << (8 - (_writer.bit & 7));
+        }
+        return(false);
+    }
+    _writer.timestamp = timestamp;
+    memcpy(_writer.values, values, _numberOfChannels * sizeof(int32_t));
+    _numberOfSamples++;
+    _buffer[2] = _numberOfSamples & 0xff;
+    _buffer[3] = _numberOfSamples >> 8;
+    return(true);
+}
+
+//
+//  Write the least significant bits of value, returns false if the block
+//  is full.
+//
+bool TimeSeriesBlock::WriteBits(uint32_t value, uint8_t bits)
+{
+    if ((_writer.bit + bits) > (_size * 8))
+    {
+        return(false);
+    }
+    while (bits > 0)
+    {
+        size_t index = _writer.bit >> 3;
+        uint8_t used = _writer.bit & 7;
+        uint8_t space = 8 - used;
+        uint8_t count = (bits < space) ? bits : space;
+        uint8_t chunk = (uint8_t) ((value >> (bits - count)) & ((1U << count) - 1));
+        if (used == 0)
+        {
+            _buffer[index] = 0;
+        }
+        _buffer[index] |= chunk << (space - count);
+        _writer.bit += count;
+        bits -= count;
+    }
+    return(true);
+}
+
+//
+//  Write a difference using the shortest code which will hold it.
+//
+bool TimeSeriesBlock::WriteDifference(int32_t difference)
+{
+    if (difference == 0)
+    {
+        return(WriteBits(0, 1));
+    }
+    uint8_t code = 0;
+    while (code < (NumberOfCodes - 1))
+    {
+        int32_t limit = 1L << (_codes[code].valueBits - 1);
+        if ((difference >= -limit) && (difference < limit))
+        {
+            break;
+        }
+        code++;
+    }
+    return(WriteBits(_codes[code].prefix, _codes[code].prefixBits) && WriteBits((uint32_t) difference, _codes[code].valueBits));
+}
+
+//******************************************************************************
+//
+//  Reading.
+//
+
+//
+//  Use an existing block of length bytes held in the buffer (read from the
+//  log or received from the station).  The block can be read but not added
+//  to.  Returns false if the header is not valid.
+//
+bool TimeSeriesBlock::Open(size_t length)
+{
+    _writable = false;
+    if ((length < HeaderSize) || (length > _size) || (_buffer[0] != Version) ||
+        (_buffer[1] == 0) || (_buffer[1] > MaximumChannels))
+    {
+        _numberOfChannels = 0;
+        _numberOfSamples = 0;
+        return(false);
+    }
+    _numberOfChannels = _buffer[1];
+    _numberOfSamples = _buffer[2] | (_buffer[3] << 8);
+    _writer.bit = length * 8;
+    Rewind();
+    return(true);
+}
+
+//
+//  Move back to the first sample in the block.
+//
+void TimeSeriesBlock::Rewind()
+{
+    _reader.bit = HeaderSize * 8;
+    _reader.timestamp = 0;
+    _reader.interval = 0;
+    _samplesRead = 0;
+}
+
+//
+//  Read the next sample, values must have room for one value per channel.
+//  Returns false at the end of the block or if the block is corrupt.
+//
+bool TimeSeriesBlock::ReadNext(uint32_t &timestamp, int32_t *values)
+{
+    uint32_t bits;
+    int32_t difference;
+
+    if (_samplesRead >= _numberOfSamples)
+    {
+        return(false);
+    }
+    if (_samplesRead == 0)
+    {
+        if (!ReadBits(32, bits))
+        {
+            return(false);
+        }
+        _reader.timestamp = bits;
+        for (uint8_t channel = 0; channel < _numberOfChannels; channel++)
+        {
+            if (!ReadBits(32, bits))
+            {
+                return(false);
+            }
+            _reader.values[channel] = (int32_t) bits;
+        }
+    }
+    else
+    {
+        if (!ReadDifference(difference))
+        {
+            return(false);
+        }
+        _reader.interval = (int32_t) ((uint32_t) _reader.interval + (uint32_t) difference);
+        _reader.timestamp += (uint32_t) _reader.interval;
+        for (uint8_t channel = 0; channel < _numberOfChannels; channel++)
+        {
+            if (!ReadDifference(difference))
+            {
+                return(false);
+            }
+            _reader.values[channel] = (int32_t) ((uint32_t) _reader.values[channel] + (uint32_t) difference);
+        }
+    }
+    _samplesRead++;
+    timestamp = _reader.timestamp;
+    memcpy(values, _reader.values, _numberOfChannels * sizeof(int32_t));
+    return(true);
+}
+
+//
+//  Read the given number of bits, returns false if this would go past the
+//  end of the block.
+//
+bool TimeSeriesBlock::ReadBits(uint8_t bits, uint32_t &value)
+{
+    if ((_reader.bit + bits) > _writer.bit)
+    {
+        return(false);
+    }
+    value = 0;
+    while (bits > 0)
+    {
+        uint8_t used = _reader.bit & 7;
+        uint8_t space = 8 - used;
+        uint8_t count = (bits < space) ? bits : space;
+        uint8_t chunk = (_buffer[_reader.bit >> 3] >> (space - count)) & ((1U << count) - 1);
+        value = (value << count) | chunk;
+        _reader.bit += count;
+        bits -= count;
+    }
+    return(true);
+}
+
+//
+//  Read a difference, the number of leading ones selects the code.
+//
+bool TimeSeriesBlock::ReadDifference(int32_t &difference)
+{
+    uint8_t ones = 0;
+    uint32_t bit;
+
+    while (ones < NumberOfCodes)
+    {
+        if (!ReadBits(1, bit))
+        {
+            return(false);
+        }
+        if (bit == 0)
+        {
+            break;
+        }
+        ones++;
+    }
+    if (ones == 0)
+    {
+        difference = 0;
+        return(true);
+    }
+    uint8_t valueBits = _codes[ones - 1].valueBits;
+    uint32_t value;
+    if (!ReadBits(valueBits, value))
+    {
+        return(false);
+    }
+    if ((valueBits < 32) && (value & (1UL << (valueBits - 1))))
+    {
+        value |= 0xffffffffUL << valueBits;
+    }
+    difference = (int32_t) value;
+    return(true);
+}
+
+//******************************************************************************
+//
+//  Properties.
+//
+
+//
+//  Number of channels in each sample.
+//
+uint8_t TimeSeriesBlock::GetNumberOfChannels()
+{
+    return(_numberOfChannels);
+}
+
+//
+//  Number of samples held in the block.
+//
+uint16_t TimeSeriesBlock::GetNumberOfSamples()
+{
+    return(_numberOfSamples);
+}
+
+//
+//  Number of bytes used by the block, including the header.
+//
+size_t TimeSeriesBlock::Length()
+{
+    return((_numberOfChannels == 0) ? 0 : ((_writer.bit + 7) / 8));
+}
+
+//
+//  Buffer holding the block.
+//
+const uint8_t *TimeSeriesBlock::GetBuffer()
+{
+    return(_buffer);
+}
@@ -0,0 +1,107 @@
+//
+//  Header for the time series block class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __TIMESERIESBLOCK_H__
+#define __TIMESERIESBLOCK_H__
+
+#include <Arduino.h>
+
+//
+//  Compressed block of time series samples held in a caller supplied buffer.
+//
+//  Each sample is a timestamp and one fixed point value for each channel.
+//  Timestamps are stored as the difference between successive intervals
+//  (delta of delta) and values as the difference from the previous value
+//  of the channel, both using the variable length codes below.  Regular
+//  samples of slowly changing readings take a bit or two per value.
+//
+//      Code                Difference
+//      0                   0
+//      10 + 3 bits         -4 to 3
+//      110 + 7 bits        -64 to 63
+//      1110 + 12 bits      -2048 to 2047
+//      1111 + 32 bits      Anything else
+//
+//  The first sample holds the timestamp and values in full.
+//
+//  Block layout (version 1):
+//
+//      Offset  Size    Contents
+//      0       1       Version.
+//      1       1       Number of channels.
+//      2       2       Number of samples (little endian).
+//      4       n       Bit stream, most significant bit first.
+//
+//  Blocks are bounded by the size of the buffer.  Append() returns false
+//  when a sample will not fit and leaves the block as it was, the caller
+//  then stores the block and starts a new one.  Nothing is allocated on the
+//  heap.
+//
+class TimeSeriesBlock
+{
+    public:
+        static const uint8_t Version = 1;
+        static const uint8_t HeaderSize = 4;
+        static const uint8_t MaximumChannels = 16;
+        static const int32_t MissingValue = (int32_t) 0x80000000;
+
+        TimeSeriesBlock(uint8_t *, size_t);
+        bool Begin(uint8_t);
+        bool Append(uint32_t, const int32_t *);
+        bool Open(size_t);
+        void Rewind();
+        bool ReadNext(uint32_t &, int32_t *);
+        uint8_t GetNumberOfChannels();
+        uint16_t GetNumberOfSamples();
+        size_t Length();
+        const uint8_t *GetBuffer();
+
+    private:
+        //
+        //  Position in the bit stream and the previous sample, used for both
+        //  writing and reading.
+        //
+        struct State
+        {
+            size_t bit;
+            uint32_t timestamp;
+            int32_t interval;
+            int32_t values[MaximumChannels];
+        };
+        uint8_t *_buffer;
+        size_t _size;
+        uint8_t _numberOfChannels;
+        uint16_t _numberOfSamples;
+        uint16_t _samplesRead;
+        bool _writable;
+        State _writer;
+        State _reader;
+        bool WriteBits(uint32_t, uint8_t);
+        bool WriteDifference(int32_t);
+        bool ReadBits(uint8_t, uint32_t &);
+        bool ReadDifference(int32_t &);
+};
+
+#endif
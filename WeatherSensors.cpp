@@ -1,664 +1,1802 @@
-//
-//  Weather sensors class.
-//
-//  MIT License
-//  
-//  Copyright(c) 2016 Mark Stevens
-//  
-//  Permission is hereby granted, free of charge, to any person obtaining a copy
-//  of this software and associated documentation files(the "Software"), to deal
-//  in the Software without restriction, including without limitation the rights
-//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
-//  copies of the Software, and to permit persons to whom the Software is
-//  furnished to do so, subject to the following conditions :
-//  
-//  The above copyright notice and this permission notice shall be included in all
-//  copies or substantial portions of the Software.
-//  
-//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
-//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-//  SOFTWARE.
-//  
-#include "WeatherSensors.h"
-
-//******************************************************************************
-//
-//  Constructors etc.
-//
-
-//
-//  Default constructor.
-//
-WeatherSensors::WeatherSensors()
-{
-    //
-    //  Populate the wind direction lookup table.  Each entry has the following form:
-    //
-    //  midPoint, reading, angle, direction, direction as text
-    //
-    //  Note that this table is order not in angles/wind direction but in terms of the
-    //  mid points of the ADC readings found empirically.  This allows for easier
-    //  searching of the table.
-    //
-    //  (char *) casts have been used in the wind direction names to stop a compiler
-    //  warning.
-    //    
-    _windDirectionLookupTable[0] = { 0, 68, 112.5, EastSouthEast, (char *) "East-South-East" };
-    _windDirectionLookupTable[1] = { 77, 87, 67.5, EastNorthEast, (char *) "East-North-East" };
-    _windDirectionLookupTable[2] = { 91, 96, 90, East, (char *) "East" };
-    _windDirectionLookupTable[3] = { 115, 135, 157.5, SouthSouthEast, (char *) "South-South-East" };
-    _windDirectionLookupTable[4] = { 165, 196, 135, SouthEast, (char *) "South-East" };
-    _windDirectionLookupTable[5] = { 227, 259, 202.5, SouthSouthWest, (char *) "South-South-West" };
-    _windDirectionLookupTable[6] = { 281, 304, 180, South, (char *) "South" };
-    _windDirectionLookupTable[7] = { 366, 429, 22.5, NorthNorthEast, (char *) "North-North-East" };
-    _windDirectionLookupTable[8] = { 456, 484, 45, NorthEast, (char *) "North-East" };
-    _windDirectionLookupTable[9] = { 553, 623, 247.5, WestSouthWest, (char *) "West-South-West" };
-    _windDirectionLookupTable[10] = { 640, 657, 225, SouthWest, (char *) "South-West" };
-    _windDirectionLookupTable[11] = { 693, 730, 337.5, NorthNorthWest, (char *) "North-North-West" };
-    _windDirectionLookupTable[12] = { 771, 812, 0, North, (char *) "North" };
-    _windDirectionLookupTable[13] = { 832, 852, 292.5, WestNorthWest, (char *) "West-North-West" };
-    _windDirectionLookupTable[14] = { 883, 914, 315, NorthWest, (char *) "North-West" };
-    _windDirectionLookupTable[15] = { 942, 970, 270, West, (char *) "West" };
-    //
-    //  Make A0 an input pin so that we can read the wind direction.
-    //
-    pinMode(A0, INPUT);
-    //
-    //  Clear the sesnosr readings to 0.
-    //
-    _ultraviolet = 0;
-    _windSpeedPulseCount = 0;
-    _pluviometerPulseCount = 0;
-    _pluviometerPulseCountToday = 0;
-}
-
-//
-//  Destructor - clean up any memory / objects in use.
-//
-WeatherSensors::~WeatherSensors()
-{
-    delete(_groundSensor);
-}
-
-//******************************************************************************
-//
-//  General methods (initialisation etc.)
-//
-
-//
-//  Initialise all of the weather sensors.
-//
-void WeatherSensors::InitialiseSensors()
-{
-    SetupGroundTemperatureSensor();
-    SetupLuminositySensor();
-    SetupTemperatureHumidityPressureSensor();
-    //SetupRainfallSensor();
-    //SeupWindSpeedSensor();
-}
-
-//
-//  Read all of the sensors.
-//
-//  This method forces all of the sensor readings to be taken in one go.
-//
-void WeatherSensors::ReadAllSensors()
-{
-    //ReadSTM8SSensors();
-    ReadGroundTemperatureSensor();
-    yield();
-    ReadLuminositySensor();
-    yield();
-    ReadTemperatureHumidityPressureSensor();
-    yield();
-    //ReadUltravioletLightSensor();
-    //ReadRainfallSensor();
-    //ReadWindSpeedSensor();
-    ReadWindDirection();
-    yield();
-}
-
-//******************************************************************************
-//
-//  DS18B20 temperature sensor.
-//
-//  Setup the DS18B20 sensor (ground temperature).
-//
-void WeatherSensors::SetupGroundTemperatureSensor()
-{
-    int index;
-    String message;
-    char number[20];
-
-    _groundSensor = new OneWire(7);
-
-    if (!_groundSensor->search(_groundTemperatureSensorAddress))
-    {
-        Debugger::DebugMessage("No more addresses.");
-        _groundSensor->reset_search();
-        delay(250);
-        return;
-    }
-
-    message = "ROM =";
-    for (index = 0; index < 8; index++)
-    {
-        message += " ";
-        message += itoa(_groundTemperatureSensorAddress[index], number, 16);
-    }
-    Debugger::DebugMessage(message);
-
-    if (OneWire::crc8(_groundTemperatureSensorAddress, 7) != _groundTemperatureSensorAddress[7])
-    {
-        Debugger::DebugMessage("CRC is not valid!");
-        return;
-    }
-
-    switch (_groundTemperatureSensorAddress[0])
-    {
-    case 0x10:
-        Debugger::DebugMessage("Chip = DS18S20");
-        _groundTemperatureSensorType = 1;
-        break;
-    case 0x28:
-        Debugger::DebugMessage("Chip = DS18B20");
-        _groundTemperatureSensorType = 0;
-        break;
-    case 0x22:
-        Debugger::DebugMessage("Chip = DS1822");
-        _groundTemperatureSensorType = 0;
-        break;
-    default:
-        Debugger::DebugMessage("Device is not a DS18x20 family device.");
-        return;
-    }
-}
-
-//
-//  Read the ground temperature from the DS18B20 sensor.
-//
-float WeatherSensors::ReadGroundTemperatureSensor()
-{
-    int index;
-    byte data[12];
-    byte present = 0;
-    String message;
-    char number[20];
-
-    _groundSensor->reset();
-    _groundSensor->select(_groundTemperatureSensorAddress);
-    _groundSensor->write(0x44, 1);    // Start conversion, with parasite power on at the end
-    delay(1000);          // Maybe 750ms is enough, maybe not
-    present = _groundSensor->reset();
-    _groundSensor->select(_groundTemperatureSensorAddress);
-    _groundSensor->write(0xBE);       // Read Scratchpad
-
-    message = "DS18B20 Data = ";
-    message += itoa(present, number, 16);
-    message += " ";
-    for (index = 0; index < 9; index++)
-    {
-        data[index] = _groundSensor->read();
-        message += itoa(data[index], number, 16);
-        message += " ";
-    }
-    message += " CRC=";
-    message += itoa(OneWire::crc8(data, 8), number, 16);
-    Debugger::DebugMessage(message);
-
-    if (OneWire::crc8(data, 8) == data[8])
-    {
-        int16_t raw = (data[1] << 8) | data[0];
-        if (_groundTemperatureSensorType)
-        {
-            raw = raw << 3; // 9 bit resolution default
-            if (data[7] == 0x10)
-            {
-                // "count remain" gives full 12 bit resolution
-                raw = (raw & 0xFFF0) + 12 - data[6];
-            }
-        }
-        else
-        {
-            byte cfg = (data[4] & 0x60);
-            // at lower res, the low bits are undefined, so let's zero them
-            switch (cfg)
-            {
-            case 0x00:
-                raw = raw & ~7;   // 9 bit resolution, 93.75 ms
-                break;
-            case 0x20:
-                raw = raw & ~3;   // 10 bit res, 187.5 ms
-                break;
-            case 0x40:
-                raw = raw & ~1;   // 11 bit res, 375 ms
-                break;
-            }
-            //// default is 12 bit resolution, 750 ms conversion time
-        }
-        _groundTemperature = (double) (raw / 16.0);
-    }
-    else
-    {
-        Debugger::DebugMessage("DS18B20 CRC failure");
-    }
-    return(_groundTemperature);
-}
-
-//
-//  Get the last ground temperature reading.
-//
-float WeatherSensors::GetGroundTemperatureReading()
-{
-    return(_groundTemperature);
-}
-
-//******************************************************************************
-//
-//  Ultraviolet light sensor.
-//
-
-//
-//  Read the ultraviolet light sensor.
-//
-float WeatherSensors::ReadUltravioletLightSensor()
-{
-    return(_ultraviolet);
-}
-
-//
-//  Get the last value read from the UV sensor.
-//
-float WeatherSensors::GetUltravioletLightReading()
-{
-    return(_ultraviolet);
-}
-
-//
-//  Convert the ultraviolet light sensor reading into mW/cm2.
-//
-float WeatherSensors::GetUltravioletLightStrength()
-{
-    float uvStrength = _ultraviolet * _voltsPerDivision;
-
-    if (uvStrength < _uvOffset)
-    {
-        uvStrength = 0;
-    }
-    else
-    {
-        uvStrength = (uvStrength - _uvOffset) / _uvGradient;
-    }
-    return(uvStrength);
-}
-
-//******************************************************************************
-//
-//  Get data from the STM8S.
-//
-//  Sensors connected to the STM8S:
-//
-//  1 - Wind Speed
-//  2 - Wind Direction
-//  3 - Ultraviolet Light
-//  4 - Rain Guage (Pluviometer)
-//
-void WeatherSensors::ReadSTM8SSensors()
-{
-    uint8_t buffer[I2CBufferSize];
-
-    Wire.beginTransmission(STM8SAddress);
-    Wire.write(I2CGetSensorData);
-    Wire.endTransmission();
-    Wire.requestFrom(STM8SAddress, I2CBufferSize);
-    bool allFF = true;
-    bool allAA = true;
-    for (int index = 0; index < I2CBufferSize; index++)
-    {
-        buffer[index] = Wire.read();
-        allFF = (allFF && (0xff == buffer[index]));
-        allAA = (allAA && (0xaa == buffer[index]));
-    }
-    Debugger::DebugMessage("STM8S Sensor data", buffer, I2CBufferSize);
-    if (allFF)
-    {
-        Debugger::DebugMessage("There is a problem with the I2C readings from the STM8S.");
-    }
-    else if (allAA)
-    {
-        Debugger::DebugMessage("STM8S data is not ready.");
-    }
-    else
-    {
-        _windSpeedPulseCount = (buffer[I2CWindSpeedMSB] * 256) + buffer[I2CWindSpeedLSB];
-        _pluviometerPulseCount = (buffer[I2CRainfallCounterMSB] * 256) + buffer[I2CRainfallCounterLSB];
-        _pluviometerPulseCountToday = _pluviometerPulseCount;
-        _ultraviolet = (buffer[I2CUVReadingMSB] * 256) + buffer[I2CUVReadingLSB];
-    }
-}
-
-//******************************************************************************
-//
-//  Sparkfun Luminosity sensor.
-//
-
-//
-//  Translate the error code into a meaningful message.
-//
-String WeatherSensors::LuminositySensorErrorMessage(byte error)
-{
-    switch (error)
-    {
-    case 0:
-        return("TSL2561 Error: Success");
-    case 1:
-        return("TSL2561 Error: Data too long for transmit buffer");
-    case 2:
-        return("TSL2561 Error: Received NACK on address (disconnected?)");
-    case 3:
-        return("TSL2561 Error: Received NACK on data");
-    case 4:
-        return("TSL2561 Error: Other error");
-    default:
-        return("TSL2561 Error: Unknown error code");
-    }
-}
-
-//
-//  Set up the luminsoity sensor.
-//
-void WeatherSensors::SetupLuminositySensor()
-{
-    char buffer[256];
-
-    _light.begin();
-
-    // Get factory ID from sensor:
-    // (Just for fun, you don't need to do this to operate the sensor)
-    unsigned char id;
-
-    if (_light.getID(id))
-    {
-        sprintf(buffer, "Retrieved TSL2561 device ID: 0x%x", id);
-        Debugger::DebugMessage(buffer);
-    }
-    else
-    {
-        byte error = _light.getError();
-        Debugger::DebugMessage(LuminositySensorErrorMessage(error));
-    }
-
-    // The light sensor has a default integration time of 402ms,
-    // and a default gain of low (1X).
-
-    // If you would like to change either of these, you can
-    // do so using the setTiming() command.
-
-    // If gain = false (0), device is set to low gain (1X)
-    // If gain = high (1), device is set to high gain (16X)  
-    _gain = 0;
-
-    // If time = 0, integration will be 13.7ms
-    // If time = 1, integration will be 101ms
-    // If time = 2, integration will be 402ms
-    // If time = 3, use manual start / stop to perform your own integration
-    unsigned char time = 2;
-
-    // setTiming() will set the third parameter (ms) to the
-    // requested integration time in ms (this will be useful later):
-    _light.setTiming(_gain, time, _ms);
-
-    // To start taking measurements, power up the sensor:
-
-    Debugger::DebugMessage((char *) "Powering up the luminosity sensor.");
-    _light.setPowerUp();
-}
-
-//
-//  Read the luminosity frolm the TSL2561 luminosity sensor.
-//
-double WeatherSensors::ReadLuminositySensor()
-{
-    unsigned int data0, data1;
-    String message;
-    char number[20];
-
-    if (_light.getData(data0, data1))
-    {
-        //
-        //  To calculate lux, pass all your settings and readings to the getLux() function.
-        //
-        //  The getLux() function will return 1 if the calculation was successful, or 0 if one or both of the sensors was
-        //  saturated (too much light). If this happens, you can reduce the integration time and/or gain.
-        //  For more information see the hookup guide at: 
-        //  https://learn.sparkfun.com/tutorials/getting-started-with-the-tsl2561-luminosity-sensor
-        //
-        // Perform lux calculation.
-        //
-        double localLux;
-        _good = _light.getLux(_gain, _ms, data0, data1, localLux);
-        if (_good)
-        {
-            _lux = localLux;
-        }
-    }
-    else
-    {
-        byte error = _light.getError();
-        Debugger::DebugMessage(LuminositySensorErrorMessage(error));
-    }
-    return(_lux);
-}
-
-//
-//  Get the last luminosity reading.
-//
-double WeatherSensors::GetLuminosityReading()
-{
-    return(_lux);
-}
-
-//******************************************************************************
-//
-//  BME280 temperature, air pressure and humidity sensor.
-//
-
-//
-//  Setup the Adafruit BME280 Temperature, pressure and humidity sensor.
-//
-void WeatherSensors::SetupTemperatureHumidityPressureSensor()
-{
-    if (!_bme.begin())
-    {
-        Debugger::DebugMessage("Could not find a valid BME280 sensor, check wiring!");
-    }
-    else
-    {
-        Debugger::DebugMessage("BME280 sensor located on I2C bus.");
-    }
-    _temperature = 0;
-    _pressure = 0;
-    _humidity = 0;
-}
-
-//
-//  Read the data from the Temperature, pressure and humidity sensor.
-//
-void WeatherSensors::ReadTemperatureHumidityPressureSensor()
-{
-    _temperature = _bme.readTemperature();
-    _pressure = _bme.readPressure();
-    _humidity = _bme.readHumidity();
-}
-
-//
-//  Get the last air temperature reading.
-//
-float WeatherSensors::GetAirTemperature()
-{
-    return(_temperature);
-}
-
-//
-//  Get the last humidity reading.
-//
-float WeatherSensors::GetHumidity()
-{
-    return(_humidity);
-}
-
-//
-//  Get thje last air pressure reading.
-//
-float WeatherSensors::GetAirPressure()
-{
-    return(_pressure);
-}
-
-//******************************************************************************
-//
-//  Pluvometer (Rainfall) sensor.
-
-//
-//  Set up the pluiometer, zero the counts and then attached and initialise the
-//  counter to the output expander.
-//
-void WeatherSensors::SetupRainfallSensor()
-{
-}
-
-//
-//  Read the counter from the Rainfall sensor then reset the count.
-//
-//  It is theoretically possible for the counter to change while it is being read.
-//  This can give an incorrect reading so the counter is read twice in succession, if
-//  the two readings are the same then we can assume that the reading is correct.
-//
-void WeatherSensors::ReadRainfallSensor()
-{
-}
-
-//
-//  Reset the pluviometer pulse counter.
-//
-void WeatherSensors::ResetPluviometerPulseCounter()
-{
-    _pluviometerPulseCount = 0;
-    _pluviometerPulseCountToday = 0;
-}
-
-//
-//  Convert the number of pulses into mm of rain.
-//
-float WeatherSensors::CalculateRainfall(int pulseCount)
-{
-    return(pulseCount * RAINFALL_TIPPER_MM_PER_PULSE);
-}
-
-//
-//  Get the rainfal in mm between the last sensor reading and this one.
-//
-float WeatherSensors::GetRainfall()
-{
-    return(CalculateRainfall(_pluviometerPulseCount));
-}
-
-//
-//  Get the total rainfall in mm today.
-//
-float WeatherSensors::GetTotalRainfallToday()
-{
-    return(CalculateRainfall(_pluviometerPulseCountToday));
-}
-
-//******************************************************************************
-//
-//  Windspeed sensor.
-//
-
-//
-//  Set up the anemometer.
-//
-void WeatherSensors::SeupWindSpeedSensor()
-{
-    pinMode(PIN_ANEMOMETER, INPUT);
-    _windSpeedPulseCount = 0;
-    WindSpeedISR = NULL;
-}
-
-//
-//  Read the wind speed.
-//
-float WeatherSensors::ReadWindSpeedSensor()
-{
-    _windSpeedPulseCount = 0;
-    if (WindSpeedISR != NULL)
-    {
-        attachInterrupt(PIN_ANEMOMETER, WindSpeedISR, RISING);
-        delay(WINDSPEED_DURATION * 1000);
-        detachInterrupt(PIN_ANEMOMETER);
-    }
-}
-
-//
-//  Get the last wind speed reading.
-//
-float WeatherSensors::GetWindSpeed()
-{
-    return(_windSpeedPulseCount * WINDSPEED_PER_PULSE);
-}
-
-//
-//  Set the Wind speed ISR
-//
-void WeatherSensors::SetWindSpeedISR(void (*isr)())
-{
-    WindSpeedISR = isr;
-}
-
-//
-//  Called by the Wind speed ISR.
-//
-void WeatherSensors::HandleWindSpeedInterrupt()
-{
-    _windSpeedPulseCount++;
-}
-
-//******************************************************************************
-//
-//  Wind direction sensor.
-//
-
-//
-//  Read the wind direction sensor and calculate the direction the vane is pointing.
-//
-WeatherSensors::WindDirection WeatherSensors::ReadWindDirection()
-{
-    int windDirection = analogRead(A0);
-
-    Debugger::DebugMessage("Wind direction ADC reading: ", windDirection, 10, "");
-    Debugger::DebugMessage("Wind direction (volts): ", windDirection * _voltsPerDivision, 4u, "V");
-    _windDirectionLookupEntry = 15;
-    for (int index = 0; index < 15; index++)
-    {
-        if ((windDirection > _windDirectionLookupTable[index].midPoint) && (windDirection <= _windDirectionLookupTable[index + 1].midPoint))
-        {
-            _windDirectionLookupEntry = index;
-            break;
-        }
-    }
-    Debugger::DebugMessage("Wind is blowing from " + String(_windDirectionLookupTable[_windDirectionLookupEntry].directionAsText));
-    return(_windDirectionLookupTable[_windDirectionLookupEntry].direction);
-}
-
-//
-//  Get the last wind direction reading as a textural description.
-//
-char *WeatherSensors::GetWindDirectionAsString()
-{
-    return(_windDirectionLookupTable[_windDirectionLookupEntry].directionAsText);
+//
+//  Weather sensors class.
+//
+//  MIT License
+//  
+//  Copyright(c) 2016 Mark Stevens
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+#include "WeatherSensors.h"
+
+//******************************************************************************
+//
+//  Wind direction decoding tables.
+//
+
+//
+//  Wind direction information, one entry for each of the 16 vane positions.
+//  Each entry has the following form:
+//
+//  reading, angle, direction, direction as text
+//
+//  Note that this table is order not in angles/wind direction but in terms of the
+//  ADC readings found empirically.
+//
+//  (char *) casts have been used in the wind direction names to stop a compiler
+//  warning.
+//
+const WeatherSensors::WindDirectionLookup WeatherSensors::_windDirectionLookupTable[16] =
+{
+    { 68, 112.5, EastSouthEast, (char *) "East-South-East" },
+    { 87, 67.5, EastNorthEast, (char *) "East-North-East" },
+    { 96, 90, East, (char *) "East" },
+    { 135, 157.5, SouthSouthEast, (char *) "South-South-East" },
+    { 196, 135, SouthEast, (char *) "South-East" },
+    { 259, 202.5, SouthSouthWest, (char *) "South-South-West" },
+    { 304, 180, South, (char *) "South" },
+    { 429, 22.5, NorthNorthEast, (char *) "North-North-East" },
+    { 484, 45, NorthEast, (char *) "North-East" },
+    { 623, 247.5, WestSouthWest, (char *) "West-South-West" },
+    { 657, 225, SouthWest, (char *) "South-West" },
+    { 730, 337.5, NorthNorthWest, (char *) "North-North-West" },
+    { 812, 0, North, (char *) "North" },
+    { 852, 292.5, WestNorthWest, (char *) "West-North-West" },
+    { 914, 315, NorthWest, (char *) "North-West" },
+    { 970, 270, West, (char *) "West" }
+};
+
+//
+//  Mid points between the ADC readings for adjacent entries in the lookup
+//  table above.  A reading in the range (midPoint[n], midPoint[n + 1]] maps
+//  to entry n, anything else maps to entry 15.
+//
+static constexpr uint16_t WindDirectionMidPoints[16] =
+{
+    0, 77, 91, 115, 165, 227, 281, 366, 456, 553, 640, 693, 771, 832, 883, 942
+};
+
+//
+//  Count the number of mid points below an ADC reading.
+//
+static constexpr uint8_t WindDirectionMidPointsBelow(int adc, int index)
+{
+    return((index == 16) ? 0 : (((WindDirectionMidPoints[index] < adc) ? 1 : 0) + WindDirectionMidPointsBelow(adc, index + 1)));
+}
+
+//
+//  Work out the lookup table entry for an ADC reading at compile time.
+//
+static constexpr uint8_t WindDirectionEntry(int adc)
+{
+    return((WindDirectionMidPointsBelow(adc, 0) == 0) ? 15 : (WindDirectionMidPointsBelow(adc, 0) - 1));
+}
+
+//
+//  Map every possible ADC reading directly to the lookup table entry.  The
+//  table is generated by the compiler and held in flash.
+//
+#define WIND_DIRECTION_ENTRIES_4(adc)       WindDirectionEntry(adc), WindDirectionEntry(adc + 1), WindDirectionEntry(adc + 2), WindDirectionEntry(adc + 3)
+#define WIND_DIRECTION_ENTRIES_16(adc)      WIND_DIRECTION_ENTRIES_4(adc), WIND_DIRECTION_ENTRIES_4(adc + 4), WIND_DIRECTION_ENTRIES_4(adc + 8), WIND_DIRECTION_ENTRIES_4(adc + 12)
+#define WIND_DIRECTION_ENTRIES_64(adc)      WIND_DIRECTION_ENTRIES_16(adc), WIND_DIRECTION_ENTRIES_16(adc + 16), WIND_DIRECTION_ENTRIES_16(adc + 32), WIND_DIRECTION_ENTRIES_16(adc + 48)
+#define WIND_DIRECTION_ENTRIES_256(adc)     WIND_DIRECTION_ENTRIES_64(adc), WIND_DIRECTION_ENTRIES_64(adc + 64), WIND_DIRECTION_ENTRIES_64(adc + 128), WIND_DIRECTION_ENTRIES_64(adc + 192)
+
+static const uint8_t WindDirectionADCLookup[1024] PROGMEM =
+{
+    WIND_DIRECTION_ENTRIES_256(0), WIND_DIRECTION_ENTRIES_256(256), WIND_DIRECTION_ENTRIES_256(512), WIND_DIRECTION_ENTRIES_256(768)
+};
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Default constructor.
+//
+WeatherSensors::WeatherSensors()
+{
+    //
+    //  Make A0 an input pin so that we can read the wind direction.
+    //
+    pinMode(A0, INPUT);
+    //
+    //  Clear the sesnosr readings to 0.
+    //
+    _ultraviolet = 0;
+    _windSpeedPulseCount = 0;
+    _pluviometerPulseCount = 0;
+    _pluviometerPulseCountToday = 0;
+    _groundSensor = NULL;
+    for (int sensor = 0; sensor < NumberOfSensors; sensor++)
+    {
+        _acquisitionStartTime[sensor] = 0;
+        _acquisitionTime[sensor] = 0;
+        _acquisitionCost[sensor] = 0;
+    }
+}
+
+//
+//  Destructor - clean up any memory / objects in use.
+//
+WeatherSensors::~WeatherSensors()
+{
+    delete(_groundSensor);
+}
+
+//******************************************************************************
+//
+//  General methods (initialisation etc.)
+//
+
+//
+//  Initialise all of the weather sensors.
+//
+void WeatherSensors::InitialiseSensors()
+{
+    SetupGroundTemperatureSensor();
+    SetupLuminositySensor();
+    SetupTemperatureHumidityPressureSensor();
+    //SetupRainfallSensor();
+    //SeupWindSpeedSensor();
+}
+
+//
+//  Read all of the sensors.
+//
+//  This method forces all of the sensor readings to be taken in one go and
+//  blocks until the slowest of the sensors has delivered its data.
+//
+void WeatherSensors::ReadAllSensors()
+{
+    StartAcquisition(AllSensors);
+    while (!ServiceAcquisition())
+    {
+        yield();
+    }
+}
+
+//
+//  Start an acquisition cycle for the requested sensors.
+//
+//  All of the conversions are started together so that a complete set of
+//  readings takes roughly as long as the slowest sensor rather than the sum
+//  of the conversion times.  ServiceAcquisition() should then be called
+//  regularly (from loop()) to collect the results as they become available.
+//
+void WeatherSensors::StartAcquisition(uint8_t sensors)
+{
+    sensors &= AllSensors;
+    for (int sensor = 0; sensor < NumberOfSensors; sensor++)
+    {
+        if (sensors & (1 << sensor))
+        {
+            unsigned long start = micros();
+            _acquisitionStartTime[sensor] = millis();
+            switch (sensor)
+            {
+                case GroundTemperatureSensor:
+                    StartGroundTemperatureConversion();
+                    break;
+                case LuminositySensor:
+                    _luminosityRetries = 0;
+                    StartLuminosityIntegration();
+                    break;
+                case TemperatureHumidityPressureSensor:
+                    StartTemperatureHumidityPressureMeasurement();
+                    break;
+                case WindDirectionSensor:
+                    //
+                    //  Analog reading, nothing to start.
+                    //
+                    break;
+            }
+            _acquisitionCost[sensor] = micros() - start;
+        }
+    }
+    //ReadSTM8SSensors();
+    //ReadUltravioletLightSensor();
+    //ReadRainfallSensor();
+    //ReadWindSpeedSensor();
+    _acquisitionPending |= sensors;
+}
+
+//
+//  Collect the data from any sensor which has completed its conversion.
+//
+//  This method never waits for a sensor, it returns true when all of the
+//  sensors in the current acquisition cycle have delivered their data.
+//
+bool WeatherSensors::ServiceAcquisition()
+{
+    for (int sensor = 0; sensor < NumberOfSensors; sensor++)
+    {
+        uint8_t mask = (1 << sensor);
+        if (!(_acquisitionPending & mask))
+        {
+            continue;
+        }
+        unsigned long start = micros();
+        bool ready = IsSensorReady((Sensor) sensor, millis() - _acquisitionStartTime[sensor]);
+        _acquisitionCost[sensor] += micros() - start;
+        if (ready)
+        {
+            start = micros();
+            switch (sensor)
+            {
+                case GroundTemperatureSensor:
+                    CollectGroundTemperatureReading();
+                    break;
+                case LuminositySensor:
+                    ReadLuminositySensor();
+                    if (_luminosityRetryRequired && (_luminosityRetries < NumberOfLuminosityRanges))
+                    {
+                        //
+                        //  Out of range for the old gain / integration time,
+                        //  try again with the new settings.
+                        //
+                        _luminosityRetries++;
+                        StartLuminosityIntegration();
+                        _acquisitionCost[sensor] += micros() - start;
+                        continue;
+                    }
+                    _light.setPowerDown();
+                    break;
+                case TemperatureHumidityPressureSensor:
+                    ReadTemperatureHumidityPressureSensor();
+                    break;
+                case WindDirectionSensor:
+                    SampleWindDirection();
+                    break;
+            }
+            _acquisitionCost[sensor] += micros() - start;
+            _acquisitionTime[sensor] = millis() - _acquisitionStartTime[sensor];
+            _acquisitionPending &= ~mask;
+            _scheduler.RecordExecution(sensor, _acquisitionCost[sensor]);
+            yield();
+        }
+    }
+    return(_acquisitionPending == 0);
+}
+
+//
+//  Determine if there are any sensors still converting.
+//
+bool WeatherSensors::AcquisitionInProgress()
+{
+    return(_acquisitionPending != 0);
+}
+
+//
+//  Get the time (in milliseconds) between starting the conversion for a
+//  sensor and its data being collected during the last acquisition cycle.
+//
+unsigned long WeatherSensors::GetAcquisitionTime(Sensor sensor)
+{
+    return(_acquisitionTime[sensor]);
+}
+
+//
+//  Register a sensor with the scheduler, the sensor will be read every
+//  period milliseconds at the phase offset given.  The scheduler picks a
+//  phase which keeps the sensor clear of the other sensors if the phase is
+//  not specified.
+//
+void WeatherSensors::ScheduleSensor(Sensor sensor, unsigned long period, unsigned long phase)
+{
+    _scheduler.AddTask(sensor, period, phase, EstimateAcquisitionCost(sensor));
+}
+
+//
+//  Start running the schedule, phases are measured from now.
+//
+void WeatherSensors::StartSchedule()
+{
+    _scheduler.Start(millis());
+}
+
+//
+//  Start the acquisition for any sensor which is due and collect the data
+//  from any sensor which has finished.  This should be called from loop().
+//
+//  A sensor which is still converting when it becomes due again is not
+//  restarted.
+//
+void WeatherSensors::ServiceSchedule()
+{
+    int sensor;
+
+    while ((sensor = _scheduler.GetNextDueTask(millis())) >= 0)
+    {
+        if (!(_acquisitionPending & (1 << sensor)))
+        {
+            StartAcquisition(1 << sensor);
+        }
+    }
+    ServiceAcquisition();
+}
+
+//
+//  Get the scheduler, this gives access to the planned and actual timings.
+//
+SensorScheduler *WeatherSensors::GetScheduler()
+{
+    return(&_scheduler);
+}
+
+//
+//  Estimate the processor time (microseconds) needed to read a sensor, this
+//  is the bus traffic and excludes the time waiting for the conversion.
+//
+unsigned long WeatherSensors::EstimateAcquisitionCost(Sensor sensor)
+{
+    switch (sensor)
+    {
+        case GroundTemperatureSensor:
+            //
+            //  Broadcast convert followed by a read of each scratchpad.
+            //
+            return(2000 + (_numberOfGroundTemperatureProbes * 12000));
+        case LuminositySensor:
+            return(2000);
+        case TemperatureHumidityPressureSensor:
+            return(2000);
+        case WindDirectionSensor:
+            return(100);
+        default:
+            return(0);
+    }
+}
+
+//
+//  Check if the data for the sensor should now be available.
+//
+bool WeatherSensors::IsSensorReady(Sensor sensor, unsigned long elapsed)
+{
+    switch (sensor)
+    {
+        case GroundTemperatureSensor:
+            return(IsGroundTemperatureConversionComplete(elapsed));
+        case LuminositySensor:
+            //
+            //  Allow 10% for the tolerance of the TSL2561 internal oscillator,
+            //  the integration may have been restarted by the auto-ranging.
+            //
+            return((millis() - _luminosityIntegrationStart) >= (_ms + (_ms / 10) + 1));
+        case TemperatureHumidityPressureSensor:
+            return(IsTemperatureHumidityPressureMeasurementComplete());
+        default:
+            return(true);
+    }
+}
+
+//******************************************************************************
+//
+//  DS18x20 temperature sensors.
+//
+//  Setup the DS18x20 sensors (ground temperature).
+//
+//  All of the probes on the OneWire bus are enumerated and their ROM codes
+//  cached so that the bus does not need to be searched again.  The probes are
+//  stored in the order the search algorithm finds them.
+//
+void WeatherSensors::SetupGroundTemperatureSensor()
+{
+    int index;
+    String message;
+    char number[20];
+    byte address[8];
+    byte data[9];
+
+    _groundSensor = new OneWire(_groundTemperaturePin);
+    _groundSensor->reset_search();
+    _numberOfGroundTemperatureProbes = 0;
+    while ((_numberOfGroundTemperatureProbes < MaximumGroundTemperatureProbes) && _groundSensor->search(address))
+    {
+        message = "ROM =";
+        for (index = 0; index < 8; index++)
+        {
+            message += " ";
+            message += itoa(address[index], number, 16);
+        }
+        Debugger::DebugMessage(message);
+
+        if (OneWire::crc8(address, 7) != address[7])
+        {
+            Debugger::DebugMessage("CRC is not valid!");
+            continue;
+        }
+
+        GroundTemperatureProbe *probe = &_groundTemperatureProbes[_numberOfGroundTemperatureProbes];
+        switch (address[0])
+        {
+        case 0x10:
+            Debugger::DebugMessage("Chip = DS18S20");
+            probe->type = 1;
+            break;
+        case 0x28:
+            Debugger::DebugMessage("Chip = DS18B20");
+            probe->type = 0;
+            break;
+        case 0x22:
+            Debugger::DebugMessage("Chip = DS1822");
+            probe->type = 0;
+            break;
+        default:
+            Debugger::DebugMessage("Device is not a DS18x20 family device.");
+            continue;
+        }
+        memcpy(probe->address, address, sizeof(probe->address));
+        probe->resolution = 12;
+        probe->crcFailures = 0;
+        probe->temperature = 0;
+        _numberOfGroundTemperatureProbes++;
+        //
+        //  Pick up the current resolution from the configuration register.
+        //
+        ReadGroundTemperatureScratchpad(_numberOfGroundTemperatureProbes - 1, data);
+    }
+    _groundSensor->reset_search();
+    if (_numberOfGroundTemperatureProbes == 0)
+    {
+        Debugger::DebugMessage("No DS18x20 devices found.");
+        return;
+    }
+    Debugger::DebugMessage("Number of ground temperature probes:", (unsigned int) _numberOfGroundTemperatureProbes, 10, "");
+    //
+    //  Read Power Supply, any parasite powered device pulls the bus low.
+    //
+    _groundSensor->reset();
+    _groundSensor->skip();
+    _groundSensor->write(0xB4);
+    _groundTemperatureParasitePower = (_groundSensor->read_bit() == 0);
+    if (_groundTemperatureParasitePower)
+    {
+        Debugger::DebugMessage("DS18x20 parasite power in use.");
+    }
+    UpdateGroundTemperatureConversionTime();
+}
+
+//
+//  Read the ground temperature from the DS18x20 sensors.
+//
+//  This method blocks while the conversion takes place.
+//
+float WeatherSensors::ReadGroundTemperatureSensor()
+{
+    unsigned long start = millis();
+
+    StartGroundTemperatureConversion();
+    while (!IsGroundTemperatureConversionComplete(millis() - start))
+    {
+        delay(1);
+    }
+    return(CollectGroundTemperatureReading());
+}
+
+//
+//  Start a temperature conversion on all of the DS18x20 probes.
+//
+//  The Skip ROM command addresses every device on the bus so a single Convert
+//  T starts all of the probes converting at the same time.  Parasite powered
+//  probes need the strong pull-up for the whole of the conversion.
+//
+void WeatherSensors::StartGroundTemperatureConversion()
+{
+    if (_numberOfGroundTemperatureProbes == 0)
+    {
+        return;
+    }
+    _groundSensor->reset();
+    _groundSensor->skip();
+    _groundSensor->write(0x44, _groundTemperatureParasitePower ? 1 : 0);
+}
+
+//
+//  Check if the conversion started by StartGroundTemperatureConversion has
+//  completed.
+//
+//  The maximum conversion time for the slowest probe is always honoured.
+//  When none of the probes are parasite powered the probes hold the bus
+//  low until they have finished and so the bus can be polled for an early
+//  completion.
+//
+bool WeatherSensors::IsGroundTemperatureConversionComplete(unsigned long elapsed)
+{
+    if ((_numberOfGroundTemperatureProbes == 0) || (elapsed >= _groundTemperatureConversionTime))
+    {
+        return(true);
+    }
+    if (!_groundTemperatureParasitePower)
+    {
+        return(_groundSensor->read_bit() == 1);
+    }
+    return(false);
+}
+
+//
+//  Work out the conversion time (in milliseconds) for the slowest probe on
+//  the bus, 93.75ms at 9 bits doubling for each additional bit.
+//
+void WeatherSensors::UpdateGroundTemperatureConversionTime()
+{
+    uint8_t resolution = 9;
+
+    for (uint8_t probe = 0; probe < _numberOfGroundTemperatureProbes; probe++)
+    {
+        if (_groundTemperatureProbes[probe].resolution > resolution)
+        {
+            resolution = _groundTemperatureProbes[probe].resolution;
+        }
+    }
+    _groundTemperatureConversionTime = (750 >> (12 - resolution)) + 1;
+}
+
+//
+//  Set the resolution of all of the DS18B20 / DS1822 probes on the bus.
+//
+bool WeatherSensors::SetGroundTemperatureResolution(uint8_t bits)
+{
+    bool result = true;
+
+    for (uint8_t probe = 0; probe < _numberOfGroundTemperatureProbes; probe++)
+    {
+        if (_groundTemperatureProbes[probe].type == 0)
+        {
+            result &= SetGroundTemperatureResolution(probe, bits);
+        }
+    }
+    return(result);
+}
+
+//
+//  Set the resolution (9 to 12 bits) of a single probe.
+//
+//  The configuration register is written to the scratchpad only, the alarm
+//  registers are preserved.  The setting is lost when the probe loses power
+//  so this should be called each time the sensors are initialised.  The
+//  DS18S20 has a fixed resolution and cannot be changed.
+//
+bool WeatherSensors::SetGroundTemperatureResolution(uint8_t probe, uint8_t bits)
+{
+    byte data[9];
+
+    if ((probe >= _numberOfGroundTemperatureProbes) || (bits < 9) || (bits > 12))
+    {
+        Debugger::DebugMessage("Invalid ground temperature resolution request.");
+        return(false);
+    }
+    GroundTemperatureProbe *device = &_groundTemperatureProbes[probe];
+    if (device->type)
+    {
+        Debugger::DebugMessage("DS18S20 resolution cannot be changed.");
+        return(false);
+    }
+    if (!ReadGroundTemperatureScratchpad(probe, data))
+    {
+        return(false);
+    }
+    _groundSensor->reset();
+    _groundSensor->select(device->address);
+    _groundSensor->write(0x4E);         // Write Scratchpad
+    _groundSensor->write(data[2]);      // TH
+    _groundSensor->write(data[3]);      // TL
+    _groundSensor->write(((bits - 9) << 5) | 0x1f);
+    //
+    //  Read the configuration back to confirm the change.
+    //
+    bool result = ReadGroundTemperatureScratchpad(probe, data) && (device->resolution == bits);
+    UpdateGroundTemperatureConversionTime();
+    if (!result)
+    {
+        Debugger::DebugMessage("Failed to set DS18x20 resolution, probe", (unsigned int) probe, 10, "");
+    }
+    return(result);
+}
+
+//
+//  Get the time (in milliseconds) allowed for a conversion at the current
+//  resolution.
+//
+unsigned long WeatherSensors::GetGroundTemperatureConversionTime()
+{
+    return(_groundTemperatureConversionTime);
+}
+
+//
+//  Determine if any of the probes are using parasite power.
+//
+bool WeatherSensors::IsGroundTemperatureParasitePowered()
+{
+    return(_groundTemperatureParasitePower);
+}
+
+//
+//  Read the scratchpad from a single probe.
+//
+//  Returns true if the CRC is valid, the CRC failure count for the probe is
+//  incremented if it is not.  The resolution of DS18B20 / DS1822 probes is
+//  updated from the configuration register.
+//
+bool WeatherSensors::ReadGroundTemperatureScratchpad(uint8_t probe, byte *data)
+{
+    int index;
+    byte present = 0;
+    String message;
+    char number[20];
+    GroundTemperatureProbe *device = &_groundTemperatureProbes[probe];
+
+    present = _groundSensor->reset();
+    _groundSensor->select(device->address);
+    _groundSensor->write(0xBE);       // Read Scratchpad
+
+    message = "DS18x20 (";
+    message += itoa(probe, number, 10);
+    message += ") Data = ";
+    message += itoa(present, number, 16);
+    message += " ";
+    for (index = 0; index < 9; index++)
+    {
+        data[index] = _groundSensor->read();
+        message += itoa(data[index], number, 16);
+        message += " ";
+    }
+    message += " CRC=";
+    message += itoa(OneWire::crc8(data, 8), number, 16);
+    Debugger::DebugMessage(message);
+
+    if (OneWire::crc8(data, 8) != data[8])
+    {
+        device->crcFailures++;
+        Debugger::DebugMessage("DS18x20 CRC failure, probe", (unsigned int) probe, 10, "");
+        return(false);
+    }
+    if (device->type == 0)
+    {
+        device->resolution = 9 + ((data[4] >> 5) & 0x03);
+    }
+    else
+    {
+        device->resolution = 12;
+    }
+    return(true);
+}
+
+//
+//  Read the scratchpad from each probe following a conversion and decode
+//  the temperatures.
+//
+//  A probe which fails its CRC check keeps its previous reading.
+//
+float WeatherSensors::CollectGroundTemperatureReading()
+{
+    byte data[9];
+
+    for (uint8_t probe = 0; probe < _numberOfGroundTemperatureProbes; probe++)
+    {
+        GroundTemperatureProbe *device = &_groundTemperatureProbes[probe];
+        if (ReadGroundTemperatureScratchpad(probe, data))
+        {
+            device->temperature = DecodeGroundTemperature(data, device->type);
+        }
+        yield();
+    }
+    return(GetGroundTemperatureReading());
+}
+
+//
+//  Convert the scratchpad from a DS18x20 into a temperature in degrees C.
+//
+//  type is non-zero for the older DS18S20 (9 bit) probes.
+//
+float WeatherSensors::DecodeGroundTemperature(const byte *data, byte type)
+{
+    int16_t raw = (data[1] << 8) | data[0];
+    if (type)
+    {
+        raw = raw << 3; // 9 bit resolution default
+        if (data[7] == 0x10)
+        {
+            // "count remain" gives full 12 bit resolution
+            raw = (raw & 0xFFF0) + 12 - data[6];
+        }
+    }
+    else
+    {
+        byte cfg = (data[4] & 0x60);
+        // at lower res, the low bits are undefined, so let's zero them
+        switch (cfg)
+        {
+        case 0x00:
+            raw = raw & ~7;   // 9 bit resolution, 93.75 ms
+            break;
+        case 0x20:
+            raw = raw & ~3;   // 10 bit res, 187.5 ms
+            break;
+        case 0x40:
+            raw = raw & ~1;   // 11 bit res, 375 ms
+            break;
+        }
+        //// default is 12 bit resolution, 750 ms conversion time
+    }
+    return((float) (raw / 16.0));
+}
+
+//
+//  Get the last ground temperature reading from the first probe.
+//
+float WeatherSensors::GetGroundTemperatureReading()
+{
+    return(GetGroundTemperatureReading(0));
+}
+
+//
+//  Get the last ground temperature reading from the specified probe.
+//
+float WeatherSensors::GetGroundTemperatureReading(uint8_t probe)
+{
+    if (probe >= _numberOfGroundTemperatureProbes)
+    {
+        return(0);
+    }
+    return(_groundTemperatureProbes[probe].temperature);
+}
+
+//
+//  Get the number of DS18x20 probes found on the OneWire bus.
+//
+uint8_t WeatherSensors::GetNumberOfGroundTemperatureProbes()
+{
+    return(_numberOfGroundTemperatureProbes);
+}
+
+//
+//  Get the ROM code for the specified probe.
+//
+const byte *WeatherSensors::GetGroundTemperatureProbeAddress(uint8_t probe)
+{
+    if (probe >= _numberOfGroundTemperatureProbes)
+    {
+        return(NULL);
+    }
+    return(_groundTemperatureProbes[probe].address);
+}
+
+//
+//  Get the resolution (in bits) of the specified probe.
+//
+uint8_t WeatherSensors::GetGroundTemperatureProbeResolution(uint8_t probe)
+{
+    if (probe >= _numberOfGroundTemperatureProbes)
+    {
+        return(0);
+    }
+    return(_groundTemperatureProbes[probe].resolution);
+}
+
+//
+//  Get the number of scratchpad reads from the probe which failed the CRC check.
+//
+uint16_t WeatherSensors::GetGroundTemperatureProbeCRCFailures(uint8_t probe)
+{
+    if (probe >= _numberOfGroundTemperatureProbes)
+    {
+        return(0);
+    }
+    return(_groundTemperatureProbes[probe].crcFailures);
+}
+
+//******************************************************************************
+//
+//  Ultraviolet light sensor.
+//
+
+//
+//  Read the ultraviolet light sensor.
+//
+float WeatherSensors::ReadUltravioletLightSensor()
+{
+    return(_ultraviolet);
+}
+
+//
+//  Get the last value read from the UV sensor.
+//
+float WeatherSensors::GetUltravioletLightReading()
+{
+    return(_ultraviolet);
+}
+
+//
+//  Convert the ultraviolet light sensor reading into mW/cm2.
+//
+float WeatherSensors::GetUltravioletLightStrength()
+{
+    float uvStrength = _ultraviolet * _voltsPerDivision;
+
+    if (uvStrength < _uvOffset)
+    {
+        uvStrength = 0;
+    }
+    else
+    {
+        uvStrength = (uvStrength - _uvOffset) / _uvGradient;
+    }
+    return(uvStrength);
+}
+
+//******************************************************************************
+//
+//  Get data from the STM8S.
+//
+//  Sensors connected to the STM8S:
+//
+//  1 - Wind Speed
+//  2 - Wind Direction
+//  3 - Ultraviolet Light
+//  4 - Rain Guage (Pluviometer)
+//
+//  The STM8S is read through its register map.  The sample frame carries a
+//  sequence number and a CRC so a frame which was updated while it was being
+//  read, or which has already been seen, can be rejected.
+//
+
+//
+//  CRC-8 of the sample frame, polynomial 0x07, initial value 0.
+//
+uint8_t WeatherSensors::Crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0;
+
+    while (length--)
+    {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+        }
+    }
+    return(crc);
+}
+
+//
+//  Values from the STM8S are sent MSB first.
+//
+uint16_t WeatherSensors::GetShort(const uint8_t *data)
+{
+    return((data[0] << 8) | data[1]);
+}
+
+uint32_t WeatherSensors::GetLong(const uint8_t *data)
+{
+    return((((uint32_t) GetShort(data)) << 16) | GetShort(data + 2));
+}
+
+//
+//  Check that the STM8S speaks a protocol version we understand and that
+//  the sample frame contains the fields we need.
+//
+bool WeatherSensors::CheckSTM8SProtocol()
+{
+    uint8_t buffer[I2CVersionLength];
+
+    Wire.beginTransmission(STM8SAddress);
+    Wire.write(I2CRegisterVersion);
+    Wire.endTransmission(false);
+    if (Wire.requestFrom(STM8SAddress, I2CVersionLength) != I2CVersionLength)
+    {
+        Debugger::DebugMessage("Unable to read the STM8S protocol version.");
+        return(false);
+    }
+    for (int index = 0; index < I2CVersionLength; index++)
+    {
+        buffer[index] = Wire.read();
+    }
+    if ((buffer[0] != I2CProtocolVersion) || ((buffer[1] & I2CRequiredCapabilities) != I2CRequiredCapabilities) || (buffer[2] != I2CSampleLength))
+    {
+        Debugger::DebugMessage("STM8S protocol is not supported", buffer, I2CVersionLength);
+        return(false);
+    }
+    _stm8sProtocolChecked = true;
+    return(true);
+}
+
+//
+//  Read the latest sample from the STM8S in a single transaction, the
+//  register address is followed by a repeated start and the sample frame.
+//
+//  Returns true if a new sample has been read.
+//
+bool WeatherSensors::ReadSTM8SSensors()
+{
+    uint8_t buffer[I2CSampleLength];
+
+    if (!_stm8sProtocolChecked && !CheckSTM8SProtocol())
+    {
+        return(false);
+    }
+    Wire.beginTransmission(STM8SAddress);
+    Wire.write(I2CRegisterSample);
+    Wire.endTransmission(false);
+    if (Wire.requestFrom(STM8SAddress, I2CSampleLength) != I2CSampleLength)
+    {
+        Debugger::DebugMessage("There is a problem with the I2C readings from the STM8S.");
+        return(false);
+    }
+    for (int index = 0; index < I2CSampleLength; index++)
+    {
+        buffer[index] = Wire.read();
+    }
+    Debugger::DebugMessage("STM8S Sensor data", buffer, I2CSampleLength);
+    if (Crc8(buffer, I2CSampleCRC) != buffer[I2CSampleCRC])
+    {
+        Debugger::DebugMessage("STM8S sample failed the CRC check.");
+        return(false);
+    }
+    uint16_t sequence = GetShort(buffer + I2CSequence);
+    if ((sequence == 0) || (sequence == _stm8sSequence))
+    {
+        Debugger::DebugMessage("STM8S data is not ready.");
+        return(false);
+    }
+    _stm8sSequence = sequence;
+    _windSpeedPulseCount = GetLong(buffer + I2CWindSpeed);
+    _pluviometerPulseCount = GetLong(buffer + I2CRainfallCounter);
+    _pluviometerPulseCountToday = _pluviometerPulseCount;
+    _ultraviolet = GetShort(buffer + I2CUVReading);
+    _windPeriodMean = GetLong(buffer + I2CWindPeriodMean);
+    _windPeriodMinimum = GetLong(buffer + I2CWindPeriodMinimum);
+    return(true);
+}
+
+//
+//  Sequence number of the last sample read from the STM8S, 0 if no sample
+//  has been read.
+//
+uint16_t WeatherSensors::GetSTM8SSequence()
+{
+    return(_stm8sSequence);
+}
+
+//
+//  Read the STM8S history starting at the record with the given sequence
+//  number, at most maximum records (and no more than STM8SRecordsPerRead)
+//  are read in a single I2C transaction.  The RTC alarm count of each record
+//  dates it, the rain gauge totals are rebuilt from the total in the header
+//  and the per record counts.  The response ends with a CRC-8 of the header
+//  and records, a response which fails the check is discarded.
+//
+//  Returns the number of records read.  If the requested record has been
+//  overwritten the first record returned is the oldest still held, check
+//  the sequence number of the first record to detect lost readings.
+//
+uint8_t WeatherSensors::ReadSTM8SHistory(uint16_t sequence, STM8SRecord *records, uint8_t maximum)
+{
+    uint8_t buffer[BUFFER_LENGTH];
+
+    if (maximum > STM8SRecordsPerRead)
+    {
+        maximum = STM8SRecordsPerRead;
+    }
+    Wire.beginTransmission(STM8SAddress);
+    Wire.write(I2CGetHistory);
+    Wire.write((uint8_t) (sequence >> 8));
+    Wire.write((uint8_t) (sequence & 0xff));
+    Wire.write(maximum);
+    Wire.endTransmission();
+    uint8_t length = STM8SHistoryHeaderSize + (maximum * STM8SHistoryRecordSize) + 1;
+    if (Wire.requestFrom(STM8SAddress, length) != length)
+    {
+        Debugger::DebugMessage("Unable to read the STM8S history.");
+        return(0);
+    }
+    for (uint8_t index = 0; index < length; index++)
+    {
+        buffer[index] = Wire.read();
+    }
+    //
+    //  A count of 0xff indicates nothing was driven onto the bus.
+    //
+    uint8_t count = buffer[0];
+    if (count > maximum)
+    {
+        Debugger::DebugMessage("STM8S history header is invalid.");
+        return(0);
+    }
+    uint8_t crcPosition = STM8SHistoryHeaderSize + (count * STM8SHistoryRecordSize);
+    if (Crc8(buffer, crcPosition) != buffer[crcPosition])
+    {
+        Debugger::DebugMessage("STM8S history failed the CRC check.");
+        return(0);
+    }
+    uint16_t first = GetShort(buffer + 1);
+    uint16_t alarm = GetShort(buffer + 3);
+    uint32_t rainfall = GetLong(buffer + 5);
+    for (uint8_t index = 0; index < count; index++)
+    {
+        const uint8_t *record = buffer + STM8SHistoryHeaderSize + (index * STM8SHistoryRecordSize);
+        rainfall += GetShort(record);
+        records[index].sequence = (index == 0) ? first : NextSTM8SSequence(records[index - 1].sequence);
+        records[index].alarm = alarm + index;
+        records[index].rainfall = rainfall;
+        records[index].windSpeed = GetShort(record + 2);
+        records[index].windDirection = ((uint16_t) (record[4] & 0x0f) << 6) | (record[5] >> 2);
+        records[index].ultraviolet = ((uint16_t) (record[5] & 0x03) << 8) | record[6];
+        records[index].windPeriodMean = ((uint32_t) GetShort(record + 7)) << 5;
+        records[index].windPeriodMinimum = ((uint32_t) GetShort(record + 9)) << 5;
+    }
+    return(count);
+}
+
+//
+//  Sequence number of the STM8S record after the given record, the numbers
+//  run from 1 to 65535 and then start again at 1.
+//
+uint16_t WeatherSensors::NextSTM8SSequence(uint16_t sequence)
+{
+    return((sequence == 0xffff) ? 1 : (sequence + 1));
+}
+
+//
+//  Set the debounce windows (mS) for the rain gauge and anemometer reed
+//  switches on the STM8S, 0 turns debouncing off.  The windows are read
+//  back to check that they have been accepted.
+//
+bool WeatherSensors::SetSTM8SDebounce(uint8_t rainGauge, uint8_t anemometer)
+{
+    Wire.beginTransmission(STM8SAddress);
+    Wire.write(I2CSetDebounce);
+    Wire.write(rainGauge);
+    Wire.write(anemometer);
+    Wire.endTransmission();
+    Wire.beginTransmission(STM8SAddress);
+    Wire.write(I2CRegisterDebounce);
+    Wire.endTransmission(false);
+    if (Wire.requestFrom(STM8SAddress, (uint8_t) 2) != 2)
+    {
+        Debugger::DebugMessage("Unable to read the STM8S debounce windows.");
+        return(false);
+    }
+    uint8_t rainGaugeWindow = Wire.read();
+    uint8_t anemometerWindow = Wire.read();
+    if ((rainGaugeWindow != rainGauge) || (anemometerWindow != anemometer))
+    {
+        Debugger::DebugMessage("STM8S did not accept the debounce windows.");
+        return(false);
+    }
+    return(true);
+}
+
+//
+//  Clear the STM8S rain gauge pulse count.  The history is unaffected, the
+//  record after the reset holds the pulses since the previous record and
+//  the totals rebuilt by ReadSTM8SHistory follow the new count.
+//
+bool WeatherSensors::ResetSTM8SRainfallCounter()
+{
+    Wire.beginTransmission(STM8SAddress);
+    Wire.write(I2CResetRainFallCounter);
+    if (Wire.endTransmission() != 0)
+    {
+        Debugger::DebugMessage("Unable to reset the STM8S rain gauge counter.");
+        return(false);
+    }
+    return(true);
+}
+
+//******************************************************************************
+//
+//  Sparkfun Luminosity sensor.
+//
+
+//
+//  Translate the error code into a meaningful message.
+//
+String WeatherSensors::LuminositySensorErrorMessage(byte error)
+{
+    switch (error)
+    {
+    case 0:
+        return("TSL2561 Error: Success");
+    case 1:
+        return("TSL2561 Error: Data too long for transmit buffer");
+    case 2:
+        return("TSL2561 Error: Received NACK on address (disconnected?)");
+    case 3:
+        return("TSL2561 Error: Received NACK on data");
+    case 4:
+        return("TSL2561 Error: Other error");
+    default:
+        return("TSL2561 Error: Unknown error code");
+    }
+}
+
+//
+//  Set up the luminsoity sensor.
+//
+void WeatherSensors::SetupLuminositySensor()
+{
+    char buffer[256];
+
+    _light.begin();
+
+    // Get factory ID from sensor:
+    // (Just for fun, you don't need to do this to operate the sensor)
+    unsigned char id;
+
+    if (_light.getID(id))
+    {
+        sprintf(buffer, "Retrieved TSL2561 device ID: 0x%x", id);
+        Debugger::DebugMessage(buffer);
+    }
+    else
+    {
+        byte error = _light.getError();
+        Debugger::DebugMessage(LuminositySensorErrorMessage(error));
+    }
+
+    //
+    //  Start with the most sensitive range, the auto-ranging will move to a
+    //  shorter integration time once it has seen the light level.
+    //
+    SetLuminosityRange(NumberOfLuminosityRanges - 1);
+    _good = true;
+
+    Debugger::DebugMessage((char *) "Powering up the luminosity sensor.");
+    _light.setPowerUp();
+}
+
+//
+//  Gain / integration time combinations in order of increasing sensitivity.
+//  For any light level the auto-ranging picks the least sensitive (and so
+//  the fastest) range which gives a useful number of counts.  1x gain is
+//  only used at 13.7ms as 16x gain is faster for the same sensitivity.
+//
+const WeatherSensors::LuminosityRange WeatherSensors::_luminosityRanges[NumberOfLuminosityRanges] =
+{
+    { 0, 0, 5047, 100 },            // 1x, 13.7ms
+    { 1, 0, 5047, 1600 },           // 16x, 13.7ms
+    { 1, 1, 37177, 11792 },         // 16x, 101ms
+    { 1, 2, 65535, 46944 }          // 16x, 402ms
+};
+
+//
+//  Set the gain and integration time for the luminosity sensor.
+//
+void WeatherSensors::SetLuminosityRange(uint8_t range)
+{
+    _luminosityRange = range;
+    _gain = _luminosityRanges[range].gain;
+    _light.setTiming(_gain, _luminosityRanges[range].time, _ms);
+}
+
+//
+//  Start a new integration cycle on the luminosity sensor.
+//
+//  Powering the TSL2561 down and back up restarts the ADC integration so the
+//  data is available _ms milliseconds later.
+//
+void WeatherSensors::StartLuminosityIntegration()
+{
+    _light.setPowerDown();
+    _light.setPowerUp();
+    _luminosityIntegrationStart = millis();
+}
+
+//
+//  Work out the best range for the light level seen in the last reading.
+//
+//  A saturated reading moves straight to the least sensitive range,
+//  otherwise the counts are scaled to each range and the first range giving
+//  at least _minimumLuminosityCount counts (without getting too close to
+//  saturation) is selected.
+//
+uint8_t WeatherSensors::SelectLuminosityRange(unsigned int data0, unsigned int data1, bool saturated)
+{
+    if (saturated)
+    {
+        return((_luminosityRange > 0) ? 0 : _luminosityRange);
+    }
+    uint32_t counts = (data0 > data1) ? data0 : data1;
+    uint32_t sensitivity = _luminosityRanges[_luminosityRange].sensitivity;
+    for (uint8_t range = 0; range < NumberOfLuminosityRanges; range++)
+    {
+        uint32_t expected = (uint32_t) (((uint64_t) counts * _luminosityRanges[range].sensitivity) / sensitivity);
+        if (expected >= ((_luminosityRanges[range].maximumCount / 4) * 3))
+        {
+            continue;
+        }
+        if ((expected >= _minimumLuminosityCount) || (range == (NumberOfLuminosityRanges - 1)))
+        {
+            return(range);
+        }
+    }
+    return(NumberOfLuminosityRanges - 1);
+}
+
+//
+//  Read the luminosity frolm the TSL2561 luminosity sensor.
+//
+//  The gain and integration time are adjusted following each reading.  If
+//  the reading was saturated or too small to be useful then a retry is
+//  flagged (_luminosityRetryRequired) so that the acquisition cycle can
+//  take the reading again with the new settings.  A saturated reading at the
+//  least sensitive range is still used, it is the best available.
+//
+double WeatherSensors::ReadLuminositySensor()
+{
+    unsigned int data0, data1;
+
+    _luminosityRetryRequired = false;
+    if (_light.getData(data0, data1))
+    {
+        unsigned int maximumCount = _luminosityRanges[_luminosityRange].maximumCount;
+        bool saturated = (data0 >= maximumCount) || (data1 >= maximumCount);
+        uint8_t range = SelectLuminosityRange(data0, data1, saturated);
+        //
+        //  To calculate lux, pass all your settings and readings to the getLux() function.
+        //
+        //  The getLux() function will return 1 if the calculation was successful, or 0 if one or both of the sensors was
+        //  saturated (too much light). If this happens, you can reduce the integration time and/or gain.
+        //  For more information see the hookup guide at: 
+        //  https://learn.sparkfun.com/tutorials/getting-started-with-the-tsl2561-luminosity-sensor
+        //
+        // Perform lux calculation.
+        //
+        double localLux;
+        _good = !saturated && _light.getLux(_gain, _ms, data0, data1, localLux);
+        if (_good || (saturated && (range == _luminosityRange) && _light.getLux(_gain, _ms, data0, data1, localLux)))
+        {
+            _lux = localLux;
+        }
+        if (range != _luminosityRange)
+        {
+            _luminosityRetryRequired = saturated || (range > _luminosityRange);
+            SetLuminosityRange(range);
+        }
+    }
+    else
+    {
+        byte error = _light.getError();
+        Debugger::DebugMessage(LuminositySensorErrorMessage(error));
+    }
+    return(_lux);
+}
+
+//
+//  Get the last luminosity reading.
+//
+double WeatherSensors::GetLuminosityReading()
+{
+    return(_lux);
+}
+
+//
+//  Check if the last luminosity reading was saturated, the reading is a
+//  lower bound for the light level.
+//
+bool WeatherSensors::IsLuminosityReadingSaturated()
+{
+    return(!_good);
+}
+
+//
+//  Get the current luminosity sensor gain, false = 1x, true = 16x.
+//
+bool WeatherSensors::GetLuminosityGain()
+{
+    return(_gain);
+}
+
+//
+//  Get the current luminosity sensor integration time (milliseconds).
+//
+unsigned int WeatherSensors::GetLuminosityIntegrationTime()
+{
+    return(_ms);
+}
+
+//******************************************************************************
+//
+//  BME280 temperature, air pressure and humidity sensor.
+//
+//  The sensor is driven directly rather than through the Adafruit library so
+//  that a measurement can be taken in forced mode and all three readings
+//  compensated from a single burst read of the data registers.
+//
+
+//
+//  Setup the BME280 Temperature, pressure and humidity sensor.
+//
+//  The default configuration follows the Bosch recommendation for weather
+//  monitoring, forced mode with 1x oversampling and the filter off.
+//
+void WeatherSensors::SetupTemperatureHumidityPressureSensor()
+{
+    _temperature = 0;
+    _pressure = 0;
+    _humidity = 0;
+    _bme280Present = (ReadBME280Register(BME280RegisterChipID) == BME280ChipID);
+    if (!_bme280Present)
+    {
+        Debugger::DebugMessage("Could not find a valid BME280 sensor, check wiring!");
+        return;
+    }
+    Debugger::DebugMessage("BME280 sensor located on I2C bus.");
+    ReadBME280Calibration();
+    WriteBME280Register(BME280RegisterConfig, 0);
+    SetTemperatureHumidityPressureOversampling(Oversampling1, Oversampling1, Oversampling1);
+}
+
+//
+//  Set the oversampling for the temperature, pressure and humidity
+//  measurements.  Higher oversampling reduces the noise at the expense of
+//  a longer measurement time.
+//
+//  Note that the humidity control register only takes effect after the
+//  measurement control register has been written.
+//
+void WeatherSensors::SetTemperatureHumidityPressureOversampling(BME280Oversampling temperature, BME280Oversampling pressure, BME280Oversampling humidity)
+{
+    _bme280ControlHumidity = humidity & 0x07;
+    _bme280ControlMeasurement = ((temperature & 0x07) << 5) | ((pressure & 0x07) << 2);
+    if (_bme280Present)
+    {
+        WriteBME280Register(BME280RegisterControlHumidity, _bme280ControlHumidity);
+        WriteBME280Register(BME280RegisterControlMeasurement, _bme280ControlMeasurement);
+    }
+}
+
+//
+//  Start a single measurement by putting the BME280 into forced mode.  The
+//  sensor returns to sleep mode once the measurement has completed.
+//
+void WeatherSensors::StartTemperatureHumidityPressureMeasurement()
+{
+    if (_bme280Present)
+    {
+        WriteBME280Register(BME280RegisterControlMeasurement, _bme280ControlMeasurement | BME280ForcedMode);
+    }
+}
+
+//
+//  Check the status register to see if the BME280 has finished measuring.
+//
+bool WeatherSensors::IsTemperatureHumidityPressureMeasurementComplete()
+{
+    if (!_bme280Present)
+    {
+        return(true);
+    }
+    return((ReadBME280Register(BME280RegisterStatus) & BME280StatusBusy) == 0);
+}
+
+//
+//  Read the compensation parameters from the two calibration blocks.
+//
+void WeatherSensors::ReadBME280Calibration()
+{
+    uint8_t data[26];
+
+    ReadBME280Registers(BME280RegisterCalibration00, data, 26);
+    _bme280Calibration.t1 = (uint16_t) ((data[1] << 8) | data[0]);
+    _bme280Calibration.t2 = (int16_t) ((data[3] << 8) | data[2]);
+    _bme280Calibration.t3 = (int16_t) ((data[5] << 8) | data[4]);
+    _bme280Calibration.p1 = (uint16_t) ((data[7] << 8) | data[6]);
+    _bme280Calibration.p2 = (int16_t) ((data[9] << 8) | data[8]);
+    _bme280Calibration.p3 = (int16_t) ((data[11] << 8) | data[10]);
+    _bme280Calibration.p4 = (int16_t) ((data[13] << 8) | data[12]);
+    _bme280Calibration.p5 = (int16_t) ((data[15] << 8) | data[14]);
+    _bme280Calibration.p6 = (int16_t) ((data[17] << 8) | data[16]);
+    _bme280Calibration.p7 = (int16_t) ((data[19] << 8) | data[18]);
+    _bme280Calibration.p8 = (int16_t) ((data[21] << 8) | data[20]);
+    _bme280Calibration.p9 = (int16_t) ((data[23] << 8) | data[22]);
+    _bme280Calibration.h1 = data[25];
+    ReadBME280Registers(BME280RegisterCalibration26, data, 7);
+    _bme280Calibration.h2 = (int16_t) ((data[1] << 8) | data[0]);
+    _bme280Calibration.h3 = data[2];
+    _bme280Calibration.h4 = (int16_t) ((((int8_t) data[3]) << 4) | (data[4] & 0x0f));
+    _bme280Calibration.h5 = (int16_t) ((((int8_t) data[5]) << 4) | (data[4] >> 4));
+    _bme280Calibration.h6 = (int8_t) data[6];
+}
+
+//
+//  Compensate the raw temperature, returns the fine temperature used by the
+//  pressure and humidity compensation.  The temperature in C is t_fine / 5120.
+//
+int32_t WeatherSensors::CompensateBME280Temperature(int32_t adc)
+{
+    int32_t t1 = _bme280Calibration.t1;
+    int32_t var1 = ((((adc >> 3) - (t1 << 1))) * ((int32_t) _bme280Calibration.t2)) >> 11;
+    int32_t var2 = (((((adc >> 4) - t1) * ((adc >> 4) - t1)) >> 12) * ((int32_t) _bme280Calibration.t3)) >> 14;
+    return(var1 + var2);
+}
+
+//
+//  Compensate the raw pressure, the result is in Pa as a Q24.8 value.
+//
+uint32_t WeatherSensors::CompensateBME280Pressure(int32_t adc, int32_t tFine)
+{
+    int64_t var1, var2, p;
+
+    var1 = ((int64_t) tFine) - 128000;
+    var2 = var1 * var1 * (int64_t) _bme280Calibration.p6;
+    var2 = var2 + ((var1 * (int64_t) _bme280Calibration.p5) << 17);
+    var2 = var2 + (((int64_t) _bme280Calibration.p4) << 35);
+    var1 = ((var1 * var1 * (int64_t) _bme280Calibration.p3) >> 8) + ((var1 * (int64_t) _bme280Calibration.p2) << 12);
+    var1 = (((((int64_t) 1) << 47) + var1)) * ((int64_t) _bme280Calibration.p1) >> 33;
+    if (var1 == 0)
+    {
+        return(0);
+    }
+    p = 1048576 - adc;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t) _bme280Calibration.p9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t) _bme280Calibration.p8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t) _bme280Calibration.p7) << 4);
+    return((uint32_t) p);
+}
+
+//
+//  Compensate the raw humidity, the result is in % as a Q22.10 value.
+//
+uint32_t WeatherSensors::CompensateBME280Humidity(int32_t adc, int32_t tFine)
+{
+    int32_t v = tFine - ((int32_t) 76800);
+
+    v = (((((adc << 14) - (((int32_t) _bme280Calibration.h4) << 20) - (((int32_t) _bme280Calibration.h5) * v)) + ((int32_t) 16384)) >> 15) *
+         (((((((v * ((int32_t) _bme280Calibration.h6)) >> 10) * (((v * ((int32_t) _bme280Calibration.h3)) >> 11) + ((int32_t) 32768))) >> 10) + ((int32_t) 2097152)) *
+           ((int32_t) _bme280Calibration.h2) + 8192) >> 14));
+    v = (v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t) _bme280Calibration.h1)) >> 4));
+    v = (v < 0) ? 0 : v;
+    v = (v > 419430400) ? 419430400 : v;
+    return((uint32_t) (v >> 12));
+}
+
+//
+//  Read a single register from the BME280.
+//
+uint8_t WeatherSensors::ReadBME280Register(uint8_t reg)
+{
+    Wire.beginTransmission(BME280Address);
+    Wire.write(reg);
+    Wire.endTransmission();
+    Wire.requestFrom(BME280Address, (uint8_t) 1);
+    return(Wire.read() & 0xff);
+}
+
+//
+//  Read a block of consecutive registers from the BME280 in one transaction,
+//  the register pointer auto-increments.
+//
+bool WeatherSensors::ReadBME280Registers(uint8_t reg, uint8_t *buffer, uint8_t length)
+{
+    Wire.beginTransmission(BME280Address);
+    Wire.write(reg);
+    Wire.endTransmission();
+    if (Wire.requestFrom(BME280Address, length) != length)
+    {
+        Debugger::DebugMessage("BME280 short read.");
+        return(false);
+    }
+    for (uint8_t index = 0; index < length; index++)
+    {
+        buffer[index] = Wire.read() & 0xff;
+    }
+    return(true);
+}
+
+//
+//  Write a value to a single BME280 register.
+//
+void WeatherSensors::WriteBME280Register(uint8_t reg, uint8_t value)
+{
+    Wire.beginTransmission(BME280Address);
+    Wire.write(reg);
+    Wire.write(value);
+    Wire.endTransmission();
+}
+
+//
+//  Read the data from the Temperature, pressure and humidity sensor.
+//
+//  The pressure, temperature and humidity registers (0xf7 - 0xfe) are read
+//  in a single burst so that all three values come from the same
+//  measurement.  A value which has been skipped (oversampling off) keeps its
+//  previous reading.
+//
+void WeatherSensors::ReadTemperatureHumidityPressureSensor()
+{
+    uint8_t data[8];
+
+    if (!_bme280Present || !ReadBME280Registers(BME280RegisterData, data, BME280DataLength))
+    {
+        return;
+    }
+    int32_t adcPressure = (((uint32_t) data[0]) << 12) | (((uint32_t) data[1]) << 4) | (data[2] >> 4);
+    int32_t adcTemperature = (((uint32_t) data[3]) << 12) | (((uint32_t) data[4]) << 4) | (data[5] >> 4);
+    int32_t adcHumidity = (((uint32_t) data[6]) << 8) | data[7];
+    if (adcTemperature == 0x80000)
+    {
+        return;
+    }
+    int32_t tFine = CompensateBME280Temperature(adcTemperature);
+    _temperature = ((tFine * 5 + 128) >> 8) / 100.0;
+    if (adcPressure != 0x80000)
+    {
+        _pressure = CompensateBME280Pressure(adcPressure, tFine) / 256.0;
+    }
+    if (adcHumidity != 0x8000)
+    {
+        _humidity = CompensateBME280Humidity(adcHumidity, tFine) / 1024.0;
+    }
+}
+
+//
+//  Get the last air temperature reading.
+//
+float WeatherSensors::GetAirTemperature()
+{
+    return(_temperature);
+}
+
+//
+//  Get the last humidity reading.
+//
+float WeatherSensors::GetHumidity()
+{
+    return(_humidity);
+}
+
+//
+//  Get thje last air pressure reading.
+//
+float WeatherSensors::GetAirPressure()
+{
+    return(_pressure);
+}
+
+//******************************************************************************
+//
+//  Pluvometer (Rainfall) sensor.
+
+//
+//  Set up the pluiometer, zero the counts and then attached and initialise the
+//  counter to the output expander.
+//
+void WeatherSensors::SetupRainfallSensor()
+{
+}
+
+//
+//  Read the counter from the Rainfall sensor then reset the count.
+//
+//  It is theoretically possible for the counter to change while it is being read.
+//  This can give an incorrect reading so the counter is read twice in succession, if
+//  the two readings are the same then we can assume that the reading is correct.
+//
+void WeatherSensors::ReadRainfallSensor()
+{
+}
+
+//
+//  Reset the pluviometer pulse counter.
+//
+void WeatherSensors::ResetPluviometerPulseCounter()
+{
+    _pluviometerPulseCount = 0;
+    _pluviometerPulseCountToday = 0;
+}
+
+//
+//  Convert the number of pulses into mm of rain.
+//
+float WeatherSensors::CalculateRainfall(int pulseCount)
+{
+    return(pulseCount * RAINFALL_TIPPER_MM_PER_PULSE);
+}
+
+//
+//  Get the rainfal in mm between the last sensor reading and this one.
+//
+float WeatherSensors::GetRainfall()
+{
+    return(CalculateRainfall(_pluviometerPulseCount));
+}
+
+//
+//  Get the total rainfall in mm today.
+//
+float WeatherSensors::GetTotalRainfallToday()
+{
+    return(CalculateRainfall(_pluviometerPulseCountToday));
+}
+
+//******************************************************************************
+//
+//  Windspeed sensor.
+//
+
+//
+//  Set up the anemometer.
+//
+void WeatherSensors::SeupWindSpeedSensor()
+{
+    pinMode(PIN_ANEMOMETER, INPUT);
+    _windSpeedPulseCount = 0;
+    WindSpeedISR = NULL;
+}
+
+//
+//  Read the wind speed.
+//
+float WeatherSensors::ReadWindSpeedSensor()
+{
+    _windSpeedPulseCount = 0;
+    if (WindSpeedISR != NULL)
+    {
+        attachInterrupt(PIN_ANEMOMETER, WindSpeedISR, RISING);
+        delay(WINDSPEED_DURATION * 1000);
+        detachInterrupt(PIN_ANEMOMETER);
+    }
+}
+
+//
+//  Get the last wind speed reading.
+//
+float WeatherSensors::GetWindSpeed()
+{
+    return(_windSpeedPulseCount * WINDSPEED_PER_PULSE);
+}
+
+//
+//  Convert an anemometer pulse period (uS) into a wind speed, one pulse per
+//  second is WINDSPEED_PER_PULSE.  No period means the wind is calm.
+//
+float WeatherSensors::SpeedFromPeriod(uint32_t period)
+{
+    if (period == 0)
+    {
+        return(0);
+    }
+    return((WINDSPEED_PER_PULSE * 1000000.0) / period);
+}
+
+//
+//  Wind speed from the mean pulse period in the last STM8S reading, this has
+//  a much better resolution at low speeds than the pulse count.
+//
+float WeatherSensors::GetMeanWindSpeedFromPeriod()
+{
+    return(SpeedFromPeriod(_windPeriodMean));
+}
+
+//
+//  Gust (shortest pulse period) in the last STM8S reading.
+//
+float WeatherSensors::GetGustFromPeriod()
+{
+    return(SpeedFromPeriod(_windPeriodMinimum));
+}
+
+//
+//  Set the Wind speed ISR
+//
+void WeatherSensors::SetWindSpeedISR(void (*isr)())
+{
+    WindSpeedISR = isr;
+}
+
+//
+//  Called by the Wind speed ISR.
+//
+void WeatherSensors::HandleWindSpeedInterrupt()
+{
+    _windSpeedPulseCount++;
+}
+
+//******************************************************************************
+//
+//  Wind direction sensor.
+//
+
+//
+//  Read the wind direction sensor and calculate the direction the vane is pointing.
+//
+WeatherSensors::WindDirection WeatherSensors::ReadWindDirection()
+{
+    int windDirection = analogRead(A0);
+
+    Debugger::DebugMessage("Wind direction ADC reading: ", windDirection, 10, "");
+    Debugger::DebugMessage("Wind direction (volts): ", windDirection * _voltsPerDivision, 4u, "V");
+    _windDirectionLookupEntry = DecodeWindDirection(windDirection);
+    Debugger::DebugMessage("Wind is blowing from " + String(_windDirectionLookupTable[_windDirectionLookupEntry].directionAsText));
+    return(_windDirectionLookupTable[_windDirectionLookupEntry].direction);
+}
+
+//
+//  Convert an ADC reading from the wind vane into the lookup table entry.
+//
+uint8_t WeatherSensors::DecodeWindDirection(uint16_t reading)
+{
+    return(pgm_read_byte(&WindDirectionADCLookup[reading & 0x3ff]));
+}
+
+//
+//  Get the last wind direction reading as a textural description.
+//
+char *WeatherSensors::GetWindDirectionAsString()
+{
+    return(_windDirectionLookupTable[_windDirectionLookupEntry].directionAsText);
+}
+
+//
+//  Take a single sample of the wind vane for the wind direction statistics.
+//
+//  This should be called several times a second, it is cheap enough to call
+//  from loop() as the ADC reading is decoded with a single table lookup.
+//
+void WeatherSensors::SampleWindDirection()
+{
+    _windDirectionLookupEntry = DecodeWindDirection(analogRead(A0));
+    _windDirectionStatistics.AddSample(_windDirectionLookupTable[_windDirectionLookupEntry].direction, millis());
+}
+
+//
+//  Get the vector mean wind direction (degrees) and the standard deviation
+//  of the wind direction (degrees) over the requested window.
+//
+bool WeatherSensors::GetMeanWindDirection(WindDirectionStatistics::Window window, float &mean, float &standardDeviation)
+{
+    _windDirectionStatistics.Update(millis());
+    return(_windDirectionStatistics.GetMeanDirection(window, mean, standardDeviation));
+}
+
+//
+//  Get the compass point nearest to the mean wind direction.  The last
+//  instantaneous reading is used if there are no samples in the window.
+//
+WeatherSensors::WindDirection WeatherSensors::GetMeanWindDirectionPoint(WindDirectionStatistics::Window window)
+{
+    float mean, standardDeviation;
+
+    if (!GetMeanWindDirection(window, mean, standardDeviation))
+    {
+        return(_windDirectionLookupTable[_windDirectionLookupEntry].direction);
+    }
+    return((WindDirection) (((int) ((mean + 11.25) / 22.5)) % 16));
+}
+
+//
+//  Get the compass point nearest to the mean wind direction as a textural
+//  description.  The last instantaneous reading is used if there are no
+//  samples in the window.
+//
+char *WeatherSensors::GetMeanWindDirectionAsString(WindDirectionStatistics::Window window)
+{
+    WindDirection direction = GetMeanWindDirectionPoint(window);
+    for (int index = 0; index < 16; index++)
+    {
+        if (_windDirectionLookupTable[index].direction == direction)
+        {
+            return(_windDirectionLookupTable[index].directionAsText);
+        }
+    }
+    return(GetWindDirectionAsString());
 }
\ No newline at end of file
@@ -1,194 +1,383 @@
-//
-//  Header for the class supporting the weather station sensors.
-//
-//  MIT License
-//  
-//  Copyright(c) 2016 Mark Stevens
-//  
-//  Permission is hereby granted, free of charge, to any person obtaining a copy
-//  of this software and associated documentation files(the "Software"), to deal
-//  in the Software without restriction, including without limitation the rights
-//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
-//  copies of the Software, and to permit persons to whom the Software is
-//  furnished to do so, subject to the following conditions :
-//  
-//  The above copyright notice and this permission notice shall be included in all
-//  copies or substantial portions of the Software.
-//  
-//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
-//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-//  SOFTWARE.
-//  
-#ifndef __WEATHERSENSORS_H__
-#define __WEATHERSENSORS_H__
-
-#include <OneWire.h>
-#include <Adafruit_BME280.h>
-#include <SparkFunTSL2561.h>
-#include "Debug.h"
-
-class WeatherSensors
-{
-    //
-    //  Interrupt Service Routine function pointer type.
-    //
-    typedef void (*ISRPointer)();
-
-    public:
-        WeatherSensors();
-        ~WeatherSensors();
-        void InitialiseSensors();
-        void ReadAllSensors();
-        //
-        //  Ground temperature sensor.
-        //
-        float ReadGroundTemperatureSensor();
-        float GetGroundTemperatureReading();
-        //
-        //  Ultraviolet light sensor.
-        //
-        float ReadUltravioletLightSensor();
-        float GetUltravioletLightReading();
-        float GetUltravioletLightStrength();
-        //
-        //  Luminosity sensor.
-        //
-        double ReadLuminositySensor();
-        double GetLuminosityReading();
-        //
-        //  Air temperature, pressure and humidity.
-        //
-        void ReadTemperatureHumidityPressureSensor();
-        float GetAirTemperature();
-        float GetHumidity();
-        float GetAirPressure();
-        //
-        //  Rain fall sensor.
-        //
-        void SetupRainfallSensor();
-        void ReadRainfallSensor();
-        float GetRainfall();
-        float GetTotalRainfallToday();
-        //
-        //  Wind speed sensor.
-        //
-        void SeupWindSpeedSensor();
-        float ReadWindSpeedSensor();
-        float GetWindSpeed();
-        void SetWindSpeedISR(ISRPointer);
-        void HandleWindSpeedInterrupt();
-        //
-        //  Wind direciton sensor.
-        //
-        enum WindDirection
-        {
-            North, NorthNorthEast, NorthEast, EastNorthEast, East, EastSouthEast, SouthEast, SouthSouthEast,
-            South, SouthSouthWest, SouthWest, WestSouthWest, West, WestNorthWest, NorthWest, NorthNorthWest
-        };
-        WindDirection ReadWindDirection();
-        char *GetWindDirectionAsString();
-
-    private:
-        //
-        //  Entry in the wind direction lookup table.
-        //
-        struct WindDirectionLookup
-        {
-            uint16_t midPoint;
-            uint16_t reading;
-            float angle;
-            WindDirection direction;
-            char *directionAsText;
-        };
-        //
-        //  Private members not related to the sensors or their readings directly.
-        //
-        //
-        //  Ground temperature variables.
-        //
-        OneWire *_groundSensor;
-        double _groundTemperature = 0;
-        byte _groundTemperatureSensorType = 0;
-        byte _groundTemperatureSensorAddress[8];
-        void SetupGroundTemperatureSensor();
-        //
-        //  Ultraviolet analog reading.
-        //
-        int _ultraviolet;
-        const float _uvGradient = 0.12;             // Gradient of the UV curve from the data sheet.
-        const int _maximumAnalogValue = 1023;
-        const float _referenceVoltage = 3.3;
-        const float _uvOffset = 1.025;              // Base reading from the sensor (observation).
-        const uint8_t _ultravioletLightChannel = 0; // ADC channel connected to the UV sensor.
-        const float _voltsPerDivision = (_referenceVoltage / _maximumAnalogValue);
-        //
-        //  STM8S I2C Address and commands.
-        //
-        const uint8_t STM8SAddress = 0x48;
-        const uint8_t I2CReset = 0x00;
-        const uint8_t I2CReadSensors = 0x01;
-        const uint8_t I2CGetSensorData = 0x02;
-        const uint8_t I2CDataReady = 0x03;
-        const uint8_t I2CResetRainFallCounter = 0x04;
-        const uint8_t I2CBufferSize = 8;
-        //
-        //  Light sensor (luminosity).
-        //
-        SFE_TSL2561 _light;
-        boolean _gain;          //  Gain setting, 0 = X1, 1 = X16;
-        unsigned int _ms;       //  Integration ("shutter") time in milliseconds
-        double _lux;            //  Luminosity in lux.
-        boolean _good;          //  True if neither sensor is saturated
-        void SetupLuminositySensor();
-        String LuminositySensorErrorMessage(byte);
-        //
-        //  Create a Temperature, humidity and pressure sensor.
-        //
-        Adafruit_BME280 _bme;
-        float _temperature = 0;
-        float _pressure = 0;
-        float _humidity = 0;
-        void SetupTemperatureHumidityPressureSensor();
-        //
-        //  Rain fall sensor.
-        //
-        int _pluviometerPulseCount = 0;
-        int _pluviometerPulseCountToday = 0;
-        const int PIN_RAINFALL_RESET = 0;
-        const float RAINFALL_TIPPER_MM_PER_PULSE = 0.2794;
-        void ResetPluviometerPulseCounter();
-        float CalculateRainfall(int);
-        //
-        //  Wind Speed sensor, each pulse per second represents 1.492 miles per hour.
-        //
-        volatile int _windSpeedPulseCount;
-        ISRPointer WindSpeedISR;
-        const int WINDSPEED_DURATION = 5;
-        const float WINDSPEED_PER_PULSE = 1.492;
-        const int PIN_ANEMOMETER = 5;
-        //
-        //  Wind direction sensor.
-        //
-        const uint8_t _windDriectionAnalogChannel = 1;
-        WindDirectionLookup _windDirectionLookupTable[16];
-        uint8_t _windDirectionLookupEntry;
-        const int I2CRainfallCounterMSB = 0;
-        const int I2CRainfallCounterLSB = 1;
-        const int I2CWindSpeedMSB = 2;
-        const int I2CWindSpeedLSB =  3;
-        const int I2CWindDirectionMSB = 4;
-        const int I2CWindDirectionLSB = 5;
-        const int I2CUVReadingMSB = 6;
-        const int I2CUVReadingLSB = 7;
-
-        //
-        //  Sensors attached to the STM8S
-        //
-        void ReadSTM8SSensors();
-};
-
-#endif
+//
+//  Header for the class supporting the weather station sensors.
+//
+//  MIT License
+//  
+//  Copyright(c) 2016 Mark Stevens
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+#ifndef __WEATHERSENSORS_H__
+#define __WEATHERSENSORS_H__
+
+#include <OneWire.h>
+#include <Wire.h>
+#include <SparkFunTSL2561.h>
+#include "Debug.h"
+#include "WindDirectionStatistics.h"
+#include "SensorScheduler.h"
+
+class WeatherSensors
+{
+    //
+    //  Interrupt Service Routine function pointer type.
+    //
+    typedef void (*ISRPointer)();
+
+    public:
+        //
+        //  Sensors which take part in an acquisition cycle.
+        //
+        enum Sensor
+        {
+            GroundTemperatureSensor, LuminositySensor, TemperatureHumidityPressureSensor, WindDirectionSensor,
+            NumberOfSensors
+        };
+        static const uint8_t AllSensors = (1 << NumberOfSensors) - 1;
+
+        WeatherSensors();
+        ~WeatherSensors();
+        void InitialiseSensors();
+        void ReadAllSensors();
+        //
+        //  Non-blocking sensor acquisition.
+        //
+        void StartAcquisition(uint8_t sensors = AllSensors);
+        bool ServiceAcquisition();
+        bool AcquisitionInProgress();
+        unsigned long GetAcquisitionTime(Sensor);
+        //
+        //  Scheduled acquisition, each sensor is read at its own rate.
+        //
+        void ScheduleSensor(Sensor, unsigned long, unsigned long phase = SensorScheduler::AutomaticPhase);
+        void StartSchedule();
+        void ServiceSchedule();
+        SensorScheduler *GetScheduler();
+        //
+        //  Ground temperature sensors, one or more DS18x20 probes on the
+        //  OneWire bus.  Probe 0 is the first probe found on the bus.
+        //
+        static const uint8_t MaximumGroundTemperatureProbes = 8;
+        float ReadGroundTemperatureSensor();
+        static float DecodeGroundTemperature(const byte *, byte);
+        float GetGroundTemperatureReading();
+        float GetGroundTemperatureReading(uint8_t);
+        uint8_t GetNumberOfGroundTemperatureProbes();
+        const byte *GetGroundTemperatureProbeAddress(uint8_t);
+        uint8_t GetGroundTemperatureProbeResolution(uint8_t);
+        uint16_t GetGroundTemperatureProbeCRCFailures(uint8_t);
+        bool SetGroundTemperatureResolution(uint8_t);
+        bool SetGroundTemperatureResolution(uint8_t, uint8_t);
+        unsigned long GetGroundTemperatureConversionTime();
+        bool IsGroundTemperatureParasitePowered();
+        //
+        //  Ultraviolet light sensor.
+        //
+        float ReadUltravioletLightSensor();
+        float GetUltravioletLightReading();
+        float GetUltravioletLightStrength();
+        //
+        //  Luminosity sensor.
+        //
+        double ReadLuminositySensor();
+        double GetLuminosityReading();
+        bool IsLuminosityReadingSaturated();
+        bool GetLuminosityGain();
+        unsigned int GetLuminosityIntegrationTime();
+        //
+        //  Air temperature, pressure and humidity.
+        //
+        enum BME280Oversampling
+        {
+            OversamplingSkipped, Oversampling1, Oversampling2, Oversampling4, Oversampling8, Oversampling16
+        };
+        void SetTemperatureHumidityPressureOversampling(BME280Oversampling, BME280Oversampling, BME280Oversampling);
+        void ReadTemperatureHumidityPressureSensor();
+        float GetAirTemperature();
+        float GetHumidity();
+        float GetAirPressure();
+        //
+        //  Rain fall sensor.
+        //
+        void SetupRainfallSensor();
+        void ReadRainfallSensor();
+        float GetRainfall();
+        float GetTotalRainfallToday();
+        //
+        //  Wind speed sensor.
+        //
+        void SeupWindSpeedSensor();
+        float ReadWindSpeedSensor();
+        float GetWindSpeed();
+        float GetMeanWindSpeedFromPeriod();
+        float GetGustFromPeriod();
+        void SetWindSpeedISR(ISRPointer);
+        void HandleWindSpeedInterrupt();
+        //
+        //  Wind direciton sensor.
+        //
+        enum WindDirection
+        {
+            North, NorthNorthEast, NorthEast, EastNorthEast, East, EastSouthEast, SouthEast, SouthSouthEast,
+            South, SouthSouthWest, SouthWest, WestSouthWest, West, WestNorthWest, NorthWest, NorthNorthWest
+        };
+        WindDirection ReadWindDirection();
+        static uint8_t DecodeWindDirection(uint16_t);
+        char *GetWindDirectionAsString();
+        void SampleWindDirection();
+        bool GetMeanWindDirection(WindDirectionStatistics::Window, float &, float &);
+        WindDirection GetMeanWindDirectionPoint(WindDirectionStatistics::Window);
+        char *GetMeanWindDirectionAsString(WindDirectionStatistics::Window);
+        //
+        //  History of readings taken by the STM8S, one record for each RTC
+        //  alarm.  The STM8S holds the last 23 records.
+        //
+        struct STM8SRecord
+        {
+            uint16_t sequence;
+            uint16_t alarm;             // RTC alarm count when the reading started.
+            uint32_t rainfall;          // Rain gauge pulse count.
+            uint16_t windSpeed;         // Wind speed pulses during the reading.
+            uint16_t windDirection;     // ADC reading.
+            uint16_t ultraviolet;       // ADC reading.
+            uint32_t windPeriodMean;    // Anemometer pulse periods (uS),
+            uint32_t windPeriodMinimum; // 32 uS resolution, 0 = not measured.
+        };
+        static const uint8_t STM8SHistoryHeaderSize = 9;
+        static const uint8_t STM8SHistoryRecordSize = 11;
+        static const uint8_t STM8SRecordsPerRead = (BUFFER_LENGTH - STM8SHistoryHeaderSize - 1) / STM8SHistoryRecordSize;
+        bool ReadSTM8SSensors();
+        uint16_t GetSTM8SSequence();
+        uint8_t ReadSTM8SHistory(uint16_t, STM8SRecord *, uint8_t);
+        static uint16_t NextSTM8SSequence(uint16_t);
+        bool SetSTM8SDebounce(uint8_t, uint8_t);
+        bool ResetSTM8SRainfallCounter();
+
+    private:
+        //
+        //  DS18x20 probe on the ground temperature OneWire bus.
+        //
+        struct GroundTemperatureProbe
+        {
+            byte address[8];
+            byte type;                  // 1 = DS18S20, 0 = DS18B20 / DS1822.
+            uint8_t resolution;         // Bits.
+            uint16_t crcFailures;
+            float temperature;
+        };
+        //
+        //  BME280 compensation parameters (see the Bosch data sheet).
+        //
+        struct BME280Calibration
+        {
+            uint16_t t1;
+            int16_t t2, t3;
+            uint16_t p1;
+            int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+            uint8_t h1, h3;
+            int16_t h2, h4, h5;
+            int8_t h6;
+        };
+        //
+        //  TSL2561 gain / integration time combination used by the auto-ranging.
+        //  The sensitivity is relative to 1x gain with a 13.7ms integration.
+        //
+        struct LuminosityRange
+        {
+            boolean gain;
+            unsigned char time;
+            unsigned int maximumCount;
+            uint32_t sensitivity;
+        };
+        //
+        //  Entry in the wind direction lookup table.
+        //
+        struct WindDirectionLookup
+        {
+            uint16_t reading;
+            float angle;
+            WindDirection direction;
+            char *directionAsText;
+        };
+        //
+        //  Private members not related to the sensors or their readings directly.
+        //
+        //
+        //  Acquisition state, a bit is set in _acquisitionPending for each sensor
+        //  which has started a conversion and not yet delivered its data.
+        //
+        uint8_t _acquisitionPending = 0;
+        unsigned long _acquisitionStartTime[NumberOfSensors];
+        unsigned long _acquisitionTime[NumberOfSensors];
+        bool IsSensorReady(Sensor, unsigned long);
+        //
+        //  Processor time (microseconds) spent on each sensor in the current
+        //  acquisition cycle, reported to the scheduler when the data has
+        //  been collected.
+        //
+        SensorScheduler _scheduler;
+        unsigned long _acquisitionCost[NumberOfSensors];
+        unsigned long EstimateAcquisitionCost(Sensor);
+        //
+        //  Ground temperature variables.
+        //
+        OneWire *_groundSensor;
+        GroundTemperatureProbe _groundTemperatureProbes[MaximumGroundTemperatureProbes];
+        uint8_t _numberOfGroundTemperatureProbes = 0;
+        const uint8_t _groundTemperaturePin = 7;
+        unsigned long _groundTemperatureConversionTime = 750;
+        bool _groundTemperatureParasitePower = true;
+        void SetupGroundTemperatureSensor();
+        void StartGroundTemperatureConversion();
+        bool IsGroundTemperatureConversionComplete(unsigned long);
+        float CollectGroundTemperatureReading();
+        bool ReadGroundTemperatureScratchpad(uint8_t, byte *);
+        void UpdateGroundTemperatureConversionTime();
+        //
+        //  Ultraviolet analog reading.
+        //
+        int _ultraviolet;
+        const float _uvGradient = 0.12;             // Gradient of the UV curve from the data sheet.
+        const int _maximumAnalogValue = 1023;
+        const float _referenceVoltage = 3.3;
+        const float _uvOffset = 1.025;              // Base reading from the sensor (observation).
+        const uint8_t _ultravioletLightChannel = 0; // ADC channel connected to the UV sensor.
+        const float _voltsPerDivision = (_referenceVoltage / _maximumAnalogValue);
+        //
+        //  STM8S I2C Address and commands.
+        //
+        const uint8_t STM8SAddress = 0x48;
+        const uint8_t I2CReset = 0x00;
+        const uint8_t I2CReadSensors = 0x01;
+        const uint8_t I2CGetSensorData = 0x02;
+        const uint8_t I2CDataReady = 0x03;
+        const uint8_t I2CResetRainFallCounter = 0x04;
+        const uint8_t I2CGetHistory = 0x05;
+        const uint8_t I2CSetDebounce = 0x06;
+        //
+        //  STM8S register map (version 4).
+        //
+        const uint8_t I2CRegisterVersion = 0x10;
+        const uint8_t I2CRegisterSample = 0x15;
+        const uint8_t I2CRegisterDebounce = 0x30;
+        const uint8_t I2CProtocolVersion = 4;
+        const uint8_t I2CRequiredCapabilities = 0x3f;  // Rainfall, wind speed, wind direction, UV, wind periods.
+        const uint8_t I2CVersionLength = 3;             // Version, capabilities and sample length.
+        static const uint8_t I2CSampleLength = 23;
+        //
+        //  Light sensor (luminosity).
+        //
+        SFE_TSL2561 _light;
+        boolean _gain;          //  Gain setting, 0 = X1, 1 = X16;
+        unsigned int _ms;       //  Integration ("shutter") time in milliseconds
+        double _lux;            //  Luminosity in lux.
+        boolean _good;          //  True if neither sensor is saturated
+        static const uint8_t NumberOfLuminosityRanges = 4;
+        static const LuminosityRange _luminosityRanges[NumberOfLuminosityRanges];
+        const unsigned int _minimumLuminosityCount = 256;
+        uint8_t _luminosityRange = NumberOfLuminosityRanges - 1;
+        uint8_t _luminosityRetries = 0;
+        bool _luminosityRetryRequired = false;
+        unsigned long _luminosityIntegrationStart = 0;
+        void SetupLuminositySensor();
+        void StartLuminosityIntegration();
+        void SetLuminosityRange(uint8_t);
+        uint8_t SelectLuminosityRange(unsigned int, unsigned int, bool);
+        String LuminositySensorErrorMessage(byte);
+        //
+        //  Create a Temperature, humidity and pressure sensor.
+        //
+        bool _bme280Present = false;
+        BME280Calibration _bme280Calibration;
+        uint8_t _bme280ControlMeasurement = 0;
+        uint8_t _bme280ControlHumidity = 0;
+        float _temperature = 0;
+        float _pressure = 0;
+        float _humidity = 0;
+        const uint8_t BME280Address = 0x77;
+        const uint8_t BME280ChipID = 0x60;
+        const uint8_t BME280RegisterCalibration00 = 0x88;
+        const uint8_t BME280RegisterChipID = 0xd0;
+        const uint8_t BME280RegisterCalibration26 = 0xe1;
+        const uint8_t BME280RegisterControlHumidity = 0xf2;
+        const uint8_t BME280RegisterStatus = 0xf3;
+        const uint8_t BME280RegisterControlMeasurement = 0xf4;
+        const uint8_t BME280RegisterConfig = 0xf5;
+        const uint8_t BME280RegisterData = 0xf7;
+        const uint8_t BME280DataLength = 8;
+        const uint8_t BME280StatusBusy = 0x09;         // measuring | im_update
+        const uint8_t BME280ForcedMode = 0x01;
+        void SetupTemperatureHumidityPressureSensor();
+        void StartTemperatureHumidityPressureMeasurement();
+        bool IsTemperatureHumidityPressureMeasurementComplete();
+        void ReadBME280Calibration();
+        int32_t CompensateBME280Temperature(int32_t);
+        uint32_t CompensateBME280Pressure(int32_t, int32_t);
+        uint32_t CompensateBME280Humidity(int32_t, int32_t);
+        uint8_t ReadBME280Register(uint8_t);
+        bool ReadBME280Registers(uint8_t, uint8_t *, uint8_t);
+        void WriteBME280Register(uint8_t, uint8_t);
+        //
+        //  Rain fall sensor.
+        //
+        int _pluviometerPulseCount = 0;
+        int _pluviometerPulseCountToday = 0;
+        const int PIN_RAINFALL_RESET = 0;
+        const float RAINFALL_TIPPER_MM_PER_PULSE = 0.2794;
+        void ResetPluviometerPulseCounter();
+        float CalculateRainfall(int);
+        //
+        //  Wind Speed sensor, each pulse per second represents 1.492 miles per hour.
+        //
+        volatile int _windSpeedPulseCount;
+        uint32_t _windPeriodMean = 0;       // From the STM8S (uS).
+        uint32_t _windPeriodMinimum = 0;
+        float SpeedFromPeriod(uint32_t);
+        ISRPointer WindSpeedISR;
+        const int WINDSPEED_DURATION = 5;
+        const float WINDSPEED_PER_PULSE = 1.492;
+        const int PIN_ANEMOMETER = 5;
+        //
+        //  Wind direction sensor.
+        //
+        const uint8_t _windDriectionAnalogChannel = 1;
+        static const WindDirectionLookup _windDirectionLookupTable[16];
+        uint8_t _windDirectionLookupEntry;
+        WindDirectionStatistics _windDirectionStatistics;
+        const int I2CSequence = 0;
+        const int I2CRainfallCounter = 2;
+        const int I2CWindSpeed = 6;
+        const int I2CWindDirection = 10;
+        const int I2CUVReading = 12;
+        const int I2CWindPeriodMean = 14;
+        const int I2CWindPeriodMinimum = 18;
+        const int I2CSampleCRC = 22;
+
+        //
+        //  Sensors attached to the STM8S
+        //
+        bool _stm8sProtocolChecked = false;
+        uint16_t _stm8sSequence = 0;
+        bool CheckSTM8SProtocol();
+        static uint8_t Crc8(const uint8_t *, uint8_t);
+        static uint16_t GetShort(const uint8_t *);
+        static uint32_t GetLong(const uint8_t *);
+};
+
+#endif
@@ -1,385 +1,1119 @@
-//
-//  Weather Station
-//
-//  Main application for the Weather Station project based around the Digistup 
-//  Oak board.
-//
-//  MIT License
-//  
-//  Copyright(c) 2016 Mark Stevens
-//  
-//  Permission is hereby granted, free of charge, to any person obtaining a copy
-//  of this software and associated documentation files(the "Software"), to deal
-//  in the Software without restriction, including without limitation the rights
-//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
-//  copies of the Software, and to permit persons to whom the Software is
-//  furnished to do so, subject to the following conditions :
-//  
-//  The above copyright notice and this permission notice shall be included in all
-//  copies or substantial portions of the Software.
-//  
-//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
-//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-//  SOFTWARE.
-//
-#include <Arduino.h>
-#include <ESP8266WiFi.h>
-#include <ESP8266HTTPClient.h>
-#include <Time.h>
-//#include <NTPtimeeSP.h>
-#include <NtpClientLib.h>
-#include <Adafruit_Sensor.h>
-#include <Adafruit_BME280.h>
-#include <SparkFunTSL2561.h>
-#include <Wire.h>
-#include <OneWire.h>
-#include <Ticker.h>
-//
-#include "WeatherSensors.h"
-#include "DS3231.h"
-#include "Debug.h"
-#include "Secrets.h"
-
-//
-//  Definitions used in the code for pins etc.
-//
-#define VERSION                 "0.20"
-//
-#define PIN_ONBOARD_LED         1
-#define PIN_WIND_SPEED          9
-#define PIN_PLUVIOMETER         8
-#define PIN_GROUND_TEMPERATURE  7
-#define PIN_RTC_INTERRUPT       5
-#define PIN_WIND_DIRECTION      A0
-
-//
-//  Weather Sensor definitions.
-//
-WeatherSensors *_sensors;
-
-//
-//  Local variables to deal with the analogue and digital sensors
-//  connected to the Oak.
-//
-volatile unsigned int _pluviometerCountToday = 0;
-volatile unsigned int _windSpeedCount = 0;
-volatile unsigned short _windDirectionReading = 0;
-volatile unsigned int _lastFiveSecondWindSpeedCount = 0;
-Ticker _fiveSecondTicker;
-Ticker _oneMinuteTicker;
-
-//
-//  Indicate if we should read the sesnosrs.
-//
-volatile bool _readSensors = false;
-unsigned int _readingNumber = 0;
-
-//
-//  DS3234 real time clock object.
-//
-//DS3231 *rtc;
-#define MAX_NTP_RETRIES 10
-
-//
-//  We are logging to Phant and we need somewhere to store the client and keys.
-//
-#define PHANT_DOMAIN        "data.sparkfun.com"
-#define PHANT_PAGE          "/input/zDA9M8dQlahOqo4bx5Dd"
-#define PHANT_PORT          80
-WiFiClient _wifiClient;
-
-//
-//  Used for debugging, determine the output state of the onboard LED.
-//
-bool _ledOutput = false;
-
-//
-//  Post the data to the Sparkfun web site.
-//
-void PostDataToPhant()
-{
-    char number[20];
-    
-    String url = PHANT_PAGE "?private_key=" PHANT_PRIVATE_KEY;
-    url += "&airpressure=";
-    url += Debugger::FloatToAscii(number, _sensors->GetAirPressure() / 100, 0);
-    url += "&groundtemperature=";
-    url += Debugger::FloatToAscii(number, _sensors->GetGroundTemperatureReading(), 2);
-    url += "&airtemperature=";
-    url += Debugger::FloatToAscii(number, _sensors->GetAirTemperature(), 2);
-    url += "&humidity=";
-    url += Debugger::FloatToAscii(number, _sensors->GetHumidity(), 2);
-    url += "&luminosity=";
-    url += Debugger::FloatToAscii(number, _sensors->GetLuminosityReading(), 2);
-    url += "&rainfall=";
-    url += Debugger::FloatToAscii(number, _pluviometerCountToday, 2);
-    url += "&winddirection=";
-    url += _sensors->GetWindDirectionAsString();
-    url += "&windspeed=";
-    url += Debugger::FloatToAscii(number, (_lastFiveSecondWindSpeedCount * 1.492) / 5, 2);
-    //
-    //  Send the data to Phant (Sparkfun's data logging service).
-    //
-    HTTPClient http;
-    http.begin(PHANT_DOMAIN, PHANT_PORT, url);
-    int httpCode = http.GET();
-    String message = "Status code: ";
-    message += itoa(httpCode, number, 10);
-    Debugger::DebugMessage(message);
-    if (httpCode == 200)
-    {
-        String response = http.getString();
-        message = "Phant response code: ";
-        message += response[3];
-        Debugger::DebugMessage(message);
-        if (response[3] != '1')
-        {
-            //
-            //  Need to put some error handling here.
-            //  
-        }
-    }
-    else
-    {
-        Debugger::DebugMessage("Error sending data to Phant.");
-    }
-    http.end();
-}
-
-//
-//  Update the RTC with the time from the Internet.
-//
-void UpdateRTCWithInternetTime(DS3231 *rtc)
-{
-    ntpClient *ntp;
-    ts *dateTime;
-    int retries = 0;
-
-    Debugger::DebugMessage("Getting Internet time and setting RTC.");
-    ntp = ntpClient::getInstance("time.nist.gov", 0);
-    ntp->setInterval(1, 1800);
-    delay(1000);
-    ntp->begin();
-    time_t ntpTime = ntp->getTime();
-    while ((year(ntpTime) == 1970) && (retries < MAX_NTP_RETRIES))
-    {
-        delay(50);
-        ntpTime = ntp->getTime();
-        retries++;
-    }
-    if (retries < MAX_NTP_RETRIES)
-    {
-        //dateTime = new(ts);
-        //dateTime->hour = hour(ntpTime);
-        //dateTime->minutes = minute(ntpTime);
-        //dateTime->seconds = second(ntpTime);
-        //dateTime->day = day(ntpTime);
-        //dateTime->month = month(ntpTime);
-        //dateTime->year = year(ntpTime);
-        //dateTime->wday = weekday(ntpTime);
-        //rtc->SetDateTime(dateTime);
-        //Debugger::DebugMessage("Setting RTC to: " + rtc->DateTimeString(dateTime));
-        //delay(1000);
-        setTime(ntpTime);
-        Serial.printf("Time: %2d:%2d:%2d\n", hour(), minute(), second());
-        while (second() != 0)
-        {
-            delay(1000);
-        }
-    }
-    ntp->stop();
-}
-
-//
-//  Reset the alarm.
-//
-void SetAlarm(DS3231 *rtc, uint8_t period)
-{
-    ts *dateTime = rtc->GetDateTime();
-    Debugger::DebugMessage("Current time retrieved: " + rtc->DateTimeString(dateTime));
-    uint8_t minutes = dateTime->minutes;
-    //
-    //  Note that the alarm we are using is When minutes and seconds match.
-    //  This mean we do not have to worry about the hours, day etc rolling
-    //  over.  A bit dirty I know :)
-    //
-    minutes += period;
-    if (minutes >= 60)
-    {
-        minutes = 0;
-    }
-    dateTime->minutes = minutes;
-    dateTime->seconds = 0;
-    Debugger::DebugMessage("Setting alarm for " + rtc->DateTimeString(dateTime));
-    rtc->ClearInterrupt(DS3231::Alarm1Raised);
-    rtc->SetAlarm(DS3231::Alarm1Raised, dateTime, DS3231::WhenMinutesSecondsMatch);
-    delete(dateTime);
-}
-
-//
-//  Take sensor readings an push the data to the Internet.
-//
-void ReadAndPublishData()
-{
-    float fReading;
-    unsigned uiReading;
-
-    Debugger::DebugMessage("Reading sensor data (", _readingNumber, 10, ")");
-    _sensors->ReadAllSensors();
-    fReading = _sensors->GetLuminosityReading();
-    Debugger::DebugMessage("Luminosity:", fReading, 2u, "lumens");
-    fReading = _sensors->GetAirTemperature();
-    Debugger::DebugMessage("Air temperature:", fReading, 2u, "C");
-    fReading = _sensors->GetHumidity();
-    Debugger::DebugMessage("Humidity:", fReading, 2u, "%");
-    fReading = _sensors->GetAirPressure() / 100;
-    Debugger::DebugMessage("Humidity:", fReading, 2u, "hPa");
-    fReading = _sensors->GetGroundTemperatureReading();
-    Debugger::DebugMessage("Ground temperature:", fReading, 2u, "C");
-    Debugger::DebugMessage("Rainfall today:", _pluviometerCountToday * 0.2794, 2u, "mm");
-    Debugger::DebugMessage("Wind speed pulse count:", _lastFiveSecondWindSpeedCount, 10, "");
-    fReading = (_lastFiveSecondWindSpeedCount * 1.492) / 5;
-    Debugger::DebugMessage("Wind speed:", fReading, 2u, "mph");
-
-    //Debugger::DebugMessage("Luminosity:", (float) _sensors->GetLuminosityReading(), 2u, "lumens");
-    //Debugger::DebugMessage("Air temperature:", _sensors->GetAirTemperature(), 2u, "C");
-    //Debugger::DebugMessage("Humidity:", _sensors->GetHumidity(), 2u, "%");
-    //Debugger::DebugMessage("Humidity:", _sensors->GetAirPressure() / 100, 2u, "hPa");
-    //Debugger::DebugMessage("Ground temperature:", _sensors->GetGroundTemperatureReading(), 2u, "C");
-    //Debugger::DebugMessage("Rainfall today:", _pluviometerCountToday * 0.2794, 2u, "mm");
-    //Debugger::DebugMessage("Wind speed pulse count:", _lastFiveSecondWindSpeedCount, 10, "");
-    //Debugger::DebugMessage("Wind speed:", (_lastFiveSecondWindSpeedCount * 1.492) / 5, 2u, "mph");
-    //
-    //  Now post to the Internet.
-    //
-    Debugger::DebugMessage("Posting to Internet.");
-    PostDataToPhant();
-}
-
-//
-//  Handle the RTC interrupt.
-//
-//  - Update the RTC from the Internet if necessary.
-//  - Reset the alarm
-//  - Indicate that the sensors need reading if necessary (this is an 
-//    ISR and we need to get out of here as soon as possible)
-//
-void RTCAlarmHandler()
-{
-    Debugger::DebugMessage("--------------------------------------------------");
-    Debugger::DebugMessage("");
-    Debugger::DebugMessage("Alarm interrupt raised.");
-    //
-    //  Reset the alarm.
-    //
-    //setAlarm(rtc, 1);
-    //
-    //  Indicate that the sensors should be read.
-    //
-    _readSensors = true;
-    Debugger::DebugMessage("Exiting RTC alarm handler");
-}
-
-//
-//  Handle the wind speed interrupts.
-//
-void WindSpeedInterruptHandler()
-{
-    _windSpeedCount++;
-}
-
-//
-//  Handle the Ticker event every five seconds.
-//
-void FiveSecondTickerInterruptHandler()
-{
-    _lastFiveSecondWindSpeedCount = _windSpeedCount;
-    _windSpeedCount = 0;
-}
-
-//
-//  Handle the Ticker event to indicate that we need to read the sensors.
-//
-void OneMinuteTickerInterruptHandler()
-{
-    _readSensors = true;
-    if ((hour() == 0) && (minute() == 0))
-    {
-        _pluviometerCountToday = 0;
-    }
-}
-
-//
-//  Simply increment the pluviometer counter for today.
-//
-void PluviometerInterruptHandler()
-{
-    _pluviometerCountToday++;
-}
-
-//
-//  Setup the application.
-//
-void setup()
-{
-    Serial.begin(115200);
-    Serial.println();
-    Serial.println();
-    Wire.begin();
-    Wire.setClock(100000);
-    //
-    //rtc = new DS3231();
-    //Debugger::AttachRTC(rtc);
-    Debugger::DebugMessage("-----------------------------");
-    Debugger::DebugMessage("Weather Station Starting (version " VERSION ", built: " __TIME__ " on " __DATE__ ")");
-    //
-    //  Connect to the WiFi.
-    //
-    Debugger::DebugMessage("Connecting to default network");
-    WiFi.begin();
-    while (WiFi.status() != WL_CONNECTED)
-    {
-        delay(1000);
-    }
-    Debugger::DebugMessage("WiFi connected, IP address: " + WiFi.localIP().toString());
-    //
-    //  Get the current date and time from the RTC or a time server.
-    //
-    //UpdateRTCWithInternetTime(rtc);
-    UpdateRTCWithInternetTime(NULL);
-    _oneMinuteTicker.attach(60.0, OneMinuteTickerInterruptHandler);
-    _fiveSecondTicker.attach(5.0, FiveSecondTickerInterruptHandler);
-    //SetAlarm(rtc, 1);
-    _sensors = new WeatherSensors();
-    _sensors->InitialiseSensors();
-    pinMode(PIN_RTC_INTERRUPT, INPUT);
-    attachInterrupt(digitalPinToInterrupt(PIN_RTC_INTERRUPT), RTCAlarmHandler, FALLING);
-    pinMode(PIN_WIND_SPEED, INPUT);
-    attachInterrupt(digitalPinToInterrupt(PIN_WIND_SPEED), WindSpeedInterruptHandler, FALLING);
-    pinMode(PIN_PLUVIOMETER, INPUT);
-    attachInterrupt(digitalPinToInterrupt(PIN_PLUVIOMETER), PluviometerInterruptHandler, FALLING);
-    pinMode(PIN_WIND_DIRECTION, INPUT);
-    pinMode(PIN_ONBOARD_LED, OUTPUT);
-}
-
-//
-//  Main program loop.
-//
-void loop()
-{
-    if (_readSensors)
-    {
-        _readSensors = false;
-        _readingNumber++;
-        digitalWrite(PIN_ONBOARD_LED, HIGH);
-        ReadAndPublishData();
-        digitalWrite(PIN_ONBOARD_LED, LOW);
-    }
-    digitalWrite(PIN_ONBOARD_LED, _ledOutput ? HIGH : LOW);
-    _ledOutput = !_ledOutput;
-    delay(500);
-}
+//
+//  Weather Station
+//
+//  Main application for the Weather Station project based around the Digistup 
+//  Oak board.
+//
+//  MIT License
+//  
+//  Copyright(c) 2016 Mark Stevens
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <Time.h>
+//#include <NTPtimeeSP.h>
+#include <NtpClientLib.h>
+#include <SparkFunTSL2561.h>
+#include <Wire.h>
+#include <OneWire.h>
+#include <Ticker.h>
+//
+#include "WeatherSensors.h"
+#include "WindSpeedStatistics.h"
+#include "RainfallStatistics.h"
+#include "TelemetrySerializer.h"
+#include "TelemetryLog.h"
+#include "TelemetryFrame.h"
+#include "TelemetryPublisher.h"
+#include "MQTTPublisher.h"
+#include "DS3231.h"
+#include "Debug.h"
+#include "Secrets.h"
+
+//
+//  Definitions used in the code for pins etc.
+//
+#define VERSION                 "0.20"
+//
+#define PIN_ONBOARD_LED         1
+#define PIN_WIND_SPEED          9
+#define PIN_PLUVIOMETER         8
+#define PIN_GROUND_TEMPERATURE  7
+#define PIN_RTC_INTERRUPT       5
+#define PIN_WIND_DIRECTION      A0
+//
+//  Resolution of the ground temperature probes, 9 to 12 bits.
+//
+#define GROUND_TEMPERATURE_RESOLUTION   10
+//
+//  Period (milliseconds) between readings of each of the sensors.
+//
+#define GROUND_TEMPERATURE_PERIOD       300000
+#define LUMINOSITY_PERIOD               60000
+#define AIR_SENSOR_PERIOD               60000
+#define WIND_DIRECTION_SAMPLE_PERIOD    250
+
+//
+//  Weather Sensor definitions.
+//
+WeatherSensors *_sensors;
+
+//
+//  Local variables to deal with the analogue and digital sensors
+//  connected to the Oak.
+//
+volatile unsigned int _windSpeedCount = 0;
+volatile unsigned short _windDirectionReading = 0;
+Ticker _oneSecondTicker;
+Ticker _oneMinuteTicker;
+//
+//  Wind speed pulse counts for each second over the last ten minutes.
+//
+WindSpeedStatistics _windSpeedStatistics;
+//
+//  Timestamped tips of the pluviometer and the rainfall totals.
+//
+RainfallStatistics _rainfallStatistics;
+
+//
+//  Indicate if we should publish the sensor readings.
+//
+volatile bool _publishReadings = false;
+unsigned int _readingNumber = 0;
+
+//
+//  DS3234 real time clock object.
+//
+//DS3231 *rtc;
+#define MAX_NTP_RETRIES 10
+
+//
+//  We are logging to Phant and we need somewhere to store the client and keys.
+//
+#define PHANT_DOMAIN        "data.sparkfun.com"
+#define PHANT_PAGE          "/input/zDA9M8dQlahOqo4bx5Dd"
+#define PHANT_PORT          80
+//
+//  The connection to the server is kept open between posts, this saves the
+//  name lookup and TCP handshake on each reading.
+//
+TelemetryPublisher _phantPublisher(PHANT_DOMAIN, PHANT_PORT);
+//
+//  The readings are serialized into a fixed buffer rather than a String
+//  to avoid fragmenting the heap.
+//
+#define TELEMETRY_BUFFER_SIZE   512
+char _telemetryBuffer[TELEMETRY_BUFFER_SIZE];
+TelemetrySerializer _telemetry(_telemetryBuffer, sizeof(_telemetryBuffer));
+//
+//  Readings are logged to flash before they are posted so that nothing is
+//  lost when the network is down.  Each reading is held as a binary
+//  telemetry frame (see TelemetryFrame.h), the backlog is uploaded a batch
+//  at a time when the network returns.
+//
+//  A full frame (58 bytes) is padded to 60 bytes and has a 12 byte record
+//  header so a sector holds 56 readings after its 16 byte header.  One
+//  sector is always being recycled, 181 sectors (724 KB, below the SDK
+//  settings at the top of the flash) hold 180 x 56 = 10080 readings, a week
+//  at one reading a minute.
+//
+#define TELEMETRY_LOG_FIRST_SECTOR  ((3 * 1024 * 1024) / SPI_FLASH_SEC_SIZE)
+#define TELEMETRY_LOG_SECTORS       181
+#define TELEMETRY_UPLOAD_BATCH      20
+TelemetryLog _telemetryLog(TELEMETRY_LOG_FIRST_SECTOR, TELEMETRY_LOG_SECTORS);
+//
+//  Readings can be posted one at a time to Phant or in batches to a local
+//  collection server.  A batch is sent once TELEMETRY_BATCH_SIZE readings are
+//  waiting or the oldest reading is TELEMETRY_BATCH_MAXIMUM_AGE seconds old.
+//  The server replies with the sequence number of the last reading it has
+//  stored, anything after that is sent again.
+//
+//  When TELEMETRY_BATCH_BINARY is set the frames from the log are sent
+//  as they are, otherwise the readings are formatted as TELEMETRY_BATCH_FORMAT
+//  text.  _batchRecords is the number of readings in the batch.
+//
+#ifndef TELEMETRY_BATCH_UPLOADS
+#define TELEMETRY_BATCH_UPLOADS         0
+#endif
+#define TELEMETRY_BATCH_DOMAIN          "weatherstation.local"
+#define TELEMETRY_BATCH_PORT            8080
+#define TELEMETRY_BATCH_PAGE            "/telemetry"
+#ifndef TELEMETRY_BATCH_BINARY
+#define TELEMETRY_BATCH_BINARY          1
+#endif
+#define TELEMETRY_BATCH_FORMAT          TelemetrySerializer::CSV
+#define TELEMETRY_BATCH_SIZE            10
+#define TELEMETRY_BATCH_MAXIMUM_AGE     (15 * 60)
+#define TELEMETRY_BATCHES_PER_UPLOAD    4
+#define TELEMETRY_BATCH_BUFFER_SIZE     2048
+char _batchBuffer[TELEMETRY_BATCH_BUFFER_SIZE];
+TelemetrySerializer _batch(_batchBuffer, sizeof(_batchBuffer));
+TelemetryPublisher _batchPublisher(TELEMETRY_BATCH_DOMAIN, TELEMETRY_BATCH_PORT);
+uint8_t _batchRecords = 0;
+//
+//  Uploads run in the background while loop() carries on sampling.  _upload
+//  is the publisher with a request in flight, _uploadSequence the last
+//  reading in that request and _uploadRequests the number of requests
+//  completed in the current upload.
+//
+TelemetryPublisher *_upload = NULL;
+uint32_t _uploadSequence = 0;
+uint8_t _uploadRequests = 0;
+//
+//  Readings can also be published to an MQTT broker (Adafruit IO), each
+//  measurement to its own topic.  The QoS 1 messages are pipelined, up to
+//  MQTTPublisher::WindowSize messages can be waiting for the broker to
+//  acknowledge them.  A reading is removed from the log once the broker has
+//  acknowledged every measurement in it.
+//
+//  A reading more than MQTT_LIVE_READING_AGE seconds old (the backlog left
+//  by an outage) is published as one message to the group's /json topic
+//  with the time of the reading in created_at, otherwise it would be stored
+//  with the time it was published.
+//
+//  Adafruit IO throttles clients which publish too quickly.  Publishing is
+//  limited to MQTT_MAXIMUM_PUBLISH_RATE messages a minute with bursts of up
+//  to one reading, so a new reading goes out at once.  A live reading takes
+//  up to 19 messages but a backlog reading only one, the backlog drains at
+//  about 29 readings a minute once the new readings are allowed for: a 12
+//  hour outage takes about 25 minutes to clear, a full log (a week) about
+//  six hours.
+//
+//  _mqttSample is the reading being published, _mqttField the next field to
+//  publish from it and _mqttPublished the last reading whose fields have all
+//  been published.  _mqttCreatedAt is set for a backlog reading.  The log is
+//  only searched for new readings when _mqttReadingsWaiting is set.
+//
+#ifndef TELEMETRY_MQTT_UPLOADS
+#define TELEMETRY_MQTT_UPLOADS      0
+#endif
+#define MQTT_DOMAIN                 "io.adafruit.com"
+#define MQTT_PORT                   1883
+#define MQTT_CLIENT_ID              "WeatherStation"
+#define MQTT_TOPIC_PREFIX           AIO_USERNAME "/feeds/"
+#define MQTT_GROUP_TOPIC            AIO_USERNAME "/groups/weatherstation/json"
+#define MQTT_LIVE_READING_AGE       120
+#define MQTT_MAXIMUM_PUBLISH_RATE   30
+#define MQTT_PUBLISH_INTERVAL       (60000UL / MQTT_MAXIMUM_PUBLISH_RATE)
+#define MQTT_PUBLISH_BURST          TelemetrySerializer::NumberOfFields
+MQTTPublisher _mqtt(MQTT_DOMAIN, MQTT_PORT, MQTT_CLIENT_ID, AIO_USERNAME, AIO_KEY);
+TelemetrySerializer::Sample _mqttSample;
+uint32_t _mqttSequence = 0;
+uint8_t _mqttField = TelemetrySerializer::NumberOfFields;
+uint32_t _mqttPublished = 0;
+uint32_t _mqttAcknowledged = 0;
+bool _mqttReadingsWaiting = true;
+char _mqttCreatedAt[24];
+char _mqttPayload[MQTTPublisher::MaximumPacketSize];
+uint8_t _mqttPublishCredit = MQTT_PUBLISH_BURST;
+unsigned long _mqttCreditTime = 0;
+
+//
+//  Used for debugging, determine the output state of the onboard LED.
+//
+#define LED_TOGGLE_PERIOD   500
+bool _ledOutput = false;
+unsigned long _lastLEDToggle = 0;
+
+//
+//  Take a copy of the latest sensor readings.
+//
+void CaptureSample(TelemetrySerializer::Sample &sample)
+{
+    float mean, standardDeviation;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp = (timeStatus() == timeNotSet) ? 0 : now();
+    sample.values[TelemetrySerializer::AirPressure] = _sensors->GetAirPressure() / 100;
+    sample.values[TelemetrySerializer::GroundTemperature] = _sensors->GetGroundTemperatureReading();
+    sample.values[TelemetrySerializer::AirTemperature] = _sensors->GetAirTemperature();
+    sample.values[TelemetrySerializer::Humidity] = _sensors->GetHumidity();
+    sample.values[TelemetrySerializer::Luminosity] = _sensors->GetLuminosityReading();
+    sample.values[TelemetrySerializer::Rainfall] = _rainfallStatistics.GetRainfallToday();
+    sample.values[TelemetrySerializer::RainRate] = _rainfallStatistics.GetRainRate(millis());
+    sample.values[TelemetrySerializer::Rainfall10Minutes] = _rainfallStatistics.GetRainfall(RainfallStatistics::TenMinutes);
+    sample.values[TelemetrySerializer::Rainfall1Hour] = _rainfallStatistics.GetRainfall(RainfallStatistics::OneHour);
+    sample.values[TelemetrySerializer::Rainfall24Hours] = _rainfallStatistics.GetRainfall(RainfallStatistics::TwentyFourHours);
+    sample.windDirection = _sensors->GetMeanWindDirectionPoint(WindDirectionStatistics::TwoMinutes);
+    if (!_sensors->GetMeanWindDirection(WindDirectionStatistics::TwoMinutes, mean, standardDeviation))
+    {
+        mean = standardDeviation = NAN;
+    }
+    sample.values[TelemetrySerializer::WindDirectionMean2Minutes] = mean;
+    sample.values[TelemetrySerializer::WindDirectionStandardDeviation2Minutes] = standardDeviation;
+    if (!_sensors->GetMeanWindDirection(WindDirectionStatistics::TenMinutes, mean, standardDeviation))
+    {
+        mean = standardDeviation = NAN;
+    }
+    sample.values[TelemetrySerializer::WindDirectionMean10Minutes] = mean;
+    sample.values[TelemetrySerializer::WindDirectionStandardDeviation10Minutes] = standardDeviation;
+    sample.values[TelemetrySerializer::WindSpeed] = _windSpeedStatistics.GetMeanSpeed(WindSpeedStatistics::TwoMinutes);
+    sample.values[TelemetrySerializer::WindSpeed10Minutes] = _windSpeedStatistics.GetMeanSpeed(WindSpeedStatistics::TenMinutes);
+    sample.values[TelemetrySerializer::WindGust] = _windSpeedStatistics.GetGust(WindSpeedStatistics::TenMinutes);
+}
+
+//
+//  Build the Phant URL for a set of readings.
+//
+bool BuildPhantURL(TelemetrySerializer &record, const TelemetrySerializer::Sample &sample)
+{
+    record.Begin(TelemetrySerializer::QueryString, PHANT_PAGE "?private_key=" PHANT_PRIVATE_KEY);
+    record.Add(sample);
+    return(record.End());
+}
+
+//
+//  Log the time taken by the last request sent by the publisher.
+//
+void LogPublisherTiming(TelemetryPublisher &publisher)
+{
+    char message[120];
+
+    snprintf(message, sizeof(message), "Request time: connect %lu ms, first byte %lu ms, total %lu ms (%s connection)",
+             publisher.GetConnectTime(), publisher.GetFirstByteTime(), publisher.GetTotalTime(),
+             publisher.WasConnectionReused() ? "reused" : "new");
+    Debugger::DebugMessage(message);
+}
+
+//
+//  Start posting the data to the Sparkfun web site.  The request is sent in
+//  the background by ServiceUploads and the URL must remain valid until it
+//  has completed.
+//
+bool PostDataToPhant(const char *url)
+{
+    //
+    //  Send the data to Phant (Sparkfun's data logging service).
+    //
+    if (!_phantPublisher.BeginGet(url))
+    {
+        return(false);
+    }
+    _upload = &_phantPublisher;
+    return(true);
+}
+
+//
+//  Check the response to the last post to Phant, returns true if Phant
+//  accepted the data.
+//
+bool PhantAcceptedData()
+{
+    char message[40];
+    bool result = false;
+
+    int httpCode = _phantPublisher.GetStatusCode();
+    snprintf(message, sizeof(message), "Status code: %d", httpCode);
+    Debugger::DebugMessage(message);
+    if (httpCode == 200)
+    {
+        const char *response = _phantPublisher.GetResponse();
+        snprintf(message, sizeof(message), "Phant response code: %c", response[3]);
+        Debugger::DebugMessage(message);
+        if (response[3] != '1')
+        {
+            //
+            //  Need to put some error handling here.
+            //  
+        }
+        result = true;
+    }
+    else
+    {
+        Debugger::DebugMessage("Error sending data to Phant.");
+    }
+    return(result);
+}
+
+//
+//  Read the next record from the telemetry log and decode it.  readable is
+//  false if the record is not a valid telemetry frame, returns false at the
+//  end of the log.
+//
+bool ReadLoggedSample(TelemetrySerializer::Sample &sample, uint32_t &sequence, bool &readable)
+{
+    uint8_t frame[TelemetryLog::MaximumRecordSize];
+    uint16_t length;
+    uint32_t frameSequence;
+
+    if (!_telemetryLog.ReadNext(frame, sizeof(frame), length, sequence))
+    {
+        return(false);
+    }
+    readable = (length <= sizeof(frame)) && (TelemetryFrame::Decode(frame, length, sample, frameSequence) == length);
+    return(true);
+}
+
+//
+//  Start sending the oldest reading held in the telemetry log to Phant,
+//  returns false if there is nothing to send or TELEMETRY_UPLOAD_BATCH
+//  readings have already been sent in this upload.
+//
+bool StartPhantUpload()
+{
+    TelemetrySerializer::Sample sample;
+    uint32_t sequence;
+    bool readable;
+
+    if (_uploadRequests >= TELEMETRY_UPLOAD_BATCH)
+    {
+        return(false);
+    }
+    _telemetryLog.Rewind();
+    while (ReadLoggedSample(sample, sequence, readable))
+    {
+        if (!readable || !BuildPhantURL(_telemetry, sample))
+        {
+            Debugger::DebugMessage("Discarding unreadable telemetry record", (unsigned int) sequence, 10, "");
+            _telemetryLog.Acknowledge(sequence);
+            continue;
+        }
+        _uploadSequence = sequence;
+        return(PostDataToPhant(_telemetry.GetBuffer()));
+    }
+    return(false);
+}
+
+//
+//  The post to Phant has completed, the reading is only removed from the
+//  log once Phant has accepted it.  Returns true if the upload should
+//  continue.
+//
+bool FinishPhantUpload()
+{
+    if (!PhantAcceptedData())
+    {
+        return(false);
+    }
+    _telemetryLog.Acknowledge(_uploadSequence);
+    _uploadRequests++;
+    return(true);
+}
+
+//
+//  Check if the readings in the log should be sent to the collection server,
+//  either a full batch is waiting or the oldest reading has reached the
+//  maximum age.
+//
+bool BatchReady()
+{
+    TelemetrySerializer::Sample sample;
+    uint32_t sequence;
+    bool readable;
+
+    _telemetryLog.Rewind();
+    if (!ReadLoggedSample(sample, sequence, readable))
+    {
+        return(false);
+    }
+    return((_telemetryLog.GetPendingCount() >= TELEMETRY_BATCH_SIZE) || !readable || (sample.timestamp == 0) || (timeStatus() == timeNotSet) ||
+           ((now() - sample.timestamp) >= TELEMETRY_BATCH_MAXIMUM_AGE));
+}
+
+//
+//  Start posting the next batch of readings from the log to the collection
+//  server, returns false if there is nothing to send or
+//  TELEMETRY_BATCHES_PER_UPLOAD batches have already been sent in this
+//  upload.
+//
+bool StartBatchUpload()
+{
+    TelemetrySerializer::Sample sample;
+    size_t batchLength = 0;
+    uint16_t length;
+    uint32_t sequence;
+    bool readable;
+
+    if (_uploadRequests >= TELEMETRY_BATCHES_PER_UPLOAD)
+    {
+        return(false);
+    }
+    _batchRecords = 0;
+    _batch.BeginBatch(TELEMETRY_BATCH_FORMAT);
+    _telemetryLog.Rewind();
+    while (_batchRecords < TELEMETRY_BATCH_SIZE)
+    {
+        uint8_t *frame = (uint8_t *) _batchBuffer + batchLength;
+        if (TELEMETRY_BATCH_BINARY)
+        {
+            //
+            //  Frames are copied straight from the log into the batch.
+            //
+            if (((sizeof(_batchBuffer) - batchLength) < TelemetryLog::MaximumRecordSize) ||
+                !_telemetryLog.ReadNext(frame, TelemetryLog::MaximumRecordSize, length, sequence))
+            {
+                break;
+            }
+            readable = (TelemetryFrame::GetFrameLength(frame, length) == length);
+        }
+        else if (!ReadLoggedSample(sample, sequence, readable))
+        {
+            break;
+        }
+        if (!readable)
+        {
+            if (_batchRecords > 0)
+            {
+                break;
+            }
+            Debugger::DebugMessage("Discarding unreadable telemetry record", (unsigned int) sequence, 10, "");
+            _telemetryLog.Acknowledge(sequence);
+            continue;
+        }
+        if (TELEMETRY_BATCH_BINARY)
+        {
+            batchLength += length;
+        }
+        else if (!_batch.AddRecord(sequence, sample))
+        {
+            break;
+        }
+        _batchRecords++;
+        _uploadSequence = sequence;
+    }
+    if (!TELEMETRY_BATCH_BINARY)
+    {
+        batchLength = _batch.Length();
+    }
+    if ((_batchRecords == 0) ||
+        !_batchPublisher.BeginPost(TELEMETRY_BATCH_PAGE,
+                                   TELEMETRY_BATCH_BINARY ? "application/octet-stream" :
+                                   (TELEMETRY_BATCH_FORMAT == TelemetrySerializer::CSV) ? "text/csv" : "application/x-ndjson",
+                                   (const uint8_t *) _batchBuffer, batchLength))
+    {
+        return(false);
+    }
+    _upload = &_batchPublisher;
+    return(true);
+}
+
+//
+//  The batch has been posted, the server replies with the sequence number of
+//  the last reading it has stored.  Anything after that stays in the log and
+//  is sent with the next batch.  Returns true if the upload should continue.
+//
+bool FinishBatchUpload()
+{
+    char message[60];
+
+    int httpCode = _batchPublisher.GetStatusCode();
+    if (httpCode != 200)
+    {
+        snprintf(message, sizeof(message), "Error sending batch, status code: %d", httpCode);
+        Debugger::DebugMessage(message);
+        return(false);
+    }
+    uint32_t acknowledged = strtoul(_batchPublisher.GetResponse(), NULL, 10);
+    _telemetryLog.Acknowledge(acknowledged);
+    snprintf(message, sizeof(message), "Readings sent in batch: %u", (unsigned int) _batchRecords);
+    Debugger::DebugMessage(message);
+    if (acknowledged < _uploadSequence)
+    {
+        snprintf(message, sizeof(message), "Server stored readings up to %lu", (unsigned long) acknowledged);
+        Debugger::DebugMessage(message);
+        return(false);
+    }
+    _uploadRequests++;
+    return(true);
+}
+
+//
+//  Move on to the next reading in the log which has not been published to
+//  the MQTT broker, returns false if there are none.
+//
+bool NextMQTTReading()
+{
+    uint32_t sequence;
+    bool readable;
+
+    _telemetryLog.Rewind();
+    while (ReadLoggedSample(_mqttSample, sequence, readable))
+    {
+        if (sequence <= _mqttSequence)
+        {
+            continue;
+        }
+        _mqttSequence = sequence;
+        if (!readable)
+        {
+            Debugger::DebugMessage("Discarding unreadable telemetry record", (unsigned int) sequence, 10, "");
+            _mqttPublished = sequence;
+            continue;
+        }
+        _mqttField = 0;
+        _mqttCreatedAt[0] = '\0';
+        if ((_mqttSample.timestamp != 0) && ((now() - _mqttSample.timestamp) > MQTT_LIVE_READING_AGE))
+        {
+            time_t timestamp = _mqttSample.timestamp;
+            snprintf(_mqttCreatedAt, sizeof(_mqttCreatedAt), "%04d-%02d-%02dT%02d:%02d:%02dZ", year(timestamp),
+                     month(timestamp), day(timestamp), hour(timestamp), minute(timestamp), second(timestamp));
+        }
+        return(true);
+    }
+    _mqttReadingsWaiting = false;
+    return(false);
+}
+
+//
+//  Add the credit earned since the last call, one message for every
+//  MQTT_PUBLISH_INTERVAL up to MQTT_PUBLISH_BURST.
+//
+void UpdateMQTTPublishCredit()
+{
+    unsigned long now = millis();
+
+    if (_mqttPublishCredit >= MQTT_PUBLISH_BURST)
+    {
+        _mqttCreditTime = now;
+        return;
+    }
+    unsigned long earned = (now - _mqttCreditTime) / MQTT_PUBLISH_INTERVAL;
+    if (earned > 0)
+    {
+        _mqttCreditTime += earned * MQTT_PUBLISH_INTERVAL;
+        earned += _mqttPublishCredit;
+        _mqttPublishCredit = (earned > MQTT_PUBLISH_BURST) ? MQTT_PUBLISH_BURST : (uint8_t) earned;
+    }
+}
+
+//
+//  Build the group message holding every field of a backlog reading:
+//
+//      {"feeds":{"airpressure":"1013.2",...},"created_at":"..."}
+//
+//  Returns false if the reading does not fit in one message.
+//
+bool FormatMQTTGroupMessage()
+{
+    char text[24];
+    TelemetrySerializer value(text, sizeof(text));
+    size_t length = snprintf(_mqttPayload, sizeof(_mqttPayload), "{\"feeds\":{");
+
+    for (uint8_t field = 0; (field < TelemetrySerializer::NumberOfFields) && (length < sizeof(_mqttPayload)); field++)
+    {
+        value.Begin(TelemetrySerializer::Value);
+        value.AddField(_mqttSample, (TelemetrySerializer::Field) field);
+        value.End();
+        if (value.Length() > 0)
+        {
+            length += snprintf(_mqttPayload + length, sizeof(_mqttPayload) - length, "%s\"%s\":\"%s\"", (_mqttPayload[length - 1] == '{') ? "" : ",",
+                               TelemetrySerializer::GetFieldName((TelemetrySerializer::Field) field), value.GetBuffer());
+        }
+    }
+    if (length < sizeof(_mqttPayload))
+    {
+        length += snprintf(_mqttPayload + length, sizeof(_mqttPayload) - length, "},\"created_at\":\"%s\"}", _mqttCreatedAt);
+    }
+    return(length < sizeof(_mqttPayload));
+}
+
+//
+//  Publish the logged readings to the MQTT broker, called from loop().
+//
+//  Messages are published while there is space in the window and publishing
+//  credit left, one per field for a live reading or one for the whole of a
+//  backlog reading.  Readings are acknowledged in the log up to the reading
+//  before the oldest message the broker has not acknowledged.
+//
+void ServiceMQTT()
+{
+    char topic[64];
+    char text[24];
+    TelemetrySerializer value(text, sizeof(text));
+    uint32_t oldest;
+
+    _mqtt.Service();
+    uint32_t acknowledged = _mqttPublished;
+    if (_mqtt.GetOldestUnacknowledged(oldest) && (oldest <= acknowledged))
+    {
+        acknowledged = oldest - 1;
+    }
+    if (acknowledged > _mqttAcknowledged)
+    {
+        _telemetryLog.Acknowledge(acknowledged);
+        _mqttAcknowledged = acknowledged;
+    }
+    UpdateMQTTPublishCredit();
+    while (_mqtt.CanPublish() && (_mqttPublishCredit > 0))
+    {
+        if ((_mqttField >= TelemetrySerializer::NumberOfFields) && (!_mqttReadingsWaiting || !NextMQTTReading()))
+        {
+            break;
+        }
+        if (_mqttCreatedAt[0] != '\0')
+        {
+            _mqttField = TelemetrySerializer::NumberOfFields;
+            if (FormatMQTTGroupMessage() && _mqtt.Publish(MQTT_GROUP_TOPIC, _mqttPayload, _mqttSequence))
+            {
+                _mqttPublishCredit--;
+            }
+            else
+            {
+                Debugger::DebugMessage("MQTT message too large for topic " MQTT_GROUP_TOPIC);
+            }
+        }
+        else
+        {
+            TelemetrySerializer::Field field = (TelemetrySerializer::Field) _mqttField++;
+            value.Begin(TelemetrySerializer::Value);
+            value.AddField(_mqttSample, field);
+            value.End();
+            if (value.Length() > 0)
+            {
+                snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "%s", TelemetrySerializer::GetFieldName(field));
+                if (_mqtt.Publish(topic, value.GetBuffer(), _mqttSequence))
+                {
+                    _mqttPublishCredit--;
+                }
+                else
+                {
+                    snprintf(_mqttPayload, sizeof(_mqttPayload), "MQTT message too large for topic %s", topic);
+                    Debugger::DebugMessage(_mqttPayload);
+                }
+            }
+        }
+        if (_mqttField == TelemetrySerializer::NumberOfFields)
+        {
+            _mqttPublished = _mqttSequence;
+        }
+    }
+}
+
+//
+//  Start uploading the readings held in the telemetry log.  Readings logged
+//  while an upload is in progress are picked up by that upload.
+//
+void StartUpload()
+{
+    if (TELEMETRY_MQTT_UPLOADS)
+    {
+        _mqttReadingsWaiting = true;
+        return;
+    }
+    if (_upload != NULL)
+    {
+        return;
+    }
+    _uploadRequests = 0;
+    if (TELEMETRY_BATCH_UPLOADS)
+    {
+        if (BatchReady())
+        {
+            StartBatchUpload();
+        }
+    }
+    else
+    {
+        StartPhantUpload();
+    }
+}
+
+//
+//  Advance the upload in progress by one step, called from loop().  When a
+//  request completes the next one is started until the upload is finished.
+//  The MQTT session is serviced here as well.
+//
+void ServiceUploads()
+{
+    if (TELEMETRY_MQTT_UPLOADS)
+    {
+        ServiceMQTT();
+    }
+    if (_upload == NULL)
+    {
+        return;
+    }
+    _upload->Service();
+    if (_upload->IsBusy())
+    {
+        return;
+    }
+    TelemetryPublisher *publisher = _upload;
+    _upload = NULL;
+    LogPublisherTiming(*publisher);
+    if (publisher == &_phantPublisher)
+    {
+        if (FinishPhantUpload() && StartPhantUpload())
+        {
+            return;
+        }
+    }
+    else
+    {
+        if (FinishBatchUpload() && StartBatchUpload())
+        {
+            return;
+        }
+    }
+    if (_telemetryLog.GetPendingCount() > 0)
+    {
+        Debugger::DebugMessage("Telemetry records waiting to be uploaded:", (unsigned int) _telemetryLog.GetPendingCount(), 10, "");
+    }
+}
+
+//
+//  Log the latest readings and then start uploading the log.
+//
+void PublishReadings()
+{
+    TelemetrySerializer::Sample sample;
+    uint8_t frame[TelemetryFrame::MaximumFrameSize];
+    uint32_t sequence;
+
+    CaptureSample(sample);
+    size_t length = TelemetryFrame::Encode(sample, _telemetryLog.GetNextSequence(), frame, sizeof(frame));
+    if ((length == 0) || !_telemetryLog.Append(frame, (uint16_t) length, sequence))
+    {
+        if (_upload != NULL)
+        {
+            Debugger::DebugMessage("Unable to log the readings, upload in progress.");
+            return;
+        }
+        Debugger::DebugMessage("Unable to log the readings, posting directly.");
+        _uploadSequence = 0;
+        _uploadRequests = TELEMETRY_UPLOAD_BATCH;
+        if (BuildPhantURL(_telemetry, sample))
+        {
+            PostDataToPhant(_telemetry.GetBuffer());
+        }
+        return;
+    }
+    StartUpload();
+}
+
+//
+//  Update the RTC with the time from the Internet.
+//
+void UpdateRTCWithInternetTime(DS3231 *rtc)
+{
+    ntpClient *ntp;
+    int retries = 0;
+
+    Debugger::DebugMessage("Getting Internet time and setting RTC.");
+    ntp = ntpClient::getInstance("time.nist.gov", 0);
+    ntp->setInterval(1, 1800);
+    delay(1000);
+    ntp->begin();
+    time_t ntpTime = ntp->getTime();
+    while ((year(ntpTime) == 1970) && (retries < MAX_NTP_RETRIES))
+    {
+        delay(50);
+        ntpTime = ntp->getTime();
+        retries++;
+    }
+    if (retries < MAX_NTP_RETRIES)
+    {
+        //dateTime = new(ts);
+        //dateTime->hour = hour(ntpTime);
+        //dateTime->minutes = minute(ntpTime);
+        //dateTime->seconds = second(ntpTime);
+        //dateTime->day = day(ntpTime);
+        //dateTime->month = month(ntpTime);
+        //dateTime->year = year(ntpTime);
+        //dateTime->wday = weekday(ntpTime);
+        //rtc->SetDateTime(dateTime);
+        //Debugger::DebugMessage("Setting RTC to: " + rtc->DateTimeString(dateTime));
+        //delay(1000);
+        setTime(ntpTime);
+        Serial.printf("Time: %2d:%2d:%2d\n", hour(), minute(), second());
+        while (second() != 0)
+        {
+            delay(1000);
+        }
+    }
+    ntp->stop();
+}
+
+//
+//  Reset the alarm.
+//
+void SetAlarm(DS3231 *rtc, uint8_t period)
+{
+    ts *dateTime = rtc->GetDateTime();
+    Debugger::DebugMessage("Current time retrieved: " + rtc->DateTimeString(dateTime));
+    uint8_t minutes = dateTime->minutes;
+    //
+    //  Note that the alarm we are using is When minutes and seconds match.
+    //  This mean we do not have to worry about the hours, day etc rolling
+    //  over.  A bit dirty I know :)
+    //
+    minutes += period;
+    if (minutes >= 60)
+    {
+        minutes = 0;
+    }
+    dateTime->minutes = minutes;
+    dateTime->seconds = 0;
+    Debugger::DebugMessage("Setting alarm for " + rtc->DateTimeString(dateTime));
+    rtc->ClearInterrupt(DS3231::Alarm1Raised);
+    rtc->SetAlarm(DS3231::Alarm1Raised, dateTime, DS3231::WhenMinutesSecondsMatch);
+    delete(dateTime);
+}
+
+//
+//  Show the planned and actual timings for each of the sensors.
+//
+void LogSensorSchedule()
+{
+    static const char *names[WeatherSensors::NumberOfSensors] = { "Ground temperature", "Luminosity", "Temperature, humidity and pressure", "Wind direction" };
+    SensorScheduler *scheduler = _sensors->GetScheduler();
+
+    for (uint8_t sensor = 0; sensor < WeatherSensors::NumberOfSensors; sensor++)
+    {
+        Serial.printf("%s: period %lu ms, phase %lu ms, acquisition %lu ms, cost estimated %lu us, last %lu us, maximum %lu us, late %lu ms (maximum %lu ms), runs %lu, missed %lu\n",
+                      names[sensor], scheduler->GetPeriod(sensor), scheduler->GetPhase(sensor), _sensors->GetAcquisitionTime((WeatherSensors::Sensor) sensor),
+                      scheduler->GetEstimatedCost(sensor), scheduler->GetLastCost(sensor), scheduler->GetMaximumCost(sensor),
+                      scheduler->GetLastLateness(sensor), scheduler->GetMaximumLateness(sensor),
+                      (unsigned long) scheduler->GetRunCount(sensor), (unsigned long) scheduler->GetMissedCount(sensor));
+    }
+}
+
+//
+//  Push the latest sensor readings to the Internet.
+//
+void ReadAndPublishData()
+{
+    float fReading;
+
+    Debugger::DebugMessage("Publishing sensor data (", _readingNumber, 10, ")");
+    LogSensorSchedule();
+    fReading = _sensors->GetLuminosityReading();
+    Debugger::DebugMessage("Luminosity:", fReading, 2u, "lumens");
+    Debugger::DebugMessage("Luminosity integration time:", (unsigned int) _sensors->GetLuminosityIntegrationTime(), 10, _sensors->GetLuminosityGain() ? "ms (16x)" : "ms (1x)");
+    if (_sensors->IsLuminosityReadingSaturated())
+    {
+        Debugger::DebugMessage("Luminosity sensor saturated.");
+    }
+    fReading = _sensors->GetAirTemperature();
+    Debugger::DebugMessage("Air temperature:", fReading, 2u, "C");
+    fReading = _sensors->GetHumidity();
+    Debugger::DebugMessage("Humidity:", fReading, 2u, "%");
+    fReading = _sensors->GetAirPressure() / 100;
+    Debugger::DebugMessage("Humidity:", fReading, 2u, "hPa");
+    float mean, standardDeviation;
+    if (_sensors->GetMeanWindDirection(WindDirectionStatistics::TwoMinutes, mean, standardDeviation))
+    {
+        Debugger::DebugMessage("Wind direction (2 minute mean):", mean, 1u, "degrees");
+        Debugger::DebugMessage("Wind direction (2 minute standard deviation):", standardDeviation, 1u, "degrees");
+    }
+    if (_sensors->GetMeanWindDirection(WindDirectionStatistics::TenMinutes, mean, standardDeviation))
+    {
+        Debugger::DebugMessage("Wind direction (10 minute mean):", mean, 1u, "degrees");
+        Debugger::DebugMessage("Wind direction (10 minute standard deviation):", standardDeviation, 1u, "degrees");
+    }
+    for (uint8_t probe = 0; probe < _sensors->GetNumberOfGroundTemperatureProbes(); probe++)
+    {
+        char message[80];
+        char number[30];
+
+        fReading = _sensors->GetGroundTemperatureReading(probe);
+        snprintf(message, sizeof(message), "Ground temperature (probe %u, %u bit, %u CRC failures): %s C", (unsigned int) probe,
+                 (unsigned int) _sensors->GetGroundTemperatureProbeResolution(probe), (unsigned int) _sensors->GetGroundTemperatureProbeCRCFailures(probe),
+                 Debugger::FloatToAscii(number, fReading, 2));
+        Debugger::DebugMessage(message);
+    }
+    Debugger::DebugMessage("Rainfall today:", _rainfallStatistics.GetRainfallToday(), 2u, "mm");
+    Debugger::DebugMessage("Rainfall (last hour):", _rainfallStatistics.GetRainfall(RainfallStatistics::OneHour), 2u, "mm");
+    Debugger::DebugMessage("Rainfall (last 24 hours):", _rainfallStatistics.GetRainfall(RainfallStatistics::TwentyFourHours), 2u, "mm");
+    Debugger::DebugMessage("Rain rate:", _rainfallStatistics.GetRainRate(millis()), 2u, "mm/h");
+    Debugger::DebugMessage("Wind speed pulse count (2 minutes):", (unsigned int) _windSpeedStatistics.GetPulseCount(WindSpeedStatistics::TwoMinutes), 10, "");
+    fReading = _windSpeedStatistics.GetMeanSpeed(WindSpeedStatistics::TwoMinutes);
+    Debugger::DebugMessage("Wind speed (2 minute mean):", fReading, 2u, "mph");
+    fReading = _windSpeedStatistics.GetMeanSpeed(WindSpeedStatistics::TenMinutes);
+    Debugger::DebugMessage("Wind speed (10 minute mean):", fReading, 2u, "mph");
+    fReading = _windSpeedStatistics.GetGust(WindSpeedStatistics::TenMinutes);
+    Debugger::DebugMessage("Wind gust (3 second peak):", fReading, 2u, "mph");
+
+    //Debugger::DebugMessage("Luminosity:", (float) _sensors->GetLuminosityReading(), 2u, "lumens");
+    //Debugger::DebugMessage("Air temperature:", _sensors->GetAirTemperature(), 2u, "C");
+    //Debugger::DebugMessage("Humidity:", _sensors->GetHumidity(), 2u, "%");
+    //Debugger::DebugMessage("Humidity:", _sensors->GetAirPressure() / 100, 2u, "hPa");
+    //Debugger::DebugMessage("Ground temperature:", _sensors->GetGroundTemperatureReading(), 2u, "C");
+    //Debugger::DebugMessage("Rainfall today:", _pluviometerCountToday * 0.2794, 2u, "mm");
+    //Debugger::DebugMessage("Wind speed pulse count:", _lastFiveSecondWindSpeedCount, 10, "");
+    //Debugger::DebugMessage("Wind speed:", (_lastFiveSecondWindSpeedCount * 1.492) / 5, 2u, "mph");
+    //
+    //  Now post to the Internet.
+    //
+    Debugger::DebugMessage("Posting to Internet.");
+    PublishReadings();
+}
+
+//
+//  Handle the RTC interrupt.
+//
+//  - Update the RTC from the Internet if necessary.
+//  - Reset the alarm
+//  - Indicate that the sensors need reading if necessary (this is an 
+//    ISR and we need to get out of here as soon as possible)
+//
+void RTCAlarmHandler()
+{
+    Debugger::DebugMessage("--------------------------------------------------");
+    Debugger::DebugMessage("");
+    Debugger::DebugMessage("Alarm interrupt raised.");
+    //
+    //  Reset the alarm.
+    //
+    //setAlarm(rtc, 1);
+    //
+    //  Indicate that the sensors should be read.
+    //
+    _publishReadings = true;
+    Debugger::DebugMessage("Exiting RTC alarm handler");
+}
+
+//
+//  Handle the wind speed interrupts.
+//
+void WindSpeedInterruptHandler()
+{
+    _windSpeedCount++;
+}
+
+//
+//  Handle the Ticker event every second, add the wind speed pulses seen in
+//  the last second to the wind speed statistics.
+//
+void OneSecondTickerInterruptHandler()
+{
+    noInterrupts();
+    unsigned int count = _windSpeedCount;
+    _windSpeedCount = 0;
+    interrupts();
+    _windSpeedStatistics.AddInterval(count);
+}
+
+//
+//  Handle the Ticker event to indicate that we need to publish the readings.
+//
+void OneMinuteTickerInterruptHandler()
+{
+    _publishReadings = true;
+}
+
+//
+//  Timestamp the tip of the pluviometer, the tip is processed later in loop().
+//
+void PluviometerInterruptHandler()
+{
+    _rainfallStatistics.RecordTip(millis());
+}
+
+//
+//  Setup the application.
+//
+void setup()
+{
+    Serial.begin(115200);
+    Serial.println();
+    Serial.println();
+    Wire.begin();
+    Wire.setClock(100000);
+    //
+    //rtc = new DS3231();
+    //Debugger::AttachRTC(rtc);
+    Debugger::DebugMessage("-----------------------------");
+    Debugger::DebugMessage("Weather Station Starting (version " VERSION ", built: " __TIME__ " on " __DATE__ ")");
+    //
+    //  Connect to the WiFi.
+    //
+    Debugger::DebugMessage("Connecting to default network");
+    WiFi.begin();
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        delay(1000);
+    }
+    Debugger::DebugMessage("WiFi connected, IP address: " + WiFi.localIP().toString());
+    //
+    //  Get the current date and time from the RTC or a time server.
+    //
+    //UpdateRTCWithInternetTime(rtc);
+    UpdateRTCWithInternetTime(NULL);
+    //
+    //  Find any readings left in the log from before the restart.
+    //
+    if (_telemetryLog.Mount())
+    {
+        Debugger::DebugMessage("Telemetry records waiting to be uploaded:", (unsigned int) _telemetryLog.GetPendingCount(), 10, "");
+    }
+    else
+    {
+        Debugger::DebugMessage("Telemetry log unavailable, readings will be lost if the network is down.");
+    }
+    _oneMinuteTicker.attach(60.0, OneMinuteTickerInterruptHandler);
+    _oneSecondTicker.attach(1.0, OneSecondTickerInterruptHandler);
+    //SetAlarm(rtc, 1);
+    _sensors = new WeatherSensors();
+    _sensors->InitialiseSensors();
+    _sensors->SetGroundTemperatureResolution(GROUND_TEMPERATURE_RESOLUTION);
+    Debugger::DebugMessage("Ground temperature conversion time:", (unsigned int) _sensors->GetGroundTemperatureConversionTime(), 10, "ms");
+    //
+    //  Take an initial set of readings and then read each sensor at its own rate.
+    //
+    _sensors->ReadAllSensors();
+    _sensors->ScheduleSensor(WeatherSensors::WindDirectionSensor, WIND_DIRECTION_SAMPLE_PERIOD);
+    _sensors->ScheduleSensor(WeatherSensors::TemperatureHumidityPressureSensor, AIR_SENSOR_PERIOD);
+    _sensors->ScheduleSensor(WeatherSensors::LuminositySensor, LUMINOSITY_PERIOD);
+    _sensors->ScheduleSensor(WeatherSensors::GroundTemperatureSensor, GROUND_TEMPERATURE_PERIOD);
+    _sensors->StartSchedule();
+    pinMode(PIN_RTC_INTERRUPT, INPUT);
+    attachInterrupt(digitalPinToInterrupt(PIN_RTC_INTERRUPT), RTCAlarmHandler, FALLING);
+    pinMode(PIN_WIND_SPEED, INPUT);
+    attachInterrupt(digitalPinToInterrupt(PIN_WIND_SPEED), WindSpeedInterruptHandler, FALLING);
+    pinMode(PIN_PLUVIOMETER, INPUT);
+    attachInterrupt(digitalPinToInterrupt(PIN_PLUVIOMETER), PluviometerInterruptHandler, FALLING);
+    pinMode(PIN_WIND_DIRECTION, INPUT);
+    pinMode(PIN_ONBOARD_LED, OUTPUT);
+}
+
+//
+//  Main program loop.
+//
+//  Each sensor is read at its own rate by the sensor scheduler using non-blocking
+//  acquisition, loop() never waits for a sensor conversion to complete.  The
+//  latest readings are published when the one minute ticker fires and are
+//  uploaded in the background a step at a time.
+//
+void loop()
+{
+    _sensors->ServiceSchedule();
+    if (_publishReadings)
+    {
+        _publishReadings = false;
+        _readingNumber++;
+        digitalWrite(PIN_ONBOARD_LED, HIGH);
+        ReadAndPublishData();
+        digitalWrite(PIN_ONBOARD_LED, LOW);
+    }
+    ServiceUploads();
+    //
+    //  Process the pluviometer tips, the date rolls the rainfall today over
+    //  at midnight.
+    //
+    _rainfallStatistics.Update(millis(), (timeStatus() == timeNotSet) ? 0 : elapsedDays(now()));
+    if ((millis() - _lastLEDToggle) >= LED_TOGGLE_PERIOD)
+    {
+        _lastLEDToggle = millis();
+        digitalWrite(PIN_ONBOARD_LED, _ledOutput ? HIGH : LOW);
+        _ledOutput = !_ledOutput;
+    }
+}
\ No newline at end of file
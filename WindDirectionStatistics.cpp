@@ -0,0 +1,192 @@
+//
+//  Wind direction statistics class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "WindDirectionStatistics.h"
+
+//
+//  Sine and cosine of each of the 16 compass points (0 = North, 1 = North-North-East
+//  etc.) scaled by _scale.
+//
+const int16_t WindDirectionStatistics::_sine[16] PROGMEM =
+{
+    0, 383, 707, 924, 1000, 924, 707, 383, 0, -383, -707, -924, -1000, -924, -707, -383
+};
+
+const int16_t WindDirectionStatistics::_cosine[16] PROGMEM =
+{
+    1000, 924, 707, 383, 0, -383, -707, -924, -1000, -924, -707, -383, 0, 383, 707, 924
+};
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Default constructor.
+//
+WindDirectionStatistics::WindDirectionStatistics()
+{
+    Reset();
+}
+
+//
+//  Discard all of the samples.
+//
+void WindDirectionStatistics::Reset()
+{
+    memset(_blocks, 0, sizeof(_blocks));
+    _currentBlock = 0;
+    _currentBlockStart = 0;
+    _started = false;
+}
+
+//******************************************************************************
+//
+//  Sample collection.
+//
+
+//
+//  Add a sample, the direction is the compass point (0 = North, 15 =
+//  North-North-West) and now is the current time in milliseconds.
+//
+//  Samples beyond MaximumSamplesPerBlock in a block are ignored to stop the
+//  sums overflowing.
+//
+void WindDirectionStatistics::AddSample(uint8_t direction, unsigned long now)
+{
+    Update(now);
+    Block *block = &_blocks[_currentBlock];
+    if (block->count < MaximumSamplesPerBlock)
+    {
+        block->sumSine += (int16_t) pgm_read_word(&_sine[direction & 0x0f]);
+        block->sumCosine += (int16_t) pgm_read_word(&_cosine[direction & 0x0f]);
+        block->count++;
+    }
+}
+
+//
+//  Move on to a new block when the current block has expired.  Any blocks
+//  which passed without a sample (loop() was busy) are cleared.
+//
+void WindDirectionStatistics::Update(unsigned long now)
+{
+    if (!_started)
+    {
+        _currentBlockStart = now;
+        _started = true;
+        return;
+    }
+    if ((now - _currentBlockStart) >= (BlockPeriod * NumberOfBlocks))
+    {
+        memset(_blocks, 0, sizeof(_blocks));
+        _currentBlockStart = now;
+        return;
+    }
+    while ((now - _currentBlockStart) >= BlockPeriod)
+    {
+        _currentBlock = (_currentBlock + 1) % NumberOfBlocks;
+        memset(&_blocks[_currentBlock], 0, sizeof(Block));
+        _currentBlockStart += BlockPeriod;
+    }
+}
+
+//******************************************************************************
+//
+//  Statistics.
+//
+
+//
+//  Number of blocks making up a window, this includes the current (partial) block.
+//
+uint8_t WindDirectionStatistics::BlocksInWindow(Window window)
+{
+    if (window == TwoMinutes)
+    {
+        return((2 * 60 * 1000) / BlockPeriod);
+    }
+    return(NumberOfBlocks);
+}
+
+//
+//  Get the number of samples in the window.
+//
+uint16_t WindDirectionStatistics::GetNumberOfSamples(Window window)
+{
+    uint16_t count = 0;
+    uint8_t index = _currentBlock;
+
+    for (uint8_t block = 0; block < BlocksInWindow(window); block++)
+    {
+        count += _blocks[index].count;
+        index = (index == 0) ? (NumberOfBlocks - 1) : (index - 1);
+    }
+    return(count);
+}
+
+//
+//  Calculate the mean direction (degrees, 0 = North) and the standard deviation
+//  of the direction (degrees) over the window.
+//
+//  The mean is the direction of the mean unit vector, the standard deviation is
+//  estimated using the Yamartino method:
+//
+//  e = sqrt(1 - (mean sine ^ 2 + mean cosine ^ 2))
+//  sd = asin(e) * (1 + 0.1547 * e ^ 3)
+//
+//  Returns false if there are no samples in the window.
+//
+bool WindDirectionStatistics::GetMeanDirection(Window window, float &mean, float &standardDeviation)
+{
+    int32_t sumSine = 0;
+    int32_t sumCosine = 0;
+    uint16_t count = 0;
+    uint8_t index = _currentBlock;
+
+    for (uint8_t block = 0; block < BlocksInWindow(window); block++)
+    {
+        sumSine += _blocks[index].sumSine;
+        sumCosine += _blocks[index].sumCosine;
+        count += _blocks[index].count;
+        index = (index == 0) ? (NumberOfBlocks - 1) : (index - 1);
+    }
+    if (count == 0)
+    {
+        mean = 0;
+        standardDeviation = 0;
+        return(false);
+    }
+    float meanSine = ((float) sumSine) / (count * _scale);
+    float meanCosine = ((float) sumCosine) / (count * _scale);
+    mean = atan2(meanSine, meanCosine) * 180.0 / M_PI;
+    if (mean < 0)
+    {
+        mean += 360.0;
+    }
+    float epsilon = 1.0 - ((meanSine * meanSine) + (meanCosine * meanCosine));
+    epsilon = (epsilon > 0) ? sqrt(epsilon) : 0;
+    standardDeviation = asin(epsilon) * (1.0 + (0.1547 * epsilon * epsilon * epsilon)) * 180.0 / M_PI;
+    return(true);
+}
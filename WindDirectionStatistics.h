@@ -0,0 +1,78 @@
+//
+//  Header for the wind direction statistics class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __WINDDIRECTIONSTATISTICS_H__
+#define __WINDDIRECTIONSTATISTICS_H__
+
+#include <Arduino.h>
+
+//
+//  Accumulate wind vane samples and calculate the vector mean direction and
+//  the standard deviation of the direction (Yamartino method) over the last
+//  two and ten minutes.
+//
+//  Samples are accumulated into five second blocks holding the sum of the
+//  sine and cosine of the direction so the memory needed does not depend on
+//  the sample rate.
+//
+class WindDirectionStatistics
+{
+    public:
+        enum Window
+        {
+            TwoMinutes, TenMinutes
+        };
+        static const unsigned long BlockPeriod = 5000;
+        static const uint8_t MaximumSamplesPerBlock = 32;
+
+        WindDirectionStatistics();
+        void Reset();
+        void AddSample(uint8_t, unsigned long);
+        void Update(unsigned long);
+        uint16_t GetNumberOfSamples(Window);
+        bool GetMeanDirection(Window, float &, float &);
+
+    private:
+        //
+        //  Sums of the sine and cosine (scaled by _scale) of the samples in a block.
+        //
+        struct Block
+        {
+            int16_t sumSine;
+            int16_t sumCosine;
+            uint8_t count;
+        };
+        static const uint8_t NumberOfBlocks = (10 * 60 * 1000) / BlockPeriod;
+        static const int16_t _sine[16];
+        static const int16_t _cosine[16];
+        static const int16_t _scale = 1000;
+        Block _blocks[NumberOfBlocks];
+        uint8_t _currentBlock;
+        unsigned long _currentBlockStart;
+        bool _started;
+        uint8_t BlocksInWindow(Window);
+};
+
+#endif
@@ -0,0 +1,165 @@
+//
+//  Wind speed statistics class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#include "WindSpeedStatistics.h"
+
+//******************************************************************************
+//
+//  Constructors etc.
+//
+
+//
+//  Default constructor.
+//
+WindSpeedStatistics::WindSpeedStatistics()
+{
+    Reset();
+}
+
+//
+//  Discard all of the readings.
+//
+void WindSpeedStatistics::Reset()
+{
+    memset(_counts, 0, sizeof(_counts));
+    _nextInterval = 0;
+    _numberOfIntervals = 0;
+    _twoMinuteSum = 0;
+    _tenMinuteSum = 0;
+}
+
+//******************************************************************************
+//
+//  Data collection.
+//
+
+//
+//  Add the number of pulses seen in the last interval (one second).
+//
+//  The running sums for the two windows are updated by adding the new count
+//  and removing the count which has just dropped out of the window.
+//
+void WindSpeedStatistics::AddInterval(unsigned int pulses)
+{
+    uint8_t count = (pulses > 0xff) ? 0xff : pulses;
+    uint16_t twoMinuteIntervals = IntervalsInWindow(TwoMinutes);
+    uint16_t leaving = (_nextInterval + NumberOfIntervals - twoMinuteIntervals) % NumberOfIntervals;
+
+    if (_numberOfIntervals >= twoMinuteIntervals)
+    {
+        _twoMinuteSum -= _counts[leaving];
+    }
+    if (_numberOfIntervals >= NumberOfIntervals)
+    {
+        _tenMinuteSum -= _counts[_nextInterval];
+    }
+    else
+    {
+        _numberOfIntervals++;
+    }
+    _counts[_nextInterval] = count;
+    _twoMinuteSum += count;
+    _tenMinuteSum += count;
+    _nextInterval = (_nextInterval + 1) % NumberOfIntervals;
+}
+
+//******************************************************************************
+//
+//  Statistics.
+//
+
+//
+//  Number of intervals covered by a window.
+//
+uint16_t WindSpeedStatistics::IntervalsInWindow(Window window)
+{
+    if (window == TwoMinutes)
+    {
+        return((2 * 60 * 1000) / IntervalPeriod);
+    }
+    return(NumberOfIntervals);
+}
+
+//
+//  Number of intervals with data in the window, this is less than the window
+//  size until the window has filled.
+//
+uint16_t WindSpeedStatistics::GetNumberOfIntervals(Window window)
+{
+    uint16_t intervals = IntervalsInWindow(window);
+    return((_numberOfIntervals < intervals) ? _numberOfIntervals : intervals);
+}
+
+//
+//  Total number of anemometer pulses in the window.
+//
+uint32_t WindSpeedStatistics::GetPulseCount(Window window)
+{
+    return((window == TwoMinutes) ? _twoMinuteSum : _tenMinuteSum);
+}
+
+//
+//  Mean wind speed (mph) over the window.
+//
+float WindSpeedStatistics::GetMeanSpeed(Window window)
+{
+    uint16_t intervals = GetNumberOfIntervals(window);
+    if (intervals == 0)
+    {
+        return(0);
+    }
+    return((GetPulseCount(window) * _speedPerPulsePerSecond * 1000) / ((float) intervals * IntervalPeriod));
+}
+
+//
+//  Peak gust (mph) in the window, the highest mean speed over any
+//  GustIntervals consecutive intervals.
+//
+float WindSpeedStatistics::GetGust(Window window)
+{
+    uint16_t intervals = GetNumberOfIntervals(window);
+    uint16_t index = (_nextInterval + NumberOfIntervals - intervals) % NumberOfIntervals;
+    uint16_t sum = 0;
+    uint16_t peak = 0;
+
+    if (intervals < GustIntervals)
+    {
+        return(0);
+    }
+    for (uint16_t interval = 0; interval < intervals; interval++)
+    {
+        sum += _counts[index];
+        if (interval >= GustIntervals)
+        {
+            sum -= _counts[(index + NumberOfIntervals - GustIntervals) % NumberOfIntervals];
+        }
+        if ((interval >= (GustIntervals - 1)) && (sum > peak))
+        {
+            peak = sum;
+        }
+        index = (index + 1) % NumberOfIntervals;
+    }
+    return((peak * _speedPerPulsePerSecond * 1000) / ((float) GustIntervals * IntervalPeriod));
+}
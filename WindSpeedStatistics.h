@@ -0,0 +1,72 @@
+//
+//  Header for the wind speed statistics class.
+//
+//  MIT License
+//
+//  Copyright(c) 2016 Mark Stevens
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files(the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions :
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+#ifndef __WINDSPEEDSTATISTICS_H__
+#define __WINDSPEEDSTATISTICS_H__
+
+#include <Arduino.h>
+
+//
+//  Keep the anemometer pulse counts for the last ten minutes, one count per
+//  second, and use them to calculate the mean wind speed over two and ten
+//  minutes and the peak three second gust.
+//
+//  AddInterval is called from the one second ticker and so only uses integer
+//  arithmetic, the means are updated as running sums.  The gust is worked
+//  out when it is requested.
+//
+class WindSpeedStatistics
+{
+    public:
+        enum Window
+        {
+            TwoMinutes, TenMinutes
+        };
+        static const uint16_t IntervalPeriod = 1000;
+        static const uint16_t NumberOfIntervals = 600;
+        static const uint8_t GustIntervals = 3;
+
+        WindSpeedStatistics();
+        void Reset();
+        void AddInterval(unsigned int);
+        uint16_t GetNumberOfIntervals(Window);
+        uint32_t GetPulseCount(Window);
+        float GetMeanSpeed(Window);
+        float GetGust(Window);
+
+    private:
+        //
+        //  Each pulse per second represents 1.492 miles per hour.
+        //
+        const float _speedPerPulsePerSecond = 1.492;
+        uint8_t _counts[NumberOfIntervals];
+        uint16_t _nextInterval;
+        uint16_t _numberOfIntervals;
+        uint32_t _twoMinuteSum;
+        uint32_t _tenMinuteSum;
+        uint16_t IntervalsInWindow(Window);
+};
+
+#endif